@@ -18,7 +18,9 @@
 #include "OpenFileThread.h"
 #include "QPasswordPromptWidget.h"
 
+#include "Minerva/Core/ImageCache.h"
 #include "Minerva/Document/MinervaDocument.h"
+#include "Minerva/Network/FetchEngine.h"
 
 #include "Constants.h"
 
@@ -209,6 +211,12 @@ void MainWindowBase::_destroy()
   MainWindowBase::_waitForJobs();
   Usul::Jobs::Manager::destroy();
 
+  // Stop the download thread now that no job can use it.
+  Minerva::Network::FetchEngine::destroy();
+
+  // Free the decoded tiles.
+  Minerva::Core::ImageCache::destroy();
+
   // Should be true.
   //USUL_ASSERT ( 0 == _refCount );
 
@@ -1057,6 +1057,37 @@ void Viewer::_stopAnimation()
   typedef Usul::Interfaces::IAnimateMatrices::Matrices Matrices;
   Matrices matrices;
   _animationController->animateMatrices ( matrices, 0 );
+  this->_prefetchPath ( Eyes(), 0 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tell the body where the path will take the camera, so the tiles along 
+//  it can be fetched ahead of time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Viewer::_prefetchPath ( const Eyes& eyes, unsigned int milliSeconds )
+{
+  if ( false == _document.valid() )
+    return;
+
+  Minerva::Core::TileEngine::Body::RefPtr body ( _document->body() );
+  if ( false == body.valid() || false == body->prefetch().valid() )
+    return;
+
+  typedef Minerva::Core::TileEngine::Prefetch Prefetch;
+  Prefetch::Positions positions;
+  positions.reserve ( eyes.size() );
+  for ( Eyes::const_iterator iter = eyes.begin(); iter != eyes.end(); ++iter )
+  {
+    double lat ( 0.0 ), lon ( 0.0 ), elevation ( 0.0 );
+    body->xyzToLatLonHeight ( *iter, lat, lon, elevation );
+    positions.push_back ( Prefetch::Vec3d ( lon, lat, elevation ) );
+  }
+
+  body->prefetch()->path ( positions, milliSeconds );
 }
 
 
@@ -1168,13 +1199,17 @@ void Viewer::playPathForward ( Minerva::Document::CameraPath::RefPtr path )
   player->playing ( true );
 
   MatrixAnimationComponent::Matrices matrices;
+  Eyes eyes;
   while ( player->playing() )
   {
-    matrices.push_back ( player->update().ptr() );
+    const osg::Matrixd m ( player->update() );
+    matrices.push_back ( m.ptr() );
+    eyes.push_back ( osg::Matrixd::inverse ( m ).getTrans() );
   }
 
   const unsigned int milliSeconds ( Usul::Registry::Database::instance()[Usul::Registry::Sections::PATH_ANIMATION]["curve"]["milliseconds"].get<unsigned int> ( 15, true ) );
   _animationController->animateMatrices ( matrices, milliSeconds );
+  this->_prefetchPath ( eyes, milliSeconds );
 }
 
 
@@ -1196,13 +1231,17 @@ void Viewer::playPathBackward ( Minerva::Document::CameraPath::RefPtr path )
   player->playing ( true );
 
   MatrixAnimationComponent::Matrices matrices;
+  Eyes eyes;
   while ( player->playing() )
   {
-    matrices.push_back ( player->update().ptr() );
+    const osg::Matrixd m ( player->update() );
+    matrices.push_back ( m.ptr() );
+    eyes.push_back ( osg::Matrixd::inverse ( m ).getTrans() );
   }
 
   const unsigned int milliSeconds ( Usul::Registry::Database::instance()[Usul::Registry::Sections::PATH_ANIMATION]["curve"]["milliseconds"].get<unsigned int> ( 15, true ) );
   _animationController->animateMatrices ( matrices, milliSeconds );
+  this->_prefetchPath ( eyes, milliSeconds );
 }
 
 
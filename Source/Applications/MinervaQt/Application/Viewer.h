@@ -151,6 +151,9 @@ private:
   
   void _stopAnimation();
 
+  typedef std::vector<osg::Vec3d> Eyes;
+  void _prefetchPath ( const Eyes& eyes, unsigned int milliSeconds );
+
   MinervaDocument::RefPtr _document;
   Minerva::Document::SceneView::RefPtr _viewer;
   QTimer *_timer;
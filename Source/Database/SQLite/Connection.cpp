@@ -33,6 +33,15 @@
 using namespace CadKit::Database::SQLite;
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The most prepared statements to keep around.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { const unsigned int MAX_CACHED_STATEMENTS ( 32 ); }
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Small helper class to initialize and shutdown the sqlite library.
@@ -66,8 +75,10 @@ namespace
 ///////////////////////////////////////////////////////////////////////////////
 
 Connection::Connection ( const std::string &file ) : BaseClass(),
-  _file   ( file ),
-  _db     ( 0x0 )
+  _file       ( file ),
+  _db         ( 0x0 ),
+  _statementList (),
+  _statements ()
 {
   // Open the database.
   {
@@ -117,6 +128,14 @@ void Connection::_destroy()
 {
   Guard guard ( this );
 
+  // The statements have to be finalized before the database will close.
+  for ( StatementList::iterator i = _statementList.begin(); i != _statementList.end(); ++i )
+  {
+    Usul::Functions::safeCall ( boost::bind<void> ( ::sqlite3_finalize, i->second ), "3059138447" );
+  }
+  _statementList.clear();
+  _statements.clear();
+
   if ( 0x0 != _db )
   {
     Usul::Functions::safeCall ( boost::bind<void> ( ::sqlite3_close, _db ), "6855261040" );
@@ -152,6 +171,20 @@ Result::RefPtr Connection::_execute ( const std::string &sql, const Binders &bin
   if ( 0x0 == _db )
     throw Usul::Exceptions::Exception ( "Error 3868552584: null database" );
 
+  // If the statement is not a select then use a cached statement. Since 
+  // it's not a select statement the caller is likely to ignore the 
+  // returned object.
+  if ( false == Helper::isSelectStatement ( sql ) )
+  {
+    Statement::RefPtr statement ( this->prepare ( sql ) );
+    for ( unsigned int i = 0; i < binders.size(); ++i )
+    {
+      statement->bind ( i, binders.at ( i ) );
+    }
+    statement->execute();
+    return Result::RefPtr ( new Result ( sql, _db, 0x0 ) );
+  }
+
   // Local scope.
   {
     // Lock the database. Using sqlite3_exec() as a guide.
@@ -182,21 +215,142 @@ Result::RefPtr Connection::_execute ( const std::string &sql, const Binders &bin
       }
     }
 
-    // Prepare the result.
-    Result::RefPtr result ( new Result ( sql, _db, statement ) );
+    // Return the result.
+    return Result::RefPtr ( new Result ( sql, _db, statement ) );
+  }
+}
+
 
-    // If the statement is not a select...
-    if ( false == Helper::isSelectStatement ( sql ) )
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get a prepared statement for the sql string.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement::RefPtr Connection::prepare ( const std::string &sql )
+{
+  Guard guard ( this );
+  ::sqlite3_stmt *statement ( this->_acquire ( sql ) );
+  return Statement::RefPtr ( new Statement ( Connection::RefPtr ( this ), sql, _db, statement ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take the statement out of the cache, or prepare a new one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+::sqlite3_stmt *Connection::_acquire ( const std::string &sql )
+{
+  Guard guard ( this );
+
+  // Handle bad state.
+  if ( 0x0 == _db )
+    throw Usul::Exceptions::Exception ( "Error 1540773026: null database" );
+
+  // Use the cached one if we can.
+  Statements::iterator i ( _statements.find ( sql ) );
+  if ( _statements.end() != i )
+  {
+    ::sqlite3_stmt *statement ( i->second->second );
+    _statementList.erase ( i->second );
+    _statements.erase ( i );
+    return statement;
+  }
+
+  // Lock the database.
+  Helper::Guard dbGuard ( _db );
+
+  ::sqlite3_stmt *statement ( 0x0 );
+  const char *leftOver ( 0x0 );
+
+  // Prepare the statement.
+  const int resultCode ( ::sqlite3_prepare_v2 ( _db, sql.c_str(), -1, &statement, &leftOver ) );
+  if ( SQLITE_OK != resultCode )
+  {
+    throw Usul::Exceptions::Exception ( Usul::Strings::format
+      ( "Error 2614038551: Result Code: ", resultCode, 
+        ", Message: '", Helper::errorMessage ( _db ), "'",
+        ", SQL: ", sql ) );
+  }
+
+  return statement;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Put the statement back in the cache. The statement has been reset.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Connection::_release ( const std::string &sql, ::sqlite3_stmt *statement )
+{
+  if ( 0x0 == statement )
+    return;
+
+  Guard guard ( this );
+
+  // Make sure it's ready to use again.
+  ::sqlite3_reset ( statement );
+  ::sqlite3_clear_bindings ( statement );
+
+  if ( 0x0 == _db )
+  {
+    ::sqlite3_finalize ( statement );
+    return;
+  }
+
+  // Make room by dropping the statement that was used the longest ago.
+  if ( _statementList.size() >= MAX_CACHED_STATEMENTS )
+  {
+    StatementList::iterator oldest ( --_statementList.end() );
+    std::pair<Statements::iterator, Statements::iterator> range ( _statements.equal_range ( oldest->first ) );
+    for ( Statements::iterator i = range.first; i != range.second; ++i )
     {
-      // This will actually execute the statement. Since it's not a select 
-      // statement the caller is likely to ignore the returned object.
-      result->prepareNextRow();
-      result->finalize();
+      if ( oldest == i->second )
+      {
+        _statements.erase ( i );
+        break;
+      }
     }
-
-    // Return the result.
-    return result;
+    ::sqlite3_finalize ( oldest->second );
+    _statementList.erase ( oldest );
   }
+
+  _statementList.push_front ( CachedStatement ( sql, statement ) );
+  _statements.insert ( Statements::value_type ( sql, _statementList.begin() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Undo everything since the savepoint and let it go.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Connection::_rollback ( const std::string &savepoint )
+{
+  typedef Result::RefPtr ( Connection::*Execute ) ( const std::string & );
+  const Execute execute ( &Connection::execute );
+
+  Guard guard ( this );
+  Usul::Functions::safeCall ( boost::bind ( execute, this, "ROLLBACK TO " + savepoint ), "2818035523" );
+  Usul::Functions::safeCall ( boost::bind ( execute, this, "RELEASE " + savepoint ), "1406929871" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the row id of the last insert.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Usul::Types::Int64 Connection::lastInsertRowId() const
+{
+  Guard guard ( this );
+  return ( ( 0x0 != _db ) ? static_cast<Usul::Types::Int64> ( ::sqlite3_last_insert_rowid ( _db ) ) : 0 );
 }
 
 
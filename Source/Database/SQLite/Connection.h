@@ -18,13 +18,18 @@
 
 #include "Database/SQLite/Binder.h"
 #include "Database/SQLite/Result.h"
+#include "Database/SQLite/Statement.h"
 
 #include "Usul/Base/Object.h"
+#include "Usul/Types/Types.h"
 
+#include <list>
+#include <map>
 #include <string>
 #include <vector>
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 
 namespace CadKit {
@@ -62,20 +67,50 @@ public:
   template < class T1, class T2, class T3, class T4, class T5 > 
   Result::RefPtr          execute ( const std::string &sql, const T1 &, const T2 &, const T3 &, const T4 &, const T5 & );
 
+  // Execute the sql string once for each item in the range. The function 
+  // is called as bindRow ( statement, item ) and returns false to skip the 
+  // item. The statement is only prepared once, so wrap the call in a 
+  // Transaction to make it fast. Returns the number of rows executed.
+  // The rows are all written or none are: if a row throws, the rows 
+  // before it are rolled back and the exception is passed on.
+  template < class Iterator, class BindFunction >
+  unsigned int            executeMany ( const std::string &sql, Iterator first, Iterator last, BindFunction bindRow );
+
   // Get the file name.
   std::string             file() const;
 
+  // Get the row id of the last insert.
+  Usul::Types::Int64      lastInsertRowId() const;
+
+  // Get a prepared statement for the sql string. Statements are cached, 
+  // so asking again for the same sql is cheap.
+  Statement::RefPtr       prepare ( const std::string &sql );
+
 protected:
 
+  friend class Statement;
+
+  // The cached statements, the most recently used first. The map finds 
+  // them by their sql string.
+  typedef std::pair<std::string, ::sqlite3_stmt *> CachedStatement;
+  typedef std::list<CachedStatement> StatementList;
+  typedef std::multimap<std::string, StatementList::iterator> Statements;
+
   // Destructor
   virtual ~Connection();
 
+  ::sqlite3_stmt *         _acquire ( const std::string &sql );
+
   static int              _busyHandler ( void *, int );
 
   void                    _destroy();
 
   Result::RefPtr          _execute ( const std::string &sql, const Binders &binders = Binders() );
 
+  void                    _release ( const std::string &sql, ::sqlite3_stmt * );
+
+  void                    _rollback ( const std::string &savepoint );
+
 private:
 
   // Can not copy or assign.
@@ -85,9 +120,52 @@ private:
   // Data members.
   std::string _file;
   ::sqlite3 *_db;
+  StatementList _statementList;
+  Statements _statements;
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the given SQL string once for each item in the range.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class Iterator, class BindFunction >
+inline unsigned int Connection::executeMany ( const std::string &sql, Iterator first, Iterator last, BindFunction bindRow )
+{
+  Guard guard ( this );
+
+  // A savepoint works inside of a transaction and also outside of one, 
+  // where it starts its own.
+  const std::string savepoint ( "execute_many" );
+  this->execute ( "SAVEPOINT " + savepoint );
+
+  unsigned int count ( 0 );
+  try
+  {
+    Statement::RefPtr statement ( this->prepare ( sql ) );
+
+    for ( Iterator iter = first; iter != last; ++iter )
+    {
+      if ( true == bindRow ( *statement, *iter ) )
+      {
+        statement->execute();
+        ++count;
+      }
+    }
+  }
+  catch ( ... )
+  {
+    this->_rollback ( savepoint );
+    throw;
+  }
+
+  this->execute ( "RELEASE " + savepoint );
+  return count;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Execute the given SQL string.
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Perry L Miller IV
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A prepared statement that can be executed many times.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Database/SQLite/Statement.h"
+#include "Database/SQLite/Connection.h"
+#include "Database/SQLite/Internal.h"
+
+#include "Usul/Exceptions/Exception.h"
+#include "Usul/Functions/SafeCall.h"
+
+#include "sqlite3.h"
+
+#include "boost/bind.hpp"
+
+using namespace CadKit::Database::SQLite;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement::Statement ( ConnectionPtr c, const std::string &sql, ::sqlite3 *db, ::sqlite3_stmt *s ) : BaseClass(),
+  _connection ( c ),
+  _database ( db ),
+  _statement ( s ),
+  _sql ( sql )
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement::~Statement()
+{
+  Usul::Functions::safeCall ( boost::bind ( &Statement::_destroy, this ), "3320547619" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destroy this instance. Should only be called from the destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Statement::_destroy()
+{
+  ConnectionPtr connection ( 0x0 );
+  ::sqlite3_stmt *statement ( 0x0 );
+  {
+    Guard guard ( this );
+    connection = _connection;
+    statement = _statement;
+    _connection = 0x0;
+    _statement = 0x0;
+  }
+
+  // Give the statement back to the connection. Done without our lock 
+  // because the connection locks itself.
+  if ( ( 0x0 != statement ) && ( true == connection.valid() ) )
+  {
+    connection->_release ( _sql, statement );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Throw if the code is an error.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Statement::_check ( int code, const std::string &message )
+{
+  if ( SQLITE_OK != code )
+  {
+    throw Usul::Exceptions::Exception ( Usul::Strings::format
+      ( message, ", Result Code: ", code, 
+        ", Message: '", Helper::errorMessage ( _database ), "'",
+        ", SQL: ", _sql ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, double value )
+{
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_double ( _statement, which + 1, value ), "Error 1707326544: Failed to bind double" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, int value )
+{
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_int ( _statement, which + 1, value ), "Error 2970436117: Failed to bind integer" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, unsigned int value )
+{
+  return this->bind ( which, static_cast<Usul::Types::Int64> ( value ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, Usul::Types::Int64 value )
+{
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_int64 ( _statement, which + 1, static_cast<sqlite3_int64> ( value ) ), "Error 3391546052: Failed to bind integer" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value. SQLite only has signed integers, so the bits are kept.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, Usul::Types::Uint64 value )
+{
+  return this->bind ( which, static_cast<Usul::Types::Int64> ( value ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, const std::string &value )
+{
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_text ( _statement, which + 1, value.c_str(), static_cast<int> ( value.size() ), SQLITE_TRANSIENT ), "Error 1238564016: Failed to bind text" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, const char *value )
+{
+  if ( 0x0 == value )
+    return this->bindNull ( which );
+
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_text ( _statement, which + 1, value, -1, SQLITE_TRANSIENT ), "Error 1238564016: Failed to bind text" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind the value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, const Blob &value )
+{
+  Guard guard ( this );
+  const void *data ( ( false == value.empty() ) ? &value[0] : 0x0 );
+  this->_check ( ::sqlite3_bind_blob ( _statement, which + 1, data, static_cast<int> ( value.size() ), SQLITE_TRANSIENT ), "Error 4075518906: Failed to bind blob" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind null.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bindNull ( unsigned int which )
+{
+  Guard guard ( this );
+  this->_check ( ::sqlite3_bind_null ( _statement, which + 1 ), "Error 2497613585: Failed to bind null" );
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind with the binder.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Statement &Statement::bind ( unsigned int which, Binder::RefPtr binder )
+{
+  Guard guard ( this );
+  if ( true == binder.valid() )
+  {
+    binder->bind ( _sql, which, _statement, _database );
+  }
+  return *this;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the statement, then reset it and clear the values. Any rows 
+//  returned are skipped.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Statement::execute()
+{
+  if ( false == _connection.valid() )
+    throw Usul::Exceptions::Exception ( "Error 2855130871: Null connection" );
+
+  // Lock the connection first, the same as a transaction does.
+  Guard connectionGuard ( _connection->mutex() );
+  Guard guard ( this );
+
+  if ( 0x0 == _statement )
+    throw Usul::Exceptions::Exception ( "Error 1099437812: Null statement pointer" );
+
+  // Lock the database.
+  Helper::Guard dbGuard ( _database );
+
+  int code ( SQLITE_ROW );
+  while ( SQLITE_ROW == code )
+  {
+    code = ::sqlite3_step ( _statement );
+  }
+
+  // Reset returns the error from the step, if there was one.
+  const int resetCode ( ::sqlite3_reset ( _statement ) );
+  ::sqlite3_clear_bindings ( _statement );
+
+  if ( SQLITE_DONE != code )
+  {
+    this->_check ( ( SQLITE_OK == resetCode ) ? code : resetCode, "Error 1926084715: Failed to execute statement" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the sql.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const std::string &Statement::sql() const
+{
+  return _sql;
+}
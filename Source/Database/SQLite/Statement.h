@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Perry L Miller IV
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A prepared statement that can be executed many times with different
+//  values. Get one from Connection::prepare(). When released it goes back
+//  to the connection's cache, ready for the next time the same SQL is used.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _SQL_LITE_WRAP_STATEMENT_H_
+#define _SQL_LITE_WRAP_STATEMENT_H_
+
+#include "Database/SQLite/Binder.h"
+
+#include "Usul/Base/Object.h"
+#include "Usul/Types/Types.h"
+
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+
+namespace CadKit {
+namespace Database {
+namespace SQLite {
+
+class Connection;
+
+
+class SQL_LITE_WRAP_EXPORT Statement : public Usul::Base::Object
+{
+public:
+
+  /// Typedefs.
+  typedef Usul::Base::Object BaseClass;
+  typedef USUL_REF_POINTER(Connection) ConnectionPtr;
+
+  // Smart-pointer definitions.
+  USUL_DECLARE_REF_POINTERS ( Statement );
+
+  // Bind the value to the parameter. The first parameter is zero.
+  // Text and blobs are copied.
+  Statement &             bind ( unsigned int which, double );
+  Statement &             bind ( unsigned int which, int );
+  Statement &             bind ( unsigned int which, unsigned int );
+  Statement &             bind ( unsigned int which, Usul::Types::Int64 );
+  Statement &             bind ( unsigned int which, Usul::Types::Uint64 );
+  Statement &             bind ( unsigned int which, const std::string & );
+  Statement &             bind ( unsigned int which, const char * );
+  Statement &             bind ( unsigned int which, const Blob & );
+  Statement &             bindNull ( unsigned int which );
+
+  // Bind with the binder. The binder's data is not copied and has to
+  // last until the statement is executed.
+  Statement &             bind ( unsigned int which, Binder::RefPtr );
+
+  // Bind any type that has binder traits. Same rules as above.
+  template < class T >
+  Statement &             bindValue ( unsigned int which, const T &t );
+
+  // Execute the statement, then reset it and clear the values.
+  void                    execute();
+
+  // Get the sql.
+  const std::string &     sql() const;
+
+protected:
+
+  friend class Connection;
+
+  // Constructor
+  Statement ( ConnectionPtr, const std::string &sql, ::sqlite3 *, ::sqlite3_stmt * );
+
+  // Use reference counting.
+  virtual ~Statement();
+
+  void                    _check ( int code, const std::string &message );
+
+  void                    _destroy();
+
+private:
+
+  // No copying or assignment.
+  Statement ( const Statement & );
+  Statement &operator = ( const Statement & );
+
+  ConnectionPtr _connection;
+  ::sqlite3 *_database;
+  ::sqlite3_stmt *_statement;
+  const std::string _sql;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bind any type that has binder traits.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class T >
+inline Statement &Statement::bindValue ( unsigned int which, const T &t )
+{
+  return this->bind ( which, CadKit::Database::SQLite::BinderTraits<T>::makeBinder ( t ) );
+}
+
+
+} // namespace SQLite
+} // namespace Database
+} // namespace CadKit
+
+
+#endif // _SQL_LITE_WRAP_STATEMENT_H_
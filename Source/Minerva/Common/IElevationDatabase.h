@@ -23,10 +23,13 @@ struct IElevationDatabase : public Usul::Interfaces::IUnknown
   USUL_DECLARE_QUERY_POINTERS ( IElevationDatabase );
   
   /// Id for this interface.
-  enum { IID = 1417816400u };
+  enum { IID = 3147480316u };
   
   // Get the elevation at a lat, lon.
   virtual double             elevationAtLatLong ( double lat, double lon ) const = 0;
+
+  // Get the elevations at n lat, lon pairs.
+  virtual void               elevations ( const double* lat, const double* lon, double* out, unsigned int n ) const = 0;
 };
 
 
@@ -28,11 +28,14 @@ struct IPlanetCoordinates : public Usul::Interfaces::IUnknown
   USUL_DECLARE_QUERY_POINTERS ( IPlanetCoordinates );
 
   /// Id for this interface.
-  enum { IID = 2885858388u };
+  enum { IID = 1454288399u };
 
   /// Convert to planet coordinates.
   virtual void               convertToPlanet ( const Usul::Math::Vec3d& orginal, Usul::Math::Vec3d& planetPoint ) const = 0;
   virtual void               convertFromPlanet ( const Usul::Math::Vec3d& planetPoint, Usul::Math::Vec3d& latLonPoint ) const = 0;
+
+  // Convert n lat, lon, elevation triples to planet coordinates with one call.
+  virtual void               convertToPlanet ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const = 0;
   
   // Matrix to place items on the planet (i.e. local coordinates to world coordinates).
   virtual osg::Matrixd       planetRotationMatrix ( double lat, double lon, double elevation, double heading ) const = 0;
@@ -0,0 +1,600 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Blend kernels for compositing raster layers.
+//
+//  Pixels are handled in blocks. Each block is first expanded to RGBA with
+//  one alpha per pixel, then blended with the widest kernel the processor
+//  has. The kernels do the same float operations in the same order as the
+//  scalar compositors, so the bytes are identical.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/Composite.h"
+
+#include "Usul/System/Processor.h"
+
+#include <cstring>
+
+#if defined ( __GNUC__ ) && ( defined ( __i386__ ) || defined ( __x86_64__ ) )
+# define MINERVA_COMPOSITE_X86
+# define MINERVA_COMPOSITE_SSE2 __attribute__ ( ( target ( "sse2" ) ) )
+# define MINERVA_COMPOSITE_AVX2 __attribute__ ( ( target ( "avx2" ) ) )
+# include <immintrin.h>
+#elif defined ( _MSC_VER ) && ( defined ( _M_IX86 ) || defined ( _M_X64 ) )
+# define MINERVA_COMPOSITE_X86
+# define MINERVA_COMPOSITE_SSE2
+# define MINERVA_COMPOSITE_AVX2
+# include <immintrin.h>
+#endif
+
+using namespace Minerva::Core::Algorithms::Composite;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constants.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  const unsigned int BLOCK_SIZE ( 256 );
+  const unsigned int MAX_BULK_COLORS ( 8 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hash the color into the slots.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  inline Usul::Types::Uint32 hash ( Usul::Types::Uint32 color, std::size_t numSlots )
+  {
+    // Fibonacci hashing. The number of slots is a power of two.
+    return static_cast<Usul::Types::Uint32> ( ( color * 2654435769u ) & ( numSlots - 1 ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+AlphaTable::AlphaTable() : _colors(), _values(), _slots()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the color, or replace its alpha.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void AlphaTable::insert ( Color color, unsigned char alpha )
+{
+  for ( unsigned int i = 0; i < _colors.size(); ++i )
+  {
+    if ( color == _colors[i] )
+    {
+      _values[i] = alpha;
+      return;
+    }
+  }
+
+  _colors.push_back ( color );
+  _values.push_back ( alpha );
+  this->_rehash();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Rebuild the hash. Keeps the table at most half full.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void AlphaTable::_rehash()
+{
+  std::size_t numSlots ( 16 );
+  while ( numSlots < _colors.size() * 2 )
+    numSlots *= 2;
+
+  _slots.assign ( numSlots, 0 );
+  for ( unsigned int i = 0; i < _colors.size(); ++i )
+  {
+    Usul::Types::Uint32 slot ( Helper::hash ( _colors[i], numSlots ) );
+    while ( 0 != _slots[slot] )
+      slot = ( slot + 1 ) & ( numSlots - 1 );
+    _slots[slot] = i + 1;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Find the alpha for the color.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool AlphaTable::find ( Color color, unsigned char& alpha ) const
+{
+  if ( true == _slots.empty() )
+    return false;
+
+  const std::size_t numSlots ( _slots.size() );
+  Usul::Types::Uint32 slot ( Helper::hash ( color, numSlots ) );
+  while ( 0 != _slots[slot] )
+  {
+    const Usul::Types::Uint32 index ( _slots[slot] - 1 );
+    if ( color == _colors[index] )
+    {
+      alpha = _values[index];
+      return true;
+    }
+    slot = ( slot + 1 ) & ( numSlots - 1 );
+  }
+  return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Expand a block of source pixels. Fills the RGBA colors (when the source
+//  is not already RGBA), the packed colors for the alpha table (when needed)
+//  and the alpha for each pixel. The alpha rules are those of Compositor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  struct Expansion
+  {
+    const unsigned char *scaled;  // Overall alpha times the source alpha.
+    unsigned char constant;       // Alpha for sources without an alpha.
+    bool hasOverallAlpha;
+    bool needColors;
+  };
+
+  template < unsigned int bands > struct Expand;
+
+  template <> struct Expand<1>
+  {
+    static void block ( const unsigned char *src, unsigned int n, const Expansion& e, unsigned char *rgba, Usul::Types::Uint32 *colors, unsigned char *alphas )
+    {
+      for ( unsigned int i = 0; i < n; ++i )
+      {
+        const unsigned char l ( src[i] );
+        rgba[i * 4 + 0] = l;
+        rgba[i * 4 + 1] = l;
+        rgba[i * 4 + 2] = l;
+        rgba[i * 4 + 3] = 0;
+        alphas[i] = e.constant;
+      }
+      if ( e.needColors )
+      {
+        for ( unsigned int i = 0; i < n; ++i )
+          colors[i] = Usul::Functions::Color::pack ( src[i], src[i], src[i], 0 );
+      }
+    }
+  };
+
+  template <> struct Expand<2>
+  {
+    static void block ( const unsigned char *src, unsigned int n, const Expansion& e, unsigned char *rgba, Usul::Types::Uint32 *colors, unsigned char *alphas )
+    {
+      for ( unsigned int i = 0; i < n; ++i )
+      {
+        const unsigned char l ( src[i * 2] );
+        const unsigned char a ( src[i * 2 + 1] );
+        rgba[i * 4 + 0] = l;
+        rgba[i * 4 + 1] = l;
+        rgba[i * 4 + 2] = l;
+        rgba[i * 4 + 3] = 0;
+        alphas[i] = ( e.hasOverallAlpha ? e.scaled[a] : a );
+      }
+      if ( e.needColors )
+      {
+        for ( unsigned int i = 0; i < n; ++i )
+          colors[i] = Usul::Functions::Color::pack ( src[i * 2], src[i * 2], src[i * 2], 0 );
+      }
+    }
+  };
+
+  template <> struct Expand<3>
+  {
+    static void block ( const unsigned char *src, unsigned int n, const Expansion& e, unsigned char *rgba, Usul::Types::Uint32 *colors, unsigned char *alphas )
+    {
+      for ( unsigned int i = 0; i < n; ++i )
+      {
+        rgba[i * 4 + 0] = src[i * 3 + 0];
+        rgba[i * 4 + 1] = src[i * 3 + 1];
+        rgba[i * 4 + 2] = src[i * 3 + 2];
+        rgba[i * 4 + 3] = 0;
+        alphas[i] = e.constant;
+      }
+      if ( e.needColors )
+      {
+        for ( unsigned int i = 0; i < n; ++i )
+          colors[i] = Usul::Functions::Color::pack ( src[i * 3 + 0], src[i * 3 + 1], src[i * 3 + 2], 0 );
+      }
+    }
+  };
+
+  // The source is already RGBA, so only the alphas are needed.
+  template <> struct Expand<4>
+  {
+    static void block ( const unsigned char *src, unsigned int n, const Expansion& e, unsigned char *, Usul::Types::Uint32 *colors, unsigned char *alphas )
+    {
+      for ( unsigned int i = 0; i < n; ++i )
+      {
+        const unsigned char a ( src[i * 4 + 3] );
+        alphas[i] = ( e.hasOverallAlpha ? e.scaled[a] : a );
+      }
+      if ( e.needColors )
+      {
+        for ( unsigned int i = 0; i < n; ++i )
+          colors[i] = Usul::Functions::Color::pack ( src[i * 4 + 0], src[i * 4 + 1], src[i * 4 + 2], 0 );
+      }
+    }
+  };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Replace the alphas of the colors in the table.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  void lookupScalar ( const AlphaTable& table, const Usul::Types::Uint32 *colors, unsigned int n, unsigned char *alphas )
+  {
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+      table.find ( colors[i], alphas[i] );
+    }
+  }
+
+#ifdef MINERVA_COMPOSITE_X86
+
+  // Compare four pixels at a time against every color in a small table.
+  // Most pixels match nothing, so the hash is only used for the rest.
+  MINERVA_COMPOSITE_SSE2 void lookupSSE2 ( const AlphaTable& table, const Usul::Types::Uint32 *colors, unsigned int n, unsigned char *alphas )
+  {
+    const AlphaTable::Colors &keys ( table.colors() );
+    const unsigned int numKeys ( table.size() );
+
+    __m128i broadcast[MAX_BULK_COLORS];
+    for ( unsigned int k = 0; k < numKeys; ++k )
+      broadcast[k] = _mm_set1_epi32 ( static_cast<int> ( keys[k] ) );
+
+    unsigned int i ( 0 );
+    for ( ; i + 4 <= n; i += 4 )
+    {
+      const __m128i c ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( colors + i ) ) );
+      __m128i hits ( _mm_setzero_si128() );
+      for ( unsigned int k = 0; k < numKeys; ++k )
+        hits = _mm_or_si128 ( hits, _mm_cmpeq_epi32 ( c, broadcast[k] ) );
+
+      if ( 0 != _mm_movemask_epi8 ( hits ) )
+        Helper::lookupScalar ( table, colors + i, 4, alphas + i );
+    }
+
+    Helper::lookupScalar ( table, colors + i, n - i, alphas + i );
+  }
+
+#endif
+
+  void lookup ( const AlphaTable& table, const Usul::Types::Uint32 *colors, unsigned int n, unsigned char *alphas, Kernel kernel )
+  {
+#ifdef MINERVA_COMPOSITE_X86
+    if ( ( KERNEL_SCALAR != kernel ) && ( table.size() <= MAX_BULK_COLORS ) )
+    {
+      Helper::lookupSSE2 ( table, colors, n, alphas );
+      return;
+    }
+#endif
+    Helper::lookupScalar ( table, colors, n, alphas );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Blend a block of RGBA pixels into the destination.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  void blendScalar ( unsigned char *dst, const unsigned char *src, const unsigned char *alphas, unsigned int n )
+  {
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+      // Normalize between zero and one.
+      const float a ( static_cast < float > ( alphas[i] ) / 255.5f );
+
+      // Composite.
+      dst[0] = static_cast < unsigned char > ( dst[0] * ( 1 - a ) + ( src[0] * a ) );
+      dst[1] = static_cast < unsigned char > ( dst[1] * ( 1 - a ) + ( src[1] * a ) );
+      dst[2] = static_cast < unsigned char > ( dst[2] * ( 1 - a ) + ( src[2] * a ) );
+
+      // Since the alpha has been accounted for above, make the pixel completely opaque.
+      if ( a > 0.0 )
+        dst[3] = 255;
+
+      dst += 4;
+      src += 4;
+    }
+  }
+
+#ifdef MINERVA_COMPOSITE_X86
+
+  // Blend one pixel held as four 32-bit integers.
+  MINERVA_COMPOSITE_SSE2 inline __m128i blendPixelSSE2 ( __m128i d, __m128i s, __m128 a, __m128 oneMinusA )
+  {
+    const __m128 result ( _mm_add_ps ( _mm_mul_ps ( _mm_cvtepi32_ps ( d ), oneMinusA ), _mm_mul_ps ( _mm_cvtepi32_ps ( s ), a ) ) );
+    return _mm_cvttps_epi32 ( result );
+  }
+
+  MINERVA_COMPOSITE_SSE2 void blendSSE2 ( unsigned char *dst, const unsigned char *src, const unsigned char *alphas, unsigned int n )
+  {
+    const __m128i zero ( _mm_setzero_si128() );
+    const __m128 one ( _mm_set1_ps ( 1.0f ) );
+    const __m128 divisor ( _mm_set1_ps ( 255.5f ) );
+    const __m128i alphaBytes ( _mm_set1_epi32 ( static_cast<int> ( 0xFF000000 ) ) );
+
+    unsigned int i ( 0 );
+    for ( ; i + 4 <= n; i += 4 )
+    {
+      // Four alphas as floats.
+      Usul::Types::Uint32 packed ( 0 );
+      ::memcpy ( &packed, alphas + i, 4 );
+      const __m128i a32 ( _mm_unpacklo_epi16 ( _mm_unpacklo_epi8 ( _mm_cvtsi32_si128 ( static_cast<int> ( packed ) ), zero ), zero ) );
+      const __m128 a ( _mm_div_ps ( _mm_cvtepi32_ps ( a32 ), divisor ) );
+      const __m128 oneMinusA ( _mm_sub_ps ( one, a ) );
+
+      const __m128i d ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( dst + i * 4 ) ) );
+      const __m128i s ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( src + i * 4 ) ) );
+
+      const __m128i dLow  ( _mm_unpacklo_epi8 ( d, zero ) );
+      const __m128i dHigh ( _mm_unpackhi_epi8 ( d, zero ) );
+      const __m128i sLow  ( _mm_unpacklo_epi8 ( s, zero ) );
+      const __m128i sHigh ( _mm_unpackhi_epi8 ( s, zero ) );
+
+      const __m128i r0 ( Helper::blendPixelSSE2 ( _mm_unpacklo_epi16 ( dLow,  zero ), _mm_unpacklo_epi16 ( sLow,  zero ), _mm_shuffle_ps ( a, a, 0x00 ), _mm_shuffle_ps ( oneMinusA, oneMinusA, 0x00 ) ) );
+      const __m128i r1 ( Helper::blendPixelSSE2 ( _mm_unpackhi_epi16 ( dLow,  zero ), _mm_unpackhi_epi16 ( sLow,  zero ), _mm_shuffle_ps ( a, a, 0x55 ), _mm_shuffle_ps ( oneMinusA, oneMinusA, 0x55 ) ) );
+      const __m128i r2 ( Helper::blendPixelSSE2 ( _mm_unpacklo_epi16 ( dHigh, zero ), _mm_unpacklo_epi16 ( sHigh, zero ), _mm_shuffle_ps ( a, a, 0xAA ), _mm_shuffle_ps ( oneMinusA, oneMinusA, 0xAA ) ) );
+      const __m128i r3 ( Helper::blendPixelSSE2 ( _mm_unpackhi_epi16 ( dHigh, zero ), _mm_unpackhi_epi16 ( sHigh, zero ), _mm_shuffle_ps ( a, a, 0xFF ), _mm_shuffle_ps ( oneMinusA, oneMinusA, 0xFF ) ) );
+
+      const __m128i colors ( _mm_packus_epi16 ( _mm_packs_epi32 ( r0, r1 ), _mm_packs_epi32 ( r2, r3 ) ) );
+
+      // Keep the destination's alpha unless this pixel's alpha is non-zero.
+      const __m128i opaque ( _mm_and_si128 ( _mm_cmpgt_epi32 ( a32, zero ), alphaBytes ) );
+      const __m128i result ( _mm_or_si128 ( _mm_or_si128 ( _mm_andnot_si128 ( alphaBytes, colors ), _mm_and_si128 ( alphaBytes, d ) ), opaque ) );
+
+      _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( dst + i * 4 ), result );
+    }
+
+    Helper::blendScalar ( dst + i * 4, src + i * 4, alphas + i, n - i );
+  }
+
+  MINERVA_COMPOSITE_AVX2 void blendAVX2 ( unsigned char *dst, const unsigned char *src, const unsigned char *alphas, unsigned int n )
+  {
+    const __m256i zero ( _mm256_setzero_si256() );
+    const __m256 one ( _mm256_set1_ps ( 1.0f ) );
+    const __m256 divisor ( _mm256_set1_ps ( 255.5f ) );
+    const __m256i alphaBytes ( _mm256_set1_epi32 ( static_cast<int> ( 0xFF000000 ) ) );
+
+    // Puts the pixels back in order after packing within 128-bit lanes.
+    const __m256i order ( _mm256_setr_epi32 ( 0, 4, 1, 5, 2, 6, 3, 7 ) );
+
+    unsigned int i ( 0 );
+    for ( ; i + 8 <= n; i += 8 )
+    {
+      // Eight alphas as floats.
+      const __m256i a32 ( _mm256_cvtepu8_epi32 ( _mm_loadl_epi64 ( reinterpret_cast<const __m128i*> ( alphas + i ) ) ) );
+      const __m256 a ( _mm256_div_ps ( _mm256_cvtepi32_ps ( a32 ), divisor ) );
+      const __m256 oneMinusA ( _mm256_sub_ps ( one, a ) );
+
+      // Two pixels at a time, each pixel in its own 128-bit lane.
+      __m256i r[4];
+      for ( unsigned int k = 0; k < 4; ++k )
+      {
+        const unsigned int p ( i + k * 2 );
+        const __m256i d ( _mm256_cvtepu8_epi32 ( _mm_loadl_epi64 ( reinterpret_cast<const __m128i*> ( dst + p * 4 ) ) ) );
+        const __m256i s ( _mm256_cvtepu8_epi32 ( _mm_loadl_epi64 ( reinterpret_cast<const __m128i*> ( src + p * 4 ) ) ) );
+        const int first ( static_cast<int> ( k * 2 ) );
+        const __m256i index ( _mm256_setr_epi32 ( first, first, first, first, first + 1, first + 1, first + 1, first + 1 ) );
+        const __m256 pa ( _mm256_permutevar8x32_ps ( a, index ) );
+        const __m256 pOneMinusA ( _mm256_permutevar8x32_ps ( oneMinusA, index ) );
+        const __m256 result ( _mm256_add_ps ( _mm256_mul_ps ( _mm256_cvtepi32_ps ( d ), pOneMinusA ), _mm256_mul_ps ( _mm256_cvtepi32_ps ( s ), pa ) ) );
+        r[k] = _mm256_cvttps_epi32 ( result );
+      }
+
+      const __m256i packed ( _mm256_packus_epi16 ( _mm256_packs_epi32 ( r[0], r[1] ), _mm256_packs_epi32 ( r[2], r[3] ) ) );
+      const __m256i colors ( _mm256_permutevar8x32_epi32 ( packed, order ) );
+
+      // Keep the destination's alpha unless this pixel's alpha is non-zero.
+      const __m256i d ( _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( dst + i * 4 ) ) );
+      const __m256i opaque ( _mm256_and_si256 ( _mm256_cmpgt_epi32 ( a32, zero ), alphaBytes ) );
+      const __m256i result ( _mm256_or_si256 ( _mm256_or_si256 ( _mm256_andnot_si256 ( alphaBytes, colors ), _mm256_and_si256 ( alphaBytes, d ) ), opaque ) );
+
+      _mm256_storeu_si256 ( reinterpret_cast<__m256i*> ( dst + i * 4 ), result );
+    }
+
+    Helper::blendSSE2 ( dst + i * 4, src + i * 4, alphas + i, n - i );
+  }
+
+#endif
+
+  void blend ( unsigned char *dst, const unsigned char *src, const unsigned char *alphas, unsigned int n, Kernel kernel )
+  {
+    switch ( kernel )
+    {
+#ifdef MINERVA_COMPOSITE_X86
+      case KERNEL_AVX2:
+        Helper::blendAVX2 ( dst, src, alphas, n );
+        return;
+      case KERNEL_SSE2:
+        Helper::blendSSE2 ( dst, src, alphas, n );
+        return;
+#endif
+      default:
+        Helper::blendScalar ( dst, src, alphas, n );
+        return;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Composite every block of the image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  template < unsigned int bands > void composite ( osg::Image& result, const osg::Image& image, const AlphaTable& table, float alpha, Kernel kernel )
+  {
+    unsigned char       *dst ( result.data() );
+    const unsigned char *src ( image.data()  );
+
+    const unsigned int width  ( result.s() );
+    const unsigned int height ( result.t() );
+
+    // We only composite images of the same size.
+    if ( ( static_cast<int> ( width ) != image.s() ) || ( static_cast<int> ( height ) != image.t() ) )
+      return;
+
+    Expansion expansion;
+    expansion.constant = static_cast < unsigned char > ( alpha * 255 );
+    expansion.hasOverallAlpha = ( alpha < 1.0f );
+    expansion.needColors = ( false == table.empty() );
+
+    // The overall alpha times each source alpha.
+    unsigned char scaled[256] = { 0 };
+    if ( true == expansion.hasOverallAlpha )
+    {
+      for ( unsigned int a = 0; a < 256; ++a )
+        scaled[a] = static_cast < unsigned char > ( alpha * a );
+    }
+    expansion.scaled = scaled;
+
+    unsigned char rgba[BLOCK_SIZE * 4];
+    Usul::Types::Uint32 colors[BLOCK_SIZE];
+    unsigned char alphas[BLOCK_SIZE];
+
+    const unsigned int size ( width * height );
+    for ( unsigned int i = 0; i < size; i += BLOCK_SIZE )
+    {
+      const unsigned int n ( Usul::Math::minimum ( BLOCK_SIZE, size - i ) );
+      const unsigned char *block ( src + i * bands );
+
+      Expand<bands>::block ( block, n, expansion, rgba, colors, alphas );
+
+      // Fast path when there are no colors with their own alpha.
+      if ( true == expansion.needColors )
+        Helper::lookup ( table, colors, n, alphas, kernel );
+
+      Helper::blend ( dst + i * 4, ( ( 4 == bands ) ? block : rgba ), alphas, n, kernel );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the kernel supported on this processor?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Minerva::Core::Algorithms::Composite::isSupported ( Kernel kernel )
+{
+  switch ( kernel )
+  {
+#ifdef MINERVA_COMPOSITE_X86
+    case KERNEL_AVX2:
+      return Usul::System::Processor::hasAVX2();
+    case KERNEL_SSE2:
+      return Usul::System::Processor::hasSSE2();
+#endif
+    case KERNEL_SCALAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The fastest kernel the processor supports.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Kernel Minerva::Core::Algorithms::Composite::bestKernel()
+{
+  static const Kernel kernel ( isSupported ( KERNEL_AVX2 ) ? KERNEL_AVX2 : ( isSupported ( KERNEL_SSE2 ) ? KERNEL_SSE2 : KERNEL_SCALAR ) );
+  return kernel;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Blend the image into the result.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Minerva::Core::Algorithms::Composite::blend ( osg::Image& result, const osg::Image& image, const AlphaTable& alphas, float alpha )
+{
+  Composite::blend ( result, image, alphas, alpha, bestKernel() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Blend the image into the result with the given kernel.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Minerva::Core::Algorithms::Composite::blend ( osg::Image& result, const osg::Image& image, const AlphaTable& alphas, float alpha, Kernel kernel )
+{
+  // Don't use a kernel the processor can't run.
+  if ( false == isSupported ( kernel ) )
+    kernel = KERNEL_SCALAR;
+
+  // We only handle these cases.
+  const GLenum format ( image.getPixelFormat() );
+  switch ( format )
+  {
+    case GL_LUMINANCE:
+      Helper::composite<1> ( result, image, alphas, alpha, kernel );
+      break;
+    case GL_LUMINANCE_ALPHA:
+      Helper::composite<2> ( result, image, alphas, alpha, kernel );
+      break;
+    case GL_RGB:
+      Helper::composite<3> ( result, image, alphas, alpha, kernel );
+      break;
+    case GL_RGBA:
+      Helper::composite<4> ( result, image, alphas, alpha, kernel );
+      break;
+  };
+}
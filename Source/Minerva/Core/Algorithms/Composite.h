@@ -11,19 +11,103 @@
 #ifndef __MINERVA_CORE_ALGORITHMS_COMPOSITE_H__
 #define __MINERVA_CORE_ALGORITHMS_COMPOSITE_H__
 
+#include "Minerva/Core/Export.h"
 #include "Minerva/Core/Algorithms/SubRegion.h"
 
 #include "Usul/Functions/Color.h"
 #include "Usul/Math/MinMax.h"
 #include "Usul/Math/Vector4.h"
+#include "Usul/Types/Types.h"
 
 #include "osg/Image"
 
+#include <vector>
+
 namespace Minerva {
 namespace Core {
 namespace Algorithms {
 namespace Composite {
-  
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Flat table of the colors that get their own alpha. Colors are packed with
+//  Usul::Functions::Color::pack. Small tables are searched a few pixels at a
+//  time, larger ones go through an open-addressing hash.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class MINERVA_EXPORT AlphaTable
+{
+public:
+
+  typedef Usul::Types::Uint32 Color;
+  typedef std::vector<Color> Colors;
+  typedef std::vector<unsigned char> Values;
+  typedef std::vector<Usul::Types::Uint32> Slots;
+
+  AlphaTable();
+
+  template < class Alphas > explicit AlphaTable ( const Alphas& alphas ) : _colors(), _values(), _slots()
+  {
+    for ( typename Alphas::const_iterator iter = alphas.begin(); iter != alphas.end(); ++iter )
+    {
+      this->insert ( iter->first, static_cast < unsigned char > ( iter->second ) );
+    }
+  }
+
+  /// Add the color, or replace its alpha.
+  void                insert ( Color color, unsigned char alpha );
+
+  /// Find the alpha for the color. Returns false if the color is not there.
+  bool                find ( Color color, unsigned char& alpha ) const;
+
+  bool                empty() const { return _colors.empty(); }
+  unsigned int        size() const { return static_cast<unsigned int> ( _colors.size() ); }
+
+  const Colors&       colors() const { return _colors; }
+  const Values&       values() const { return _values; }
+
+private:
+
+  void                _rehash();
+
+  Colors _colors;
+  Values _values;
+  Slots _slots;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The blend kernels. Every kernel gives the same bytes as Compositor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+enum Kernel
+{
+  KERNEL_SCALAR,
+  KERNEL_SSE2,
+  KERNEL_AVX2
+};
+
+/// The fastest kernel the processor supports.
+MINERVA_EXPORT Kernel bestKernel();
+
+/// Is the kernel supported on this processor?
+MINERVA_EXPORT bool   isSupported ( Kernel kernel );
+
+/// Blend the image into the result, which has to be GL_RGBA.
+MINERVA_EXPORT void   blend ( osg::Image& result, const osg::Image& image, const AlphaTable& alphas, float alpha );
+MINERVA_EXPORT void   blend ( osg::Image& result, const osg::Image& image, const AlphaTable& alphas, float alpha, Kernel kernel );
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The scalar compositors. These are the reference for the kernels above.
+//
+///////////////////////////////////////////////////////////////////////////////
+
 template<class Alphas, unsigned int bands> struct Compositor;
   
 template<class Alphas>
@@ -276,25 +360,8 @@ struct Compositor<Alphas,4>
 template < class Alphas >
 inline void raster ( osg::Image& result, const osg::Image& image, const Alphas &alphas, float alpha )
 {
-  // We only handle these cases.
-  const GLenum format ( image.getPixelFormat() );
-  switch ( format )
-  {
-    case GL_LUMINANCE:
-      Compositor<Alphas,1>::composite ( result, image, alphas, alpha );
-      break;
-    case GL_LUMINANCE_ALPHA:
-      Compositor<Alphas,2>::composite ( result, image, alphas, alpha );
-      break;
-    case GL_RGB:
-      Compositor<Alphas,3>::composite ( result, image, alphas, alpha );
-      break;
-    case GL_RGBA:
-      Compositor<Alphas,4>::composite ( result, image, alphas, alpha );
-      break;
-  };
+  Composite::blend ( result, image, AlphaTable ( alphas ), alpha );
 }
-
  
 
 }
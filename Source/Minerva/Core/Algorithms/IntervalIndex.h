@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Index of values with half-open intervals [begin,end). The values are kept
+//  sorted by both end points. When a query interval moves, only the values
+//  that begin between the old and new query ends, or end between the old and
+//  new query begins, can go in or out. They are found without looking at the
+//  rest.
+//
+//  Not thread safe.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ALGORITHMS_INTERVAL_INDEX_H__
+#define __MINERVA_CORE_ALGORITHMS_INTERVAL_INDEX_H__
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Algorithms {
+
+
+template < class KeyType, class ValueType > class IntervalIndex
+{
+public:
+
+  typedef std::vector<ValueType> Values;
+  typedef typename Values::size_type size_type;
+
+  IntervalIndex() : _begins(), _ends()
+  {
+  }
+
+  // Remove all the values.
+  void clear()
+  {
+    _begins.clear();
+    _ends.clear();
+  }
+
+  // Add the value. Empty intervals are not added. Use the same interval to remove it.
+  bool insert ( const ValueType& value, const KeyType& begin, const KeyType& end )
+  {
+    if ( false == ( begin < end ) )
+      return false;
+
+    _begins.insert ( typename Map::value_type ( begin, Entry ( end, value ) ) );
+    _ends.insert   ( typename Map::value_type ( end, Entry ( begin, value ) ) );
+    return true;
+  }
+
+  // Remove the value. The interval must be the one it was added with.
+  bool remove ( const ValueType& value, const KeyType& begin, const KeyType& end )
+  {
+    return IntervalIndex::_erase ( _begins, begin, value ) && IntervalIndex::_erase ( _ends, end, value );
+  }
+
+  // Does [begin0,end0) overlap [begin1,end1)? Both must not be empty.
+  static bool overlaps ( const KeyType& begin0, const KeyType& end0, const KeyType& begin1, const KeyType& end1 )
+  {
+    return ( begin0 < end1 ) && ( begin1 < end0 );
+  }
+
+  // Append the values that overlap the query and the ones that don't.
+  void query ( const KeyType& begin, const KeyType& end, Values& inside, Values& outside ) const
+  {
+    for ( typename Map::const_iterator iter = _begins.begin(); iter != _begins.end(); ++iter )
+    {
+      const bool in ( IntervalIndex::overlaps ( iter->first, iter->second.first, begin, end ) );
+      ( in ? inside : outside ).push_back ( iter->second.second );
+    }
+  }
+
+  // Append the values that start or stop overlapping when the query moves
+  // from [fromBegin,fromEnd) to [toBegin,toEnd). Neither may be empty.
+  void changes ( const KeyType& fromBegin, const KeyType& fromEnd,
+                 const KeyType& toBegin,   const KeyType& toEnd,
+                 Values& entered, Values& left ) const
+  {
+    // A value's begin is compared with the query's end. Only the ones with
+    // a begin in [low,high) compare differently.
+    const KeyType beginLow  ( std::min ( fromEnd, toEnd ) );
+    const KeyType beginHigh ( std::max ( fromEnd, toEnd ) );
+
+    typename Map::const_iterator stop ( _begins.lower_bound ( beginHigh ) );
+    for ( typename Map::const_iterator iter = _begins.lower_bound ( beginLow ); iter != stop; ++iter )
+    {
+      IntervalIndex::_change ( iter->first, iter->second.first, iter->second.second, fromBegin, fromEnd, toBegin, toEnd, entered, left );
+    }
+
+    // A value's end is compared with the query's begin. Only the ones with
+    // an end in (low,high] compare differently. Skip the ones found above.
+    const KeyType endLow  ( std::min ( fromBegin, toBegin ) );
+    const KeyType endHigh ( std::max ( fromBegin, toBegin ) );
+
+    stop = _ends.upper_bound ( endHigh );
+    for ( typename Map::const_iterator iter = _ends.upper_bound ( endLow ); iter != stop; ++iter )
+    {
+      const KeyType &begin ( iter->second.first );
+      if ( begin < beginLow || false == ( begin < beginHigh ) )
+        IntervalIndex::_change ( begin, iter->first, iter->second.second, fromBegin, fromEnd, toBegin, toEnd, entered, left );
+    }
+  }
+
+  // Get the number of values.
+  size_type size() const
+  {
+    return _begins.size();
+  }
+
+private:
+
+  // The other end point and the value.
+  typedef std::pair<KeyType,ValueType> Entry;
+  typedef std::multimap<KeyType,Entry> Map;
+
+  // No copying or assignment.
+  IntervalIndex ( const IntervalIndex& );
+  IntervalIndex& operator = ( const IntervalIndex& );
+
+  static bool _erase ( Map& map, const KeyType& key, const ValueType& value )
+  {
+    std::pair<typename Map::iterator,typename Map::iterator> range ( map.equal_range ( key ) );
+    for ( typename Map::iterator iter = range.first; iter != range.second; ++iter )
+    {
+      if ( iter->second.second == value )
+      {
+        map.erase ( iter );
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void _change ( const KeyType& begin, const KeyType& end, const ValueType& value,
+                        const KeyType& fromBegin, const KeyType& fromEnd,
+                        const KeyType& toBegin,   const KeyType& toEnd,
+                        Values& entered, Values& left )
+  {
+    const bool was ( IntervalIndex::overlaps ( begin, end, fromBegin, fromEnd ) );
+    const bool is  ( IntervalIndex::overlaps ( begin, end, toBegin, toEnd ) );
+
+    if ( is && !was )
+      entered.push_back ( value );
+    else if ( was && !is )
+      left.push_back ( value );
+  }
+
+  Map _begins;
+  Map _ends;
+};
+
+
+} // namespace Algorithms
+} // namespace Core
+} // namespace Minerva
+
+
+#endif // __MINERVA_CORE_ALGORITHMS_INTERVAL_INDEX_H__
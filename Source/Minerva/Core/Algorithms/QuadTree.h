@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Loose quad-tree of values with extents. The cells split the same way as
+//  the tile keys. A value lives in the deepest cell that contains its center
+//  and is at least as big as the value. Each cell is searched with bounds
+//  twice its size, so values that straddle a cell border still fit.
+//
+//  Not thread safe.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ALGORITHMS_QUAD_TREE_H__
+#define __MINERVA_CORE_ALGORITHMS_QUAD_TREE_H__
+
+#include "Minerva/Common/Extents.h"
+
+#include <utility>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Algorithms {
+
+
+template < class ValueType > class QuadTree
+{
+public:
+
+  typedef Minerva::Common::Extents Extents;
+  typedef std::vector<ValueType> Values;
+  typedef typename Values::size_type size_type;
+
+  QuadTree ( const Extents& bounds = Extents ( -180.0, -90.0, 180.0, 90.0 ), unsigned int maxDepth = 18 ) :
+    _bounds ( bounds ),
+    _maxDepth ( maxDepth ),
+    _root ( new Node )
+  {
+  }
+
+  ~QuadTree()
+  {
+    delete _root;
+  }
+
+  // Remove all the values.
+  void clear()
+  {
+    delete _root;
+    _root = new Node;
+  }
+
+  // Add the value. Use the same extents to remove it.
+  void insert ( const ValueType& value, const Extents& extents )
+  {
+    Node *node ( _root );
+    ++node->count;
+
+    Extents bounds ( _bounds );
+    for ( unsigned int depth = 0; depth < _maxDepth; ++depth )
+    {
+      const unsigned int quadrant ( QuadTree::_quadrant ( bounds, extents ) );
+      if ( QuadTree::NONE == quadrant )
+        break;
+
+      if ( 0x0 == node->children[quadrant] )
+        node->children[quadrant] = new Node;
+
+      node = node->children[quadrant];
+      ++node->count;
+      bounds = QuadTree::_child ( bounds, quadrant );
+    }
+
+    node->values.push_back ( Entry ( value, extents ) );
+  }
+
+  // Remove the value. The extents must be the ones it was added with.
+  bool remove ( const ValueType& value, const Extents& extents )
+  {
+    // Find the path to the cell.
+    Node *path[64] = { _root };
+    unsigned int quadrants[64] = { 0 };
+    unsigned int depth ( 0 );
+
+    Extents bounds ( _bounds );
+    for ( ; depth < _maxDepth && depth < 63; ++depth )
+    {
+      const unsigned int quadrant ( QuadTree::_quadrant ( bounds, extents ) );
+      if ( QuadTree::NONE == quadrant )
+        break;
+
+      Node *child ( path[depth]->children[quadrant] );
+      if ( 0x0 == child )
+        break;
+
+      path[depth + 1] = child;
+      quadrants[depth + 1] = quadrant;
+      bounds = QuadTree::_child ( bounds, quadrant );
+    }
+
+    Entries &values ( path[depth]->values );
+    typename Entries::iterator iter ( values.begin() );
+    while ( values.end() != iter && !( iter->first == value ) )
+      ++iter;
+
+    if ( values.end() == iter )
+      return false;
+
+    // Order doesn't matter within a cell.
+    *iter = values.back();
+    values.pop_back();
+
+    // Update the counts and delete the empty cells.
+    for ( unsigned int i = 0; i <= depth; ++i )
+      --path[i]->count;
+
+    for ( unsigned int i = depth; i > 0; --i )
+    {
+      if ( 0 == path[i]->count )
+      {
+        delete path[i];
+        path[i - 1]->children[quadrants[i]] = 0x0;
+      }
+    }
+
+    return true;
+  }
+
+  // Append the values with extents that intersect the given extents.
+  void query ( const Extents& extents, Values& results ) const
+  {
+    QuadTree::_query ( *_root, _bounds, extents, results );
+  }
+
+  // Get the number of values.
+  size_type size() const
+  {
+    return _root->count;
+  }
+
+private:
+
+  typedef std::pair<ValueType,Extents> Entry;
+  typedef std::vector<Entry> Entries;
+
+  enum { NONE = 4 };
+
+  struct Node
+  {
+    Node() : values(), count ( 0 )
+    {
+      children[0] = children[1] = children[2] = children[3] = 0x0;
+    }
+
+    ~Node()
+    {
+      for ( unsigned int i = 0; i < 4; ++i )
+        delete children[i];
+    }
+
+    Node *children[4];
+    Entries values;
+    size_type count;
+
+  private:
+
+    Node ( const Node& );
+    Node& operator = ( const Node& );
+  };
+
+  // No copying or assignment.
+  QuadTree ( const QuadTree& );
+  QuadTree& operator = ( const QuadTree& );
+
+  // Get the child cell that holds the extents, or NONE if they are too big 
+  // for the children. Anything outside the bounds stays in the root.
+  static unsigned int _quadrant ( const Extents& bounds, const Extents& extents )
+  {
+    const Extents::Vertex center ( extents.center() );
+    if ( false == bounds.contains ( center ) )
+      return NONE;
+
+    const double halfWidth  ( ( bounds.maxLon() - bounds.minLon() ) * 0.5 );
+    const double halfHeight ( ( bounds.maxLat() - bounds.minLat() ) * 0.5 );
+
+    if ( ( extents.maxLon() - extents.minLon() ) > halfWidth || ( extents.maxLat() - extents.minLat() ) > halfHeight )
+      return NONE;
+
+    const unsigned int column ( center[0] < bounds.minLon() + halfWidth  ? 0 : 1 );
+    const unsigned int row    ( center[1] < bounds.minLat() + halfHeight ? 0 : 2 );
+
+    // Same order as the tile keys: lower left, lower right, upper left, upper right.
+    return row + column;
+  }
+
+  // Get the bounds of the child cell.
+  static Extents _child ( const Extents& bounds, unsigned int quadrant )
+  {
+    Extents ll, lr, ul, ur;
+    bounds.split ( ll, lr, ul, ur );
+
+    switch ( quadrant )
+    {
+      case 0:  return ll;
+      case 1:  return lr;
+      case 2:  return ul;
+      default: return ur;
+    }
+  }
+
+  // Search the cell and its children.
+  static void _query ( const Node& node, const Extents& bounds, const Extents& extents, Values& results )
+  {
+    if ( 0 == node.count )
+      return;
+
+    for ( typename Entries::const_iterator iter = node.values.begin(); iter != node.values.end(); ++iter )
+    {
+      if ( iter->second.intersects ( extents ) )
+        results.push_back ( iter->first );
+    }
+
+    for ( unsigned int i = 0; i < 4; ++i )
+    {
+      const Node *child ( node.children[i] );
+      if ( 0x0 != child )
+      {
+        const Extents childBounds ( QuadTree::_child ( bounds, i ) );
+        if ( QuadTree::_loose ( childBounds ).intersects ( extents ) )
+          QuadTree::_query ( *child, childBounds, extents, results );
+      }
+    }
+  }
+
+  // Get the loose bounds of the cell.
+  static Extents _loose ( const Extents& bounds )
+  {
+    const double halfWidth  ( ( bounds.maxLon() - bounds.minLon() ) * 0.5 );
+    const double halfHeight ( ( bounds.maxLat() - bounds.minLat() ) * 0.5 );
+    return Extents ( bounds.minLon() - halfWidth, bounds.minLat() - halfHeight, bounds.maxLon() + halfWidth, bounds.maxLat() + halfHeight );
+  }
+
+  Extents _bounds;
+  unsigned int _maxDepth;
+  Node *_root;
+};
+
+
+} // namespace Algorithms
+} // namespace Core
+} // namespace Minerva
+
+
+#endif // __MINERVA_CORE_ALGORITHMS_QUAD_TREE_H__
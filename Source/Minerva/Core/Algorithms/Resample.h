@@ -16,6 +16,8 @@
 #include "Minerva/Common/IElevationDatabase.h"
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace Minerva {
 namespace Core {
@@ -38,41 +40,66 @@ namespace Detail
 
 
 
-  template < typename Point, typename ParmetricPoints >
+  // Bisect the segments between the points until the midpoints are on the 
+  // ground, adding the midpoints to the end. The segments are split one 
+  // level at a time so the elevations for a whole level come from one query.
+  template < typename ParametricPoints >
   void bisect ( 
-               Point &point0, 
-               Point &point2, 
-               ParmetricPoints& answer, 
-               unsigned int depth, 
+               ParametricPoints& points, 
                unsigned int maximumDepth, 
                Minerva::Common::IElevationDatabase* elevation )
   {
-    if( depth > maximumDepth )
-      return;
-
-    double u1 ( ( point0.u + point2.u ) * 0.50 );
-
-    double lat1 ( ( point0.p[1] + point2.p[1] ) * 0.50 );
-    double lon1 ( ( point0.p[0] + point2.p[0] ) * 0.50 );
-    double height1 ( ( point0.p[2] + point2.p[2] ) * 0.50 );
+    typedef typename ParametricPoints::value_type Point;
+    typedef std::pair < Point, Point > Segment;
+    typedef std::vector < Segment > Segments;
 
-    const double height ( ( elevation ) ? elevation->elevationAtLatLong ( lat1, lon1 ) : 0.0 );
+    Segments segments;
+    segments.reserve ( points.size() );
+    for ( unsigned int i = 0; i + 1 < points.size(); ++i )
+      segments.push_back ( Segment ( points[i], points[i + 1] ) );
 
     /// one cm resolution
     const double errorFactor ( 0.01 );
 
-    if( Usul::Math::absolute ( height - height1 ) < errorFactor )
-      return;
+    // Each level adds two to the depth.
+    for ( unsigned int depth = 0; depth <= maximumDepth && false == segments.empty(); depth += 2 )
+    {
+      const unsigned int size ( segments.size() );
+      std::vector<double> lat ( size ), lon ( size ), heights ( size, 0.0 );
+
+      for ( unsigned int i = 0; i < size; ++i )
+      {
+        lat[i] = ( segments[i].first.p[1] + segments[i].second.p[1] ) * 0.50;
+        lon[i] = ( segments[i].first.p[0] + segments[i].second.p[0] ) * 0.50;
+      }
+
+      if ( 0x0 != elevation )
+        elevation->elevations ( &lat[0], &lon[0], &heights[0], size );
+
+      Segments next;
+      next.reserve ( size * 2 );
+
+      for ( unsigned int i = 0; i < size; ++i )
+      {
+        const Point &point0 ( segments[i].first );
+        const Point &point2 ( segments[i].second );
 
-    Point midPoint;
-    midPoint.p = typename Point::PointType ( lon1, lat1, height );
-    midPoint.u = u1;
+        const double height1 ( ( point0.p[2] + point2.p[2] ) * 0.50 );
+        if( Usul::Math::absolute ( heights[i] - height1 ) < errorFactor )
+          continue;
 
-    answer.push_back ( midPoint );
+        Point midPoint;
+        midPoint.p = typename Point::PointType ( lon[i], lat[i], heights[i] );
+        midPoint.u = ( point0.u + point2.u ) * 0.50;
 
-    ++depth;
-    bisect ( point0, midPoint, answer, depth + 1, maximumDepth, elevation );
-    bisect ( midPoint, point2, answer, depth + 1, maximumDepth, elevation );
+        points.push_back ( midPoint );
+
+        next.push_back ( Segment ( point0, midPoint ) );
+        next.push_back ( Segment ( midPoint, point2 ) );
+      }
+
+      segments.swap ( next );
+    }
   }
 }
 
@@ -113,19 +140,8 @@ namespace Detail
       points.push_back ( p );
     }
 
-    const unsigned int size ( points.size() );
-
-    // Run through the line segments.
-    for( unsigned int i = 0; i < size - 1; ++i )
-    {
-      UPoint point0 ( points.at( i ) );
-      UPoint point1 ( points.at( i + 1 ) );
-
-      unsigned int depth ( 0 );
-
-      // bisect.
-      bisect ( point0, point1, points, depth, maximumDepth, elevation );
-    }
+    // Bisect the line segments.
+    Detail::bisect ( points, maximumDepth, elevation );
 
     std::sort ( points.begin(), points.end() );
 
@@ -1,4 +1,3 @@
-
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Copyright (c) 2008, Adam Kubach
@@ -9,6 +8,11 @@
 
 #include "Minerva/Core/Algorithms/ResampleElevation.h"
 #include "Minerva/Core/ElevationData.h"
+#include "Minerva/Core/TileEngine/Mesh.h"
+
+#include "Usul/Math/MinMax.h"
+
+#include <vector>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -27,28 +31,107 @@ Minerva::Common::IElevationData* Minerva::Core::Algorithms::resampleElevation (
   const MeshSize meshSize ( tile->meshSize() );
   const MeshSize::value_type rows ( meshSize[0] );
   const MeshSize::value_type columns ( meshSize[1] );
-  
-  Minerva::Core::ElevationData::RefPtr answer ( new Minerva::Core::ElevationData ( rows, columns ) );
-  
-  const Extents::Vertex &mn ( request.minimum() );
-  const Extents::Vertex &mx ( request.maximum() );
-    
-  // For each lat/lon location in the image, ask the parent for it's value.
-  for ( int i = rows - 1; i >= 0; --i )
+
+  Minerva::Common::IElevationData::RefPtr elevation ( tile->elevationData() );
+
+  // The mesh is flat when the data doesn't fit it, so the answer is too.
+  if ( false == elevation.valid() || rows != elevation->height() || columns != elevation->width() )
+    return new Minerva::Core::ElevationData ( rows, columns );
+
+  return Minerva::Core::Algorithms::resampleElevation ( *elevation, tile->extents(), request, rows, columns );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Find the cell and where in it for each sample along one side of the grid.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  void cells ( double first, double step, unsigned int samples, unsigned int size, std::vector<unsigned int>& cells, std::vector<double>& weights )
   {
-    const double u ( 1.0 - static_cast<double> ( i ) / ( rows - 1 ) );
-    
-    for ( MeshSize::value_type j = 0; j < columns; ++j )
+    cells.resize ( samples );
+    weights.resize ( samples );
+
+    for ( unsigned int i = 0; i < samples; ++i )
     {
-      const double v ( static_cast<double> ( j ) / ( columns - 1 ) );
-      
-      const double lon ( mn[0] + u * ( mx[0] - mn[0] ) );
-      const double lat ( mn[1] + v * ( mx[1] - mn[1] ) );
-      
-      const double heightAboveSeaLevel ( tile->elevation ( lat, lon ) );
-      answer->value ( rows - i - 1, j, heightAboveSeaLevel );
+      const double x ( Usul::Math::maximum ( first + i * step, 0.0 ) );
+      const unsigned int cell ( Usul::Math::minimum ( static_cast<unsigned int> ( x ), size - 2 ) );
+      cells[i] = cell;
+      weights[i] = x - cell;
     }
   }
-  
-  return answer.release();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Resample the part of the grid in the request extents. The grid is in the 
+//  same layout the mesh reads it: row r is at longitude r / ( rows - 1 ) 
+//  across the extents and column c is at latitude c / ( columns - 1 ). 
+//  The cells and weights are found once per row and column, so the loop 
+//  over the samples only interpolates.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Minerva::Common::IElevationData* Minerva::Core::Algorithms::resampleElevation ( const Minerva::Common::IElevationData& grid, 
+                                                                                  const Extents& extents, 
+                                                                                  const Extents& request, 
+                                                                                  unsigned int rows, 
+                                                                                  unsigned int columns )
+{
+  typedef Minerva::Common::IElevationData::ValueType ValueType;
+  typedef Minerva::Core::TileEngine::Mesh Mesh;
+
+  const unsigned int gridRows ( grid.height() );
+  const unsigned int gridColumns ( grid.width() );
+
+  if ( rows < 2 || columns < 2 || gridRows < 2 || gridColumns < 2 )
+    return new Minerva::Core::ElevationData ( rows, columns );
+
+  // Copy the grid in the mesh's order, with row zero at the maximum longitude.
+  std::vector<double> heights ( gridRows * gridColumns );
+  for ( unsigned int i = 0; i < gridRows; ++i )
+  {
+    for ( unsigned int j = 0; j < gridColumns; ++j )
+    {
+      heights[i * gridColumns + j] = grid.value ( gridRows - i - 1, j );
+    }
+  }
+
+  const Extents::Vertex &mn ( extents.minimum() );
+  const Extents::Vertex &mx ( extents.maximum() );
+  const Extents::Vertex &rmn ( request.minimum() );
+  const Extents::Vertex &rmx ( request.maximum() );
+
+  // Sample positions in grid units. The answer's rows go from the minimum 
+  // longitude, which is the last row of the mesh order.
+  const double lonScale ( ( gridRows - 1 ) / ( mx[0] - mn[0] ) );
+  const double latScale ( ( gridColumns - 1 ) / ( mx[1] - mn[1] ) );
+
+  std::vector<unsigned int> rowCells, columnCells;
+  std::vector<double> rowWeights, columnWeights;
+  Detail::cells ( ( mx[0] - rmn[0] ) * lonScale, -( rmx[0] - rmn[0] ) * lonScale / ( rows - 1 ), rows, gridRows, rowCells, rowWeights );
+  Detail::cells ( ( rmn[1] - mn[1] ) * latScale,  ( rmx[1] - rmn[1] ) * latScale / ( columns - 1 ), columns, gridColumns, columnCells, columnWeights );
+
+  std::vector<ValueType> answer ( rows * columns );
+
+  for ( unsigned int r = 0; r < rows; ++r )
+  {
+    const double *row0 ( &heights[rowCells[r] * gridColumns] );
+    const double *row1 ( row0 + gridColumns );
+    const double s ( rowWeights[r] );
+
+    ValueType *out ( &answer[r * columns] );
+
+    for ( unsigned int c = 0; c < columns; ++c )
+    {
+      const unsigned int j ( columnCells[c] );
+      out[c] = static_cast<ValueType> ( Mesh::interpolate ( row0[j], row1[j], row0[j + 1], row1[j + 1], s, columnWeights[c] ) );
+    }
+  }
+
+  return new Minerva::Core::ElevationData ( rows, columns, answer );
 }
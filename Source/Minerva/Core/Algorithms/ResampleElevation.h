@@ -24,8 +24,17 @@ namespace Algorithms {
   typedef Minerva::Core::TileEngine::Tile Tile;
   typedef Minerva::Core::TileEngine::Extents Extents;
 
+  // Resample the tile's elevation for the request extents, at the tile's mesh size.
   MINERVA_EXPORT Minerva::Common::IElevationData* resampleElevation ( Tile::RefPtr tile, const Extents& request );
 
+  // Resample the part of the grid in the request extents into a rows x columns grid.
+  // The heights are interpolated on the same triangles the mesh draws.
+  MINERVA_EXPORT Minerva::Common::IElevationData* resampleElevation ( const Minerva::Common::IElevationData& grid, 
+                                                                      const Extents& extents, 
+                                                                      const Extents& request, 
+                                                                      unsigned int rows, 
+                                                                      unsigned int columns );
+
 }
 }
 }
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Douglas-Peucker line simplification. Only the first two components of
+//  each point are used.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ALGORITHMS_SIMPLIFY_H__
+#define __MINERVA_CORE_ALGORITHMS_SIMPLIFY_H__
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Algorithms {
+namespace Detail
+{
+  // Squared distance from p to the segment from a to b.
+  template < typename Point >
+  inline double distanceSquared ( const Point& p, const Point& a, const Point& b )
+  {
+    const double dx ( b[0] - a[0] );
+    const double dy ( b[1] - a[1] );
+    const double lengthSquared ( dx * dx + dy * dy );
+
+    double u ( 0.0 );
+    if ( lengthSquared > 0.0 )
+    {
+      u = ( ( p[0] - a[0] ) * dx + ( p[1] - a[1] ) * dy ) / lengthSquared;
+      u = std::max ( 0.0, std::min ( 1.0, u ) );
+    }
+
+    const double x ( a[0] + u * dx - p[0] );
+    const double y ( a[1] + u * dy - p[1] );
+    return x * x + y * y;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Find the indices of the points to keep so that no point that is dropped
+//  is further than the tolerance from the simplified line. The first and
+//  last points are always kept. The indices are in increasing order.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < typename Points >
+inline void simplify ( const Points& points, double tolerance, std::vector<unsigned int>& keep )
+{
+  keep.clear();
+
+  const unsigned int size ( points.size() );
+  if ( size < 3 )
+  {
+    for ( unsigned int i = 0; i < size; ++i )
+      keep.push_back ( i );
+    return;
+  }
+
+  const double toleranceSquared ( tolerance * tolerance );
+
+  std::vector<bool> marked ( size, false );
+  marked.front() = true;
+  marked.back() = true;
+
+  // Use a stack instead of recursion, long ways have thousands of points.
+  typedef std::pair<unsigned int, unsigned int> Range;
+  std::vector<Range> stack;
+  stack.push_back ( Range ( 0, size - 1 ) );
+
+  while ( false == stack.empty() )
+  {
+    const Range range ( stack.back() );
+    stack.pop_back();
+
+    double maximum ( 0.0 );
+    unsigned int index ( range.first );
+
+    for ( unsigned int i = range.first + 1; i < range.second; ++i )
+    {
+      const double d ( Detail::distanceSquared ( points[i], points[range.first], points[range.second] ) );
+      if ( d > maximum )
+      {
+        maximum = d;
+        index = i;
+      }
+    }
+
+    if ( maximum > toleranceSquared )
+    {
+      marked[index] = true;
+      stack.push_back ( Range ( range.first, index ) );
+      stack.push_back ( Range ( index, range.second ) );
+    }
+  }
+
+  for ( unsigned int i = 0; i < size; ++i )
+  {
+    if ( marked[i] )
+      keep.push_back ( i );
+  }
+}
+
+
+}
+}
+}
+
+#endif // __MINERVA_CORE_ALGORITHMS_SIMPLIFY_H__
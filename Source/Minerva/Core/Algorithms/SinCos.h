@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sine and cosine of arrays of angles in degrees. The angle is reduced to
+//  [-45,45] degrees by subtracting a multiple of 90, which is exact enough
+//  in degrees, and then the fdlibm kernel polynomials are used. Angles must
+//  be less than 2^31 quarter turns. With SSE2 math there are no branches or
+//  library calls in the loop, so the compiler can vectorize it. The answer
+//  is within a couple of ulps of std::sin and std::cos.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ALGORITHMS_SIN_COS_H__
+#define __MINERVA_CORE_ALGORITHMS_SIN_COS_H__
+
+#include "Usul/Math/Constants.h"
+
+#include <cmath>
+
+// Rounding by adding and subtracting 1.5 * 2^52 needs each operation to be
+// done in double precision. That isn't so with x87 math, or when the 
+// compiler is allowed to reassociate, so floor is used then.
+#if !defined ( __FAST_MATH__ ) && !defined ( _M_FP_FAST ) && \
+    ( ( defined ( __FLT_EVAL_METHOD__ ) && 0 == __FLT_EVAL_METHOD__ ) || \
+      defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+# define MINERVA_SIN_COS_ROUND_WITH_CONSTANT
+#endif
+
+namespace Minerva {
+namespace Core {
+namespace Algorithms {
+namespace Detail
+{
+  // Round to the nearest integer. Either way of breaking a tie is fine here.
+  inline double nearestInteger ( double value )
+  {
+#ifdef MINERVA_SIN_COS_ROUND_WITH_CONSTANT
+    // No call to floor, which would keep the loop from vectorizing.
+    const double round ( 6755399441055744.0 );
+    return ( value + round ) - round;
+#else
+    return std::floor ( value + 0.5 );
+#endif
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sine and cosine of one angle in degrees.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+inline void sinCosDegrees ( double degrees, double& s, double& c )
+{
+  // Which quarter turn, and what is left over.
+  const double turns ( Detail::nearestInteger ( degrees / 90.0 ) );
+  const double x ( ( degrees - turns * 90.0 ) * Usul::Math::DEG_TO_RAD );
+  const int quadrant ( static_cast<int> ( turns ) & 3 );
+
+  const double z ( x * x );
+
+  const double sx ( x + x * z * ( -1.66666666666666324348e-01 + z * ( 8.33333333332248946124e-03 +
+                    z * ( -1.98412698298579493134e-04 + z * ( 2.75573137070700676789e-06 +
+                    z * ( -2.50507602534068634195e-08 + z * 1.58969099521155010221e-10 ) ) ) ) ) );
+
+  const double cx ( 1.0 - 0.5 * z + z * z * ( 4.16666666666666019037e-02 + z * ( -1.38888888888741095749e-03 +
+                    z * ( 2.48015872894767294178e-05 + z * ( -2.75573143513906633035e-07 +
+                    z * ( 2.08757232129817482790e-09 + z * -1.13596475577881948265e-11 ) ) ) ) ) );
+
+  // Rotate by the quarter turns. This is arithmetic instead of a branch so
+  // that the loop below vectorizes. Multiplying by one or zero is exact.
+  const double swap ( quadrant & 1 );
+  const double sinSign ( 1 - ( quadrant & 2 ) );
+  const double cosSign ( 1 - ( ( quadrant + 1 ) & 2 ) );
+
+  s = sinSign * ( swap * cx + ( 1.0 - swap ) * sx );
+  c = cosSign * ( swap * sx + ( 1.0 - swap ) * cx );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sine and cosine of n angles in degrees.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+inline void sinCosDegrees ( const double* degrees, double* s, double* c, unsigned int n )
+{
+  for ( unsigned int i = 0; i < n; ++i )
+  {
+    Minerva::Core::Algorithms::sinCosDegrees ( degrees[i], s[i], c[i] );
+  }
+}
+
+
+}
+}
+}
+
+#endif // __MINERVA_CORE_ALGORITHMS_SIN_COS_H__
@@ -10,6 +10,9 @@
 #ifndef __MINERVA_CORE_ALGORITHMS_SUB_REGION_H__
 #define __MINERVA_CORE_ALGORITHMS_SUB_REGION_H__
 
+#include "Usul/Math/MinMax.h"
+#include "Usul/Math/Vector4.h"
+
 #include "osg/Image"
 
 #include <cstring>
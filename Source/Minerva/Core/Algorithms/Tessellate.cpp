@@ -0,0 +1,942 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Ear-clipping tessellation of planar polygons with holes.
+//
+//  The rings are kept as circular lists of nodes. An ear is a convex corner
+//  with no reflex corner inside it. When no ear is left the points are
+//  cleaned up, then small self-intersections are cut off, and last the
+//  polygon is split along a valid diagonal. For large rings the nodes are
+//  also kept in z-order, so only the nodes near a corner are checked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/Tessellate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+
+using namespace Minerva::Core::Algorithms;
+
+
+namespace Detail
+{
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  A corner of a ring.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  struct Node
+  {
+    Node ( unsigned int index, double x_, double y_ ) :
+      i ( index ),
+      x ( x_ ),
+      y ( y_ ),
+      prev ( 0x0 ),
+      next ( 0x0 ),
+      z ( 0 ),
+      prevZ ( 0x0 ),
+      nextZ ( 0x0 ),
+      steiner ( false )
+    {
+    }
+
+    unsigned int i;
+    double x;
+    double y;
+    Node *prev;
+    Node *next;
+    unsigned int z;
+    Node *prevZ;
+    Node *nextZ;
+    bool steiner;
+  };
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Makes the triangles. The nodes live as long as it does.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  class Tessellator
+  {
+  public:
+
+    Tessellator ( const TessellatePoints& points, TessellateIndices& triangles ) :
+      _points ( points ),
+      _triangles ( triangles ),
+      _nodes(),
+      _minX ( 0.0 ),
+      _minY ( 0.0 ),
+      _invSize ( 0.0 )
+    {
+    }
+
+    void run ( const TessellateIndices& ringSizes );
+
+  private:
+
+    static double area ( const Node *p, const Node *q, const Node *r )
+    {
+      return ( q->y - p->y ) * ( r->x - q->x ) - ( q->x - p->x ) * ( r->y - q->y );
+    }
+
+    static bool equals ( const Node *a, const Node *b )
+    {
+      return ( a->x == b->x && a->y == b->y );
+    }
+
+    static int sign ( double value )
+    {
+      return ( value > 0.0 ? 1 : ( value < 0.0 ? -1 : 0 ) );
+    }
+
+    static bool pointInTriangle ( double ax, double ay, double bx, double by, double cx, double cy, double px, double py )
+    {
+      return ( ( cx - px ) * ( ay - py ) >= ( ax - px ) * ( cy - py ) &&
+               ( ax - px ) * ( by - py ) >= ( bx - px ) * ( ay - py ) &&
+               ( bx - px ) * ( cy - py ) >= ( cx - px ) * ( by - py ) );
+    }
+
+    static bool onSegment ( const Node *p, const Node *q, const Node *r )
+    {
+      return ( q->x <= std::max ( p->x, r->x ) && q->x >= std::min ( p->x, r->x ) &&
+               q->y <= std::max ( p->y, r->y ) && q->y >= std::min ( p->y, r->y ) );
+    }
+
+    static bool intersects ( const Node *p1, const Node *q1, const Node *p2, const Node *q2 );
+    static bool intersectsPolygon ( const Node *a, const Node *b );
+    static bool locallyInside ( const Node *a, const Node *b );
+    static bool middleInside ( const Node *a, const Node *b );
+    static bool isValidDiagonal ( const Node *a, const Node *b );
+    static bool sectorContainsSector ( const Node *m, const Node *p );
+    static void removeNode ( Node *p );
+    static Node* leftmost ( Node *start );
+
+    Node*         _insertNode ( unsigned int i, Node *last );
+    Node*         _linkedList ( unsigned int start, unsigned int end, bool clockwise );
+    Node*         _filterPoints ( Node *start, Node *end = 0x0 );
+    Node*         _splitPolygon ( Node *a, Node *b );
+    Node*         _eliminateHoles ( const TessellateIndices& ringSizes, Node *outer );
+    Node*         _eliminateHole ( Node *hole, Node *outer );
+    Node*         _findHoleBridge ( Node *hole, Node *outer );
+    Node*         _cureLocalIntersections ( Node *start );
+    void          _earcutLinked ( Node *ear, int pass );
+    void          _splitEarcut ( Node *start );
+    bool          _isEar ( const Node *ear ) const;
+    bool          _isEarHashed ( const Node *ear ) const;
+    void          _indexCurve ( Node *start );
+    unsigned int  _zOrder ( double x, double y ) const;
+    void          _triangle ( const Node *a, const Node *b, const Node *c );
+
+    double        _signedArea ( unsigned int start, unsigned int end ) const;
+
+    const TessellatePoints &_points;
+    TessellateIndices &_triangles;
+    std::deque<Node> _nodes;
+    double _minX;
+    double _minY;
+    double _invSize;
+  };
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Do the segments cross or touch?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::intersects ( const Node *p1, const Node *q1, const Node *p2, const Node *q2 )
+  {
+    const int o1 ( sign ( area ( p1, q1, p2 ) ) );
+    const int o2 ( sign ( area ( p1, q1, q2 ) ) );
+    const int o3 ( sign ( area ( p2, q2, p1 ) ) );
+    const int o4 ( sign ( area ( p2, q2, q1 ) ) );
+
+    if ( o1 != o2 && o3 != o4 )
+      return true;
+
+    // Collinear and on the other segment.
+    if ( 0 == o1 && onSegment ( p1, p2, q1 ) ) return true;
+    if ( 0 == o2 && onSegment ( p1, q2, q1 ) ) return true;
+    if ( 0 == o3 && onSegment ( p2, p1, q2 ) ) return true;
+    if ( 0 == o4 && onSegment ( p2, q1, q2 ) ) return true;
+
+    return false;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Does the diagonal cross any edge of the polygon?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::intersectsPolygon ( const Node *a, const Node *b )
+  {
+    const Node *p ( a );
+    do
+    {
+      if ( p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && intersects ( p, p->next, a, b ) )
+        return true;
+      p = p->next;
+    }
+    while ( p != a );
+
+    return false;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the diagonal inside the polygon near a?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::locallyInside ( const Node *a, const Node *b )
+  {
+    return ( area ( a->prev, a, a->next ) < 0.0 ) ?
+      ( area ( a, b, a->next ) >= 0.0 && area ( a, a->prev, b ) >= 0.0 ) :
+      ( area ( a, b, a->prev ) < 0.0 || area ( a, a->next, b ) < 0.0 );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the middle of the diagonal inside the polygon?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::middleInside ( const Node *a, const Node *b )
+  {
+    const Node *p ( a );
+    bool inside ( false );
+    const double px ( ( a->x + b->x ) / 2.0 );
+    const double py ( ( a->y + b->y ) / 2.0 );
+
+    do
+    {
+      if ( ( ( p->y > py ) != ( p->next->y > py ) ) && p->next->y != p->y &&
+           ( px < ( p->next->x - p->x ) * ( py - p->y ) / ( p->next->y - p->y ) + p->x ) )
+      {
+        inside = !inside;
+      }
+      p = p->next;
+    }
+    while ( p != a );
+
+    return inside;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Can the polygon be split along the diagonal?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::isValidDiagonal ( const Node *a, const Node *b )
+  {
+    if ( a->next->i == b->i || a->prev->i == b->i || intersectsPolygon ( a, b ) )
+      return false;
+
+    // It's inside and doesn't make a flat corner...
+    if ( locallyInside ( a, b ) && locallyInside ( b, a ) && middleInside ( a, b ) &&
+         ( 0.0 != area ( a->prev, a, b->prev ) || 0.0 != area ( a, b->prev, b ) ) )
+    {
+      return true;
+    }
+
+    // ... or it has no length between two convex corners.
+    return ( equals ( a, b ) && area ( a->prev, a, a->next ) > 0.0 && area ( b->prev, b, b->next ) > 0.0 );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the corner at p inside the corner at m?
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::sectorContainsSector ( const Node *m, const Node *p )
+  {
+    return ( area ( m->prev, m, p->prev ) < 0.0 && area ( p->next, m, m->next ) < 0.0 );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Take the node out of both lists.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  void Tessellator::removeNode ( Node *p )
+  {
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+
+    if ( 0x0 != p->prevZ )
+      p->prevZ->nextZ = p->nextZ;
+    if ( 0x0 != p->nextZ )
+      p->nextZ->prevZ = p->prevZ;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Find the left-most node of the ring.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::leftmost ( Node *start )
+  {
+    Node *p ( start ), *answer ( start );
+    do
+    {
+      if ( p->x < answer->x || ( p->x == answer->x && p->y < answer->y ) )
+        answer = p;
+      p = p->next;
+    }
+    while ( p != start );
+
+    return answer;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Add a node after the last one.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_insertNode ( unsigned int i, Node *last )
+  {
+    _nodes.push_back ( Node ( i, _points[i][0], _points[i][1] ) );
+    Node *p ( &_nodes.back() );
+
+    if ( 0x0 == last )
+    {
+      p->prev = p;
+      p->next = p;
+    }
+    else
+    {
+      p->next = last->next;
+      p->prev = last;
+      last->next->prev = p;
+      last->next = p;
+    }
+
+    return p;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Twice the signed area of the ring. Positive when it's clockwise.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  double Tessellator::_signedArea ( unsigned int start, unsigned int end ) const
+  {
+    double sum ( 0.0 );
+    for ( unsigned int i = start, j = end - 1; i < end; j = i++ )
+    {
+      sum += ( _points[j][0] - _points[i][0] ) * ( _points[i][1] + _points[j][1] );
+    }
+    return sum;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Make a circular list of the ring, in the given winding.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_linkedList ( unsigned int start, unsigned int end, bool clockwise )
+  {
+    Node *last ( 0x0 );
+    if ( end <= start )
+      return last;
+
+    if ( clockwise == ( this->_signedArea ( start, end ) > 0.0 ) )
+    {
+      for ( unsigned int i = start; i < end; ++i )
+        last = this->_insertNode ( i, last );
+    }
+    else
+    {
+      for ( unsigned int i = end; i > start; --i )
+        last = this->_insertNode ( i - 1, last );
+    }
+
+    // Drop the first point if it's repeated at the end.
+    if ( 0x0 != last && last != last->next && equals ( last, last->next ) )
+    {
+      removeNode ( last );
+      last = last->next;
+    }
+
+    return last;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Remove repeated points and flat corners.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_filterPoints ( Node *start, Node *end )
+  {
+    if ( 0x0 == start )
+      return start;
+    if ( 0x0 == end )
+      end = start;
+
+    Node *p ( start );
+    bool again ( false );
+    do
+    {
+      again = false;
+
+      if ( false == p->steiner && ( equals ( p, p->next ) || 0.0 == area ( p->prev, p, p->next ) ) )
+      {
+        removeNode ( p );
+        p = end = p->prev;
+        if ( p == p->next )
+          break;
+        again = true;
+      }
+      else
+      {
+        p = p->next;
+      }
+    }
+    while ( again || p != end );
+
+    return end;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Split the polygon in two along the diagonal. Returns the copy of b.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_splitPolygon ( Node *a, Node *b )
+  {
+    _nodes.push_back ( Node ( a->i, a->x, a->y ) );
+    Node *a2 ( &_nodes.back() );
+    _nodes.push_back ( Node ( b->i, b->x, b->y ) );
+    Node *b2 ( &_nodes.back() );
+
+    Node *an ( a->next );
+    Node *bp ( b->prev );
+
+    a->next = b;
+    b->prev = a;
+
+    a2->next = an;
+    an->prev = a2;
+
+    b2->next = a2;
+    a2->prev = b2;
+
+    bp->next = b2;
+    b2->prev = bp;
+
+    return b2;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Join the holes to the outer ring, from left to right.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  struct CompareX
+  {
+    bool operator() ( const Node *a, const Node *b ) const
+    {
+      return ( a->x < b->x );
+    }
+  };
+
+  Node* Tessellator::_eliminateHoles ( const TessellateIndices& ringSizes, Node *outer )
+  {
+    std::vector<Node*> queue;
+    queue.reserve ( ringSizes.size() );
+
+    unsigned int start ( ringSizes.front() );
+    for ( unsigned int r = 1; r < ringSizes.size(); ++r )
+    {
+      const unsigned int end ( std::min<unsigned int> ( start + ringSizes[r], _points.size() ) );
+      Node *list ( this->_linkedList ( start, end, false ) );
+      start = end;
+
+      if ( 0x0 == list )
+        continue;
+
+      if ( list == list->next )
+        list->steiner = true;
+
+      queue.push_back ( leftmost ( list ) );
+    }
+
+    std::sort ( queue.begin(), queue.end(), CompareX() );
+
+    for ( unsigned int i = 0; i < queue.size(); ++i )
+    {
+      outer = this->_eliminateHole ( queue[i], outer );
+    }
+
+    return outer;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Join the hole to the outer ring with a bridge.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_eliminateHole ( Node *hole, Node *outer )
+  {
+    Node *bridge ( this->_findHoleBridge ( hole, outer ) );
+    if ( 0x0 == bridge )
+      return outer;
+
+    Node *bridgeReverse ( this->_splitPolygon ( bridge, hole ) );
+
+    // Filter the collinear points around the cuts.
+    this->_filterPoints ( bridgeReverse, bridgeReverse->next );
+    return this->_filterPoints ( bridge, bridge->next );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Find the outer node that the hole's left-most node can connect to.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_findHoleBridge ( Node *hole, Node *outer )
+  {
+    Node *p ( outer );
+    const double hx ( hole->x );
+    const double hy ( hole->y );
+    double qx ( -std::numeric_limits<double>::max() );
+    Node *m ( 0x0 );
+
+    // Find the closest edge to the left of the hole's point, on the same
+    // horizontal line. The end of the edge furthest left may connect.
+    do
+    {
+      if ( hy <= p->y && hy >= p->next->y && p->next->y != p->y )
+      {
+        const double x ( p->x + ( hy - p->y ) * ( p->next->x - p->x ) / ( p->next->y - p->y ) );
+        if ( x <= hx && x > qx )
+        {
+          qx = x;
+          m = ( p->x < p->next->x ? p : p->next );
+          if ( x == hx )
+            return m;
+        }
+      }
+      p = p->next;
+    }
+    while ( p != outer );
+
+    if ( 0x0 == m )
+      return 0x0;
+
+    // Look for points inside the triangle of the hole's point, the edge
+    // crossing and m. The one with the smallest angle is used instead.
+    const Node *stop ( m );
+    const double mx ( m->x );
+    const double my ( m->y );
+    double tanMin ( std::numeric_limits<double>::max() );
+
+    p = m;
+    do
+    {
+      if ( hx >= p->x && p->x >= mx && hx != p->x &&
+           pointInTriangle ( hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y ) )
+      {
+        const double tan ( std::abs ( hy - p->y ) / ( hx - p->x ) );
+
+        if ( locallyInside ( p, hole ) &&
+             ( tan < tanMin || ( tan == tanMin && ( p->x > m->x || ( p->x == m->x && sectorContainsSector ( m, p ) ) ) ) ) )
+        {
+          m = p;
+          tanMin = tan;
+        }
+      }
+
+      p = p->next;
+    }
+    while ( p != stop );
+
+    return m;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Cut off the small self-intersections.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  Node* Tessellator::_cureLocalIntersections ( Node *start )
+  {
+    Node *p ( start );
+    do
+    {
+      Node *a ( p->prev );
+      Node *b ( p->next->next );
+
+      if ( false == equals ( a, b ) && intersects ( a, p, p->next, b ) && locallyInside ( a, b ) && locallyInside ( b, a ) )
+      {
+        this->_triangle ( a, p, b );
+
+        removeNode ( p );
+        removeNode ( p->next );
+
+        p = start = b;
+      }
+      p = p->next;
+    }
+    while ( p != start );
+
+    return this->_filterPoints ( p );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Split the polygon along a valid diagonal and tessellate both parts.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  void Tessellator::_splitEarcut ( Node *start )
+  {
+    Node *a ( start );
+    do
+    {
+      Node *b ( a->next->next );
+      while ( b != a->prev )
+      {
+        if ( a->i != b->i && isValidDiagonal ( a, b ) )
+        {
+          Node *c ( this->_splitPolygon ( a, b ) );
+
+          a = this->_filterPoints ( a, a->next );
+          c = this->_filterPoints ( c, c->next );
+
+          this->_earcutLinked ( a, 0 );
+          this->_earcutLinked ( c, 0 );
+          return;
+        }
+        b = b->next;
+      }
+      a = a->next;
+    }
+    while ( a != start );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Cut off ears until there is one triangle left.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  void Tessellator::_earcutLinked ( Node *ear, int pass )
+  {
+    if ( 0x0 == ear )
+      return;
+
+    if ( 0 == pass && 0.0 != _invSize )
+      this->_indexCurve ( ear );
+
+    Node *stop ( ear );
+
+    while ( ear->prev != ear->next )
+    {
+      Node *prev ( ear->prev );
+      Node *next ( ear->next );
+
+      if ( 0.0 != _invSize ? this->_isEarHashed ( ear ) : this->_isEar ( ear ) )
+      {
+        this->_triangle ( prev, ear, next );
+        removeNode ( ear );
+
+        // Skipping the next corner leaves fewer slivers.
+        ear = next->next;
+        stop = next->next;
+        continue;
+      }
+
+      ear = next;
+
+      // Went all the way around without an ear.
+      if ( ear == stop )
+      {
+        if ( 0 == pass )
+        {
+          this->_earcutLinked ( this->_filterPoints ( ear ), 1 );
+        }
+        else if ( 1 == pass )
+        {
+          ear = this->_cureLocalIntersections ( this->_filterPoints ( ear ) );
+          this->_earcutLinked ( ear, 2 );
+        }
+        else if ( 2 == pass )
+        {
+          this->_splitEarcut ( ear );
+        }
+        break;
+      }
+    }
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the corner an ear? Checks every other corner.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::_isEar ( const Node *ear ) const
+  {
+    const Node *a ( ear->prev );
+    const Node *b ( ear );
+    const Node *c ( ear->next );
+
+    // Reflex corners can't be ears.
+    if ( area ( a, b, c ) >= 0.0 )
+      return false;
+
+    for ( const Node *p = ear->next->next; p != ear->prev; p = p->next )
+    {
+      if ( pointInTriangle ( a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y ) && area ( p->prev, p, p->next ) >= 0.0 )
+        return false;
+    }
+
+    return true;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the corner an ear? Only checks the corners with a z-order inside the
+  //  triangle's bounding box.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  bool Tessellator::_isEarHashed ( const Node *ear ) const
+  {
+    const Node *a ( ear->prev );
+    const Node *b ( ear );
+    const Node *c ( ear->next );
+
+    if ( area ( a, b, c ) >= 0.0 )
+      return false;
+
+    const double minTX ( std::min ( a->x, std::min ( b->x, c->x ) ) );
+    const double minTY ( std::min ( a->y, std::min ( b->y, c->y ) ) );
+    const double maxTX ( std::max ( a->x, std::max ( b->x, c->x ) ) );
+    const double maxTY ( std::max ( a->y, std::max ( b->y, c->y ) ) );
+
+    const unsigned int minZ ( this->_zOrder ( minTX, minTY ) );
+    const unsigned int maxZ ( this->_zOrder ( maxTX, maxTY ) );
+
+    const Node *p ( ear->prevZ );
+    const Node *n ( ear->nextZ );
+
+    // Look both ways at once.
+    while ( 0x0 != p && p->z >= minZ && 0x0 != n && n->z <= maxZ )
+    {
+      if ( p != ear->prev && p != ear->next &&
+           pointInTriangle ( a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y ) && area ( p->prev, p, p->next ) >= 0.0 )
+        return false;
+      p = p->prevZ;
+
+      if ( n != ear->prev && n != ear->next &&
+           pointInTriangle ( a->x, a->y, b->x, b->y, c->x, c->y, n->x, n->y ) && area ( n->prev, n, n->next ) >= 0.0 )
+        return false;
+      n = n->nextZ;
+    }
+
+    while ( 0x0 != p && p->z >= minZ )
+    {
+      if ( p != ear->prev && p != ear->next &&
+           pointInTriangle ( a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y ) && area ( p->prev, p, p->next ) >= 0.0 )
+        return false;
+      p = p->prevZ;
+    }
+
+    while ( 0x0 != n && n->z <= maxZ )
+    {
+      if ( n != ear->prev && n != ear->next &&
+           pointInTriangle ( a->x, a->y, b->x, b->y, c->x, c->y, n->x, n->y ) && area ( n->prev, n, n->next ) >= 0.0 )
+        return false;
+      n = n->nextZ;
+    }
+
+    return true;
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Sort the nodes along the z-order curve.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  struct CompareZ
+  {
+    bool operator() ( const Node *a, const Node *b ) const
+    {
+      return ( a->z < b->z );
+    }
+  };
+
+  void Tessellator::_indexCurve ( Node *start )
+  {
+    std::vector<Node*> sorted;
+
+    Node *p ( start );
+    do
+    {
+      if ( 0 == p->z )
+        p->z = this->_zOrder ( p->x, p->y );
+      sorted.push_back ( p );
+      p = p->next;
+    }
+    while ( p != start );
+
+    std::stable_sort ( sorted.begin(), sorted.end(), CompareZ() );
+
+    for ( unsigned int i = 0; i < sorted.size(); ++i )
+    {
+      sorted[i]->prevZ = ( i > 0 ? sorted[i - 1] : 0x0 );
+      sorted[i]->nextZ = ( i + 1 < sorted.size() ? sorted[i + 1] : 0x0 );
+    }
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Interleave the bits of the scaled coordinates.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  unsigned int Tessellator::_zOrder ( double xd, double yd ) const
+  {
+    unsigned int x ( static_cast<unsigned int> ( ( xd - _minX ) * _invSize ) );
+    unsigned int y ( static_cast<unsigned int> ( ( yd - _minY ) * _invSize ) );
+
+    x = ( x | ( x << 8 ) ) & 0x00FF00FF;
+    x = ( x | ( x << 4 ) ) & 0x0F0F0F0F;
+    x = ( x | ( x << 2 ) ) & 0x33333333;
+    x = ( x | ( x << 1 ) ) & 0x55555555;
+
+    y = ( y | ( y << 8 ) ) & 0x00FF00FF;
+    y = ( y | ( y << 4 ) ) & 0x0F0F0F0F;
+    y = ( y | ( y << 2 ) ) & 0x33333333;
+    y = ( y | ( y << 1 ) ) & 0x55555555;
+
+    return ( x | ( y << 1 ) );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Add a triangle.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  void Tessellator::_triangle ( const Node *a, const Node *b, const Node *c )
+  {
+    _triangles.push_back ( a->i );
+    _triangles.push_back ( b->i );
+    _triangles.push_back ( c->i );
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Make the triangles.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  void Tessellator::run ( const TessellateIndices& ringSizes )
+  {
+    const unsigned int outerSize ( std::min<unsigned int> ( ringSizes.front(), _points.size() ) );
+
+    Node *outer ( this->_linkedList ( 0, outerSize, true ) );
+    if ( 0x0 == outer || outer->next == outer->prev )
+      return;
+
+    if ( ringSizes.size() > 1 )
+      outer = this->_eliminateHoles ( ringSizes, outer );
+
+    // Hash the corners when there are enough that checking them all is slow.
+    if ( _points.size() > 80 )
+    {
+      double maxX ( _points[0][0] ), maxY ( _points[0][1] );
+      _minX = maxX;
+      _minY = maxY;
+
+      for ( unsigned int i = 1; i < outerSize; ++i )
+      {
+        _minX = std::min ( _minX, _points[i][0] );
+        _minY = std::min ( _minY, _points[i][1] );
+        maxX = std::max ( maxX, _points[i][0] );
+        maxY = std::max ( maxY, _points[i][1] );
+      }
+
+      // The z-order uses 15 bits for each coordinate.
+      const double size ( std::max ( maxX - _minX, maxY - _minY ) );
+      _invSize = ( 0.0 != size ? 32767.0 / size : 0.0 );
+    }
+
+    this->_earcutLinked ( outer, 0 );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make triangles from the rings.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Minerva::Core::Algorithms::tessellate ( const TessellatePoints& points, const TessellateIndices& ringSizes, TessellateIndices& triangles )
+{
+  if ( points.size() < 3 || ringSizes.empty() )
+    return false;
+
+  const TessellateIndices::size_type before ( triangles.size() );
+
+  Detail::Tessellator tessellator ( points, triangles );
+  tessellator.run ( ringSizes );
+
+  return ( triangles.size() > before );
+}
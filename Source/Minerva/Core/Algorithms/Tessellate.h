@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Ear-clipping tessellation of planar polygons with holes. Only the first
+//  two coordinates (longitude and latitude) are used. Holes are joined to
+//  the outer ring with bridge edges, and the ears are found with the help
+//  of a z-order curve for large rings. Nothing is added to the points, so
+//  the triangles index the points given.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ALGORITHMS_TESSELLATE_H__
+#define __MINERVA_CORE_ALGORITHMS_TESSELLATE_H__
+
+#include "Minerva/Core/Export.h"
+
+#include "Usul/Math/Vector3.h"
+
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Algorithms {
+
+  typedef std::vector<Usul::Math::Vec3d> TessellatePoints;
+  typedef std::vector<unsigned int>      TessellateIndices;
+
+  // Make triangles from the rings. The points of the outer ring come first,
+  // then the points of each hole. The ring sizes say how many points are in
+  // each. The first point may be repeated at the end. Three indices are
+  // appended for each triangle. Returns false if no triangles were made.
+  MINERVA_EXPORT bool tessellate ( const TessellatePoints& points,
+                                   const TessellateIndices& ringSizes,
+                                   TessellateIndices& triangles );
+
+}
+}
+}
+
+#endif // __MINERVA_CORE_ALGORITHMS_TESSELLATE_H__
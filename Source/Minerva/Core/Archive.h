@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Base class for an archive of files, like a kmz. Mount it with the virtual
+//  file system and the files in it can be read without extracting them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ARCHIVE_H__
+#define __MINERVA_CORE_ARCHIVE_H__
+
+#include "Minerva/Core/Export.h"
+
+#include "Usul/Base/Referenced.h"
+#include "Usul/Pointers/Pointers.h"
+
+#include <string>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT Archive : public Usul::Base::Referenced
+{
+public:
+
+  typedef Usul::Base::Referenced BaseClass;
+  typedef std::vector<char> Buffer;
+  typedef std::vector<std::string> Entries;
+
+  USUL_DECLARE_REF_POINTERS ( Archive );
+
+  /// Is the entry in the archive? Entries use '/' between directories.
+  virtual bool contains ( const std::string& entry ) const = 0;
+
+  /// Get the names of all the entries.
+  virtual void entries ( Entries& names ) const = 0;
+
+  /// Read the entry. Returns false if the entry is not in the archive.
+  virtual bool read ( const std::string& entry, Buffer& buffer ) const = 0;
+
+protected:
+
+  Archive() : BaseClass() {}
+  virtual ~Archive() {}
+
+private:
+
+  Archive ( const Archive& );
+  Archive& operator= ( const Archive& );
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_ARCHIVE_H__
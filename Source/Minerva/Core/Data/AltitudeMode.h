@@ -18,6 +18,8 @@
 
 #include "Minerva/Common/IElevationDatabase.h"
 
+#include <vector>
+
 namespace Minerva {
 namespace Core {
 namespace Data {
@@ -29,6 +31,21 @@ namespace Data {
     ALTITUDE_MODE_ABSOLUTE
   };
 
+  // Get the height for the mode, given the ground elevation under the point.
+  inline double heightFromGround ( double height, double ground, AltitudeMode mode )
+  {
+    switch ( mode )
+    {
+      case ALTITUDE_MODE_CLAMP_TO_GROUND:
+        return ground;
+      case ALTITUDE_MODE_RELATIVE_TO_GROUND:
+        return height + ground;
+      case ALTITUDE_MODE_ABSOLUTE:
+        return height;
+    }
+    return 0.0;
+  }
+
   template<class Vertex>
   inline double getElevationAtPoint ( const Vertex& point, Minerva::Common::IElevationDatabase* elevation, AltitudeMode mode )
   {
@@ -44,6 +61,31 @@ namespace Data {
     return 0.0;
   }
 
+  // Set the elevation of all the points with one query.
+  template<class Vertices>
+  inline void getElevationAtPoints ( Vertices& points, Minerva::Common::IElevationDatabase* elevation, AltitudeMode mode )
+  {
+    if ( ALTITUDE_MODE_ABSOLUTE == mode || true == points.empty() )
+      return;
+
+    const unsigned int size ( points.size() );
+    std::vector<double> lat ( size ), lon ( size ), heights ( size, 0.0 );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      lat[i] = points[i][1];
+      lon[i] = points[i][0];
+    }
+
+    if ( 0x0 != elevation )
+      elevation->elevations ( &lat[0], &lon[0], &heights[0], size );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      points[i][2] = heightFromGround ( points[i][2], heights[i], mode );
+    }
+  }
+
 }
 }
 }
@@ -10,6 +10,10 @@
 
 #include "Minerva/Core/Data/Container.h"
 #include "Minerva/Core/Data/DataObject.h"
+#include "Minerva/Core/Data/GeometryBatch.h"
+#include "Minerva/Core/Data/MultiGeometry.h"
+#include "Minerva/Core/Data/Polygon.h"
+#include "Minerva/Core/Jobs/TessellatePolygons.h"
 #include "Minerva/Core/Visitor.h"
 
 #include "Minerva/Common/IElevationDatabase.h"
@@ -19,12 +23,14 @@
 
 #include "Usul/Bits/Bits.h"
 #include "Usul/Factory/RegisterCreator.h"
+#include "Usul/Jobs/Manager.h"
 #include "Usul/Threads/Safe.h"
 
 #include "osg/Group"
 
 #include "boost/bind.hpp"
 
+#include <algorithm>
 #include <limits>
 
 using namespace Minerva::Core::Data;
@@ -41,6 +47,18 @@ USUL_FACTORY_REGISTER_CREATOR_WITH_NAME ( "Container", Container );
 USUL_IMPLEMENT_IUNKNOWN_MEMBERS ( Container, Container::BaseClass );
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Index of a builder whose node is null, so it's not a child.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  const unsigned int NO_CHILD ( std::numeric_limits<unsigned int>::max() );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Constructor.
@@ -51,10 +69,24 @@ Container::Container() :
   BaseClass(),
   _layers(),
   _builders(),
+  _changedBuilders(),
+  _removedBuilders(),
+  _childIndices(),
+  _childOwners(),
   _flags ( Container::ALL ),
   _root ( new osg::Group ),
   _unknownMap(),
-  _comments()
+  _comments(),
+  _index ( 0x0 ),
+  _indexEntries(),
+  _unindexed(),
+  _indexOrder ( 0 ),
+  _temporal ( 0x0 ),
+  _temporalOthers(),
+  _temporalConnections(),
+  _temporalBegin(),
+  _temporalEnd(),
+  _batch ( 0x0 )
 {
   this->_registerMembers();
 }
@@ -70,10 +102,24 @@ Container::Container( const Container& rhs ) :
   BaseClass ( rhs ),
   _layers( rhs._layers ),
   _builders ( rhs._builders ),
-  _flags ( rhs._flags | Container::SCENE_DIRTY ), // Make sure scene gets rebuilt.
+  _changedBuilders(),
+  _removedBuilders(),
+  _childIndices(),
+  _childOwners(),
+  _flags ( rhs._flags | Container::SCENE_DIRTY | Container::SCENE_RESET ), // Make sure scene gets rebuilt.
   _root ( new osg::Group ),
   _unknownMap ( rhs._unknownMap ),
-  _comments ( rhs._comments )
+  _comments ( rhs._comments ),
+  _index ( 0x0 ),
+  _indexEntries(),
+  _unindexed(),
+  _indexOrder ( 0 ),
+  _temporal ( 0x0 ),
+  _temporalOthers(),
+  _temporalConnections(),
+  _temporalBegin(),
+  _temporalEnd(),
+  _batch ( 0x0 != rhs._batch ? new GeometryBatch : 0x0 )
 {
   this->_registerMembers();
 }
@@ -87,11 +133,58 @@ Container::Container( const Container& rhs ) :
 
 Container::~Container()
 {
+  // Stop listening to the features first.
+  this->_indexClear();
+  this->_temporalClear();
+
   _layers.clear();
   _builders.clear();
+  _changedBuilders.clear();
+  _removedBuilders.clear();
+  _childIndices.clear();
+  _childOwners.clear();
   _unknownMap.clear();
   _comments.clear();
   _root = 0x0;
+  delete _batch; _batch = 0x0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the flag to merge the features into a few large geometries.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Container::batching() const
+{
+  Guard guard ( this->mutex() );
+  return ( 0x0 != _batch );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the flag to merge the features into a few large geometries. Lines 
+//  and polygons that share a state are drawn with one call. Features with 
+//  labels, shaders or blending still get their own node.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::batching ( bool b )
+{
+  {
+    Guard guard ( this->mutex() );
+
+    if ( b == ( 0x0 != _batch ) )
+      return;
+
+    delete _batch;
+    _batch = ( b ? new GeometryBatch : 0x0 );
+  }
+
+  // Our scene needs rebuilt.
+  this->dirtyScene ( true );
 }
 
 
@@ -196,22 +289,28 @@ void Container::add ( Feature* feature, bool notify )
     _layers.push_back ( feature );
     
     _unknownMap.insert ( FeatureMap::value_type ( feature->objectId(), feature ) );
+
+    // Keep the spatial index current, if there is one.
+    if ( 0x0 != _index )
+      this->_indexAdd ( feature );
+
+    // The new feature needs a full pass.
+    this->_temporalClear();
   }
 
-  // Add the builder.
+  // Add the builder. Only its node is added to the scene.
   IBuildScene::QueryPtr buildScene ( feature );
   if ( buildScene.valid() )
   {
     Guard guard ( this );
     _builders.push_back ( buildScene );
+    _changedBuilders.push_back ( buildScene );
+    _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY, true );
   }
   
   // Update the extents.
   this->_updateExtents ( feature );
   
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
-  
   // Notify any listeners that the data has changed.
   if ( notify )
     this->_notifyDataChangedListeners();
@@ -238,21 +337,31 @@ void Container::remove ( Feature *feature )
         _layers.erase( doomed );
     }
 
-    // Remove the builder.
+    // Remove the builder. Only its node is removed from the scene.
     IBuildScene::QueryPtr buildScene ( feature );
     if ( buildScene.valid() )
     {
       Builders::iterator doomed ( std::find ( _builders.begin(), _builders.end(), Builders::value_type ( buildScene ) ) );
       if( doomed != _builders.end() )
         _builders.erase ( doomed );
+
+      _changedBuilders.erase ( std::remove ( _changedBuilders.begin(), _changedBuilders.end(), Builders::value_type ( buildScene ) ), _changedBuilders.end() );
+
+      if ( _childIndices.end() != _childIndices.find ( buildScene.get() ) )
+        _removedBuilders.push_back ( buildScene );
+
+      if ( 0x0 != _batch )
+        _batch->remove ( feature );
+
+      _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY, true );
     }
     
     // If we can get a GUID, remove the mapping.
     _unknownMap.erase ( feature->objectId() );
-  }
 
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
+    this->_indexRemove ( feature );
+    this->_temporalClear();
+  }
   
   // Notify any listeners that the data has changed.
   this->_notifyDataChangedListeners();
@@ -272,6 +381,8 @@ void Container::clear()
   _unknownMap.clear();
   _layers.clear();
   _builders.clear();
+  this->_indexClear();
+  this->_temporalClear();
 
   // Our scene needs to be rebuilt.
   this->dirtyScene ( true );
@@ -334,32 +445,259 @@ void Container::_buildScene ( Minerva::Common::IPlanetCoordinates *planet, Miner
     // For debugging...
     _root->setName ( this->name() );
     
-    // Remove all children.
-    OsgTools::Group::removeAllChildren ( _root.get() );
+    // Only the children that were added, removed or changed are touched, 
+    // unless the whole scene was dirtied.
+    const bool reset ( Usul::Bits::has<unsigned int, unsigned int> ( _flags, Container::SCENE_RESET ) );
+    if ( true == reset || false == BaseClass::visibility() )
+    {
+      this->_buildAllChildren ( planet, elevation );
+    }
+    else
+    {
+      this->_buildChangedChildren ( planet, elevation );
+    }
+
+    // Our scene is no longer dirty.
+    this->dirtyScene ( false );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the scene for all the children. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_buildAllChildren ( Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation )
+{
+  // Remove all children.
+  OsgTools::Group::removeAllChildren ( _root.get() );
+  _childIndices.clear();
+  _childOwners.clear();
+  _changedBuilders.clear();
+  _removedBuilders.clear();
+
+  if ( 0x0 != _batch )
+  {
+    _batch->clear();
+  }
 
-    // Add to the scene if we are shown.
-    if ( BaseClass::visibility() )
+  // Add to the scene if we are shown.
+  if ( BaseClass::visibility() )
+  {
+    this->_tessellatePolygons ( _builders );
+
+    for ( Builders::iterator iter = _builders.begin(); iter != _builders.end(); ++iter )
     {
-      for ( Builders::iterator iter = _builders.begin(); iter != _builders.end(); ++iter )
+      Builders::value_type dataObject ( *iter );
+
+      // Should we build the scene?
+      if ( dataObject.valid() && false == this->_batchAdd ( dataObject.get(), planet, elevation ) )
       {
-        Builders::value_type dataObject ( *iter );
+        // Build the scene. Handle possible null return.
+        osg::ref_ptr<osg::Node> node ( dataObject->buildScene ( planet, elevation ) );
+        this->_childNodeSet ( dataObject.get(), node.get() );
+      }
+    }
 
-        // Should we build the scene?
-        if ( dataObject.valid() )
-        {
-          // Build the scene. Handle possible null return.
-          osg::ref_ptr<osg::Node> node ( dataObject->buildScene ( planet, elevation ) );
-          if ( true == node.valid() )
-          {
-            _root->addChild ( node.get() );
-          }
-        }
+    // The batch's node is kept with a null builder.
+    if ( 0x0 != _batch )
+    {
+      osg::ref_ptr<osg::Node> node ( _batch->buildScene() );
+      this->_childNodeSet ( 0x0, node.get() );
+    }
+  }
+  
+  // Building the scene can change the extents.
+  this->_indexUpdate();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the scene for the children that were added or changed, and remove
+//  the ones that were removed. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_buildChangedChildren ( Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation )
+{
+  Builders removed, changed;
+  removed.swap ( _removedBuilders );
+  changed.swap ( _changedBuilders );
+
+  for ( Builders::iterator iter = removed.begin(); iter != removed.end(); ++iter )
+  {
+    this->_childNodeRemove ( iter->get() );
+  }
+
+  this->_tessellatePolygons ( changed );
+
+  for ( Builders::iterator iter = changed.begin(); iter != changed.end(); ++iter )
+  {
+    Builders::value_type dataObject ( *iter );
+    if ( false == dataObject.valid() )
+      continue;
+
+    if ( true == this->_batchAdd ( dataObject.get(), planet, elevation ) )
+    {
+      // It may have had a node of its own before.
+      this->_childNodeRemove ( dataObject.get() );
+    }
+    else
+    {
+      osg::ref_ptr<osg::Node> node ( dataObject->buildScene ( planet, elevation ) );
+      this->_childNodeSet ( dataObject.get(), node.get() );
+    }
+
+    // Building the scene can change the extents.
+    this->_indexUpdate ( dynamic_cast<Feature*> ( dataObject.get() ) );
+  }
+
+  // Merge the batch again if a feature in it changed.
+  if ( 0x0 != _batch && _batch->dirty() )
+  {
+    osg::ref_ptr<osg::Node> node ( _batch->buildScene() );
+    this->_childNodeSet ( 0x0, node.get() );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate the polygons of the dirty data objects on the job threads. 
+//  Only the tessellation is done there. Getting the elevation needs the 
+//  body's lock, which the caller of updateNotify may have.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_tessellatePolygons ( const Builders& builders ) const
+{
+  Minerva::Core::Jobs::Polygons polygons;
+
+  for ( Builders::const_iterator iter = builders.begin(); iter != builders.end(); ++iter )
+  {
+    DataObject::RefPtr dataObject ( dynamic_cast<DataObject*> ( iter->get() ) );
+    if ( false == dataObject.valid() || false == dataObject->dirty() )
+      continue;
+
+    Geometry::RefPtr geometry ( dataObject->geometry() );
+    if ( Polygon *polygon = dynamic_cast<Polygon*> ( geometry.get() ) )
+    {
+      polygons.push_back ( polygon );
+    }
+    else if ( MultiGeometry *multi = dynamic_cast<MultiGeometry*> ( geometry.get() ) )
+    {
+      const MultiGeometry::Geometries geometries ( multi->geometries() );
+      for ( MultiGeometry::Geometries::const_iterator part = geometries.begin(); part != geometries.end(); ++part )
+      {
+        if ( Polygon *polygon = dynamic_cast<Polygon*> ( part->get() ) )
+          polygons.push_back ( polygon );
       }
     }
-    
-    // Our scene is no longer dirty.
-    this->dirtyScene ( false );
   }
+
+  if ( false == polygons.empty() )
+  {
+    Minerva::Core::Jobs::tessellatePolygons ( polygons, Usul::Jobs::Manager::instance() );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the builder to the batch. Returns false if it needs a node of its 
+//  own. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Container::_batchAdd ( IBuildScene* builder, Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation )
+{
+  if ( 0x0 == _batch )
+    return false;
+
+  DataObject::RefPtr dataObject ( dynamic_cast<DataObject*> ( builder ) );
+  if ( false == dataObject.valid() )
+    return false;
+
+  // Replace what it had in the batch.
+  _batch->remove ( dataObject.get() );
+  return dataObject->batch ( *_batch, planet, elevation );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the builder's node in the scene. The children keep the index of 
+//  their node, so it can be replaced without looking for it. The mutex 
+//  should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_childNodeSet ( IBuildScene* builder, osg::Node* node )
+{
+  ChildIndices::iterator iter ( _childIndices.find ( builder ) );
+  if ( _childIndices.end() == iter )
+  {
+    iter = _childIndices.insert ( ChildIndices::value_type ( builder, Helper::NO_CHILD ) ).first;
+  }
+
+  unsigned int &index ( iter->second );
+
+  if ( 0x0 == node )
+  {
+    // Keep the builder, so it's known when it changes later.
+    if ( Helper::NO_CHILD != index )
+    {
+      this->_childNodeRemove ( builder );
+      _childIndices.insert ( ChildIndices::value_type ( builder, Helper::NO_CHILD ) );
+    }
+    return;
+  }
+
+  if ( Helper::NO_CHILD == index )
+  {
+    index = _root->getNumChildren();
+    _root->addChild ( node );
+    _childOwners.push_back ( builder );
+  }
+  else if ( _root->getChild ( index ) != node )
+  {
+    _root->setChild ( index, node );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the builder's node from the scene. The last child is moved into 
+//  its place, so nothing is searched or shifted. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_childNodeRemove ( IBuildScene* builder )
+{
+  ChildIndices::iterator iter ( _childIndices.find ( builder ) );
+  if ( _childIndices.end() == iter )
+    return;
+
+  const unsigned int index ( iter->second );
+  _childIndices.erase ( iter );
+
+  if ( Helper::NO_CHILD == index || index >= _childOwners.size() )
+    return;
+
+  const unsigned int last ( static_cast<unsigned int> ( _childOwners.size() - 1 ) );
+  if ( index != last )
+  {
+    _root->setChild ( index, _root->getChild ( last ) );
+    _childOwners[index] = _childOwners[last];
+    _childIndices[_childOwners[index]] = index;
+  }
+
+  _root->removeChildren ( last, 1 );
+  _childOwners.pop_back();
 }
 
 
@@ -463,7 +801,7 @@ bool Container::dirtyScene() const
 void Container::dirtyScene ( bool b )
 {
   Guard guard ( this->mutex() );
-  _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY, b );
+  _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY | Container::SCENE_RESET, b );
 }
 
 
@@ -500,6 +838,13 @@ Container::Extents Container::calculateExtents() const
 
 void Container::updateNotify ( CameraState* camera, Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation )
 {
+  // The features in the batch don't have a node of their own to hide.
+  {
+    Guard guard ( this->mutex() );
+    if ( 0x0 != _batch && _batch->dirty() )
+      _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY, true );
+  }
+
   // Build if we need to...
   if ( this->dirtyScene()  )
   {
@@ -552,6 +897,10 @@ void Container::deserialize ( const XmlTree::Node &node )
 
   _dataMemberMap.deserialize ( node );
 
+  // The layers are all new.
+  this->_indexClear();
+  this->_temporalClear();
+
   // Add layers.
   for ( Features::iterator iter = _layers.begin(); iter != _layers.end(); ++iter )
   {
@@ -586,7 +935,7 @@ bool Container::elevationChangedNotify ( const Extents& extents, unsigned int le
       {
         if ( ecl->elevationChangedNotify ( extents, level, elevationData, caller ) )
         {
-          this->dirtyScene ( true );
+          this->featureChanged ( iter->get() );
           handled = true;
         }
       }
@@ -673,8 +1022,28 @@ Feature::RefPtr Container::getItemsWithinExtents ( double minLon, double minLat,
   Container::RefPtr answer ( new Container );
   Extents givenExtents ( minLon, minLat, maxLon, maxLat );
 
-  // Get a copy of the layers.
-  const Features layers ( Usul::Threads::Safe::get ( this->mutex(), _layers ) );
+  // Get the layers that may be in the extents.
+  Features layers;
+  {
+    Guard guard ( this->mutex() );
+
+    // Make the index the first time.
+    if ( 0x0 == _index )
+      this->_indexBuild();
+
+    SpatialIndex::Values values;
+    _index->query ( givenExtents, values );
+    values.insert ( values.end(), _unindexed.begin(), _unindexed.end() );
+
+    // Keep the order of the layers.
+    std::sort ( values.begin(), values.end() );
+
+    layers.reserve ( values.size() );
+    for ( SpatialIndex::Values::const_iterator iter = values.begin(); iter != values.end(); ++iter )
+    {
+      layers.push_back ( iter->second );
+    }
+  }
 
   // Loop through the layers.
   for ( Features::const_iterator i = layers.begin(); i != layers.end(); ++i )
@@ -736,6 +1105,9 @@ void Container::swap ( Feature* layer0, Feature* layer1 )
       Feature::RefPtr temp ( *iter0 );
       *iter0 = *iter1;
       *iter1 = temp;
+
+      // The order changed, so make the index again when needed.
+      this->_indexClear();
     }
   }
   
@@ -756,6 +1128,30 @@ Feature::RefPtr Container::feature ( unsigned int i )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The feature's scene changed. Only its node is built again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::featureChanged ( Feature* feature )
+{
+  IBuildScene::QueryPtr buildScene ( feature );
+  if ( false == buildScene.valid() )
+    return;
+
+  Guard guard ( this->mutex() );
+
+  // Features that aren't built yet will be anyway.
+  const bool batched ( 0x0 != _batch && _batch->contains ( feature ) );
+  if ( false == batched && _childIndices.end() == _childIndices.find ( buildScene.get() ) )
+    return;
+
+  _changedBuilders.push_back ( buildScene );
+  _flags = Usul::Bits::set<unsigned int, unsigned int> ( _flags, Container::SCENE_DIRTY, true );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Reserve enough room.
@@ -768,3 +1164,407 @@ void Container::reserve ( unsigned int size )
   _layers.reserve ( size );
   _builders.reserve ( size );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helpers for the spatial index.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  // Only leaf features with extents are put in the index. Containers have 
+  // their own index and are always asked. A feature with the default extents 
+  // probably doesn't have them yet.
+  inline bool isIndexable ( Feature& feature, const Feature::Extents& extents )
+  {
+    const bool hasExtents ( 0.0 != extents[0] || 0.0 != extents[1] || 0.0 != extents[2] || 0.0 != extents[3] );
+    return ( 0x0 == feature.asContainer() ) && hasExtents;
+  }
+
+  inline bool isEqual ( const Feature::Extents& a, const Feature::Extents& b )
+  {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+  }
+
+  template < class Entries > inline void disconnect ( Entries& entries )
+  {
+    for ( typename Entries::iterator iter = entries.begin(); iter != entries.end(); ++iter )
+    {
+      iter->second.connection.disconnect();
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the feature to the spatial index. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexAdd ( Feature* feature ) const
+{
+  if ( 0x0 == feature || 0x0 == _index )
+    return;
+
+  // The same feature is only indexed once.
+  if ( _indexEntries.end() != _indexEntries.find ( feature ) )
+    return;
+
+  IndexEntry &entry ( _indexEntries[feature] );
+  entry.order = ++_indexOrder;
+  entry.extents = feature->extents();
+  entry.indexed = Helper::isIndexable ( *feature, entry.extents );
+
+  // Move the feature when its extents are set.
+  entry.connection = feature->addExtentsChangedListener ( boost::bind ( &Container::_indexMoved, this, _1 ) );
+
+  if ( entry.indexed )
+  {
+    _index->insert ( IndexValue ( entry.order, feature ), entry.extents );
+  }
+  else
+  {
+    _unindexed.insert ( IndexValue ( entry.order, feature ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the feature from the spatial index. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexRemove ( Feature* feature )
+{
+  if ( 0x0 == _index )
+    return;
+
+  IndexEntries::iterator iter ( _indexEntries.find ( feature ) );
+  if ( _indexEntries.end() == iter )
+    return;
+
+  IndexEntry &entry ( iter->second );
+  const IndexValue value ( entry.order, feature );
+
+  entry.connection.disconnect();
+
+  if ( entry.indexed )
+  {
+    _index->remove ( value, entry.extents );
+  }
+  else
+  {
+    _unindexed.erase ( value );
+  }
+
+  _indexEntries.erase ( iter );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the spatial index from the layers. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexBuild() const
+{
+  Helper::disconnect ( _indexEntries );
+
+  delete _index;
+  _index = new SpatialIndex;
+  _indexEntries.clear();
+  _unindexed.clear();
+  _indexOrder = 0;
+
+  for ( Features::const_iterator iter = _layers.begin(); iter != _layers.end(); ++iter )
+  {
+    this->_indexAdd ( iter->get() );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Delete the spatial index. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexClear()
+{
+  Helper::disconnect ( _indexEntries );
+
+  delete _index;
+  _index = 0x0;
+  _indexEntries.clear();
+  _unindexed.clear();
+  _indexOrder = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the features with new extents. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexUpdate() const
+{
+  if ( 0x0 == _index )
+    return;
+
+  for ( IndexEntries::iterator iter = _indexEntries.begin(); iter != _indexEntries.end(); ++iter )
+  {
+    this->_indexUpdate ( iter );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the feature if it has new extents. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexUpdate ( Feature* feature ) const
+{
+  if ( 0x0 == _index || 0x0 == feature )
+    return;
+
+  IndexEntries::iterator iter ( _indexEntries.find ( feature ) );
+  if ( _indexEntries.end() != iter )
+  {
+    this->_indexUpdate ( iter );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the entry's feature if it has new extents. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexUpdate ( IndexEntries::iterator iter ) const
+{
+  Feature *feature ( iter->first );
+  IndexEntry &entry ( iter->second );
+
+  const Extents extents ( feature->extents() );
+  if ( Helper::isEqual ( extents, entry.extents ) )
+    return;
+
+  const IndexValue value ( entry.order, feature );
+  if ( entry.indexed )
+  {
+    _index->remove ( value, entry.extents );
+  }
+  else
+  {
+    _unindexed.erase ( value );
+  }
+
+  entry.extents = extents;
+  entry.indexed = Helper::isIndexable ( *feature, extents );
+
+  if ( entry.indexed )
+  {
+    _index->insert ( value, extents );
+  }
+  else
+  {
+    _unindexed.insert ( value );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The feature's extents were set, so move it in the index. This is called 
+//  by the thread that set them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_indexMoved ( Feature* feature ) const
+{
+  Guard guard ( this->mutex() );
+  this->_indexUpdate ( feature );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helpers for the temporal index.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  // Only change the visibility when it's different, so nothing is dirtied for no reason.
+  inline void visibilitySet ( Feature& feature, bool visible )
+  {
+    if ( visible != feature.visibility() )
+      feature.visibilitySet ( visible );
+  }
+
+  // Is the feature visible over the period? Features without a time always are.
+  inline bool isVisible ( const Feature& feature, const TimePrimitive::Period& period )
+  {
+    TimePrimitive::RefPtr timePrimitive ( feature.timePrimitive() );
+    return ( timePrimitive.valid() ? timePrimitive->isVisible ( period ) : true );
+  }
+
+  template < class Values > inline void visibilitySetAll ( const Values& values, bool visible )
+  {
+    for ( typename Values::const_iterator iter = values.begin(); iter != values.end(); ++iter )
+    {
+      Feature::RefPtr feature ( *iter );
+      if ( feature.valid() )
+        Helper::visibilitySet ( *feature, visible );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Show the features that are visible over the period. The first time, and 
+//  after the features change, all of them are checked. After that only the 
+//  ones the index says went in or out of the period.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::temporalVisibility ( const Period& period )
+{
+  TemporalIndex::Values shown, hidden;
+  Features untimed, others;
+
+  {
+    Guard guard ( this->mutex() );
+
+    // Boost treats empty periods differently, so check each feature the slow way.
+    if ( period.is_null() )
+    {
+      this->_temporalClear();
+      others = _layers;
+    }
+    else
+    {
+      if ( 0x0 == _temporal )
+      {
+        this->_temporalBuild ( untimed );
+        _temporal->query ( period.begin(), period.end(), shown, hidden );
+      }
+      else
+      {
+        _temporal->changes ( _temporalBegin, _temporalEnd, period.begin(), period.end(), shown, hidden );
+      }
+
+      _temporalBegin = period.begin();
+      _temporalEnd = period.end();
+      others = _temporalOthers;
+    }
+  }
+
+  // Set the visibility without the lock, in case the features call back.
+  Helper::visibilitySetAll ( untimed, true );
+  Helper::visibilitySetAll ( shown, true );
+  Helper::visibilitySetAll ( hidden, false );
+
+  for ( Features::iterator iter = others.begin(); iter != others.end(); ++iter )
+  {
+    Feature::RefPtr feature ( *iter );
+    if ( false == feature.valid() )
+      continue;
+
+    Helper::visibilitySet ( *feature, Helper::isVisible ( *feature, period ) );
+
+    Container::RefPtr container ( feature->asContainer() );
+    if ( container.valid() )
+      container->temporalVisibility ( period );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the temporal index from the layers. Features without a time are 
+//  appended to the given list. Containers and times that can't be indexed 
+//  are checked every time. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_temporalBuild ( Features& untimed )
+{
+  this->_temporalClear();
+  _temporal = new TemporalIndex;
+
+  for ( Features::const_iterator iter = _layers.begin(); iter != _layers.end(); ++iter )
+  {
+    Feature::RefPtr feature ( *iter );
+    if ( false == feature.valid() )
+      continue;
+
+    if ( 0x0 != feature->asContainer() )
+    {
+      _temporalOthers.push_back ( feature );
+      continue;
+    }
+
+    // Start over when the feature gets a new time.
+    _temporalConnections.push_back ( feature->addTimeChangedListener ( boost::bind ( &Container::_temporalChanged, this, _1 ) ) );
+
+    TimePrimitive::RefPtr timePrimitive ( feature->timePrimitive() );
+    if ( false == timePrimitive.valid() )
+    {
+      untimed.push_back ( feature );
+      continue;
+    }
+
+    const Period period ( timePrimitive->period() );
+    const bool special ( period.begin().is_special() || period.end().is_special() );
+    if ( special || false == _temporal->insert ( feature.get(), period.begin(), period.end() ) )
+    {
+      _temporalOthers.push_back ( feature );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Delete the temporal index. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_temporalClear()
+{
+  for ( TemporalConnections::iterator iter = _temporalConnections.begin(); iter != _temporalConnections.end(); ++iter )
+  {
+    iter->disconnect();
+  }
+  _temporalConnections.clear();
+
+  delete _temporal;
+  _temporal = 0x0;
+  _temporalOthers.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A feature's time primitive was set, so the index is out of date. The next
+//  call to temporalVisibility makes a new one and checks every feature. This 
+//  is called by the thread that set the time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Container::_temporalChanged ( Feature* )
+{
+  Guard guard ( this->mutex() );
+  this->_temporalClear();
+}
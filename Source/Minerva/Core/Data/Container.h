@@ -12,6 +12,8 @@
 #define __MINERVA_LAYERS_CONTAINER_H__
 
 #include "Minerva/Core/Export.h"
+#include "Minerva/Core/Algorithms/IntervalIndex.h"
+#include "Minerva/Core/Algorithms/QuadTree.h"
 #include "Minerva/Core/Data/Feature.h"
 #include "Minerva/Core/Data/DataObject.h"
 
@@ -27,6 +29,7 @@
 #include "osg/Group"
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -37,6 +40,8 @@ class Visitor;
 
 namespace Data {
 
+class GeometryBatch;
+
 class MINERVA_EXPORT Container : 
   public Minerva::Core::Data::Feature,
   public Minerva::Common::IElevationChangedListener,
@@ -53,6 +58,7 @@ public:
   typedef Minerva::Common::ITileVectorData          ITileVectorData;
   typedef ITileVectorData::Jobs                     TileVectorJobs;
   typedef Minerva::Common::IWithinExtents           IWithinExtents;
+  typedef TimePrimitive::Period                     Period;
   typedef std::vector<std::string> Comments;
 
   /// Smart-pointer definitions.
@@ -64,7 +70,8 @@ public:
     DATA_DIRTY    = 0x00000001,
     EXTENTS_DIRTY = 0x00000002,
     SCENE_DIRTY   = 0x00000004,
-    ALL           = DATA_DIRTY | EXTENTS_DIRTY | SCENE_DIRTY
+    SCENE_RESET   = 0x00000008,
+    ALL           = DATA_DIRTY | EXTENTS_DIRTY | SCENE_DIRTY | SCENE_RESET
   };
   
   Container();
@@ -78,6 +85,10 @@ public:
   /// Add an object.
   void                        add ( Feature* layer, bool notify = true );
 
+  /// Get/Set the flag to merge the features that share a state into a few large geometries.
+  bool                        batching() const;
+  void                        batching ( bool );
+
   osg::Node*                  getScene();
   
   /// Build the scene (IBuildScene).
@@ -103,7 +114,7 @@ public:
   bool                        dirtyExtents() const;
   void                        dirtyExtents ( bool );
   
-  /// Get/Set dirty scene flag (IDirtyScene).
+  /// Get/Set dirty scene flag (IDirtyScene). Setting it rebuilds the whole scene.
   virtual bool                dirtyScene() const;
   virtual void                dirtyScene ( bool b );
 
@@ -112,6 +123,9 @@ public:
   
   /// Get the feature.
   Feature::RefPtr             feature ( unsigned int i );
+
+  /// The feature's scene changed. Only its node is built again.
+  void                        featureChanged ( Feature* feature );
   
   /// Find unknown with given id.  The function will return null if not found.
   Feature::RefPtr             find ( const ObjectID& id ) const;
@@ -137,6 +151,12 @@ public:
 
   // Swap two features.
   void                        swap ( Feature* layer0, Feature* layer1 );
+
+  /// Show the features that are visible over the period, and hide the rest.
+  /// After the first call only the features that go in or out are touched.
+  /// Features are indexed by the time they have when first asked, and again
+  /// after features are added or removed.
+  void                        temporalVisibility ( const Period& period );
   
   /// Traverse all DataObjects.
   virtual void                traverse ( Minerva::Core::Visitor& visitor );
@@ -172,16 +192,80 @@ private:
   // Register members for serialization.
   void                        _registerMembers();
 
+  // Add the builder to the batch. The mutex should be locked.
+  bool                        _batchAdd ( Minerva::Common::IBuildScene* builder, Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation );
+
+  // Build the whole scene, or only the children that changed. The mutex should be locked.
+  void                        _buildAllChildren ( Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation );
+  void                        _buildChangedChildren ( Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation );
+  void                        _childNodeRemove ( Minerva::Common::IBuildScene* builder );
+  void                        _childNodeSet ( Minerva::Common::IBuildScene* builder, osg::Node* node );
+
+  // Spatial index of the features, used by getItemsWithinExtents.
+  void                        _indexAdd ( Feature* feature ) const;
+  void                        _indexBuild() const;
+  void                        _indexClear();
+  void                        _indexRemove ( Feature* feature );
+  void                        _indexUpdate() const;
+  void                        _indexUpdate ( Feature* feature ) const;
+
+  // Called when an indexed feature's extents are set.
+  void                        _indexMoved ( Feature* feature ) const;
+
+  // Temporal index of the features, used by temporalVisibility.
+  void                        _temporalBuild ( Features& untimed );
+  void                        _temporalChanged ( Feature* feature );
+  void                        _temporalClear();
+
   typedef Minerva::Common::IBuildScene IBuildScene;
   typedef std::vector<IBuildScene::RefPtr> Builders;
   typedef std::map<ObjectID,Feature::RefPtr>      FeatureMap;
+
+  // Values in the index are the feature and the order it was added, so the 
+  // answer keeps the same order as the layers.
+  typedef std::pair<unsigned long,Feature*>        IndexValue;
+  typedef Minerva::Core::Algorithms::QuadTree<IndexValue> SpatialIndex;
+  struct IndexEntry
+  {
+    IndexEntry() : order ( 0 ), extents(), indexed ( false ), connection() {}
+    unsigned long order;
+    Extents extents;
+    bool indexed;
+    Feature::Connection connection;
+  };
+  typedef std::map<Feature*,IndexEntry>            IndexEntries;
+  typedef std::map<IBuildScene*,unsigned int>      ChildIndices;
+  typedef std::vector<IBuildScene*>                ChildOwners;
+  typedef std::set<IndexValue>                     IndexValues;
+  typedef boost::posix_time::ptime                 TemporalKey;
+  typedef Minerva::Core::Algorithms::IntervalIndex<TemporalKey,Feature*> TemporalIndex;
+  typedef std::vector<Feature::Connection>         TemporalConnections;
+
+  void                        _indexUpdate ( IndexEntries::iterator iter ) const;
+
+  // Tessellate the polygons that are about to be built on the job threads.
+  void                        _tessellatePolygons ( const Builders& builders ) const;
   
   Features _layers;
   Builders _builders;
+  Builders _changedBuilders;
+  Builders _removedBuilders;
+  ChildIndices _childIndices;
+  ChildOwners _childOwners;
   unsigned int _flags;
   osg::ref_ptr<osg::Group> _root;
   FeatureMap _unknownMap;
   Comments _comments;
+  mutable SpatialIndex *_index;
+  mutable IndexEntries _indexEntries;
+  mutable IndexValues _unindexed;
+  mutable unsigned long _indexOrder;
+  TemporalIndex *_temporal;
+  Features _temporalOthers;
+  TemporalConnections _temporalConnections;
+  TemporalKey _temporalBegin;
+  TemporalKey _temporalEnd;
+  GeometryBatch *_batch;
   
   SERIALIZE_XML_CLASS_NAME( Container )
 };
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert many points to planet coordinates with one call.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_DATA_CONVERT_TO_PLANET_H__
+#define __MINERVA_CORE_DATA_CONVERT_TO_PLANET_H__
+
+#include "Minerva/Common/IPlanetCoordinates.h"
+
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Data {
+
+  // Convert the lon, lat, elevation points to planet coordinates in place.
+  template<class Vertices>
+  inline void convertToPlanet ( Vertices& points, Minerva::Common::IPlanetCoordinates* planet )
+  {
+    if ( 0x0 == planet || true == points.empty() )
+      return;
+
+    const unsigned int size ( points.size() );
+    std::vector<double> lat ( size ), lon ( size ), elevation ( size ), x ( size ), y ( size ), z ( size );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      lon[i] = points[i][0];
+      lat[i] = points[i][1];
+      elevation[i] = points[i][2];
+    }
+
+    planet->convertToPlanet ( &lat[0], &lon[0], &elevation[0], &x[0], &y[0], &z[0], size );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      points[i][0] = x[i];
+      points[i][1] = y[i];
+      points[i][2] = z[i];
+    }
+  }
+
+}
+}
+}
+
+#endif // __MINERVA_CORE_DATA_CONVERT_TO_PLANET_H__
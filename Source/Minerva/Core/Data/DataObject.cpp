@@ -146,11 +146,14 @@ void DataObject::accept ( Minerva::Core::Visitor& visitor )
 
 void DataObject::geometry ( Geometry::RefPtr geometry )
 {
-  Guard guard ( this );
-  _geometry = geometry;
+  {
+    Guard guard ( this );
+    _geometry = geometry;
+  }
 
   if ( true == geometry.valid() )
   {
+    // Set the extents without the lock, the containers are told about it.
     this->extents ( geometry->extents() );
     
     this->dirty ( true );
@@ -308,6 +311,31 @@ bool DataObject::showLabel () const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the geometry to the batch. Labels need a scene branch of their own.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool DataObject::batch ( GeometryBatch& batch, Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation )
+{
+  if ( this->showLabel() && !this->label().empty() )
+    return false;
+
+  Geometry::RefPtr geometry ( this->geometry() );
+  if ( false == geometry.valid() )
+    return false;
+
+  if ( false == geometry->batch ( batch, this, this->style(), planet, elevation ) )
+    return false;
+
+  // The extents may be updated when the geometry is batched.
+  this->extents ( geometry->extents() );
+
+  return true;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Build the scene.
@@ -91,6 +91,9 @@ public:
   /// Accept the visitor.
   virtual void          accept ( Minerva::Core::Visitor& visitor );
 
+  /// Add the geometry to the batch. Returns false if this needs a scene branch of its own.
+  bool                  batch ( GeometryBatch& batch, Minerva::Common::IPlanetCoordinates *planet, Minerva::Common::IElevationDatabase *elevation );
+
   /// DataObject has been clicked.
   virtual Item*         clicked ( Usul::Interfaces::IUnknown* caller = 0x0 ) const;
 
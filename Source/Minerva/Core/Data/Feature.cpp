@@ -45,7 +45,9 @@ Feature::Feature() :
   _lookAt ( 0x0 ),
   _timePrimitive ( 0x0 ),
   _extents(),
-  _dataChangedListeners()
+  _dataChangedListeners(),
+  _extentsChangedListeners(),
+  _timeChangedListeners()
 {
   _visibility.fetch_and_store ( true );
   this->_addMember ( "name", _name.getReference() );
@@ -68,7 +70,9 @@ Feature::Feature ( const Feature& rhs ) : BaseClass ( rhs ),
   _lookAt ( rhs._lookAt ),
   _timePrimitive ( rhs._timePrimitive ),
   _extents ( rhs._extents ),
-  _dataChangedListeners()
+  _dataChangedListeners(),
+  _extentsChangedListeners(),
+  _timeChangedListeners()
 {
   this->_addMember ( "name", _name.getReference() );
   this->_addMember ( "visibility", _visibility );
@@ -209,8 +213,13 @@ std::string Feature::styleUrl() const
 
 void Feature::timePrimitive ( TimePrimitive* timePrimitive )
 {
-  Guard guard ( this->mutex() );
-  _timePrimitive = timePrimitive;
+  {
+    Guard guard ( this->mutex() );
+    _timePrimitive = timePrimitive;
+  }
+
+  // The containers that index this feature by time forget their index.
+  _timeChangedListeners ( this );
 }
 
 
@@ -315,6 +324,30 @@ void Feature::_notifyDataChangedListeners()
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the listener.  Note: No need to guard, _extentsChangedListeners has it's own mutex.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Feature::Connection Feature::addExtentsChangedListener ( const ExtentsCallback& caller )
+{
+  return _extentsChangedListeners.connect ( caller );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the listener.  Note: No need to guard, _timeChangedListeners has it's own mutex.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Feature::Connection Feature::addTimeChangedListener ( const TimeCallback& caller )
+{
+  return _timeChangedListeners.connect ( caller );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Set the extents.
@@ -323,8 +356,14 @@ void Feature::_notifyDataChangedListeners()
 
 void Feature::extents ( const Extents& e )
 {
-  Guard guard ( this->mutex() );
-  _extents = e;
+  {
+    Guard guard ( this->mutex() );
+    _extents = e;
+  }
+
+  // The containers that index this feature move it. They lock their own 
+  // mutex, so ours can't be locked here.
+  _extentsChangedListeners ( this );
 }
 
 
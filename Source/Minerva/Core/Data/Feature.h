@@ -41,10 +41,14 @@ class MINERVA_EXPORT Feature : public Minerva::Core::Data::Object
 {
   typedef Minerva::Core::Data::Object      BaseClass;
   typedef boost::signals2::signal<void ()> DataChangedListeners;
+  typedef boost::signals2::signal<void ( Feature* )> ExtentsChangedListeners;
+  typedef boost::signals2::signal<void ( Feature* )> TimeChangedListeners;
 public:
   typedef Minerva::Core::Data::TimePrimitive  TimePrimitive;
   typedef Minerva::Common::Extents            Extents;
   typedef DataChangedListeners::slot_type ModifiedCallback;
+  typedef ExtentsChangedListeners::slot_type ExtentsCallback;
+  typedef TimeChangedListeners::slot_type TimeCallback;
   typedef boost::signals2::connection Connection;
 
   USUL_DECLARE_REF_POINTERS ( Feature );
@@ -98,6 +102,12 @@ public:
   
   // Remove the listener.
   void                   removeDataChangedListener ( const Connection& connection );
+
+  // Add a listener that is called after the extents are set.
+  Connection             addExtentsChangedListener ( const ExtentsCallback& caller );
+
+  // Add a listener that is called after the time primitive is set.
+  Connection             addTimeChangedListener ( const TimeCallback& caller );
   
   // Get the number of children.
   virtual unsigned int        getNumChildNodes() const;
@@ -137,6 +147,8 @@ private:
   TimePrimitive::RefPtr _timePrimitive;
   Extents _extents;
   DataChangedListeners _dataChangedListeners;
+  ExtentsChangedListeners _extentsChangedListeners;
+  TimeChangedListeners _timeChangedListeners;
 };
 
 
@@ -82,6 +82,19 @@ AltitudeMode Geometry::altitudeMode () const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add to the batch for the owner. Only geometries that know how can be 
+//  batched.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Geometry::batch ( GeometryBatch&, Feature*, Style::RefPtr, IPlanetCoordinates *, IElevationDatabase* )
+{
+  return false;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Build the scene branch.
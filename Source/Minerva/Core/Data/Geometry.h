@@ -35,6 +35,9 @@ namespace Minerva {
 namespace Core {
 namespace Data {
 
+class Feature;
+class GeometryBatch;
+
 class MINERVA_EXPORT Geometry : public Minerva::Core::Data::Object
 {
 public:
@@ -50,6 +53,9 @@ public:
   void                  altitudeMode ( AltitudeMode mode );
   AltitudeMode          altitudeMode() const;
 
+  /// Add to the batch for the owner. Returns false if the geometry needs a scene branch of its own.
+  virtual bool          batch ( GeometryBatch& batch, Feature* owner, Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation );
+
   /// Build the scene branch.
   osg::Node*            buildScene ( Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation );
   
@@ -0,0 +1,585 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Merges the geometry of many features into a few large vertex buffers.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Data/GeometryBatch.h"
+#include "Minerva/Core/Data/UserData.h"
+
+#include "Minerva/OsgTools/StateSet.h"
+
+#include "osg/Geode"
+#include "osg/Geometry"
+#include "osg/MatrixTransform"
+#include "osg/PolygonOffset"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Minerva::Core::Data;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The arrays for the features that share a key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct GeometryBatch::Merged
+{
+  Merged() :
+    numVertices ( 0 ),
+    numIndices ( 0 ),
+    numPrimitives ( 0 ),
+    vertices(),
+    colors(),
+    elements(),
+    userData()
+  {
+  }
+
+  unsigned int numVertices;
+  unsigned int numIndices;
+  unsigned int numPrimitives;
+  osg::ref_ptr<osg::Vec3Array> vertices;
+  osg::ref_ptr<osg::Vec4ubArray> colors;
+  osg::ref_ptr<osg::DrawElementsUInt> elements;
+  osg::ref_ptr<BatchUserData> userData;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helper functions.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  // Floats have about a centimeter of precision this far from the origin.
+  const double TILE_SIZE ( 100000.0 );
+
+  inline unsigned char toByte ( float value )
+  {
+    return static_cast<unsigned char> ( std::max ( 0.0f, std::min ( 1.0f, value ) ) * 255.0f + 0.5f );
+  }
+
+  inline unsigned int verticesPerPrimitive ( unsigned int mode )
+  {
+    return ( GL_LINES == mode ? 2 : 3 );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Key constructor. The tile is the one the vertex is in.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::Key::Key ( unsigned int m, float w, unsigned int r, bool d, const Vertex& v ) :
+  mode ( m ),
+  width ( w ),
+  renderBin ( r ),
+  depthTest ( d )
+{
+  for ( unsigned int i = 0; i < 3; ++i )
+  {
+    tile[i] = static_cast<int> ( std::floor ( v[i] / Helper::TILE_SIZE ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Compare the keys.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryBatch::Key::operator < ( const Key& rhs ) const
+{
+  if ( mode != rhs.mode )
+    return mode < rhs.mode;
+  if ( width != rhs.width )
+    return width < rhs.width;
+  if ( renderBin != rhs.renderBin )
+    return renderBin < rhs.renderBin;
+  if ( depthTest != rhs.depthTest )
+    return depthTest < rhs.depthTest;
+  return std::lexicographical_compare ( tile, tile + 3, rhs.tile, rhs.tile + 3 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Are the keys the same?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryBatch::Key::operator == ( const Key& rhs ) const
+{
+  return ( false == ( *this < rhs ) && false == ( rhs < *this ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the center of the tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::Vertex GeometryBatch::Key::origin() const
+{
+  return Vertex ( ( tile[0] + 0.5 ) * Helper::TILE_SIZE, 
+                  ( tile[1] + 0.5 ) * Helper::TILE_SIZE, 
+                  ( tile[2] + 0.5 ) * Helper::TILE_SIZE );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Piece constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::Piece::Piece ( const Key& k, const Color& c ) :
+  key ( k ),
+  color ( c ),
+  vertices(),
+  indices()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Owner constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::Owner::Owner() :
+  feature(),
+  id(),
+  visible ( true ),
+  pieces()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Batch constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::Batch::Batch() :
+  owners(),
+  node(),
+  dirty ( true )
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::GeometryBatch() :
+  _owners(),
+  _batches(),
+  _root ( new osg::Group ),
+  _dirty ( false )
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GeometryBatch::~GeometryBatch()
+{
+  _owners.clear();
+  _batches.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the size of the tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double GeometryBatch::tileSize()
+{
+  return Helper::TILE_SIZE;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the piece to the owner and to its batch.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryBatch::_add ( Feature* feature, const Piece& piece )
+{
+  Owners::iterator iter ( _owners.find ( feature ) );
+  if ( _owners.end() == iter )
+  {
+    iter = _owners.insert ( Owners::value_type ( feature, Owner() ) ).first;
+    iter->second.feature = feature;
+    iter->second.id = feature->objectId();
+    iter->second.visible = feature->visibility();
+  }
+
+  iter->second.pieces.push_back ( piece );
+
+  Batch &batch ( _batches[piece.key] );
+  batch.owners.insert ( feature );
+  batch.dirty = true;
+
+  _dirty = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Mark the batches that the owner is in as changed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryBatch::_dirtyBatches ( const Owner& owner )
+{
+  for ( std::vector<Piece>::const_iterator piece = owner.pieces.begin(); piece != owner.pieces.end(); ++piece )
+  {
+    Batches::iterator iter ( _batches.find ( piece->key ) );
+    if ( _batches.end() != iter )
+      iter->second.dirty = true;
+  }
+
+  _dirty = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a line strip for the feature. It's stored as separate segments, so
+//  all the lines with the same state are drawn with one call. The strip goes
+//  in the tile of its first vertex.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryBatch::lines ( Feature* owner, const Vertices& strip, const Color& color, float width, unsigned int renderBin )
+{
+  if ( 0x0 == owner || strip.size() < 2 )
+    return;
+
+  Piece piece ( Key ( GL_LINES, width, renderBin, true, strip.front() ), color );
+  piece.vertices = strip;
+  piece.indices.reserve ( ( strip.size() - 1 ) * 2 );
+
+  for ( unsigned int i = 1; i < strip.size(); ++i )
+  {
+    piece.indices.push_back ( i - 1 );
+    piece.indices.push_back ( i );
+  }
+
+  this->_add ( owner, piece );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add triangles for the feature. They go in the tile of the first vertex.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryBatch::triangles ( Feature* owner, const Vertices& vertices, const Indices& indices, const Color& color, unsigned int renderBin, bool depthTest )
+{
+  if ( 0x0 == owner || indices.size() < 3 || vertices.empty() )
+    return;
+
+  Piece piece ( Key ( GL_TRIANGLES, 1.0f, renderBin, depthTest, vertices.front() ), color );
+  piece.vertices = vertices;
+  piece.indices.assign ( indices.begin(), indices.end() - ( indices.size() % 3 ) );
+
+  this->_add ( owner, piece );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the feature. Only the batches it was in are merged again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryBatch::remove ( Feature* owner )
+{
+  Owners::iterator iter ( _owners.find ( owner ) );
+  if ( _owners.end() == iter )
+    return false;
+
+  for ( std::vector<Piece>::const_iterator piece = iter->second.pieces.begin(); piece != iter->second.pieces.end(); ++piece )
+  {
+    Batches::iterator batch ( _batches.find ( piece->key ) );
+    if ( _batches.end() != batch )
+    {
+      batch->second.owners.erase ( owner );
+      batch->second.dirty = true;
+    }
+  }
+
+  _owners.erase ( iter );
+  _dirty = true;
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove all the features.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void GeometryBatch::clear()
+{
+  _owners.clear();
+  _batches.clear();
+  _root->removeChildren ( 0, _root->getNumChildren() );
+  _dirty = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the feature in the batch?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryBatch::contains ( Feature* owner ) const
+{
+  return _owners.end() != _owners.find ( owner );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of batches.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int GeometryBatch::numBatches() const
+{
+  return static_cast<unsigned int> ( _batches.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Has anything changed since the scene was built? The features don't have
+//  a node of their own to hide, so their visibility is checked here.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool GeometryBatch::dirty() const
+{
+  if ( _dirty )
+    return true;
+
+  for ( Owners::const_iterator iter = _owners.begin(); iter != _owners.end(); ++iter )
+  {
+    const Owner &owner ( iter->second );
+    if ( owner.visible != owner.feature->visibility() )
+      return true;
+  }
+
+  return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the scene. Only the batches with a feature that was added, removed,
+//  shown or hidden are merged again. The others keep their node.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+osg::Node* GeometryBatch::buildScene()
+{
+  // The batches of the features that were shown or hidden changed.
+  for ( Owners::iterator iter = _owners.begin(); iter != _owners.end(); ++iter )
+  {
+    Owner &owner ( iter->second );
+    const bool visible ( owner.feature->visibility() );
+    if ( visible != owner.visible )
+    {
+      owner.visible = visible;
+      this->_dirtyBatches ( owner );
+    }
+  }
+
+  _dirty = false;
+
+  Batches::iterator iter ( _batches.begin() );
+  while ( _batches.end() != iter )
+  {
+    Batch &batch ( iter->second );
+    if ( false == batch.dirty )
+    {
+      ++iter;
+      continue;
+    }
+
+    osg::ref_ptr<osg::Node> node ( batch.owners.empty() ? 0x0 : this->_buildBatch ( iter->first, batch ) );
+
+    if ( batch.node.valid() && node.valid() )
+      _root->replaceChild ( batch.node.get(), node.get() );
+    else if ( batch.node.valid() )
+      _root->removeChild ( batch.node.get() );
+    else if ( node.valid() )
+      _root->addChild ( node.get() );
+
+    batch.node = node;
+    batch.dirty = false;
+
+    // Batches without features are gone.
+    if ( batch.owners.empty() )
+      _batches.erase ( iter++ );
+    else
+      ++iter;
+  }
+
+  return ( _root->getNumChildren() > 0 ? _root.get() : 0x0 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Merge the visible features of the batch. The arrays are sized first, so 
+//  each is allocated once. Returns null if none are visible.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+osg::Node* GeometryBatch::_buildBatch ( const Key& key, const Batch& batch ) const
+{
+  Merged m;
+
+  // Count what goes in the batch.
+  for ( std::set<Feature*>::const_iterator iter = batch.owners.begin(); iter != batch.owners.end(); ++iter )
+  {
+    Owners::const_iterator owner ( _owners.find ( *iter ) );
+    if ( _owners.end() == owner || false == owner->second.visible )
+      continue;
+
+    const std::vector<Piece> &pieces ( owner->second.pieces );
+    for ( std::vector<Piece>::const_iterator piece = pieces.begin(); piece != pieces.end(); ++piece )
+    {
+      if ( key == piece->key )
+      {
+        m.numVertices += piece->vertices.size();
+        m.numIndices += piece->indices.size();
+      }
+    }
+  }
+
+  if ( 0 == m.numIndices )
+    return 0x0;
+
+  m.vertices = new osg::Vec3Array;
+  m.vertices->reserve ( m.numVertices );
+  m.colors = new osg::Vec4ubArray;
+  m.colors->reserve ( m.numVertices );
+  m.elements = new osg::DrawElementsUInt ( key.mode );
+  m.elements->reserve ( m.numIndices );
+  m.userData = new BatchUserData;
+
+  // Fill the arrays. The vertices are moved close to the origin of the tile.
+  const Vertex origin ( key.origin() );
+
+  for ( std::set<Feature*>::const_iterator iter = batch.owners.begin(); iter != batch.owners.end(); ++iter )
+  {
+    Owners::const_iterator owner ( _owners.find ( *iter ) );
+    if ( _owners.end() == owner || false == owner->second.visible )
+      continue;
+
+    const std::vector<Piece> &pieces ( owner->second.pieces );
+    for ( std::vector<Piece>::const_iterator piece = pieces.begin(); piece != pieces.end(); ++piece )
+    {
+      if ( false == ( key == piece->key ) )
+        continue;
+
+      m.userData->add ( m.numPrimitives, owner->second.id );
+      m.numPrimitives += piece->indices.size() / Helper::verticesPerPrimitive ( key.mode );
+
+      const unsigned int first ( m.vertices->size() );
+      for ( Indices::const_iterator index = piece->indices.begin(); index != piece->indices.end(); ++index )
+      {
+        m.elements->push_back ( first + *index );
+      }
+
+      for ( Vertices::const_iterator vertex = piece->vertices.begin(); vertex != piece->vertices.end(); ++vertex )
+      {
+        const Vertex v ( *vertex - origin );
+        m.vertices->push_back ( osg::Vec3f ( v[0], v[1], v[2] ) );
+      }
+
+      const osg::Vec4ub color ( Helper::toByte ( piece->color[0] ), Helper::toByte ( piece->color[1] ),
+                                Helper::toByte ( piece->color[2] ), Helper::toByte ( piece->color[3] ) );
+      m.colors->insert ( m.colors->end(), piece->vertices.size(), color );
+    }
+  }
+
+  // One buffer for all the features. Display lists don't help with this much data.
+  osg::ref_ptr<osg::Geometry> geometry ( new osg::Geometry );
+  geometry->setVertexArray ( m.vertices.get() );
+  geometry->setColorArray ( m.colors.get() );
+  geometry->setColorBinding ( osg::Geometry::BIND_PER_VERTEX );
+  geometry->addPrimitiveSet ( m.elements.get() );
+  geometry->setUseDisplayList ( false );
+  geometry->setUseVertexBufferObjects ( true );
+
+  osg::ref_ptr<osg::Geode> geode ( new osg::Geode );
+  geode->addDrawable ( geometry.get() );
+  geode->setUserData ( m.userData.get() );
+
+  // Set the state once for the batch.
+  osg::ref_ptr<osg::StateSet> ss ( geode->getOrCreateStateSet() );
+  OsgTools::State::StateSet::setLighting ( ss.get(), false );
+  ss->setRenderBinDetails ( key.renderBin, "RenderBin" );
+
+  if ( GL_LINES == key.mode )
+  {
+    OsgTools::State::StateSet::setLineWidth ( ss.get(), key.width );
+  }
+  else
+  {
+    osg::ref_ptr<osg::PolygonOffset> po ( new osg::PolygonOffset ( 1.0f, 4.0f ) );
+    ss->setMode ( GL_POLYGON_OFFSET_FILL, osg::StateAttribute::ON | osg::StateAttribute::PROTECTED );
+    ss->setAttribute ( po.get(), osg::StateAttribute::ON | osg::StateAttribute::PROTECTED );
+  }
+
+  if ( false == key.depthTest )
+  {
+    ss->setMode ( GL_DEPTH_TEST, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE );
+  }
+
+  osg::ref_ptr<osg::MatrixTransform> mt ( new osg::MatrixTransform );
+  mt->setMatrix ( osg::Matrixd::translate ( osg::Vec3d ( origin[0], origin[1], origin[2] ) ) );
+  mt->addChild ( geode.get() );
+
+  return mt.release();
+}
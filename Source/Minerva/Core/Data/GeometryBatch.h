@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Merges the geometry of many features into a few large vertex buffers.
+//  Features with the same state (primitive type, line width, render bin and
+//  depth test) in the same tile share one osg::Geometry, with the color in
+//  each vertex. Each tile has its own origin, so the vertices keep their
+//  precision as floats. Only the batches that changed are merged again.
+//  Each geode has a BatchUserData, which maps the primitive that was picked
+//  back to the feature's id.
+//
+//  Not thread safe. The container keeps it under its own lock.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_DATA_GEOMETRY_BATCH_H__
+#define __MINERVA_CORE_DATA_GEOMETRY_BATCH_H__
+
+#include "Minerva/Core/Export.h"
+#include "Minerva/Core/Data/ColorStyle.h"
+#include "Minerva/Core/Data/Feature.h"
+
+#include "Usul/Math/Vector3.h"
+
+#include "osg/Group"
+#include "osg/ref_ptr"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace Data {
+
+
+class MINERVA_EXPORT GeometryBatch
+{
+public:
+
+  typedef ColorStyle::Color                 Color;
+  typedef Usul::Math::Vec3d                 Vertex;
+  typedef std::vector<Vertex>               Vertices;
+  typedef std::vector<unsigned int>         Indices;
+
+  GeometryBatch();
+  ~GeometryBatch();
+
+  /// Build the scene from the visible features. Only the batches that changed
+  /// are merged again, and the same group is returned each time. Returns null
+  /// if there is nothing to draw.
+  osg::Node*                  buildScene();
+
+  /// Remove all the features.
+  void                        clear();
+
+  /// Is the feature in the batch?
+  bool                        contains ( Feature* owner ) const;
+
+  /// Has anything changed since the scene was built? This includes the visibility of the features.
+  bool                        dirty() const;
+
+  /// Add a line strip for the feature. The vertices are in planet coordinates.
+  void                        lines ( Feature* owner, const Vertices& strip, const Color& color, float width, unsigned int renderBin );
+
+  /// Get the number of batches.
+  unsigned int                numBatches() const;
+
+  /// Remove the feature. Returns true if it was in the batch.
+  bool                        remove ( Feature* owner );
+
+  /// Get the size of the tiles. Batches are split into tiles, so each has an origin near its vertices.
+  static double               tileSize();
+
+  /// Add triangles for the feature. The vertices are in planet coordinates.
+  void                        triangles ( Feature* owner, const Vertices& vertices, const Indices& indices, const Color& color, unsigned int renderBin, bool depthTest );
+
+private:
+
+  // No copying or assignment.
+  GeometryBatch ( const GeometryBatch& );
+  GeometryBatch& operator = ( const GeometryBatch& );
+
+  // The state and the tile that a batch shares.
+  struct Key
+  {
+    Key ( unsigned int mode, float width, unsigned int renderBin, bool depthTest, const Vertex& v );
+    bool operator < ( const Key& rhs ) const;
+    bool operator == ( const Key& rhs ) const;
+
+    // The center of the tile.
+    Vertex                    origin() const;
+
+    unsigned int mode;
+    float width;
+    unsigned int renderBin;
+    bool depthTest;
+    int tile[3];
+  };
+
+  // Indices into the vertices, as GL_LINES or GL_TRIANGLES.
+  struct Piece
+  {
+    Piece ( const Key& key, const Color& color );
+
+    Key key;
+    Color color;
+    Vertices vertices;
+    Indices indices;
+  };
+
+  struct Owner
+  {
+    Owner();
+
+    Feature::RefPtr feature;
+    std::string id;
+    bool visible;
+    std::vector<Piece> pieces;
+  };
+
+  // The features that share a key, and their merged node.
+  struct Batch
+  {
+    Batch();
+
+    std::set<Feature*> owners;
+    osg::ref_ptr<osg::Node> node;
+    bool dirty;
+  };
+
+  // The arrays for a batch.
+  struct Merged;
+
+  typedef std::map<Feature*,Owner> Owners;
+  typedef std::map<Key,Batch> Batches;
+
+  void                        _add ( Feature* feature, const Piece& piece );
+  osg::Node*                  _buildBatch ( const Key& key, const Batch& batch ) const;
+  void                        _dirtyBatches ( const Owner& owner );
+
+  Owners _owners;
+  Batches _batches;
+  osg::ref_ptr<osg::Group> _root;
+  bool _dirty;
+};
+
+
+}
+}
+}
+
+#endif // __MINERVA_CORE_DATA_GEOMETRY_BATCH_H__
@@ -9,6 +9,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Core/Data/Line.h"
+#include "Minerva/Core/Data/ConvertToPlanet.h"
+#include "Minerva/Core/Data/GeometryBatch.h"
 #include "Minerva/Core/Algorithms/Resample.h"
 
 #include "Minerva/OsgTools/StateSet.h"
@@ -94,63 +96,118 @@ Line::Coordinates::RefPtr Line::coordinates() const
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Build the scene branch for the data object.
+//  Get the line style, or the default one.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-osg::Node* Line::_buildScene ( Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+namespace Helper
 {
-  LineStyle::RefPtr lineStyle;
-  if ( style )
+  LineStyle::RefPtr lineStyle ( Style::RefPtr style )
   {
-    lineStyle = style->linestyle();
-  }
-  
-  if ( !lineStyle )
-  {
-    lineStyle = new LineStyle;
+    LineStyle::RefPtr lineStyle;
+    if ( style )
+    {
+      lineStyle = style->linestyle();
+    }
+    
+    if ( !lineStyle )
+    {
+      lineStyle = new LineStyle;
+    }
+
+    return lineStyle;
   }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the scene branch for the data object.
+//
+///////////////////////////////////////////////////////////////////////////////
 
+osg::Node* Line::_buildScene ( Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+{
+  LineStyle::RefPtr lineStyle ( Helper::lineStyle ( style ) );
   return this->_buildScene ( lineStyle->color(), lineStyle->width(), planet, elevation );
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Build the scene branch for the data object.
+//  Add to the batch for the owner. Lines drawn with a shader, or blended,
+//  need their own state.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-osg::Node* Line::_buildScene ( const Color& color, float width, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+bool Line::batch ( GeometryBatch& batch, Feature* owner, Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation )
 {
-  //Guard guard ( this ); Was causing deadlock!
+  if ( true == this->useShader() || true == Geometry::isSemiTransparent ( style ) )
+    return false;
+
+  Coordinates::Vector points;
+  if ( true == this->_planetPoints ( planet, elevation, points ) )
+  {
+    LineStyle::RefPtr lineStyle ( Helper::lineStyle ( style ) );
+    batch.lines ( owner, points, lineStyle->color(), lineStyle->width(), this->renderBin() );
+  }
+
+  this->dirty ( false );
+  return true;
+}
+
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the points in planet coordinates.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Line::_planetPoints ( IPlanetCoordinates *planet, IElevationDatabase* elevation, Coordinates::Vector& points ) const
+{
   // Get the line data.
   Coordinates::RefPtr data ( this->coordinates() );
   
   // Make sure there are at least 2 points.
   if ( !data || true == data->empty() || !planet )
-    return 0x0;
+    return false;
 
   // TODO: Implement fit to ground.
+
+  // Get the heights and convert all the points at once.
+  points.assign ( data->begin(), data->end() );
+  Minerva::Core::Data::getElevationAtPoints ( points, elevation, this->altitudeMode() );
+  Minerva::Core::Data::convertToPlanet ( points, planet );
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the scene branch for the data object.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+osg::Node* Line::_buildScene ( const Color& color, float width, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+{
+  //Guard guard ( this ); Was causing deadlock!
+
+  // Get the points in planet coordinates.
+  Coordinates::Vector points;
+  if ( false == this->_planetPoints ( planet, elevation, points ) )
+    return 0x0;
   
   // Make the osg::Vec3Array.
   osg::ref_ptr< osg::Vec3Array > vertices ( new osg::Vec3Array );
-  vertices->reserve ( data->size() );
+  vertices->reserve ( points.size() );
 
-  Coordinates::value_type offset ( data->at ( 0 ) );
-  offset[2] = Minerva::Core::Data::getElevationAtPoint ( offset, elevation, this->altitudeMode() );
-  planet->convertToPlanet ( Usul::Math::Vec3d ( offset ), offset );
+  const Coordinates::value_type offset ( points.front() );
 
-  // Convert and move all the points so that the first point starts at (0,0,0).
-  for ( Coordinates::const_iterator iter = data->begin(); iter != data->end(); ++iter )
+  // Move all the points so that the first point starts at (0,0,0).
+  for ( Coordinates::Vector::const_iterator iter = points.begin(); iter != points.end(); ++iter )
   {
-    Coordinates::value_type v ( *iter );
-
-    v[2] = Minerva::Core::Data::getElevationAtPoint ( v, elevation, this->altitudeMode() );
-    planet->convertToPlanet ( Usul::Math::Vec3d ( v ), v );
-
-    Coordinates::value_type point ( v - offset );
+    Coordinates::value_type point ( *iter - offset );
     vertices->push_back ( osg::Vec3f ( point[0], point[1], point[2] ) );
   }
 
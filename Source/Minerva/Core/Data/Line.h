@@ -36,6 +36,9 @@ public:
 
   Line();
 
+  /// Add to the batch for the owner (Geometry).
+  virtual bool          batch ( GeometryBatch& batch, Feature* owner, Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation );
+
   /// Get/Set the coordinates.
   void                  coordinates ( Coordinates::RefPtr );
   Coordinates::RefPtr   coordinates() const;
@@ -57,6 +60,9 @@ protected:
   
 private:
   
+  // Get the points in planet coordinates. Returns false if there aren't any.
+  bool                  _planetPoints ( IPlanetCoordinates *planet, IElevationDatabase* elevation, Coordinates::Vector& points ) const;
+
   // Set proper state.
   void                  _setState ( osg::StateSet*, const Color& color, float width ) const;
 
@@ -66,25 +66,7 @@ Model::~Model()
 
 Model::Matrix Model::matrix ( Minerva::Common::IPlanetCoordinates* planet, Minerva::Common::IElevationDatabase* elevation ) const
 {
-#if 0
-  osg::Vec3d location ( this->location() );
-
-  // Get the height.
-  const double height ( Minerva::Core::Data::getElevationAtPoint ( location, elevation, this->altitudeMode() ) );
-
-  osg::Vec3d hpr ( this->orientation() );
-  const double heading ( hpr[0] ), tilt ( hpr[1] ), roll ( hpr[2] );
-  
-  osg::Matrixd R ( 0x0 != planet ? planet->planetRotationMatrix ( location[1], location[0], height, heading ) : osg::Matrixd() );
-  osg::Matrixd S ( osg::Matrixd::scale ( this->scale() * this->toMeters() ) );
-
-  Matrix result ( S *
-                  osg::Matrix::rotate ( osg::DegreesToRadians ( tilt ), osg::Vec3 ( 1.0, 0.0, 0.0 ) ) * 
-                  osg::Matrix::rotate ( osg::DegreesToRadians ( roll ), osg::Vec3 ( 0.0, 1.0, 0.0 ) ) * R );
-  return result;
-#else
   return Model::matrix ( this->location(), this->orientation(), this->scale(), this->toMeters(), this->altitudeMode(), planet, elevation );
-#endif
 }
 
 
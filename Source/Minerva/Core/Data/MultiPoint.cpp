@@ -9,6 +9,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Core/Data/MultiPoint.h"
+#include "Minerva/Core/Data/ConvertToPlanet.h"
 #include "Minerva/Core/Data/PointStyle.h"
 #include "Minerva/OsgTools/StateSet.h"
 #include "Minerva/OsgTools/ConvertVector.h"
@@ -111,19 +112,17 @@ osg::Node* MultiPoint::_buildScene ( Style::RefPtr style, IPlanetCoordinates *pl
   osg::ref_ptr< osg::Vec3Array > vertices ( new osg::Vec3Array );
   vertices->reserve ( data->size() );
 
-  Coordinates::value_type offset ( data->at ( 0 ) );
-  offset[2] = Minerva::Core::Data::getElevationAtPoint ( offset, elevation, this->altitudeMode() );
-  planet->convertToPlanet ( Usul::Math::Vec3d ( offset ), offset );
+  // Get the heights and convert all the points at once.
+  Coordinates::Vector points ( data->begin(), data->end() );
+  Minerva::Core::Data::getElevationAtPoints ( points, elevation, this->altitudeMode() );
+  Minerva::Core::Data::convertToPlanet ( points, planet );
+
+  const Coordinates::value_type offset ( points.at ( 0 ) );
   
-  // Convert and move all the points so that the first point starts at (0,0,0).
-  for ( Coordinates::const_iterator iter = data->begin(); iter != data->end(); ++iter )
+  // Move all the points so that the first point starts at (0,0,0).
+  for ( Coordinates::Vector::const_iterator iter = points.begin(); iter != points.end(); ++iter )
   {
-    Coordinates::value_type v ( *iter );
-
-    v[2] = Minerva::Core::Data::getElevationAtPoint ( v, elevation, this->altitudeMode() );
-    planet->convertToPlanet ( Usul::Math::Vec3d ( v ), v );
-
-    Coordinates::value_type point ( v - offset );
+    Coordinates::value_type point ( *iter - offset );
     vertices->push_back ( osg::Vec3f ( point[0], point[1], point[2] ) );
   }
 
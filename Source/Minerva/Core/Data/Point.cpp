@@ -114,10 +114,13 @@ osg::Node* Point::_buildScene ( Style::RefPtr style, IPlanetCoordinates *planet,
   /// Get the center from our data source.
   Usul::Math::Vec3d location ( this->point() );
 
+  // Get the ground once, it's used for the height and the bottom of the extrusion.
+  const AltitudeMode mode ( this->altitudeMode() );
+  const bool needGround ( 0x0 != elevation && ( ALTITUDE_MODE_ABSOLUTE != mode || this->extrude() ) );
+  const double height ( needGround ? elevation->elevationAtLatLong ( location[1], location[0] ) : 0.0 );
+
   // Set the height.
-  location[2] = Minerva::Core::Data::getElevationAtPoint ( location, elevation, this->altitudeMode() );
-  
-  const double height ( elevation ? elevation->elevationAtLatLong ( location[1], location[0] ) : 0.0 );
+  location[2] = Minerva::Core::Data::heightFromGround ( location[2], height, mode );
   
   // Convert to planet coordinates.
   if( planet )
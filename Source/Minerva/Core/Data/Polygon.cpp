@@ -9,6 +9,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Core/Data/Polygon.h"
+#include "Minerva/Core/Data/ConvertToPlanet.h"
+#include "Minerva/Core/Data/GeometryBatch.h"
 
 #include "Minerva/OsgTools/ConvertVector.h"
 #include "Minerva/OsgTools/StateSet.h"
@@ -23,9 +25,10 @@
 #include "osg/Geode"
 #include "osg/Geometry"
 
-#include "osgUtil/Tessellator"
 #include "osgUtil/SmoothingVisitor"
 
+#include <numeric>
+
 using namespace Minerva::Core::Data;
 
 
@@ -38,7 +41,10 @@ using namespace Minerva::Core::Data;
 Polygon::Polygon ( ) :
   BaseClass(),
   _outerBoundary(),
-  _boundaries()
+  _boundaries(),
+  _tessellatedRings(),
+  _points(),
+  _triangles()
 {
 }
 
@@ -64,6 +70,7 @@ void Polygon::outerBoundary ( Line::RefPtr line )
 {
   Guard guard ( this );
   _outerBoundary = line;
+  _tessellatedRings.clear();
 }
 
 
@@ -90,6 +97,7 @@ void Polygon::addInnerBoundary ( Line::RefPtr line )
 {
   Guard guard ( this->mutex() );
   _boundaries.push_back ( line );
+  _tessellatedRings.clear();
 }
 
 
@@ -127,45 +135,27 @@ namespace Detail
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Build geometry from vertices.
+//  Build geometry from the triangles.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-osg::Node* Polygon::_buildGeometry ( const PolyStyle& polyStyle, Minerva::Common::Coordinates::RefPtr inVertices, Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+osg::Node* Polygon::_buildGeometry ( const PolyStyle& polyStyle, Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation )
 {
-  // Make sure we have vertices.
-  if ( !inVertices || inVertices->size() < 3 )
+  Vertices convertedPoints;
+  Indices indices;
+  if ( false == this->_tessellate ( e, planet, elevation, convertedPoints, indices ) )
     return 0x0;
   
   // Vertices and normals.
   osg::ref_ptr<osg::Vec3Array> vertices ( new osg::Vec3Array );
   osg::ref_ptr<osg::Vec3Array> normals  ( new osg::Vec3Array );
-  osg::ref_ptr<osg::Vec4Array> colors  ( new osg::Vec4Array ( inVertices->size() ) );
+  osg::ref_ptr<osg::Vec4Array> colors  ( new osg::Vec4Array ( convertedPoints.size() ) );
   osg::Vec4f color ( Usul::Convert::Type<Color,osg::Vec4f>::convert ( polyStyle.color() ) );
   std::fill ( colors->begin(), colors->end(), color );
   
   // Reserve enough rooms.
-  vertices->reserve ( inVertices->size() );
-  normals->reserve ( inVertices->size() );
-  
-  Vertices convertedPoints;
-  convertedPoints.reserve ( inVertices->size() );
-  
-  // Expand the vertex.
-  e.expand ( inVertices->extents() );
-  
-  for ( Coordinates::const_iterator iter = inVertices->begin(); iter != inVertices->end(); ++iter )
-  {
-    Coordinates::value_type v0 ( *iter ), p0;
-    
-    if ( elevation )
-      v0[2] = Minerva::Core::Data::getElevationAtPoint ( v0, elevation, this->altitudeMode() );
-    
-    if ( planet )
-      planet->convertToPlanet ( v0, p0 );
-    
-    convertedPoints.push_back ( p0 );
-  }
+  vertices->reserve ( convertedPoints.size() );
+  normals->reserve ( convertedPoints.size() );
 
   // Subtract the first point from all vertices.
   const Vertices::value_type offset ( convertedPoints.front() );
@@ -191,14 +181,7 @@ osg::Node* Polygon::_buildGeometry ( const PolyStyle& polyStyle, Minerva::Common
   geom->setColorArray ( colors.get() );
   geom->setColorBinding ( osg::Geometry::BIND_PER_VERTEX );
   
-  geom->addPrimitiveSet ( new osg::DrawArrays ( GL_POLYGON, 0, vertices->size() ) );
-  
-  // Make into triangles.
-  osg::ref_ptr<osgUtil::Tessellator> tessellator ( new osgUtil::Tessellator );
-  tessellator->retessellatePolygons ( *geom );
-  
-  // Make normals.
-  osgUtil::SmoothingVisitor::smooth ( *geom );
+  geom->addPrimitiveSet ( new osg::DrawElementsUInt ( GL_TRIANGLES, indices.begin(), indices.end() ) );
   
   osg::ref_ptr<osg::Geode> geode ( new osg::Geode );
   geode->addDrawable ( geom.get() );
@@ -213,21 +196,165 @@ osg::Node* Polygon::_buildGeometry ( const PolyStyle& polyStyle, Minerva::Common
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Convert to planet coordinates.
+//  Convert the points to planet coordinates in place. The heights and the 
+//  conversion are each done with one call.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-Polygon::Vertex Polygon::_convertToPlanetCoordinates ( const Polygon::Vertex& v, Minerva::Common::IPlanetCoordinates* planet, Minerva::Common::IElevationDatabase* elevation ) const
+void Polygon::_convertToPlanetCoordinates ( Vertices& points, Minerva::Common::IPlanetCoordinates* planet, Minerva::Common::IElevationDatabase* elevation ) const
 {
-  Polygon::Vertex v0 ( v ), p0;
-  
-  if ( 0x0 != elevation )
-    v0[2] = Minerva::Core::Data::getElevationAtPoint ( v0, elevation, this->altitudeMode() );
-  
-  if ( 0x0 != planet )
-    planet->convertToPlanet ( v0, p0 );
-  
-  return p0;
+  Minerva::Core::Data::getElevationAtPoints ( points, elevation, this->altitudeMode() );
+  Minerva::Core::Data::convertToPlanet ( points, planet );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the rings that have enough points. The outer boundary is first.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Polygon::Rings Polygon::_rings() const
+{
+  Rings rings;
+
+  Line::RefPtr outer ( this->outerBoundary() );
+  Coordinates::RefPtr coordinates ( outer.valid() ? outer->coordinates() : Coordinates::RefPtr ( 0x0 ) );
+  if ( false == coordinates.valid() || coordinates->size() < 3 )
+    return rings;
+
+  rings.push_back ( coordinates );
+
+  const Boundaries inner ( Usul::Threads::Safe::get ( this->mutex(), _boundaries ) );
+  for ( Boundaries::const_iterator iter = inner.begin(); iter != inner.end(); ++iter )
+  {
+    coordinates = ( iter->valid() ? ( *iter )->coordinates() : Coordinates::RefPtr ( 0x0 ) );
+    if ( coordinates.valid() && coordinates->size() >= 3 )
+      rings.push_back ( coordinates );
+  }
+
+  return rings;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the triangles in longitude and latitude.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Polygon::tessellate()
+{
+  const Rings rings ( this->_rings() );
+
+  Minerva::Core::Algorithms::TessellatePoints points;
+  Minerva::Core::Algorithms::TessellateIndices sizes, triangles;
+
+  for ( Rings::const_iterator iter = rings.begin(); iter != rings.end(); ++iter )
+  {
+    sizes.push_back ( ( *iter )->size() );
+  }
+
+  // Use what we have if the rings are the same.
+  {
+    Guard guard ( this );
+    if ( rings == _tessellatedRings && std::accumulate ( sizes.begin(), sizes.end(), 0u ) == _points.size() )
+      return ( false == _triangles.empty() );
+  }
+
+  for ( Rings::const_iterator iter = rings.begin(); iter != rings.end(); ++iter )
+  {
+    points.insert ( points.end(), ( *iter )->begin(), ( *iter )->end() );
+  }
+
+  Minerva::Core::Algorithms::tessellate ( points, sizes, triangles );
+
+  Guard guard ( this );
+  _tessellatedRings = rings;
+  _points.swap ( points );
+  _triangles.swap ( triangles );
+  return ( false == _triangles.empty() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make triangles from the rings. The answer is in planet coordinates.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Polygon::_tessellate ( Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation, Vertices& answer, Indices& indices )
+{
+  if ( 0x0 == planet || false == this->tessellate() )
+    return false;
+
+  {
+    Guard guard ( this );
+    answer.assign ( _points.begin(), _points.end() );
+    indices.assign ( _triangles.begin(), _triangles.end() );
+  }
+
+  // Expand the extents by the outer boundary.
+  Line::RefPtr outer ( this->outerBoundary() );
+  Coordinates::RefPtr coordinates ( outer.valid() ? outer->coordinates() : Coordinates::RefPtr ( 0x0 ) );
+  if ( coordinates.valid() )
+    e.expand ( coordinates->extents() );
+
+  this->_convertToPlanetCoordinates ( answer, planet, elevation );
+
+  return ( false == indices.empty() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add to the batch for the owner. Extruded and blended polygons need their 
+//  own state.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Polygon::batch ( GeometryBatch& batch, Feature* owner, Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation )
+{
+  if ( true == this->extrude() || true == Geometry::isSemiTransparent ( style ) )
+    return false;
+
+  PolyStyle::RefPtr polyStyle;
+  if ( style )
+  {
+    polyStyle = style->polystyle();
+  }
+
+  if ( !polyStyle )
+  {
+    polyStyle = new PolyStyle;
+  }
+
+  Line::RefPtr line ( this->outerBoundary() );
+  if ( polyStyle->outline() && line && line->useShader() )
+    return false;
+
+  if ( polyStyle->fill() && line )
+  {
+    Extents e;
+    Vertices vertices;
+    Indices indices;
+    if ( this->_tessellate ( e, planet, elevation, vertices, indices ) )
+    {
+      // Don't depth test if we are clamping to ground, like the scene.
+      const bool depthTest ( ALTITUDE_MODE_CLAMP_TO_GROUND != this->altitudeMode() );
+      batch.triangles ( owner, vertices, indices, polyStyle->color(), this->renderBin(), depthTest );
+    }
+
+    this->extents ( e );
+  }
+
+  if ( polyStyle->outline() && line )
+  {
+    line->batch ( batch, owner, style, planet, elevation );
+  }
+
+  this->dirty ( false );
+  return true;
 }
 
 
@@ -239,7 +366,7 @@ Polygon::Vertex Polygon::_convertToPlanetCoordinates ( const Polygon::Vertex& v,
 
 osg::Node* Polygon::_extrudeToGround ( const PolyStyle& polyStyle, Minerva::Common::Coordinates::RefPtr inVertices, IPlanetCoordinates *planet, IElevationDatabase* elevation )
 {
-  if ( !inVertices )
+  if ( !inVertices || true == inVertices->empty() )
   {
     return 0x0;
   }
@@ -261,17 +388,22 @@ osg::Node* Polygon::_extrudeToGround ( const PolyStyle& polyStyle, Minerva::Comm
   Vertices convertedPoints;
   convertedPoints.reserve ( numVertices );
 
-  // Loop over the vertices.
+  // Each vertex and the one below it.
   for ( Coordinates::const_iterator iter = inVertices->begin(); iter != inVertices->end(); ++iter )
   {
     Vertex top ( *iter );
     Vertex bottom ( top ); bottom[2] = 0.0;
 
-    Vertex p0 ( this->_convertToPlanetCoordinates ( top, planet, elevation ) );
-    Vertex p1 ( this->_convertToPlanetCoordinates ( bottom, planet, elevation ) );
+    convertedPoints.push_back ( top );
+    convertedPoints.push_back ( bottom );
+  }
+
+  this->_convertToPlanetCoordinates ( convertedPoints, planet, elevation );
 
-    convertedPoints.push_back ( p0 );
-    convertedPoints.push_back ( p1 );
+  for ( Vertices::size_type i = 0; i + 1 < convertedPoints.size(); i += 2 )
+  {
+    Vertex p0 ( convertedPoints[i] );
+    Vertex p1 ( convertedPoints[i + 1] );
 
     p0.normalize();
     p1.normalize();
@@ -331,14 +463,10 @@ osg::Node* Polygon::_buildPolygons ( const PolyStyle& polyStyle, IPlanetCoordina
   if ( !outerBoundary )
     return 0x0;
   
-  // Need at least 3 points to make a polygon.
-
-  // TODO: Handle inner boundaries.
-  //Boundaries innerBoundaries ( polygon->innerBoundaries() );
-
   osg::ref_ptr<osg::Group> group ( new osg::Group );
   
-  group->addChild ( this->_buildGeometry ( polyStyle, outerBoundary->coordinates(), e, planet, elevation ) );
+  // The inner boundaries are holes in the triangles.
+  group->addChild ( this->_buildGeometry ( polyStyle, e, planet, elevation ) );
 
   // Extrude if we are suppose to.
   if ( true == this->extrude() )
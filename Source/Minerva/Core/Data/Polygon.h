@@ -12,6 +12,7 @@
 #define __MINERVA_POSTGIS_POLYGON_GEOMETRY_H__
 
 #include "Minerva/Core/Export.h"
+#include "Minerva/Core/Algorithms/Tessellate.h"
 #include "Minerva/Core/Data/Line.h"
 #include "Minerva/Core/Data/PolyStyle.h"
 
@@ -47,11 +48,21 @@ public:
   void                  addInnerBoundary ( Line::RefPtr );
   const Boundaries&     innerBoundaries() const;
 
+  /// Add to the batch for the owner (Geometry).
+  virtual bool          batch ( GeometryBatch& batch, Feature* owner, Style::RefPtr style, IPlanetCoordinates *planet, IElevationDatabase* elevation );
+
+  /// Make the triangles in longitude and latitude. They are kept until the 
+  /// boundaries change, so this can be called on another thread before the 
+  /// scene is built. Returns false if there are no triangles.
+  bool                  tessellate();
+
 protected:
   
   typedef Usul::Math::Vec3d            Vertex;
   typedef std::vector < Vertex >       Vertices;
+  typedef std::vector < unsigned int > Indices;
   typedef Minerva::Common::Coordinates Coordinates;
+  typedef std::vector<Coordinates::RefPtr> Rings;
   
   virtual ~Polygon();
   
@@ -60,15 +71,22 @@ protected:
   
   osg::Node*            _buildPolygons ( const PolyStyle& polyStyle, IPlanetCoordinates *planet, IElevationDatabase* elevation );
   
-  osg::Node*            _buildGeometry ( const PolyStyle& polyStyle, Coordinates::RefPtr inVertices, Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation );
+  osg::Node*            _buildGeometry ( const PolyStyle& polyStyle, Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation );
   osg::Node*            _extrudeToGround ( const PolyStyle& polyStyle, Coordinates::RefPtr, IPlanetCoordinates *planet, IElevationDatabase* elevation );
 
-  Vertex                _convertToPlanetCoordinates ( const Polygon::Vertex& v, IPlanetCoordinates* planet, IElevationDatabase* elevation ) const;
+  void                  _convertToPlanetCoordinates ( Vertices& points, IPlanetCoordinates* planet, IElevationDatabase* elevation ) const;
+
+  Rings                 _rings() const;
+
+  bool                  _tessellate ( Extents& e, IPlanetCoordinates *planet, IElevationDatabase* elevation, Vertices& vertices, Indices& indices );
 
 private:
   
   Line::RefPtr _outerBoundary;
   Boundaries _boundaries;
+  Rings _tessellatedRings;
+  Minerva::Core::Algorithms::TessellatePoints _points;
+  Minerva::Core::Algorithms::TessellateIndices _triangles;
 };
 
 }
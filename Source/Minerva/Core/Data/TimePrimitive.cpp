@@ -49,11 +49,23 @@ TimePrimitive::~TimePrimitive()
 
 bool TimePrimitive::_isVisible ( const Date& begin, const Date& end, const boost::posix_time::time_period& period ) const
 {
-  Date theEnd ( end ); theEnd.increment ( Date::INCREMENT_SECOND, 1 );
-
-  // This is [first,last), so for proper animation, make the object's last date one day past the actual last date.
-  boost::posix_time::time_period timespan ( begin.date(), theEnd.date() );
+  const Period timespan ( TimePrimitive::_period ( begin, end ) );
   
   const bool visible ( period.intersects ( timespan ) ? true : false );
   return visible;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the period from the first to the last date.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TimePrimitive::Period TimePrimitive::_period ( const Date& begin, const Date& end )
+{
+  Date theEnd ( end ); theEnd.increment ( Date::INCREMENT_SECOND, 1 );
+
+  // This is [first,last), so for proper animation, make the object's last date one second past the actual last date.
+  return Period ( begin.date(), theEnd.date() );
+}
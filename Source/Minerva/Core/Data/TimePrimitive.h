@@ -28,11 +28,15 @@ class MINERVA_EXPORT TimePrimitive : public Minerva::Core::Data::Object
 public:
   typedef Minerva::Core::Data::Object BaseClass;
   typedef Minerva::Core::Data::Date Date;
+  typedef boost::posix_time::time_period Period;
   
   USUL_DECLARE_REF_POINTERS ( TimePrimitive );
 
   virtual bool isVisible ( const boost::posix_time::time_period& ) const = 0;
 
+  /// Get the time this is visible, as [begin,end+1s).
+  virtual Period period() const = 0;
+
 protected:
   
   TimePrimitive();
@@ -40,6 +44,8 @@ protected:
 
   bool _isVisible ( const Date& begin, const Date& end, const boost::posix_time::time_period& ) const;
 
+  static Period _period ( const Date& begin, const Date& end );
+
 };
 
 
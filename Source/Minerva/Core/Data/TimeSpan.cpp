@@ -120,3 +120,15 @@ bool TimeSpan::isVisible ( const boost::posix_time::time_period& period ) const
 {
   return this->_isVisible ( this->begin(), this->end(), period );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the time this is visible.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TimeSpan::Period TimeSpan::period() const
+{
+  return TimeSpan::_period ( this->begin(), this->end() );
+}
@@ -37,6 +37,7 @@ public:
   Date  end() const;
   
   virtual bool isVisible ( const boost::posix_time::time_period& ) const;
+  virtual Period period() const;
 
 protected:
   
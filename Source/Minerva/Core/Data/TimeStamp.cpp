@@ -91,3 +91,16 @@ bool TimeStamp::isVisible ( const boost::posix_time::time_period& period ) const
 {
   return this->_isVisible ( this->when(), this->when(), period );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the time this is visible.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TimeStamp::Period TimeStamp::period() const
+{
+  const Date when ( this->when() );
+  return TimeStamp::_period ( when, when );
+}
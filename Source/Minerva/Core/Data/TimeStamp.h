@@ -33,6 +33,7 @@ public:
   Date  when() const;
 
   virtual bool isVisible ( const boost::posix_time::time_period& ) const;
+  virtual Period period() const;
 
 protected:
   
@@ -16,6 +16,9 @@
 
 #include "osg/Referenced"
 
+#include <algorithm>
+#include <vector>
+
 namespace Minerva {
 namespace Core {
 namespace Data {
@@ -32,11 +35,57 @@ struct MINERVA_EXPORT UserData : public osg::Referenced
     return _id;
   }
 
+  // Get the id of the object that the picked primitive belongs to.
+  virtual DataObject::ObjectID objectID ( unsigned int primitiveIndex ) const
+  {
+    return _id;
+  }
+
 private:
 
   DataObject::ObjectID _id;
 };
 
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  User data for geometry that many objects were merged into. Each object 
+//  has a range of primitives, added in order of the first primitive.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct MINERVA_EXPORT BatchUserData : public UserData
+{
+  BatchUserData() : 
+    UserData ( DataObject::ObjectID() ),
+    _firsts(),
+    _ids()
+  {
+  }
+
+  using UserData::objectID;
+
+  void add ( unsigned int firstPrimitive, const DataObject::ObjectID& id )
+  {
+    _firsts.push_back ( firstPrimitive );
+    _ids.push_back ( id );
+  }
+
+  virtual DataObject::ObjectID objectID ( unsigned int primitiveIndex ) const
+  {
+    std::vector<unsigned int>::const_iterator iter ( std::upper_bound ( _firsts.begin(), _firsts.end(), primitiveIndex ) );
+    if ( _firsts.begin() == iter )
+      return DataObject::ObjectID();
+
+    return _ids.at ( ( iter - _firsts.begin() ) - 1 );
+  }
+
+private:
+
+  std::vector<unsigned int> _firsts;
+  std::vector<DataObject::ObjectID> _ids;
+};
+
 }
 }
 }
@@ -14,9 +14,14 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Core/DiskCache.h"
+#include "Minerva/Core/ElevationFile.h"
+#include "Minerva/Core/ImageCache.h"
+#include "Minerva/Core/PackedTileStore.h"
+#include "Minerva/Core/VirtualFileSystem.h"
 
 #include "Usul/File/Temp.h"
 #include "Usul/Math/Absolute.h"
+#include "Usul/Registry/Database.h"
 #include "Usul/Scope/Caller.h"
 #include "Usul/Strings/Format.h"
 #include "Usul/Threads/Guard.h"
@@ -28,9 +33,11 @@
 #include "boost/filesystem.hpp"
 
 #include "osgDB/ReadFile"
+#include "osgDB/Registry"
 #include "osgDB/WriteFile"
 
 #include <iomanip>
+#include <iostream>
 #include <sstream>
 
 using namespace Minerva::Core;
@@ -71,7 +78,10 @@ DiskCache::DiskCache() :
   _readerMutex ( new Usul::Threads::Mutex ),
   _writerMutex ( new Usul::Threads::Mutex ),
   _cacheDirMutex ( new Usul::Threads::Mutex ),
-  _baseCacheDirectory ( Usul::File::Temp::directory() + "/Minerva" )
+  _baseCacheDirectory ( Usul::File::Temp::directory() + "/Minerva" ),
+  _tileStore ( 0x0 ),
+  _tileStoreChecked ( false ),
+  _tileStoreSet ( false )
 {
 }
 
@@ -87,6 +97,7 @@ DiskCache::~DiskCache()
   delete _readerMutex;
   delete _writerMutex;
   delete _cacheDirMutex;
+  _tileStore = 0x0;
 }
 
 
@@ -100,6 +111,13 @@ void DiskCache::cacheDirectory ( const std::string& directory )
 {
   Usul::Threads::Guard<Usul::Threads::Mutex> guard ( *_cacheDirMutex );
   _baseCacheDirectory = directory;
+
+  // Look for a store in the new directory, unless one was set.
+  if ( false == _tileStoreSet )
+  {
+    _tileStore = 0x0;
+    _tileStoreChecked = false;
+  }
 }
 
 
@@ -116,6 +134,199 @@ std::string DiskCache::cacheDirectory() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the tile store.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DiskCache::tileStore ( TileStore::RefPtr store )
+{
+  Usul::Threads::Guard<Usul::Threads::Mutex> guard ( *_cacheDirMutex );
+  _tileStore = store;
+  _tileStoreChecked = true;
+  _tileStoreSet = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the tile store. The first time, open the one in the registry. Other 
+//  threads wait here while it opens, so they all see the same store.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DiskCache::TileStore::RefPtr DiskCache::tileStore() const
+{
+  Usul::Threads::Guard<Usul::Threads::Mutex> guard ( *_cacheDirMutex );
+
+  if ( false == _tileStoreChecked )
+  {
+    _tileStoreChecked = true;
+
+    Usul::Registry::Node &node ( Usul::Registry::Database::instance()["disk_cache"]["packed_store"] );
+    if ( true == node["enabled"].get<bool> ( false, true ) )
+    {
+      const std::string directory ( Usul::Strings::format ( _baseCacheDirectory, "/Packed" ) );
+      const Usul::Types::Uint64 megaBytes ( node["segment_size_mb"].get<unsigned int> ( 256, true ) );
+
+      // Only one process can have the store open. Use one file per tile if 
+      // another one has it.
+      try
+      {
+        _tileStore = new PackedTileStore ( directory, megaBytes * 1024 * 1024 );
+      }
+      catch ( const std::exception &e )
+      {
+        std::cout << "Error 1582609917: Could not open tile store, using one file per tile. " << e.what() << std::endl;
+      }
+    }
+  }
+
+  return _tileStore;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read an image from the tile store.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DiskCache::ImagePtr DiskCache::readImage ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension ) const
+{
+  TileStore::RefPtr store ( this->tileStore() );
+  if ( false == store.valid() )
+    return ImagePtr ( 0x0 );
+
+  TileStore::Buffer buffer;
+  if ( false == store->read ( layerKey, tileKey, width, height, extension, buffer ) )
+    return ImagePtr ( 0x0 );
+
+  return DiskCache::decodeImage ( buffer, extension );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Decode the image from memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DiskCache::ImagePtr DiskCache::decodeImage ( const TileStore::Buffer& buffer, const std::string& extension )
+{
+  if ( true == buffer.empty() )
+    return ImagePtr ( 0x0 );
+
+  osgDB::ReaderWriter *rw ( osgDB::Registry::instance()->getReaderWriterForExtension ( extension ) );
+  if ( 0x0 == rw )
+    return ImagePtr ( 0x0 );
+
+  std::istringstream in ( std::string ( buffer.begin(), buffer.end() ), std::ios::in | std::ios::binary );
+  osgDB::ReaderWriter::ReadResult result ( rw->readImage ( in ) );
+  return ( result.success() ? ImagePtr ( result.getImage() ) : ImagePtr ( 0x0 ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the encoded tile into the tile store.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DiskCache::storeTile ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, const TileStore::Buffer& buffer )
+{
+  TileStore::RefPtr store ( this->tileStore() );
+  if ( false == store.valid() || buffer.empty() )
+    return;
+
+  store->write ( layerKey, tileKey, width, height, extension, buffer );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Encode the image and write it into the tile store.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DiskCache::storeImage ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, ImagePtr image )
+{
+  if ( false == image.valid() || false == this->tileStore().valid() )
+    return;
+
+  osgDB::ReaderWriter *rw ( osgDB::Registry::instance()->getReaderWriterForExtension ( extension ) );
+  if ( 0x0 == rw )
+    return;
+
+  std::string encoded;
+  {
+    Usul::Threads::Guard<Usul::Threads::Mutex> guard ( *_writerMutex );
+
+    std::ostringstream out ( std::ios::out | std::ios::binary );
+    osgDB::ReaderWriter::WriteResult result ( rw->writeImage ( *image, out ) );
+    if ( false == result.success() )
+      return;
+
+    encoded = out.str();
+  }
+
+  this->storeTile ( layerKey, tileKey, width, height, extension, TileStore::Buffer ( encoded.begin(), encoded.end() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the elevation.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ElevationData::RefPtr DiskCache::readElevation ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height )
+{
+  TileStore::RefPtr store ( this->tileStore() );
+  if ( true == store.valid() )
+  {
+    TileStore::Buffer buffer;
+    if ( false == store->read ( layerKey, tileKey, width, height, ElevationFile::extension(), buffer ) || buffer.empty() )
+      return ElevationData::RefPtr ( 0x0 );
+
+    return ElevationFile::decode ( &buffer[0], buffer.size() );
+  }
+
+  if ( true == layerKey.name().empty() )
+    return ElevationData::RefPtr ( 0x0 );
+
+  // Map the file without checking it first. A missing tile is written after 
+  // this returns null, and that makes the directory.
+  return ElevationFile::read ( this->_cacheFilename ( layerKey, tileKey, width, height, ElevationFile::extension() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the elevation.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DiskCache::writeElevation ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const IElevationData& data )
+{
+  TileStore::RefPtr store ( this->tileStore() );
+  if ( true == store.valid() )
+  {
+    TileStore::Buffer buffer;
+    ElevationFile::encode ( data, buffer );
+    store->write ( layerKey, tileKey, width, height, ElevationFile::extension(), buffer );
+    return;
+  }
+
+  std::string filename;
+  if ( CACHE_STATUS_FILE_NAME_ERROR == this->getAndCheckCacheFilename ( layerKey, tileKey, width, height, ElevationFile::extension(), filename ) )
+    return;
+
+  ElevationFile::write ( filename, data );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Read an image file.
@@ -124,6 +335,11 @@ std::string DiskCache::cacheDirectory() const
 
 DiskCache::ImagePtr DiskCache::readImage ( const std::string& filename, ReaderPtr reader ) const
 {
+  // Files in a mounted archive are read from memory.
+  VirtualFileSystem &vfs ( VirtualFileSystem::instance() );
+  if ( vfs.contains ( filename ) )
+    return vfs.readImage ( filename );
+
   // Try to use the given reader.
   if ( reader.valid() )
     return reader->readImageFile ( filename );
@@ -294,6 +510,13 @@ std::string DiskCache::getCacheDirectory ( const LayerKey& layerKey, const TileK
 
 void DiskCache::deleteCache ( const LayerKey& layerKey )
 {
+  // Decoded images for the layer are no longer valid either.
+  Minerva::Core::ImageCache::instance().remove ( layerKey );
+
+  TileStore::RefPtr store ( this->tileStore() );
+  if ( store.valid() )
+    store->remove ( layerKey );
+
   const std::string directory ( Minerva::Core::DiskCache::buildCacheDir ( layerKey.name(), layerKey.id() ) );
 
   if ( boost::filesystem::exists ( directory ) && boost::filesystem::is_directory ( directory ) )
@@ -303,7 +526,8 @@ void DiskCache::deleteCache ( const LayerKey& layerKey )
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get the cache filename.
+//  Get the cache filename. When there is a tile store the filename is empty, 
+//  because tiles are read from and written to the store.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -317,26 +541,45 @@ DiskCache::CacheStatus DiskCache::getAndCheckCacheFilename ( const LayerKey& lay
   if ( true == layerKey.name().empty() )
     return CACHE_STATUS_FILE_NAME_ERROR;
 
+  // With a tile store there are no per-tile files to make or check.
+  if ( true == this->tileStore().valid() )
+  {
+    filename.clear();
+    return CACHE_STATUS_FILE_DOES_NOT_EXIST;
+  }
+
   // Make the directory. Guard it so that it's atomic.
-  const std::string baseDir ( Minerva::Core::DiskCache::instance().getCacheDirectory ( layerKey, key, width, height ) );
   {
     Guard guard ( *_writerMutex );
-    boost::filesystem::create_directories ( baseDir );
+    boost::filesystem::create_directories ( this->getCacheDirectory ( layerKey, key, width, height ) );
   }
 
   // Make the file name.
-  filename = Usul::Strings::format (
-    baseDir, Minerva::Core::DiskCache::makeExtentsString ( key.extents() ), '.', extension );
+  filename = this->_cacheFilename ( layerKey, key, width, height, extension );
 
   // If the file does not exist then return.
   if ( false == boost::filesystem::exists ( filename ) )
     return CACHE_STATUS_FILE_DOES_NOT_EXIST;
 
-  // If the file is empty then remove it.
+  // If the file is empty then remove it and make it again.
   if ( 0 == boost::filesystem::file_size ( filename ) )
   {
     boost::filesystem::remove ( filename );
+    return CACHE_STATUS_FILE_DOES_NOT_EXIST;
   }
 
   return CACHE_STATUS_FILE_OK;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the cache filename without touching the file system.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string DiskCache::_cacheFilename ( const LayerKey& layerKey, const TileKey& key, unsigned int width, unsigned int height, const std::string& extension ) const
+{
+  return Usul::Strings::format ( 
+    this->getCacheDirectory ( layerKey, key, width, height ), Minerva::Core::DiskCache::makeExtentsString ( key.extents() ), '.', extension );
+}
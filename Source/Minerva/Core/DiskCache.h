@@ -17,6 +17,8 @@
 #define __MINERVA_CORE_DISK_CACHE_H__
 
 #include "Minerva/Core/Export.h"
+#include "Minerva/Core/ElevationData.h"
+#include "Minerva/Core/TileStore.h"
 
 #include "Minerva/Common/Extents.h"
 #include "Minerva/Common/IReadImageFile.h"
@@ -39,11 +41,13 @@ class MINERVA_EXPORT DiskCache
 public:
 
   typedef Minerva::Common::Extents Extents;
+  typedef Minerva::Common::IElevationData IElevationData;
   typedef osg::ref_ptr<osg::Image> ImagePtr;
   typedef Minerva::Common::IReadImageFile IReadImageFile;
   typedef IReadImageFile::RefPtr ReaderPtr;
   typedef Minerva::Common::LayerKey LayerKey;
   typedef Minerva::Common::TileKey TileKey;
+  typedef Minerva::Core::TileStore TileStore;
 
   static DiskCache& instance();
 
@@ -51,10 +55,33 @@ public:
   void cacheDirectory ( const std::string& directory );
   std::string cacheDirectory() const;
 
+  /// Set/get the tile store. When there is one, tiles are kept in the store instead of one file 
+  /// per tile. If none was set, the first get opens a packed store in the cache directory when 
+  /// the registry has disk_cache/packed_store/enabled set to true.
+  void              tileStore ( TileStore::RefPtr store );
+  TileStore::RefPtr tileStore() const;
+
   // Read and write.
   ImagePtr readImage ( const std::string& filename, ReaderPtr reader ) const;
   void     writeImage ( const std::string& filename, ImagePtr image );
 
+  // Read from the tile store. Returns null if there is no store or the tile is not in it.
+  ImagePtr readImage ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension ) const;
+
+  // Write the encoded tile into the tile store. Does nothing if there is no store.
+  void     storeTile ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, const TileStore::Buffer& buffer );
+
+  // Encode the image and write it into the tile store. Does nothing if there is no store.
+  void     storeImage ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, ImagePtr image );
+
+  // Decode the image from memory. Returns null if it can't be read.
+  static ImagePtr decodeImage ( const TileStore::Buffer& buffer, const std::string& extension );
+
+  // Read and write elevation in the native format, from the tile store if there is one. 
+  // Returns null if the tile hasn't been written.
+  ElevationData::RefPtr readElevation ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height );
+  void                  writeElevation ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const IElevationData& data );
+
   std::string getCacheDirectory ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height ) const;
   std::string getCacheDirectory ( const LayerKey& layerKey, const TileKey& tileKey ) const;
 
@@ -70,6 +97,8 @@ public:
     CACHE_STATUS_FILE_NAME_ERROR
   };
 
+  // When there is a tile store the filename is empty. Check the store with 
+  // readImage, and write the tile with storeTile or storeImage.
   CacheStatus getAndCheckCacheFilename ( const LayerKey& layerKey,
                                          const TileKey& key,
                                          unsigned int width,
@@ -83,6 +112,8 @@ private:
   static std::string makeDirectoryString ( const std::string& cacheDir, unsigned int width, unsigned int height, unsigned int level );
   static std::string makeLevelString ( unsigned int level );
 
+  std::string _cacheFilename ( const LayerKey& layerKey, const TileKey& key, unsigned int width, unsigned int height, const std::string& extension ) const;
+
   DiskCache();
   ~DiskCache();
 
@@ -90,6 +121,9 @@ private:
   Usul::Threads::Mutex *_writerMutex;
   Usul::Threads::Mutex *_cacheDirMutex;
   std::string _baseCacheDirectory;
+  mutable TileStore::RefPtr _tileStore;
+  mutable bool _tileStoreChecked;
+  bool _tileStoreSet;
 
   static DiskCache *_instance;
 };
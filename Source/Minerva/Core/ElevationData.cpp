@@ -15,6 +15,9 @@
 
 #include "Minerva/Core/ElevationData.h"
 
+#include "boost/math/special_functions/next.hpp"
+
+#include <algorithm>
 #include <limits>
 
 using namespace Minerva::Core;
@@ -135,6 +138,107 @@ ElevationData::ValueType ElevationData::noDataValue() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the range of values that are the no data value. This matches 
+//  CloseFloat with 10 units in the last place, but can be checked with two 
+//  comparisons.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  void noDataRange ( ElevationData::ValueType noData, ElevationData::ValueType& low, ElevationData::ValueType& high )
+  {
+    typedef ElevationData::ValueType ValueType;
+    const ValueType biggest ( std::numeric_limits<ValueType>::max() );
+
+    low = noData;
+    high = noData;
+
+    // Infinity and nan only match themselves.
+    if ( false == ( noData >= -biggest && noData <= biggest ) )
+      return;
+
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      if ( low > -biggest )
+        low = boost::math::float_prior ( low );
+      if ( high < biggest )
+        high = boost::math::float_next ( high );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copy the values from the source that aren't its no data value. When the 
+//  source is the same size and kind, the arrays are merged in one loop 
+//  without branches, which the compiler can vectorize.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ElevationData::merge ( const IElevationData& source )
+{
+  ValueType low ( 0 ), high ( 0 );
+  Detail::noDataRange ( source.noDataValue(), low, high );
+
+  const ElevationData *data ( dynamic_cast<const ElevationData*> ( &source ) );
+  if ( 0x0 != data && data->_width == _width && data->_height == _height && false == _data.empty() )
+  {
+    const ValueType *src ( &data->_data[0] );
+    ValueType *dst ( &_data[0] );
+    const std::size_t size ( _data.size() );
+
+    for ( std::size_t i = 0; i < size; ++i )
+    {
+      const ValueType value ( src[i] );
+      const bool keep ( value >= low && value <= high );
+      dst[i] = ( keep ? dst[i] : value );
+    }
+    return;
+  }
+
+  const SizeType width  ( std::min ( _width,  source.width() ) );
+  const SizeType height ( std::min ( _height, source.height() ) );
+
+  for ( SizeType i = 0; i < width; ++i )
+  {
+    for ( SizeType j = 0; j < height; ++j )
+    {
+      const ValueType value ( source.value ( i, j ) );
+      if ( false == ( value >= low && value <= high ) )
+        _data[this->_index ( i, j )] = value;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the values.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ElevationData::ValueType* ElevationData::values()
+{
+  return ( _data.empty() ? 0x0 : &_data[0] );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the values.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const ElevationData::ValueType* ElevationData::values() const
+{
+  return ( _data.empty() ? 0x0 : &_data[0] );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the width.
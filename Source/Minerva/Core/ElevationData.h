@@ -52,6 +52,13 @@ public:
   void              noDataValue ( ValueType noData );
   virtual ValueType noDataValue() const;
 
+  /// Copy the values from the source that aren't its no data value.
+  void              merge ( const IElevationData& source );
+
+  /// Get the values. There are width * height of them, in the order of the rows.
+  ValueType*        values();
+  const ValueType*  values() const;
+
   /// Get the size.
   virtual SizeType height() const;
   virtual SizeType width() const;
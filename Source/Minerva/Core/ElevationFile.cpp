@@ -0,0 +1,300 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Native file format for cached elevation tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/ElevationFile.h"
+
+#include "Usul/Predicates/CloseFloat.h"
+#include "Usul/Types/Types.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+using namespace Minerva::Core;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  File layout.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  typedef ElevationData::ValueType ValueType;
+
+  const Usul::Types::Uint32 MAGIC ( 0x314C454D ); // "MEL1"
+  const Usul::Types::Uint32 TYPE_FLOAT32 ( 0 );
+  const Usul::Types::Uint32 TYPE_INT16 ( 1 );
+
+  // The samples follow the header, so it keeps them aligned.
+  struct Header
+  {
+    Usul::Types::Uint32 magic;
+    Usul::Types::Uint32 type;
+    Usul::Types::Uint32 width;
+    Usul::Types::Uint32 height;
+    Usul::Types::Float32 scale;
+    Usul::Types::Float32 offset;
+    Usul::Types::Float32 noData;
+    Usul::Types::Uint32 reserved;
+  };
+
+  inline std::size_t sampleSize ( Usul::Types::Uint32 type )
+  {
+    switch ( type )
+    {
+      case TYPE_FLOAT32: return sizeof ( Usul::Types::Float32 );
+      case TYPE_INT16:   return sizeof ( Usul::Types::Int16 );
+      default:           return 0;
+    }
+  }
+
+  inline std::size_t maskSize ( std::size_t count )
+  {
+    return ( count + 7 ) / 8;
+  }
+
+  inline std::size_t fileSize ( const Header& header )
+  {
+    const std::size_t count ( static_cast<std::size_t> ( header.width ) * header.height );
+    return sizeof ( Header ) + count * Helper::sampleSize ( header.type ) + Helper::maskSize ( count );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The file extension.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string ElevationFile::extension()
+{
+  return std::string ( "elev" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Decode the bytes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ElevationData::RefPtr ElevationFile::decode ( const char* bytes, std::size_t size )
+{
+  if ( 0x0 == bytes || size < sizeof ( Helper::Header ) )
+    return ElevationData::RefPtr ( 0x0 );
+
+  Helper::Header header;
+  std::memcpy ( &header, bytes, sizeof ( Helper::Header ) );
+
+  if ( Helper::MAGIC != header.magic || 0 == Helper::sampleSize ( header.type ) || size < Helper::fileSize ( header ) )
+    return ElevationData::RefPtr ( 0x0 );
+
+  const std::size_t count ( static_cast<std::size_t> ( header.width ) * header.height );
+  const char *samples ( bytes + sizeof ( Helper::Header ) );
+  const unsigned char *mask ( reinterpret_cast<const unsigned char*> ( samples + count * Helper::sampleSize ( header.type ) ) );
+
+  ElevationData::RefPtr data ( new ElevationData ( header.width, header.height ) );
+  data->noDataValue ( header.noData );
+
+  Helper::ValueType *values ( data->values() );
+  if ( 0x0 == values )
+    return data;
+
+  if ( Helper::TYPE_FLOAT32 == header.type )
+  {
+    std::memcpy ( values, samples, count * sizeof ( Helper::ValueType ) );
+  }
+  else
+  {
+    const Usul::Types::Int16 *quantized ( reinterpret_cast<const Usul::Types::Int16*> ( samples ) );
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      values[i] = header.offset + header.scale * static_cast<Helper::ValueType> ( quantized[i] );
+    }
+  }
+
+  // Samples without data get the no data value. Most bytes of the mask are full.
+  for ( std::size_t i = 0; i < Helper::maskSize ( count ); ++i )
+  {
+    if ( 0xFF == mask[i] )
+      continue;
+
+    const std::size_t last ( std::min ( count, ( i + 1 ) * 8 ) );
+    for ( std::size_t j = i * 8; j < last; ++j )
+    {
+      if ( 0 == ( mask[i] & ( 1 << ( j % 8 ) ) ) )
+        values[j] = header.noData;
+    }
+  }
+
+  return data;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Encode the data.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ElevationFile::encode ( const IElevationData& data, Buffer& buffer, Format format )
+{
+  const unsigned int width ( data.width() );
+  const unsigned int height ( data.height() );
+  const std::size_t count ( static_cast<std::size_t> ( width ) * height );
+  const Helper::ValueType noData ( data.noDataValue() );
+
+  // Get the values and which ones have data.
+  std::vector<Helper::ValueType> values ( count, noData );
+  std::vector<unsigned char> mask ( Helper::maskSize ( count ), 0 );
+
+  Helper::ValueType low ( std::numeric_limits<Helper::ValueType>::max() );
+  Helper::ValueType high ( -std::numeric_limits<Helper::ValueType>::max() );
+  bool integers ( true );
+
+  for ( unsigned int i = 0; i < width; ++i )
+  {
+    for ( unsigned int j = 0; j < height; ++j )
+    {
+      const std::size_t index ( static_cast<std::size_t> ( i ) * height + j );
+      const Helper::ValueType value ( data.value ( i, j ) );
+      values[index] = value;
+
+      const bool finite ( value >= -std::numeric_limits<Helper::ValueType>::max() && value <= std::numeric_limits<Helper::ValueType>::max() );
+      if ( false == finite || Usul::Predicates::CloseFloat<Helper::ValueType>::compare ( value, noData, 10 ) )
+        continue;
+
+      mask[index / 8] |= static_cast<unsigned char> ( 1 << ( index % 8 ) );
+      low = std::min ( low, value );
+      high = std::max ( high, value );
+      integers = integers && ( std::floor ( value ) == value );
+    }
+  }
+
+  // Int16 is exact when the values are whole numbers that fit.
+  const bool empty ( low > high );
+  const bool exact ( empty || ( integers && low >= -32768.0f && high <= 32767.0f ) );
+
+  Helper::Header header;
+  header.magic = Helper::MAGIC;
+  header.type = ( ( FORMAT_INT16 == format || ( FORMAT_AUTO == format && exact ) ) ? Helper::TYPE_INT16 : Helper::TYPE_FLOAT32 );
+  header.width = width;
+  header.height = height;
+  header.scale = 1.0f;
+  header.offset = 0.0f;
+  header.noData = noData;
+  header.reserved = 0;
+
+  // Otherwise spread the range over all the steps.
+  if ( Helper::TYPE_INT16 == header.type && false == exact )
+  {
+    header.scale = ( ( high > low ) ? ( high - low ) / 65535.0f : 1.0f );
+    header.offset = ( ( high > low ) ? low + 32768.0f * header.scale : low );
+  }
+
+  buffer.resize ( Helper::fileSize ( header ) );
+  std::memcpy ( &buffer[0], &header, sizeof ( Helper::Header ) );
+  char *samples ( &buffer[0] + sizeof ( Helper::Header ) );
+
+  if ( Helper::TYPE_FLOAT32 == header.type )
+  {
+    if ( count > 0 )
+      std::memcpy ( samples, &values[0], count * sizeof ( Helper::ValueType ) );
+  }
+  else
+  {
+    Usul::Types::Int16 *quantized ( reinterpret_cast<Usul::Types::Int16*> ( samples ) );
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      const bool valid ( 0 != ( mask[i / 8] & ( 1 << ( i % 8 ) ) ) );
+      const Helper::ValueType step ( valid ? std::floor ( ( values[i] - header.offset ) / header.scale + 0.5f ) : 0.0f );
+      quantized[i] = static_cast<Usul::Types::Int16> ( std::max ( -32768.0f, std::min ( 32767.0f, step ) ) );
+    }
+  }
+
+  if ( false == mask.empty() )
+    std::memcpy ( samples + count * Helper::sampleSize ( header.type ), &mask[0], mask.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the file. It's mapped, so the samples are decoded from the page cache.
+//  The file isn't checked first, mapping a missing or empty file throws.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ElevationData::RefPtr ElevationFile::read ( const std::string& filename )
+{
+  try
+  {
+    boost::interprocess::file_mapping mapping ( filename.c_str(), boost::interprocess::read_only );
+    boost::interprocess::mapped_region region ( mapping, boost::interprocess::read_only );
+    return ElevationFile::decode ( static_cast<const char*> ( region.get_address() ), region.get_size() );
+  }
+  catch ( const boost::interprocess::interprocess_exception& )
+  {
+    return ElevationData::RefPtr ( 0x0 );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool ElevationFile::write ( const std::string& filename, const IElevationData& data, Format format )
+{
+  Buffer buffer;
+  ElevationFile::encode ( data, buffer, format );
+
+  // Each writer, in this process or another one, writes its own file, and 
+  // the last one renamed wins.
+  const std::string temp ( boost::filesystem::unique_path ( filename + ".%%%%-%%%%-%%%%.tmp" ).string() );
+  {
+    std::ofstream out ( temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( false == out.is_open() )
+      return false;
+
+    out.write ( &buffer[0], static_cast<std::streamsize> ( buffer.size() ) );
+    if ( false == out.good() )
+    {
+      out.close();
+      boost::system::error_code ec;
+      boost::filesystem::remove ( temp, ec );
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::rename ( temp, filename, ec );
+  if ( ec )
+  {
+    boost::filesystem::remove ( temp, ec );
+    return false;
+  }
+
+  return true;
+}
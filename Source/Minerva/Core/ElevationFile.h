@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Native file format for cached elevation tiles. A small header is followed
+//  by the samples, in the same order as ElevationData, and a bit mask of the
+//  samples that have data. The samples are float32, or int16 with a scale
+//  and offset. Files are memory-mapped and decoded straight into the data.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_ELEVATION_FILE_H__
+#define __MINERVA_CORE_ELEVATION_FILE_H__
+
+#include "Minerva/Core/Export.h"
+#include "Minerva/Core/ElevationData.h"
+
+#include <string>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT ElevationFile
+{
+public:
+
+  typedef Minerva::Common::IElevationData IElevationData;
+  typedef std::vector<char> Buffer;
+
+  enum Format
+  {
+    FORMAT_AUTO,    // Int16 when it doesn't lose anything, otherwise float32.
+    FORMAT_FLOAT32,
+    FORMAT_INT16    // Quantized over the range of the values.
+  };
+
+  /// The file extension.
+  static std::string extension();
+
+  /// Decode the bytes. Returns null if they aren't an elevation tile.
+  static ElevationData::RefPtr decode ( const char* bytes, std::size_t size );
+
+  /// Encode the data.
+  static void encode ( const IElevationData& data, Buffer& buffer, Format format = FORMAT_AUTO );
+
+  /// Read the file. Returns null if it is missing, empty or isn't an elevation tile.
+  static ElevationData::RefPtr read ( const std::string& filename );
+
+  /// Write the file. The file is renamed into place, so readers never see part of it.
+  static bool write ( const std::string& filename, const IElevationData& data, Format format = FORMAT_AUTO );
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_ELEVATION_FILE_H__
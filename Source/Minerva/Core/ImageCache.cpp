@@ -0,0 +1,415 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Process-wide cache of decoded tile images.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/ImageCache.h"
+
+#include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
+
+#include "boost/functional/hash.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <list>
+#include <map>
+
+using namespace Minerva::Core;
+
+typedef Usul::Threads::Guard<Usul::Threads::Mutex> Guard;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constants.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  const unsigned int NUM_SHARDS ( 16 );
+  const Usul::Types::Uint64 DEFAULT_MAXIMUM_BYTES ( 256 * 1024 * 1024 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Initialize static data members.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache* ImageCache::_instance ( 0x0 );
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Guards making and destroying the instance. The first call to instance()
+//  is from a tile job, so two threads can get there together.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail { boost::mutex instanceMutex; }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A shard of the cache. The front of the list is the most recently used.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct ImageCache::Shard
+{
+  typedef std::pair<Key,ImagePtr> Entry;
+  typedef std::list<Entry> Entries;
+  typedef std::map<Key,Entries::iterator> Index;
+
+  Shard() : mutex(), entries(), index(), bytes ( 0 ), maximumBytes ( 0 ), hits ( 0 ), misses ( 0 ), evictions ( 0 ) {}
+
+  static Uint64 sizeOf ( const ImagePtr& image )
+  {
+    return ( image.valid() ? static_cast<Uint64> ( image->getTotalSizeInBytesIncludingMipmaps() ) : 0 );
+  }
+
+  // Call with the mutex locked.
+  void erase ( Index::iterator i )
+  {
+    bytes -= Shard::sizeOf ( i->second->second );
+    entries.erase ( i->second );
+    index.erase ( i );
+  }
+
+  // Call with the mutex locked.
+  void trim()
+  {
+    while ( ( bytes > maximumBytes ) && ( false == entries.empty() ) )
+    {
+      Index::iterator i ( index.find ( entries.back().first ) );
+      this->erase ( i );
+      ++evictions;
+    }
+  }
+
+  mutable Usul::Threads::Mutex mutex;
+  Entries entries;
+  Index index;
+  Uint64 bytes;
+  Uint64 maximumBytes;
+  Uint64 hits;
+  Uint64 misses;
+  Uint64 evictions;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache& ImageCache::instance()
+{
+  boost::mutex::scoped_lock lock ( Detail::instanceMutex );
+
+  if ( 0x0 == _instance )
+    _instance = new ImageCache;
+
+  return *_instance;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destroy the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ImageCache::destroy()
+{
+  boost::mutex::scoped_lock lock ( Detail::instanceMutex );
+
+  delete _instance;
+  _instance = 0x0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::ImageCache() : _shards()
+{
+  _shards.reserve ( Helper::NUM_SHARDS );
+  for ( unsigned int i = 0; i < Helper::NUM_SHARDS; ++i )
+  {
+    _shards.push_back ( new Shard );
+  }
+
+  this->maximumBytes ( Helper::DEFAULT_MAXIMUM_BYTES );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::~ImageCache()
+{
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    delete *iter;
+    *iter = 0x0;
+  }
+  _shards.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Compare keys.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool ImageCache::Key::operator < ( const Key& rhs ) const
+{
+  if ( layer  != rhs.layer  ) return layer  < rhs.layer;
+  if ( level  != rhs.level  ) return level  < rhs.level;
+  if ( row    != rhs.row    ) return row    < rhs.row;
+  if ( column != rhs.column ) return column < rhs.column;
+  if ( width  != rhs.width  ) return width  < rhs.width;
+  return height < rhs.height;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hash the layer key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::Uint64 ImageCache::_layerHash ( const LayerKey& layerKey )
+{
+  std::size_t seed ( 0 );
+  boost::hash_combine ( seed, layerKey.name() );
+  boost::hash_combine ( seed, layerKey.id() );
+  return static_cast<Uint64> ( seed );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::Key ImageCache::_makeKey ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height )
+{
+  Key key;
+  key.layer = ImageCache::_layerHash ( layerKey );
+  key.level = tileKey.level();
+  key.row = tileKey.row();
+  key.column = tileKey.column();
+  key.width = width;
+  key.height = height;
+  return key;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the shard for the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::Shard& ImageCache::_shard ( const Key& key ) const
+{
+  std::size_t seed ( 0 );
+  boost::hash_combine ( seed, key.layer );
+  boost::hash_combine ( seed, key.level );
+  boost::hash_combine ( seed, key.row );
+  boost::hash_combine ( seed, key.column );
+  return *_shards[seed % _shards.size()];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Find the image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::ImagePtr ImageCache::find ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height )
+{
+  const Key key ( ImageCache::_makeKey ( layerKey, tileKey, width, height ) );
+  Shard& shard ( this->_shard ( key ) );
+
+  Guard guard ( shard.mutex );
+
+  Shard::Index::iterator i ( shard.index.find ( key ) );
+  if ( shard.index.end() == i )
+  {
+    ++shard.misses;
+    return ImagePtr ( 0x0 );
+  }
+
+  // Move to the front.
+  shard.entries.splice ( shard.entries.begin(), shard.entries, i->second );
+  ++shard.hits;
+
+  return i->second->second;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ImageCache::insert ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, ImagePtr image )
+{
+  if ( false == image.valid() )
+    return;
+
+  const Key key ( ImageCache::_makeKey ( layerKey, tileKey, width, height ) );
+  Shard& shard ( this->_shard ( key ) );
+
+  Guard guard ( shard.mutex );
+
+  // Images bigger than the shard's budget are not kept.
+  const Uint64 bytes ( Shard::sizeOf ( image ) );
+  if ( bytes > shard.maximumBytes )
+    return;
+
+  Shard::Index::iterator i ( shard.index.find ( key ) );
+  if ( shard.index.end() != i )
+  {
+    shard.erase ( i );
+  }
+
+  shard.entries.push_front ( Shard::Entry ( key, image ) );
+  shard.index[key] = shard.entries.begin();
+  shard.bytes += bytes;
+
+  shard.trim();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove all images for the layer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ImageCache::remove ( const LayerKey& layerKey )
+{
+  const Uint64 layer ( ImageCache::_layerHash ( layerKey ) );
+
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+
+    Shard::Index::iterator i ( shard.index.begin() );
+    while ( i != shard.index.end() )
+    {
+      if ( layer == i->first.layer )
+        shard.erase ( i++ );
+      else
+        ++i;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove all images.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ImageCache::clear()
+{
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+    shard.index.clear();
+    shard.entries.clear();
+    shard.bytes = 0;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the memory budget. Each shard gets an equal share.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void ImageCache::maximumBytes ( Uint64 bytes )
+{
+  const Uint64 share ( bytes / _shards.size() );
+
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+    shard.maximumBytes = share;
+    shard.trim();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the memory budget.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::Uint64 ImageCache::maximumBytes() const
+{
+  Uint64 bytes ( 0 );
+  for ( Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    const Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+    bytes += shard.maximumBytes;
+  }
+  return bytes;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the counters.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ImageCache::Statistics ImageCache::statistics() const
+{
+  Statistics stats;
+  for ( Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    const Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+    stats.hits += shard.hits;
+    stats.misses += shard.misses;
+    stats.evictions += shard.evictions;
+    stats.bytes += shard.bytes;
+    stats.entries += shard.index.size();
+  }
+  return stats;
+}
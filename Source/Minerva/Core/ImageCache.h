@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Process-wide cache of decoded tile images. The least recently used
+//  images are dropped when the cache grows past its memory budget.
+//
+//  The cache is split into shards, each with its own mutex and its own
+//  share of the budget, so that tile jobs on different threads rarely
+//  wait on each other.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_IMAGE_CACHE_H__
+#define __MINERVA_CORE_IMAGE_CACHE_H__
+
+#include "Minerva/Core/Export.h"
+
+#include "Minerva/Common/LayerKey.h"
+#include "Minerva/Common/TileKey.h"
+
+#include "Usul/Types/Types.h"
+
+#include "osg/Image"
+#include "osg/ref_ptr"
+
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT ImageCache
+{
+public:
+
+  typedef osg::ref_ptr<osg::Image> ImagePtr;
+  typedef Minerva::Common::LayerKey LayerKey;
+  typedef Minerva::Common::TileKey TileKey;
+  typedef Usul::Types::Uint64 Uint64;
+
+  struct Statistics
+  {
+    Statistics() : hits ( 0 ), misses ( 0 ), evictions ( 0 ), bytes ( 0 ), entries ( 0 ) {}
+
+    Uint64 hits;
+    Uint64 misses;
+    Uint64 evictions;
+    Uint64 bytes;
+    Uint64 entries;
+  };
+
+  /// Get the instance.
+  static ImageCache& instance();
+
+  /// Destroy the instance and the images in it.
+  static void        destroy();
+
+  /// Find the image. Returns null if it is not in the cache.
+  ImagePtr   find ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height );
+
+  /// Add the image. Replaces any existing image for the same key.
+  void       insert ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, ImagePtr image );
+
+  /// Remove all images for the layer.
+  void       remove ( const LayerKey& layerKey );
+
+  /// Remove all images.
+  void       clear();
+
+  /// Set/get the memory budget in bytes. Zero turns the cache off.
+  void       maximumBytes ( Uint64 bytes );
+  Uint64     maximumBytes() const;
+
+  /// Get the counters.
+  Statistics statistics() const;
+
+private:
+
+  struct Key
+  {
+    Uint64 layer;
+    unsigned int level;
+    unsigned int row;
+    unsigned int column;
+    unsigned int width;
+    unsigned int height;
+
+    bool operator < ( const Key& rhs ) const;
+  };
+
+  struct Shard;
+  typedef std::vector<Shard*> Shards;
+
+  static Key  _makeKey ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height );
+  static Uint64 _layerHash ( const LayerKey& layerKey );
+
+  Shard&      _shard ( const Key& key ) const;
+
+  ImageCache();
+  ~ImageCache();
+
+  ImageCache ( const ImageCache& );
+  ImageCache& operator= ( const ImageCache& );
+
+  Shards _shards;
+
+  static ImageCache *_instance;
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_IMAGE_CACHE_H__
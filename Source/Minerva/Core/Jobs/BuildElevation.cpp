@@ -32,7 +32,7 @@ BuildElevation::BuildElevation ( Tile::RefPtr tile ) : BaseClass ( 0x0, false ),
   if ( _tile.valid() )
   {
     const unsigned int level ( _tile->level() );
-    this->priority ( -1 * static_cast<int> ( level ) );
+    this->priority ( _tile->jobPriority() );
   
     const Minerva::Core::TileEngine::Extents extents ( _tile->extents() );
     this->name ( Usul::Strings::format ( "BuildElevation, Extents: [", extents.minimum()[0], ", ", extents.minimum()[1], ", ", extents.maximum()[0], ", ", extents.maximum()[1], "], level: ", level ) );
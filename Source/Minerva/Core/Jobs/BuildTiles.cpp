@@ -17,12 +17,78 @@
 #include "Minerva/Core/Jobs/BuildTiles.h"
 
 #include "Usul/Convert/Convert.h"
+#include "Usul/Errors/Assert.h"
+#include "Usul/Exceptions/Canceled.h"
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Jobs/Manager.h"
 #include "Usul/Pointers/Pointers.h"
 #include "Usul/Threads/Safe.h"
 
+#include "boost/bind.hpp"
+
 using namespace Minerva::Core::Jobs;
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Job for one stage of one child. It counts as canceled when the owner is.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class BuildTiles::Part : public Usul::Jobs::Job
+{
+public:
+
+  typedef Usul::Jobs::Job BaseClass;
+
+  Part ( BuildTiles::RefPtr owner, unsigned int child, BuildTiles::Stage stage ) : BaseClass(),
+    _owner ( owner ),
+    _child ( child ),
+    _stage ( stage )
+  {
+    this->priority ( owner->priority() );
+    this->name ( Usul::Strings::format ( owner->name(), ", child: ", child, ", stage: ", static_cast<int> ( stage ) ) );
+  }
+
+  virtual bool canceled() const
+  {
+    return ( BaseClass::canceled() || _owner->canceled() );
+  }
+
+protected:
+
+  virtual ~Part()
+  {
+  }
+
+  virtual void _started()
+  {
+    _owner->_runPart ( _child, _stage, Usul::Jobs::Job::RefPtr ( this ) );
+  }
+
+  virtual void _finished()
+  {
+    _owner->_partDone ( _child, _stage, false == this->canceled() );
+  }
+
+  virtual void _cancelled()
+  {
+    _owner->_partDone ( _child, _stage, false );
+  }
+
+  virtual void _error()
+  {
+    _owner->_partDone ( _child, _stage, false );
+  }
+
+private:
+
+  BuildTiles::RefPtr _owner;
+  const unsigned int _child;
+  const BuildTiles::Stage _stage;
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Constructor.
@@ -31,12 +97,18 @@ using namespace Minerva::Core::Jobs;
 
 BuildTiles::BuildTiles ( Tile::RefPtr tile ) : BaseClass(),
   _tile ( tile ),
+  _manager ( 0x0 ),
+  _children(),
+  _pending(),
+  _remaining ( 0 ),
+  _failed ( false ),
+  _complete ( false ),
   _success ( false )
 {
   if ( _tile.valid() )
   {
     const unsigned int level ( _tile->level() );
-    this->priority ( -1 * static_cast<int> ( level ) );
+    this->priority ( _tile->jobPriority() );
   
     const Minerva::Core::TileEngine::Extents extents ( _tile->extents() );
     typedef Usul::Convert::Type<float,std::string> Converter;
@@ -60,6 +132,7 @@ BuildTiles::BuildTiles ( Tile::RefPtr tile ) : BaseClass(),
 BuildTiles::~BuildTiles()
 {
   _tile = 0x0;
+  _children.clear();
 }
 
 
@@ -73,17 +146,208 @@ void BuildTiles::_started()
 {
   // Make sure we have valid data.
   if ( false == _tile.valid() )
+  {
+    Usul::Threads::Safe::set ( this->mutex(), true, _complete );
     return;
+  }
   
   // Have we been cancelled?
   if ( true == this->canceled() )
-    this->cancel();
+  {
+    Usul::Threads::Safe::set ( this->mutex(), true, _complete );
+    throw Usul::Exceptions::Canceled ( "Message 2710496588: BuildTiles canceled" );
+  }
+
+  Usul::Jobs::Manager *manager ( _tile->jobManager() );
+
+  // Without a job manager build the children here.
+  if ( 0x0 == manager )
+  {
+    _tile->split ( Usul::Jobs::Job::RefPtr ( this ) );
+
+    Guard guard ( this );
+    _success = true;
+    _complete = true;
+    return;
+  }
+
+  typedef Minerva::Common::TileKey TileKey;
+  TileKey::ChildrenKeys keys;
+  _tile->key()->split ( keys );
+
+  const double half ( _tile->splitDistance() * 0.5 );
+
+  // Make the children. Their data is built by the parts.
+  Tile::Tiles children ( 4 );
+  for ( unsigned int i = 0; i < 4; ++i )
+  {
+    children[i] = _tile->makeChild ( keys[i], half );
+  }
 
-  // Ask the tile to split.
-  _tile->split ( Usul::Jobs::Job::RefPtr ( this ) );
+  {
+    Guard guard ( this );
+    _manager = manager;
+    _children = children;
+    _pending.assign ( 4, 2 );
+    _remaining = 4;
+  }
+
+  // Fetch the elevation and raster of each child at the same time.
+  for ( unsigned int i = 0; i < 4; ++i )
+  {
+    this->_addPart ( i, ELEVATION );
+    this->_addPart ( i, RASTER );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when _started throws. There is nothing to wait for unless some 
+//  of the parts were added.
+//
+///////////////////////////////////////////////////////////////////////////////
 
-  // If we get to here it worked.
-  Usul::Threads::Safe::set ( this->mutex(), true, _success );
+void BuildTiles::_error()
+{
+  Guard guard ( this );
+  if ( 0 == _remaining )
+  {
+    _complete = true;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job for the stage of the child.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void BuildTiles::_addPart ( unsigned int child, Stage stage )
+{
+  Usul::Jobs::Manager *manager ( Usul::Threads::Safe::get ( this->mutex(), _manager ) );
+  USUL_ASSERT ( 0x0 != manager );
+
+  manager->addJob ( new Part ( BuildTiles::RefPtr ( this ), child, stage ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Run the stage of the child. Called from the part's thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void BuildTiles::_runPart ( unsigned int child, Stage stage, Usul::Jobs::Job::RefPtr part )
+{
+  // Have we been cancelled?
+  if ( true == part->canceled() )
+    throw Usul::Exceptions::Canceled ( "Message 1183672942: BuildTiles canceled" );
+
+  Tile::RefPtr tile ( 0x0 );
+  Tile::RefPtr parent ( 0x0 );
+  {
+    Guard guard ( this );
+    tile = _children.at ( child );
+    parent = _tile;
+  }
+
+  switch ( stage )
+  {
+  case ELEVATION:
+    parent->buildChildElevation ( tile, part );
+    break;
+  case RASTER:
+    tile->buildRaster ( part );
+    break;
+  case DETAIL:
+    tile->buildDetail ( part );
+    break;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a part is finished. When both fetches of a child are done the 
+//  rest of it is built, and when all the children are done they are given 
+//  to the tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void BuildTiles::_partDone ( unsigned int child, Stage stage, bool success )
+{
+  bool detail ( false );
+  bool last ( false );
+  {
+    Guard guard ( this );
+
+    if ( false == success )
+      _failed = true;
+
+    bool childDone ( DETAIL == stage );
+    if ( false == childDone )
+    {
+      USUL_ASSERT ( _pending.at ( child ) > 0 );
+      if ( 0 == --_pending.at ( child ) )
+      {
+        // Build the rest if everything has worked so far.
+        detail = ( false == _failed ) && ( false == this->canceled() );
+        childDone = ( false == detail );
+      }
+    }
+
+    if ( true == childDone )
+    {
+      USUL_ASSERT ( _remaining > 0 );
+      last = ( 0 == --_remaining );
+    }
+  }
+
+  if ( true == detail )
+  {
+    this->_addPart ( child, DETAIL );
+    return;
+  }
+
+  if ( false == last )
+    return;
+
+  Tile::RefPtr tile ( 0x0 );
+  Tile::Tiles children;
+  bool failed ( false );
+  {
+    Guard guard ( this );
+    tile = _tile;
+    children = _children;
+    failed = _failed;
+  }
+
+  // Give the children to the tile.
+  const bool worked ( ( false == failed ) && ( false == this->canceled() ) );
+  if ( true == worked )
+  {
+    Usul::Functions::safeCall ( boost::bind ( &Tile::attachChildren, tile, children ), "3075623341" );
+  }
+
+  Guard guard ( this );
+  _success = worked;
+  _complete = true;
+  _children.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The job is done when all the children are.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool BuildTiles::isDone() const
+{
+  Guard guard ( this );
+  return ( true == _complete ) && ( true == BaseClass::isDone() );
 }
 
 
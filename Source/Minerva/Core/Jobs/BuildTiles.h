@@ -12,6 +12,13 @@
 //
 //  Build four sub-tiles.
 //
+//  Each child's elevation and raster are built by their own jobs, so the 
+//  four children and the two fetches within each run at the same time. 
+//  When both are done a third job builds the child's mesh, texture and 
+//  vector data. The children are given to the parent tile when the last 
+//  one is finished. No thread waits on another, so the jobs can share the 
+//  pool with everything else.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef __MINERVA_CORE_JOBS_BUILD_TILES_H__
@@ -22,6 +29,10 @@
 
 #include "Usul/Jobs/Job.h"
 
+#include <vector>
+
+namespace Usul { namespace Jobs { class Manager; } }
+
 
 namespace Minerva {
 namespace Core {
@@ -40,17 +51,41 @@ public:
   
   BuildTiles ( Tile::RefPtr tile );
 
+  // The job is done when all the children are.
+  virtual bool        isDone() const;
+
   virtual bool        success() const;
 
 protected:
 
   virtual ~BuildTiles();
   
+  virtual void        _error();
   virtual void        _started();
   
 private:
 
+  class Part;
+  friend class Part;
+
+  enum Stage
+  {
+    ELEVATION,
+    RASTER,
+    DETAIL
+  };
+
+  void                _addPart ( unsigned int child, Stage stage );
+  void                _partDone ( unsigned int child, Stage stage, bool success );
+  void                _runPart ( unsigned int child, Stage stage, Usul::Jobs::Job::RefPtr part );
+
   Tile::RefPtr _tile;
+  Usul::Jobs::Manager *_manager;
+  Tile::Tiles _children;
+  std::vector<unsigned int> _pending;
+  unsigned int _remaining;
+  bool _failed;
+  bool _complete;
   bool _success;
 };
 
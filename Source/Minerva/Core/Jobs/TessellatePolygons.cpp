@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate many polygons at once on the job manager's threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Jobs/TessellatePolygons.h"
+
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Jobs/Manager.h"
+
+#include "boost/bind.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <algorithm>
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The work that is shared between the threads. Jobs that start after the
+//  caller has returned find nothing left to do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  const unsigned int CHUNK_SIZE ( 16 );
+
+  struct Work
+  {
+    Work ( const Minerva::Core::Jobs::Polygons& p ) : polygons ( p ), next ( 0 ), running ( 0 ), mutex(), finished()
+    {
+    }
+
+    const Minerva::Core::Jobs::Polygons polygons;
+    unsigned int next;
+    unsigned int running;
+    boost::mutex mutex;
+    boost::condition_variable finished;
+  };
+
+  typedef boost::shared_ptr<Work> WorkPtr;
+
+  void tessellate ( WorkPtr work )
+  {
+    const unsigned int size ( work->polygons.size() );
+
+    while ( true )
+    {
+      unsigned int first ( 0 );
+      {
+        boost::mutex::scoped_lock lock ( work->mutex );
+        if ( work->next >= size )
+          return;
+
+        first = work->next;
+        work->next = std::min ( size, first + CHUNK_SIZE );
+        ++work->running;
+      }
+
+      const unsigned int last ( std::min ( size, first + CHUNK_SIZE ) );
+      for ( unsigned int i = first; i < last; ++i )
+      {
+        Minerva::Core::Data::Polygon::RefPtr polygon ( work->polygons[i] );
+        if ( polygon.valid() )
+        {
+          Usul::Functions::safeCall ( boost::bind ( &Minerva::Core::Data::Polygon::tessellate, polygon.get() ), "1407293155" );
+        }
+      }
+
+      {
+        boost::mutex::scoped_lock lock ( work->mutex );
+        --work->running;
+      }
+      work->finished.notify_all();
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate the polygons.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Minerva::Core::Jobs::tessellatePolygons ( const Polygons& polygons, Usul::Jobs::Manager& manager )
+{
+  Detail::WorkPtr work ( new Detail::Work ( polygons ) );
+
+  // Don't bother the other threads if there is only a chunk or two.
+  const unsigned int numChunks ( ( polygons.size() + Detail::CHUNK_SIZE - 1 ) / Detail::CHUNK_SIZE );
+  const unsigned int numJobs ( std::min<unsigned int> ( manager.poolSize(), ( numChunks > 2 ? numChunks - 1 : 0 ) ) );
+
+  for ( unsigned int i = 0; i < numJobs; ++i )
+  {
+    manager.addJob ( Usul::Jobs::create ( boost::bind ( &Detail::tessellate, work ) ) );
+  }
+
+  // Take chunks until there are none left.
+  Detail::tessellate ( work );
+
+  // Wait for the chunks that other threads are working on.
+  boost::mutex::scoped_lock lock ( work->mutex );
+  while ( work->running > 0 )
+  {
+    work->finished.wait ( lock );
+  }
+}
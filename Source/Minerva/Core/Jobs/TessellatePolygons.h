@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate many polygons at once on the job manager's threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _MINERVA_CORE_JOBS_TESSELLATE_POLYGONS_H_
+#define _MINERVA_CORE_JOBS_TESSELLATE_POLYGONS_H_
+
+#include "Minerva/Core/Export.h"
+#include "Minerva/Core/Data/Polygon.h"
+
+#include <vector>
+
+namespace Usul { namespace Jobs { class Manager; } }
+
+namespace Minerva {
+namespace Core {
+namespace Jobs {
+
+  typedef std::vector<Minerva::Core::Data::Polygon::RefPtr> Polygons;
+
+  // Tessellate the polygons in chunks. The calling thread takes chunks too,
+  // and only waits for the chunks that other threads have started, so this
+  // is safe to call from one of the manager's threads. Only the polygons'
+  // own locks are used.
+  MINERVA_EXPORT void tessellatePolygons ( const Polygons& polygons, Usul::Jobs::Manager& manager );
+
+} // namespace Jobs
+} // namespace Core
+} // namespace Minerva
+
+
+#endif // _MINERVA_CORE_JOBS_TESSELLATE_POLYGONS_H_
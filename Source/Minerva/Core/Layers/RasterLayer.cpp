@@ -11,6 +11,7 @@
 #include "Minerva/Core/Layers/RasterLayer.h"
 #include "Minerva/Core/DiskCache.h"
 #include "Minerva/Core/ElevationData.h"
+#include "Minerva/Core/ImageCache.h"
 #include "Minerva/Core/Visitor.h"
 
 #include "Usul/Components/Manager.h"
@@ -188,18 +189,49 @@ RasterLayer::ImagePtr RasterLayer::texture (
   // See if the job has been cancelled.
   RasterLayer::_checkForCanceledJob ( job );
 
-  // Make the file name.
-  std::string file;
-  if ( DiskCache::CACHE_STATUS_FILE_OK == this->_getAndCheckCacheFilename ( key, width, height, file ) )
+  // Images that were decoded recently are kept in memory.
+  LayerKey::RefPtr layerKey ( this->cacheKey() );
+  if ( true == layerKey.valid() )
+  {
+    ImagePtr image ( Minerva::Core::ImageCache::instance().find ( *layerKey, key, width, height ) );
+    if ( true == image.valid() )
+      return image;
+  }
+
+  // Look in the tile store next, if there is one.
+  DiskCache &cache ( DiskCache::instance() );
+  const bool useStore ( layerKey.valid() && cache.tileStore().valid() );
+  ImagePtr image ( 0x0 );
+  if ( true == useStore )
   {
-    RasterLayer::_checkForCanceledJob ( job );
+    image = cache.readImage ( *layerKey, key, width, height, this->_cacheFileExtension() );
+  }
+
+  if ( false == image.valid() )
+  {
+    // Make the file name.
+    std::string file;
+    if ( DiskCache::CACHE_STATUS_FILE_OK == this->_getAndCheckCacheFilename ( key, width, height, file ) )
+    {
+      RasterLayer::_checkForCanceledJob ( job );
+
+      // Load the file.
+      image = this->_readImageFile ( file );
+    }
+    else
+    {
+      // With a tile store the file is empty and the layer writes into the store.
+      image = this->_textureImplementation ( file, key, width, height, job, 0x0 );
+    }
+  }
 
-    // Load the file.
-    ImagePtr image ( this->_readImageFile ( file ) );
-    return image;
+  // Keep the decoded image for next time.
+  if ( true == layerKey.valid() && true == image.valid() )
+  {
+    Minerva::Core::ImageCache::instance().insert ( *layerKey, key, width, height, image );
   }
 
-  return this->_textureImplementation ( file, key, width, height, job, 0x0 );
+  return image;
 }
 
 
@@ -423,16 +455,20 @@ namespace Detail {
 
     const unsigned int width ( image.s() );
     const unsigned int height ( image.t() );
-    Minerva::Common::IElevationData::RefPtr data ( new Minerva::Core::ElevationData ( width, height ) );
+    Minerva::Core::ElevationData::RefPtr data ( new Minerva::Core::ElevationData ( width, height ) );
+    Minerva::Core::ElevationData::ValueType *values ( data->values() );
+    if ( 0x0 == values )
+      return 0x0;
+
     for ( unsigned int i = 0; i < width; ++i )
     {
       for ( unsigned int j = 0; j < height; ++j )
       {
         const SrcType value ( *reinterpret_cast < const SrcType * > ( image.data ( i, j ) ) );
-        data->value ( i, j, static_cast<float> ( value ) );
+        values[i * height + j] = static_cast<float> ( value );
       }
     }
-    return data;
+    return RasterLayer::IElevationData::RefPtr ( data );
   }
 
   
@@ -472,8 +508,22 @@ RasterLayer::IElevationData::RefPtr RasterLayer::elevationData (
                                                                 Usul::Jobs::Job* job,
                                                                 Usul::Interfaces::IUnknown* caller )
 {
+  // Elevation that was converted before is kept in the native format.
+  LayerKey::RefPtr layerKey ( this->cacheKey() );
+  DiskCache &cache ( DiskCache::instance() );
+  if ( true == layerKey.valid() )
+  {
+    Minerva::Core::ElevationData::RefPtr data ( cache.readElevation ( *layerKey, key, width, height ) );
+    if ( true == data.valid() )
+      return IElevationData::RefPtr ( data );
+  }
+
   osg::ref_ptr<osg::Image> image ( this->texture ( key, width, height, job, caller ) );
   Minerva::Common::IElevationData::RefPtr data ( Detail::convertFromOsgImage ( image.get() ) );
+
+  if ( true == layerKey.valid() && true == data.valid() )
+    cache.writeElevation ( *layerKey, key, width, height, *data );
+
   return data;
 }
 
@@ -125,7 +125,8 @@ protected:
 
   virtual ImagePtr      _readImageFile ( const std::string & ) const;
 
-  // Get the texture.
+  // Get the texture. The filename is empty when there is a tile store, and 
+  // the tile is written with DiskCache::storeTile or storeImage instead.
   virtual ImagePtr      _textureImplementation ( 
                                                 const std::string& filename, 
                                                 const TileKey& key, 
@@ -15,9 +15,10 @@
 
 #include "Minerva/Core/Layers/RasterLayerArcGIS.h"
 
-#include "Minerva/Network/Http.h"
+#include "Minerva/Network/FetchEngine.h"
 
 #include "Usul/Factory/RegisterCreator.h"
+#include "Usul/Jobs/Job.h"
 #include "Usul/Strings/Format.h"
 
 using namespace Minerva::Core::Layers;
@@ -89,10 +90,27 @@ std::string RasterLayerArcGIS::urlFull ( const TileKey& key, unsigned int width,
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void RasterLayerArcGIS::_download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller )
+void RasterLayerArcGIS::_download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *job, IUnknown *caller )
 {
+  Usul::Interfaces::IUnknown::QueryPtr unknown ( job );
   const std::string url ( this->urlFull ( key, width, height ) );
-  Minerva::Network::Http::download ( url, file, 0 );
+  const int priority ( ( 0x0 != job ) ? job->priority() : 0 );
+  Minerva::Network::FetchEngine::download ( url, file, priority, 0, unknown );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Download image for tile into memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void RasterLayerArcGIS::_downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *job, IUnknown *caller )
+{
+  Usul::Interfaces::IUnknown::QueryPtr unknown ( job );
+  const std::string url ( this->urlFull ( key, width, height ) );
+  const int priority ( ( 0x0 != job ) ? job->priority() : 0 );
+  Minerva::Network::FetchEngine::download ( url, data, priority, 0, unknown );
 }
 
 
@@ -53,6 +53,7 @@ protected:
   RasterLayerArcGIS ( const RasterLayerArcGIS& );
   
   virtual void          _download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller );
+  virtual void          _downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller );
   
 private:
   
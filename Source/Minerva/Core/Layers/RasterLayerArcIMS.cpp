@@ -159,6 +159,47 @@ void RasterLayerArcIMS::_registerMembers()
 ///////////////////////////////////////////////////////////////////////////////
 
 void RasterLayerArcIMS::_download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller )
+{
+  // Get the url where the image is.
+  const std::string imageUrl ( this->_imageUrl ( key, width, height ) );
+
+  // Make sure it's not empty.
+  if ( false == imageUrl.empty() )
+  {
+    // Download to the given filename.
+    Minerva::Network::downloadToFile ( imageUrl, file, this->timeoutMilliSeconds() );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Download image for tile into memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void RasterLayerArcIMS::_downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller )
+{
+  const std::string imageUrl ( this->_imageUrl ( key, width, height ) );
+  if ( true == imageUrl.empty() )
+    return;
+
+  std::ostringstream os;
+  Minerva::Network::Http http ( imageUrl, &os );
+  http.download ( this->timeoutMilliSeconds() );
+
+  const std::string bytes ( os.str() );
+  data.assign ( bytes.begin(), bytes.end() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Post the request and get the url of the image the server made.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string RasterLayerArcIMS::_imageUrl ( const TileKey& key, unsigned int width, unsigned int height ) const
 {
   // Make the xml to request the image.
   std::string request ( this->_createRequestXml ( key.extents(), width, height, key.level() ) );
@@ -178,19 +219,8 @@ void RasterLayerArcIMS::_download ( const std::string& file, const TileKey& key,
   // Look for the url.
   XmlTree::Node::Children output ( doc->find ( "OUTPUT", true ) );
 
-  // If we have an output.
-  if ( false == output.empty() )
-  {
-    // Get the url where the image is.
-    std::string imageUrl ( output.front()->attribute ( "url" ) );
-
-    // Make sure it's not empty.
-    if ( false == imageUrl.empty() )
-    {
-      // Download to the given filename.
-      Minerva::Network::downloadToFile ( imageUrl, file, this->timeoutMilliSeconds() );
-    }
-  }
+  // Get the url where the image is, if we have an output.
+  return ( ( false == output.empty() ) ? output.front()->attribute ( "url" ) : std::string() );
 }
 
 
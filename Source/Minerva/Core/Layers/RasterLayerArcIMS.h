@@ -66,6 +66,9 @@ protected:
   RasterLayerArcIMS ( const RasterLayerArcIMS& );
 
   virtual void          _download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller );
+  virtual void          _downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller );
+
+  std::string           _imageUrl ( const TileKey& key, unsigned int width, unsigned int height ) const;
 
 private:
 
@@ -16,6 +16,7 @@
 
 #include "Minerva/Core/Layers/RasterLayerNetwork.h"
 #include "Minerva/Core/DiskCache.h"
+#include "Minerva/Network/FetchEngine.h"
 #include "Minerva/Network/Names.h"
 
 #include "Usul/File/Path.h"
@@ -170,8 +171,12 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
   // Change the name of the job for better feedback.
   this->_setJobName ( job, extents, url, level );
 
+  // Without a file the tile goes into the tile store.
+  const bool useStore ( true == file.empty() );
+  Buffer data;
+
   // Are we supposed to look for a "failed" file?
-  if ( true == Usul::Threads::Safe::get ( this->mutex(), _readFailedFlags ) )
+  if ( ( false == useStore ) && ( true == Usul::Threads::Safe::get ( this->mutex(), _readFailedFlags ) ) )
   {
     const std::string failedFile ( Helper::getFailedFileName ( file ) );
     if ( true == boost::filesystem::exists ( failedFile ) )
@@ -188,12 +193,15 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
   const std::string fullUrl ( this->urlFull ( key, width, height ) );
   
   // Pull it down if we should...
-	if ( ( false == boost::filesystem::exists ( file ) ) && ( true == this->useNetwork() ) )
+	if ( ( ( true == useStore ) || ( false == boost::filesystem::exists ( file ) ) ) && ( true == this->useNetwork() ) )
   {
     try
     {
       this->_logEvent ( Usul::Strings::format ( "Message 3507413903: Download started: ", fullUrl ) );
-      this->_download ( file, key, width, height, job, caller );
+      if ( true == useStore )
+        this->_downloadData ( data, key, width, height, job, caller );
+      else
+        this->_download ( file, key, width, height, job, caller );
       this->_logEvent ( Usul::Strings::format ( "Message 1315552899: Download finished: ", fullUrl ) );
     }
     catch ( const Usul::Exceptions::Canceled & )
@@ -227,6 +235,9 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
   // See if the job has been cancelled.
   _checkForCanceledJob ( job );
 
+  if ( true == useStore )
+    return this->_storeDownload ( data, key, width, height, fullUrl );
+
   // If the file does not exist then return.
   if ( false == boost::filesystem::exists ( file ) )
   {
@@ -235,11 +246,14 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
     return ImagePtr ( 0x0 );
   }
 
-  // If the file is empty then remove it and return.
-  if ( 0 == boost::filesystem::file_size ( file ) )
+  // Downloads are renamed into place when they're complete, so an empty file 
+  // is an empty download and not one still being written. Another process 
+  // sharing the cache may remove it first.
+  boost::system::error_code ec;
+  if ( 0 == boost::filesystem::file_size ( file, ec ) || ec )
   {
     this->_logEvent ( Usul::Strings::format ( "Error 3244363936: Download file is empty. File: ", file, ", URL: ", fullUrl, ". Removing file." ) );
-    boost::filesystem::remove ( file );
+    boost::filesystem::remove ( file, ec );
     this->_downloadFailed ( file, fullUrl );
     return ImagePtr ( 0x0 );
   }
@@ -251,7 +265,7 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
   if ( false == image.valid() )
   {
     this->_logEvent ( Usul::Strings::format ( "Error 2720181403: Failed to load file: ", file, ", downloaded from URL: ", fullUrl, ". Removing file." ) );
-    boost::filesystem::remove ( file );
+    boost::filesystem::remove ( file, ec );
     this->_downloadFailed ( file, fullUrl );
     return ImagePtr ( 0x0 );
   }
@@ -262,6 +276,54 @@ RasterLayerNetwork::ImagePtr RasterLayerNetwork::_textureImplementation (
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Download into memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void RasterLayerNetwork::_downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *job, IUnknown * )
+{
+  // Requests for the same url share one transfer.
+  Usul::Interfaces::IUnknown::QueryPtr caller ( job );
+  const std::string url ( this->urlFull ( key, width, height ) );
+  const int priority ( ( 0x0 != job ) ? job->priority() : 0 );
+  Minerva::Network::FetchEngine::download ( url, data, priority, this->timeoutMilliSeconds(), caller );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Decode the download and write it into the tile store if it's good.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+RasterLayerNetwork::ImagePtr RasterLayerNetwork::_storeDownload ( const Buffer& data, const TileKey& key, unsigned int width, unsigned int height, const std::string& url )
+{
+  if ( true == data.empty() )
+  {
+    this->_logEvent ( Usul::Strings::format ( "Error 2290574316: Download is empty. URL: ", url ) );
+    return ImagePtr ( 0x0 );
+  }
+
+  const std::string extension ( this->_cacheFileExtension() );
+  ImagePtr image ( DiskCache::decodeImage ( data, extension ) );
+  if ( false == image.valid() )
+  {
+    this->_logEvent ( Usul::Strings::format ( "Error 1838266704: Failed to load download from URL: ", url ) );
+    return ImagePtr ( 0x0 );
+  }
+
+  LayerKey::RefPtr layerKey ( this->cacheKey() );
+  if ( true == layerKey.valid() )
+  {
+    DiskCache::instance().storeTile ( *layerKey, key, width, height, extension, data );
+  }
+
+  return image;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the directory.
@@ -308,6 +370,10 @@ std::string RasterLayerNetwork::_getAllOptions() const
 
 void RasterLayerNetwork::_downloadFailed ( const std::string &file, const std::string &url )
 {
+  // The flag is a file next to the tile, so there's none with a tile store.
+  if ( true == file.empty() )
+    return;
+
   bool writeFailed ( Usul::Threads::Safe::get ( this->mutex(), _writeFailedFlags ) );
   if ( true == writeFailed )
   {
@@ -19,6 +19,7 @@
 
 #include "Minerva/Core/Export.h"
 #include "Minerva/Core/Layers/RasterLayer.h"
+#include "Minerva/Core/TileStore.h"
 
 #include <map>
 #include <string>
@@ -36,6 +37,7 @@ public:
   typedef RasterLayer BaseClass;
   typedef std::map < std::string, std::string > Options;
   typedef BaseClass::IReadImageFile IReadImageFile;
+  typedef Minerva::Core::TileStore::Buffer Buffer;
 
   USUL_DECLARE_REF_POINTERS ( RasterLayerNetwork );
 
@@ -88,6 +90,9 @@ protected:
 
   virtual void          _download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller ) = 0;
 
+  // Download into memory, for the tile store. The default fetches urlFull.
+  virtual void          _downloadData ( Buffer& data, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *, IUnknown *caller );
+
   // Get the texture.
   virtual ImagePtr      _textureImplementation ( 
     const std::string& filename, 
@@ -114,6 +119,8 @@ private:
 
   void                  _downloadFailed ( const std::string &file, const std::string &url );
 
+  ImagePtr              _storeDownload ( const Buffer& data, const TileKey& key, unsigned int width, unsigned int height, const std::string& url );
+
   std::string _url;
   Options _options;
   bool _useNetwork;
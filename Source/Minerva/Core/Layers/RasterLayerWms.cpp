@@ -21,6 +21,7 @@
 #endif
 
 #include "Minerva/Core/Layers/RasterLayerWms.h"
+#include "Minerva/Network/FetchEngine.h"
 #include "Minerva/Network/Http.h"
 #include "Minerva/Network/Names.h"
 
@@ -105,10 +106,11 @@ Minerva::Core::Data::Feature* RasterLayerWms::clone() const
 
 void RasterLayerWms::_download ( const std::string& file, const TileKey& key, unsigned int width, unsigned int height, Usul::Jobs::Job *job, IUnknown * )
 {
-  // Download the file.
+  // Download the file. Requests for the same url share one transfer.
   Usul::Interfaces::IUnknown::QueryPtr caller ( job );
   const std::string url ( this->urlFull ( key, width, height ) );
-  Minerva::Network::Http::download ( url, file, this->timeoutMilliSeconds(), caller );
+  const int priority ( ( 0x0 != job ) ? job->priority() : 0 );
+  Minerva::Network::FetchEngine::download ( url, file, priority, this->timeoutMilliSeconds(), caller );
 }
 
 
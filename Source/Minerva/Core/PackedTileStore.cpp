@@ -0,0 +1,902 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tile store that packs tiles into large memory-mapped segment files.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/PackedTileStore.h"
+
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Strings/Format.h"
+#include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
+
+#include "boost/bind.hpp"
+#include "boost/crc.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/functional/hash.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/sync/file_lock.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace Minerva::Core;
+
+typedef Usul::Threads::Guard<Usul::Threads::Mutex> Guard;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Record layout.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  const Usul::Types::Uint32 MAGIC ( 0x3153544D ); // "MTS1"
+  const Usul::Types::Uint32 RECORD_TILE ( 0 );
+  const Usul::Types::Uint32 RECORD_REMOVE_LAYER ( 1 );
+  const unsigned int NUM_SHARDS ( 64 );
+  const unsigned int MAX_SEGMENTS ( 4096 );
+  const char COMPACT_DIRECTORY[] = "compact";
+  const char COMPACT_DONE[] = "done";
+
+  struct RecordHeader
+  {
+    Usul::Types::Uint32 magic;
+    Usul::Types::Uint32 type;
+    Usul::Types::Uint32 size;
+    Usul::Types::Uint32 checksum;
+    Usul::Types::Uint64 layer;
+    Usul::Types::Uint32 width;
+    Usul::Types::Uint32 height;
+    Usul::Types::Uint32 level;
+    Usul::Types::Uint32 row;
+    Usul::Types::Uint32 column;
+    Usul::Types::Uint32 extension;
+  };
+
+  // Records start on 8 byte boundaries.
+  inline Usul::Types::Uint64 recordSize ( Usul::Types::Uint32 size )
+  {
+    const Usul::Types::Uint64 bytes ( sizeof ( RecordHeader ) + size );
+    return ( bytes + 7 ) & ~static_cast<Usul::Types::Uint64> ( 7 );
+  }
+
+  // The checksum covers everything in the header after the checksum, and the data.
+  inline Usul::Types::Uint32 checksum ( const RecordHeader& header, const char* data )
+  {
+    boost::crc_32_type crc;
+    crc.process_bytes ( &header.type, sizeof ( header.type ) );
+    crc.process_bytes ( &header.size, sizeof ( header.size ) );
+    crc.process_bytes ( &header.layer, sizeof ( RecordHeader ) - offsetof ( RecordHeader, layer ) );
+    if ( header.size > 0 )
+      crc.process_bytes ( data, header.size );
+    return crc.checksum();
+  }
+
+  // File locks are held by the process, so they do not keep two stores in
+  // the same process apart. These are the directories open in this process.
+  typedef std::set<std::string> Directories;
+  inline Usul::Threads::Mutex& openMutex()
+  {
+    static Usul::Threads::Mutex mutex;
+    return mutex;
+  }
+  inline Directories& openDirectories()
+  {
+    static Directories directories;
+    return directories;
+  }
+
+  // Close a segment written while compacting and make it full size.
+  inline void closeSegment ( std::ofstream& out, const std::string& filename, Usul::Types::Uint64 size )
+  {
+    out.close();
+    if ( true == out.fail() )
+      throw std::runtime_error ( "Error 2837361049: Could not write segment while compacting: " + filename );
+    boost::filesystem::resize_file ( filename, size );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A memory-mapped segment file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct PackedTileStore::Segment
+{
+  Segment ( const std::string& filename ) :
+    mapping ( filename.c_str(), boost::interprocess::read_write ),
+    region ( mapping, boost::interprocess::read_write ),
+    address ( static_cast<char*> ( region.get_address() ) ),
+    size ( region.get_size() )
+  {
+  }
+
+  boost::interprocess::file_mapping mapping;
+  boost::interprocess::mapped_region region;
+  char *address;
+  Uint64 size;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A shard of the index.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct PackedTileStore::Shard
+{
+  Shard() : mutex(), index() {}
+
+  mutable Usul::Threads::Mutex mutex;
+  Index index;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Compare keys.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::Key::operator < ( const Key& rhs ) const
+{
+  if ( layer     != rhs.layer     ) return layer     < rhs.layer;
+  if ( level     != rhs.level     ) return level     < rhs.level;
+  if ( row       != rhs.row       ) return row       < rhs.row;
+  if ( column    != rhs.column    ) return column    < rhs.column;
+  if ( width     != rhs.width     ) return width     < rhs.width;
+  if ( height    != rhs.height    ) return height    < rhs.height;
+  return extension < rhs.extension;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::PackedTileStore ( const std::string& directory, Uint64 segmentSize ) : BaseClass(),
+  _directory ( directory ),
+  _segmentSize ( segmentSize ),
+  _segments ( Helper::MAX_SEGMENTS, static_cast<Segment*> ( 0x0 ) ),
+  _shards(),
+  _allocMutex ( new Usul::Threads::Mutex ),
+  _fileLock ( 0x0 ),
+  _lockedDirectory(),
+  _numSegments ( 0 ),
+  _offset ( 0 )
+{
+  try
+  {
+    boost::filesystem::create_directories ( _directory );
+
+    // Make sure no other store is writing here.
+    this->_lock();
+
+    _shards.reserve ( Helper::NUM_SHARDS );
+    for ( unsigned int i = 0; i < Helper::NUM_SHARDS; ++i )
+    {
+      _shards.push_back ( new Shard );
+    }
+
+    // Finish or undo a compaction that was cut short.
+    this->_finishCompact();
+
+    // Build the index from what is on disk.
+    this->_scan();
+
+    // Drop the records that were written over or removed.
+    if ( true == this->_shouldCompact() )
+      this->_compact();
+  }
+  catch ( ... )
+  {
+    this->_destroy();
+    throw;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::~PackedTileStore()
+{
+  Usul::Functions::safeCall ( boost::bind ( &PackedTileStore::_destroy, this ), "1739250486" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destroy.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_destroy()
+{
+  this->_closeSegments();
+
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    delete *iter;
+    *iter = 0x0;
+  }
+
+  delete _allocMutex;
+  _allocMutex = 0x0;
+
+  delete _fileLock;
+  _fileLock = 0x0;
+
+  if ( false == _lockedDirectory.empty() )
+  {
+    Guard guard ( Helper::openMutex() );
+    Helper::openDirectories().erase ( _lockedDirectory );
+    _lockedDirectory.clear();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take the directory for this store. Throws if it is already taken.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_lock()
+{
+  const std::string directory ( boost::filesystem::canonical ( _directory ).string() );
+
+  {
+    Guard guard ( Helper::openMutex() );
+    if ( false == Helper::openDirectories().insert ( directory ).second )
+      throw std::runtime_error ( "Error 2837361045: Packed tile store is already open in this process: " + directory );
+  }
+  _lockedDirectory = directory;
+
+  // The lock file is never removed. The lock on it goes away with the process.
+  const std::string filename ( directory + "/store.lock" );
+  {
+    std::ofstream out ( filename.c_str(), std::ios::binary | std::ios::app );
+    if ( false == out.is_open() )
+      throw std::runtime_error ( "Error 2837361046: Could not create lock file: " + filename );
+  }
+
+  _fileLock = new boost::interprocess::file_lock ( filename.c_str() );
+  if ( false == _fileLock->try_lock() )
+    throw std::runtime_error ( "Error 2837361047: Packed tile store is already open in another process: " + directory );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the directory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const std::string& PackedTileStore::directory() const
+{
+  return _directory;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of tiles in the index.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t PackedTileStore::numTiles() const
+{
+  std::size_t num ( 0 );
+  for ( Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Guard guard ( (*iter)->mutex );
+    num += (*iter)->index.size();
+  }
+  return num;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of segment files.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int PackedTileStore::numSegments() const
+{
+  Guard guard ( *_allocMutex );
+  return _numSegments;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hash the layer key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::Uint64 PackedTileStore::_layerHash ( const LayerKey& layerKey )
+{
+  std::size_t seed ( 0 );
+  boost::hash_combine ( seed, layerKey.name() );
+  boost::hash_combine ( seed, layerKey.id() );
+  return static_cast<Uint64> ( seed );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::Key PackedTileStore::_makeKey ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension )
+{
+  Key key;
+  key.layer = PackedTileStore::_layerHash ( layerKey );
+  key.width = width;
+  key.height = height;
+  key.level = tileKey.level();
+  key.row = tileKey.row();
+  key.column = tileKey.column();
+  key.extension = static_cast<Uint32> ( boost::hash<std::string>() ( extension ) );
+  return key;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the shard for the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::Shard& PackedTileStore::_shard ( const Key& key ) const
+{
+  std::size_t seed ( 0 );
+  boost::hash_combine ( seed, key.layer );
+  boost::hash_combine ( seed, key.level );
+  boost::hash_combine ( seed, key.row );
+  boost::hash_combine ( seed, key.column );
+  return *_shards[seed % _shards.size()];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Find the location of the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::_find ( const Key& key, Location& location ) const
+{
+  Shard& shard ( this->_shard ( key ) );
+  Guard guard ( shard.mutex );
+  Index::const_iterator iter ( shard.index.find ( key ) );
+  if ( shard.index.end() == iter )
+    return false;
+
+  location = iter->second;
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Insert the location for the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_insert ( const Key& key, const Location& location )
+{
+  Shard& shard ( this->_shard ( key ) );
+  Guard guard ( shard.mutex );
+  shard.index[key] = location;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the tile in the store?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::contains ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension ) const
+{
+  Location location;
+  return this->_find ( PackedTileStore::_makeKey ( layerKey, tileKey, width, height, extension ), location );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the encoded tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::read ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, Buffer& buffer ) const
+{
+  Location location;
+  if ( false == this->_find ( PackedTileStore::_makeKey ( layerKey, tileKey, width, height, extension ), location ) )
+    return false;
+
+  // The segment is published before any location that refers to it.
+  const Segment *segment ( _segments.at ( location.segment ) );
+  if ( 0x0 == segment )
+    return false;
+
+  const char *data ( segment->address + location.offset + sizeof ( Helper::RecordHeader ) );
+  buffer.assign ( data, data + location.size );
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the encoded tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::write ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, const Buffer& buffer )
+{
+  if ( true == buffer.empty() )
+    return;
+
+  const Key key ( PackedTileStore::_makeKey ( layerKey, tileKey, width, height, extension ) );
+  this->_append ( Helper::RECORD_TILE, key, &buffer[0], static_cast<Uint32> ( buffer.size() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove all tiles for the layer. The space is not reclaimed, but the
+//  record makes sure the tiles are not added back on the next scan.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::remove ( const LayerKey& layerKey )
+{
+  Key key;
+  std::memset ( &key, 0, sizeof ( Key ) );
+  key.layer = PackedTileStore::_layerHash ( layerKey );
+
+  this->_append ( Helper::RECORD_REMOVE_LAYER, key, 0x0, 0 );
+  this->_removeLayer ( key.layer );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the layer from the index.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_removeLayer ( Uint64 layer )
+{
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Shard& shard ( **iter );
+    Guard guard ( shard.mutex );
+    Index::iterator i ( shard.index.begin() );
+    while ( i != shard.index.end() )
+    {
+      if ( layer == i->first.layer )
+        shard.index.erase ( i++ );
+      else
+        ++i;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Append a record.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_append ( Uint32 type, const Key& key, const char* data, Uint32 size )
+{
+  Uint32 index ( 0 );
+  Uint64 offset ( 0 );
+  if ( false == this->_reserve ( Helper::recordSize ( size ), index, offset ) )
+    return;
+
+  Segment *segment ( _segments.at ( index ) );
+  char *address ( segment->address + offset );
+
+  Helper::RecordHeader header;
+  std::memset ( &header, 0, sizeof ( header ) );
+  header.magic = Helper::MAGIC;
+  header.type = type;
+  header.size = size;
+  header.layer = key.layer;
+  header.width = key.width;
+  header.height = key.height;
+  header.level = key.level;
+  header.row = key.row;
+  header.column = key.column;
+  header.extension = key.extension;
+  header.checksum = Helper::checksum ( header, data );
+
+  // Copy the data before the header so a scan never sees a header without its data.
+  if ( size > 0 )
+    std::memcpy ( address + sizeof ( header ), data, size );
+  std::memcpy ( address, &header, sizeof ( header ) );
+
+  if ( Helper::RECORD_TILE == type )
+  {
+    Location location;
+    location.segment = index;
+    location.offset = offset;
+    location.size = size;
+    this->_insert ( key, location );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Reserve space for a record. Starts a new segment when the current one
+//  is full. Only the bookkeeping happens under the lock.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::_reserve ( Uint64 bytes, Uint32& segment, Uint64& offset )
+{
+  // Too big for any segment.
+  if ( bytes > _segmentSize )
+    return false;
+
+  Guard guard ( *_allocMutex );
+
+  if ( ( 0 == _numSegments ) || ( _offset + bytes > _segmentSize ) )
+  {
+    if ( _numSegments >= _segments.size() )
+      return false;
+
+    Segment *next ( this->_openSegment ( _numSegments, true ) );
+    if ( 0x0 == next )
+      return false;
+
+    _segments[_numSegments] = next;
+    ++_numSegments;
+    _offset = 0;
+  }
+
+  segment = _numSegments - 1;
+  offset = _offset;
+  _offset += bytes;
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the filename for the segment.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string PackedTileStore::_segmentFilename ( Uint32 index ) const
+{
+  return PackedTileStore::_segmentFilename ( _directory, index );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the filename for the segment in the directory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string PackedTileStore::_segmentFilename ( const std::string& directory, Uint32 index )
+{
+  std::ostringstream out;
+  out << directory << "/segment_" << std::setw ( 5 ) << std::setfill ( '0' ) << index << ".mts";
+  return out.str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Open the segment. When creating, the file is sized to the full segment.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+PackedTileStore::Segment* PackedTileStore::_openSegment ( Uint32 index, bool create )
+{
+  const std::string filename ( this->_segmentFilename ( index ) );
+
+  if ( true == create )
+  {
+    {
+      std::ofstream out ( filename.c_str(), std::ios::binary | std::ios::trunc );
+      if ( false == out.is_open() )
+        return 0x0;
+    }
+    boost::filesystem::resize_file ( filename, _segmentSize );
+  }
+  else if ( false == boost::filesystem::exists ( filename ) )
+  {
+    return 0x0;
+  }
+  else if ( boost::filesystem::file_size ( filename ) < _segmentSize )
+  {
+    // A segment that was cut short would be written past its end, so grow
+    // it back. The new bytes are zero, which the scan reads as the end.
+    boost::filesystem::resize_file ( filename, _segmentSize );
+  }
+
+  return new Segment ( filename );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Scan the segments and build the index. Writing continues after the last
+//  good record of the last segment.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_scan()
+{
+  Guard guard ( *_allocMutex );
+
+  for ( Uint32 i = 0; i < _segments.size(); ++i )
+  {
+    Segment *segment ( this->_openSegment ( i, false ) );
+    if ( 0x0 == segment )
+      break;
+
+    _segments[i] = segment;
+    _numSegments = i + 1;
+
+    Uint64 offset ( 0 );
+    while ( offset + sizeof ( Helper::RecordHeader ) <= segment->size )
+    {
+      Helper::RecordHeader header;
+      std::memcpy ( &header, segment->address + offset, sizeof ( header ) );
+
+      if ( Helper::MAGIC != header.magic )
+        break;
+
+      const Uint64 bytes ( Helper::recordSize ( header.size ) );
+      if ( offset + bytes > segment->size )
+        break;
+
+      const char *data ( segment->address + offset + sizeof ( header ) );
+      if ( Helper::checksum ( header, data ) != header.checksum )
+        break;
+
+      Key key;
+      key.layer = header.layer;
+      key.width = header.width;
+      key.height = header.height;
+      key.level = header.level;
+      key.row = header.row;
+      key.column = header.column;
+      key.extension = header.extension;
+
+      if ( Helper::RECORD_TILE == header.type )
+      {
+        Location location;
+        location.segment = i;
+        location.offset = offset;
+        location.size = header.size;
+        this->_insert ( key, location );
+      }
+      else if ( Helper::RECORD_REMOVE_LAYER == header.type )
+      {
+        this->_removeLayer ( key.layer );
+      }
+
+      offset += bytes;
+    }
+
+    _offset = offset;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Unmap the segments.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_closeSegments()
+{
+  for ( Segments::iterator iter = _segments.begin(); iter != _segments.end(); ++iter )
+  {
+    if ( 0x0 != *iter )
+    {
+      (*iter)->region.flush();
+      delete *iter;
+      *iter = 0x0;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the directory the live records are copied to.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string PackedTileStore::_compactDirectory() const
+{
+  return Usul::Strings::format ( _directory, '/', Helper::COMPACT_DIRECTORY );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is less than half of the used space live? Only worth it when there is 
+//  more than one segment.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool PackedTileStore::_shouldCompact() const
+{
+  Guard guard ( *_allocMutex );
+
+  if ( _numSegments < 2 )
+    return false;
+
+  Uint64 live ( 0 );
+  for ( Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Guard shardGuard ( (*iter)->mutex );
+    for ( Index::const_iterator i = (*iter)->index.begin(); i != (*iter)->index.end(); ++i )
+    {
+      live += Helper::recordSize ( i->second.size );
+    }
+  }
+
+  const Uint64 used ( ( _numSegments - 1 ) * _segmentSize + _offset );
+  return ( live * 2 < used );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copy the live records into new segments and use them instead of the old 
+//  ones. Only called from the constructor, so nothing else is using the 
+//  segments.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_compact()
+{
+  const std::string directory ( this->_compactDirectory() );
+  boost::filesystem::remove_all ( directory );
+  boost::filesystem::create_directories ( directory );
+
+  {
+    Guard guard ( *_allocMutex );
+
+    Uint32 count ( 0 );
+    Uint64 offset ( 0 );
+    std::ofstream out;
+
+    for ( Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+    {
+      Guard shardGuard ( (*iter)->mutex );
+      for ( Index::const_iterator i = (*iter)->index.begin(); i != (*iter)->index.end(); ++i )
+      {
+        const Location& location ( i->second );
+        const Uint64 bytes ( Helper::recordSize ( location.size ) );
+
+        // Start the next segment when this one is full.
+        if ( ( false == out.is_open() ) || ( offset + bytes > _segmentSize ) )
+        {
+          if ( true == out.is_open() )
+            Helper::closeSegment ( out, PackedTileStore::_segmentFilename ( directory, count - 1 ), _segmentSize );
+
+          out.open ( PackedTileStore::_segmentFilename ( directory, count ).c_str(), std::ios::binary | std::ios::trunc );
+          if ( false == out.is_open() )
+            throw std::runtime_error ( "Error 2837361048: Could not create segment while compacting: " + directory );
+
+          ++count;
+          offset = 0;
+        }
+
+        // The record is copied as is, its header doesn't say where it is.
+        out.write ( _segments.at ( location.segment )->address + location.offset, static_cast<std::streamsize> ( bytes ) );
+        offset += bytes;
+      }
+    }
+
+    if ( true == out.is_open() )
+      Helper::closeSegment ( out, PackedTileStore::_segmentFilename ( directory, count - 1 ), _segmentSize );
+
+    // The new segments are complete. The marker says how many there are.
+    std::ofstream done ( Usul::Strings::format ( directory, '/', Helper::COMPACT_DONE ).c_str() );
+    done << count;
+  }
+
+  // Use the new segments and index them again.
+  {
+    Guard guard ( *_allocMutex );
+    this->_closeSegments();
+    _numSegments = 0;
+    _offset = 0;
+  }
+
+  for ( Shards::iterator iter = _shards.begin(); iter != _shards.end(); ++iter )
+  {
+    Guard guard ( (*iter)->mutex );
+    (*iter)->index.clear();
+  }
+
+  this->_finishCompact();
+  this->_scan();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the compacted segments into place if they were finished, otherwise
+//  throw them away. Every step can be done again, so this also finishes a 
+//  move that was cut short.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void PackedTileStore::_finishCompact()
+{
+  const std::string directory ( this->_compactDirectory() );
+  if ( false == boost::filesystem::exists ( directory ) )
+    return;
+
+  Uint32 count ( 0 );
+  std::ifstream done ( Usul::Strings::format ( directory, '/', Helper::COMPACT_DONE ).c_str() );
+  if ( ( true == done.is_open() ) && ( done >> count ) )
+  {
+    // Move the new segments over the old ones. 
+    for ( Uint32 i = 0; i < count; ++i )
+    {
+      const std::string from ( PackedTileStore::_segmentFilename ( directory, i ) );
+      if ( true == boost::filesystem::exists ( from ) )
+        boost::filesystem::rename ( from, this->_segmentFilename ( i ) );
+    }
+
+    // Remove the old segments past the new ones.
+    for ( Uint32 i = count; i < Helper::MAX_SEGMENTS; ++i )
+    {
+      const std::string filename ( this->_segmentFilename ( i ) );
+      if ( false == boost::filesystem::exists ( filename ) )
+        break;
+      boost::filesystem::remove ( filename );
+    }
+  }
+  done.close();
+
+  boost::filesystem::remove_all ( directory );
+}
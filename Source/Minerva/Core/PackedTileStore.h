@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tile store that packs tiles into large memory-mapped segment files.
+//
+//  Records are appended to the current segment. Each record has a header
+//  with the tile key and a checksum, so the index can be rebuilt by
+//  scanning the segments when the store is opened. A scan stops at the
+//  first record that does not check out, which is how a partial write
+//  from a crash is discarded.
+//
+//  The index is split into shards, each with its own mutex. Writers only
+//  share a small mutex while reserving space in the current segment; the
+//  copy into the mapped memory happens outside of any lock.
+//
+//  Records that were written over or removed still take up space. When the
+//  store is opened and less than half of the used space is live, the live
+//  records are copied into new segments in a sub-directory, which then
+//  replace the old ones. A marker file written after the copy says the new
+//  segments are complete, so a crash part way through is finished or undone
+//  on the next open.
+//
+//  Only one store may have a directory open at a time, in this process or
+//  in any other. The index of one store would not see the records that
+//  another appends, so the constructor throws if the directory is in use.
+//  An exclusive lock on a file in the directory enforces this between
+//  processes, and it is released when the store is destroyed or the
+//  process ends.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_PACKED_TILE_STORE_H__
+#define __MINERVA_CORE_PACKED_TILE_STORE_H__
+
+#include "Minerva/Core/TileStore.h"
+
+#include "Usul/Types/Types.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Usul { namespace Threads { class Mutex; } }
+namespace boost { namespace interprocess { class file_lock; } }
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT PackedTileStore : public Minerva::Core::TileStore
+{
+public:
+
+  typedef Minerva::Core::TileStore BaseClass;
+  typedef Usul::Types::Uint32 Uint32;
+  typedef Usul::Types::Uint64 Uint64;
+
+  USUL_DECLARE_REF_POINTERS ( PackedTileStore );
+
+  /// Open the store in the given directory. Existing segments are scanned.
+  /// Throws if another store has the directory open.
+  PackedTileStore ( const std::string& directory, Uint64 segmentSize = 256 * 1024 * 1024 );
+
+  /// Tile store interface.
+  virtual bool contains ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension ) const;
+  virtual bool read ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, Buffer& buffer ) const;
+  virtual void write ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, const Buffer& buffer );
+  virtual void remove ( const LayerKey& layerKey );
+
+  /// Get the directory.
+  const std::string& directory() const;
+
+  /// Get the number of tiles in the index.
+  std::size_t numTiles() const;
+
+  /// Get the number of segment files.
+  unsigned int numSegments() const;
+
+protected:
+
+  virtual ~PackedTileStore();
+
+private:
+
+  struct Key
+  {
+    Uint64 layer;
+    Uint32 width;
+    Uint32 height;
+    Uint32 level;
+    Uint32 row;
+    Uint32 column;
+    Uint32 extension;
+
+    bool operator < ( const Key& rhs ) const;
+  };
+
+  struct Location
+  {
+    Uint32 segment;
+    Uint64 offset;
+    Uint32 size;
+  };
+
+  struct Segment;
+  struct Shard;
+  typedef std::map<Key,Location> Index;
+  typedef std::vector<Segment*> Segments;
+  typedef std::vector<Shard*> Shards;
+
+  static Uint64 _layerHash ( const LayerKey& layerKey );
+  static Key    _makeKey ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension );
+
+  void          _append ( Uint32 type, const Key& key, const char* data, Uint32 size );
+  void          _closeSegments();
+  void          _compact();
+  std::string   _compactDirectory() const;
+  void          _destroy();
+  void          _finishCompact();
+  void          _lock();
+  bool          _find ( const Key& key, Location& location ) const;
+  void          _insert ( const Key& key, const Location& location );
+  Segment*      _openSegment ( Uint32 index, bool create );
+  void          _removeLayer ( Uint64 layer );
+  bool          _reserve ( Uint64 bytes, Uint32& segment, Uint64& offset );
+  void          _scan();
+  std::string   _segmentFilename ( Uint32 index ) const;
+  static std::string _segmentFilename ( const std::string& directory, Uint32 index );
+  Shard&        _shard ( const Key& key ) const;
+  bool          _shouldCompact() const;
+
+  const std::string _directory;
+  const Uint64 _segmentSize;
+  Segments _segments;
+  Shards _shards;
+  Usul::Threads::Mutex *_allocMutex;
+  boost::interprocess::file_lock *_fileLock;
+  std::string _lockedDirectory;
+  Uint32 _numSegments;
+  Uint64 _offset;
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_PACKED_TILE_STORE_H__
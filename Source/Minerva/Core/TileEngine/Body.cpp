@@ -105,8 +105,11 @@ Body::Body ( unsigned int numberOfRows,
   _numberOfRows ( numberOfRows ),
   _numberOfColumns ( numberOfColumns ),
   _extents ( extents ),
+  _prefetch ( 0x0 ),
   SERIALIZE_XML_INITIALIZER_LIST
 {
+  _prefetch = new Prefetch ( this );
+
   _container->add ( new Container );
   _container->add ( new Container );
   _container->add ( new Container );
@@ -176,6 +179,11 @@ Body::~Body()
 void Body::_destroy()
 {
   this->clear();
+
+  if ( _prefetch.valid() )
+  {
+    _prefetch->clear();
+  }
 }
 
 
@@ -538,6 +546,23 @@ void Body::latLonHeightToXYZ ( double lat, double lon, double elevation, osg::Ve
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n lat,lon,heights to x,y,z.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Body::latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const
+{
+  Guard guard ( this );
+
+  if ( true == _landModel.valid() )
+  {
+    _landModel->latLonHeightToXYZ ( lat, lon, elevation, x, y, z, n );
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Convert x,y,z to lat, lon, height.
@@ -569,6 +594,18 @@ void Body::convertToPlanet ( const Usul::Math::Vec3d& orginal, Usul::Math::Vec3d
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n points to planet coordinates.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Body::convertToPlanet ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const
+{
+  this->latLonHeightToXYZ ( lat, lon, elevation, x, y, z, n );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Convert from planet coordinates.
@@ -913,38 +950,55 @@ double Body::splitDistance() const
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get the elevation from a tile.
+//  Find the leaf tile under the point. The child at each level comes from 
+//  the next bit of the point's position in the top tile, which is how the 
+//  tile keys are numbered, so only one child is looked at per level.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-namespace Detail
+Tile::RefPtr Body::leafTile ( const Tiles& tiles, const Extents::Vertex& p )
 {
-  bool elevationFromTile ( Tile::RefPtr tile, const Extents::Vertex& p, double& elevation )
+  typedef Minerva::Common::TileKey TileKey;
+  static const unsigned int quadrants[2][2] = 
   {
+    { TileKey::LOWER_LEFT, TileKey::LOWER_RIGHT },
+    { TileKey::UPPER_LEFT, TileKey::UPPER_RIGHT }
+  };
+
+  for ( Tiles::const_iterator iter = tiles.begin(); iter != tiles.end(); ++iter )
+  {
+    Tile::RefPtr tile ( *iter );
     if ( false == tile.valid() )
-      return false;
+      continue;
+
+    const Extents e ( tile->extents() );
+    if ( false == e.contains ( p ) )
+      continue;
 
-    Extents e ( tile->extents() );
+    // Position in the top tile, from zero to one.
+    const Extents::Vertex &mn ( e.minimum() );
+    const Extents::Vertex &mx ( e.maximum() );
+    double u ( ( p[0] - mn[0] ) / ( mx[0] - mn[0] ) );
+    double v ( ( p[1] - mn[1] ) / ( mx[1] - mn[1] ) );
 
-    if ( e.contains ( p ) )
+    while ( true )
     {
-      if ( tile->isLeaf() )
-      {
-        elevation = tile->elevation ( p[1], p[0] );
-        return true;
-      }
-      else
-      {
-        // Ask the children.
-        if ( Detail::elevationFromTile ( tile->childAt ( 0 ), p, elevation ) ) return true;
-        if ( Detail::elevationFromTile ( tile->childAt ( 1 ), p, elevation ) ) return true;
-        if ( Detail::elevationFromTile ( tile->childAt ( 2 ), p, elevation ) ) return true;
-        if ( Detail::elevationFromTile ( tile->childAt ( 3 ), p, elevation ) ) return true;
-      }
+      u *= 2.0;
+      v *= 2.0;
+      const unsigned int column ( u >= 1.0 ? 1 : 0 );
+      const unsigned int row    ( v >= 1.0 ? 1 : 0 );
+      u -= column;
+      v -= row;
+
+      Tile::RefPtr child ( tile->childIfSplit ( quadrants[row][column] ) );
+      if ( false == child.valid() )
+        return tile;
+
+      tile = child;
     }
-
-    return false;
   }
+
+  return Tile::RefPtr ( 0x0 );
 }
 
 
@@ -957,17 +1011,9 @@ namespace Detail
 double Body::elevation ( double lat, double lon ) const
 {
   Tiles tiles ( Usul::Threads::Safe::get ( this->mutex(), _topTiles ) );
-  
-  Extents::Vertex v ( lon, lat );
-  double elevation ( 0.0 );
 
-  for ( Tiles::const_iterator iter = tiles.begin(); iter != tiles.end(); ++iter )
-  {
-    if ( Detail::elevationFromTile ( *iter, v, elevation ) ) 
-      break;
-  }
-  
-  return elevation;
+  Tile::RefPtr tile ( Body::leafTile ( tiles, Extents::Vertex ( lon, lat ) ) );
+  return ( tile.valid() ? tile->elevation ( lat, lon ) : 0.0 );
   
   // Should we use a geoid here?  Keeping this for reference.
   // http://en.wikipedia.org/wiki/Geoid
@@ -1048,6 +1094,73 @@ void Body::updateNotify ( Minerva::Core::Data::Camera* camera )
   
   // Update the vector group.
   _container->updateNotify ( cameraState, planet.get(), elevation.get() );
+
+  // Look for tiles we are about to need.
+  if ( 0x0 != camera )
+  {
+    _prefetch->cameraNotify ( longitude, latitude, altitude );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the prefetcher.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Prefetch::RefPtr Body::prefetch() const
+{
+  Guard guard ( this );
+  return _prefetch;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the key of the tile at the level that contains the point. The keys 
+//  are split the same way the tiles are, so they match the tiles' keys.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Minerva::Common::TileKey::RefPtr Body::keyAt ( double lon, double lat, unsigned int level ) const
+{
+  typedef Minerva::Common::TileKey TileKey;
+
+  // Find the top-level tile.
+  TileKey::RefPtr key ( 0x0 );
+  {
+    Guard guard ( this );
+    for ( Tiles::const_iterator iter = _topTiles.begin(); iter != _topTiles.end(); ++iter )
+    {
+      Tile::RefPtr tile ( *iter );
+      if ( tile.valid() && tile->extents().contains ( Extents::Vertex ( lon, lat ) ) )
+      {
+        key = tile->key();
+        break;
+      }
+    }
+  }
+
+  // Go down to the level.
+  while ( key.valid() && key->level() < level )
+  {
+    TileKey::ChildrenKeys keys;
+    key->split ( keys );
+
+    TileKey::RefPtr next ( 0x0 );
+    for ( unsigned int i = 0; i < keys.size(); ++i )
+    {
+      if ( keys[i]->extents().contains ( Extents::Vertex ( lon, lat ) ) )
+      {
+        next = keys[i];
+        break;
+      }
+    }
+    key = next;
+  }
+
+  return key;
 }
 
 
@@ -1139,6 +1252,51 @@ double Body::elevationAtLatLong ( double lat, double lon ) const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the elevations at many points (IElevationDatabase). Neighboring points
+//  are usually on the same tile, so that one is tried before looking again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Body::elevations ( const double* lat, const double* lon, double* out, unsigned int n ) const
+{
+  Tiles tiles ( Usul::Threads::Safe::get ( this->mutex(), _topTiles ) );
+  Body::tileElevations ( tiles, lat, lon, out, n );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the elevations at many points from the leaf tiles under the given 
+//  top tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Body::tileElevations ( const Tiles& tiles, const double* lat, const double* lon, double* out, unsigned int n )
+{
+  if ( 0x0 == lat || 0x0 == lon || 0x0 == out )
+    return;
+
+  Tile::RefPtr tile ( 0x0 );
+  Extents extents;
+
+  for ( unsigned int i = 0; i < n; ++i )
+  {
+    const Extents::Vertex p ( lon[i], lat[i] );
+
+    if ( false == tile.valid() || false == extents.contains ( p ) )
+    {
+      tile = Body::leafTile ( tiles, p );
+      if ( tile.valid() )
+        extents = tile->extents();
+    }
+
+    out[i] = ( tile.valid() ? tile->elevation ( lat[i], lon[i] ) : 0.0 );
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Set the flag that says to allow spliting.
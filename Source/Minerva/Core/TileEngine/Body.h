@@ -19,6 +19,7 @@
 
 #include "Minerva/Core/Macros.h"
 #include "Minerva/Core/TileEngine/LandModel.h"
+#include "Minerva/Core/TileEngine/Prefetch.h"
 #include "Minerva/Core/TileEngine/SplitCallbacks.h"
 #include "Minerva/Core/TileEngine/Tile.h"
 #include "Minerva/Core/TileEngine/Typedefs.h"
@@ -113,6 +114,14 @@ public:
 
   // Get the elevation at a lat, lon (IElevationDatabase).
   virtual double            elevationAtLatLong ( double lat, double lon ) const;
+
+  // Get the elevations at many points (IElevationDatabase).
+  virtual void              elevations ( const double* lat, const double* lon, double* out, unsigned int n ) const;
+
+  // Find the leaf tile under the point, or get the elevations at many points, 
+  // starting from the given top tiles.
+  static Tile::RefPtr       leafTile ( const Tiles& tiles, const Extents::Vertex& p );
+  static void               tileElevations ( const Tiles& tiles, const double* lat, const double* lon, double* out, unsigned int n );
   
   // Append elevation data.
   void                      elevationAppend ( Minerva::Core::Data::Feature * );
@@ -127,6 +136,10 @@ public:
   void                      jobManager ( Usul::Jobs::Manager * );
   Usul::Jobs::Manager *     jobManager();
 
+  // Make the key of the tile at the level that contains the point. 
+  // Returns null if the point is outside the body.
+  Minerva::Common::TileKey::RefPtr keyAt ( double lon, double lat, unsigned int level ) const;
+
   // Set/get the flag that says to keep detail.
   void                      keepDetail ( bool );
   bool                      keepDetail() const;
@@ -134,9 +147,11 @@ public:
   // Convert lat, lon, height to x,y,z.
   void                      latLonHeightToXYZ ( double lat, double lon, double elevation, osg::Vec3d& point ) const;
   void                      xyzToLatLonHeight ( const osg::Vec3d& point, double& lat, double& lon, double& elevation ) const;
+  void                      latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const;
 
   /// Convert to planet coordinates.
   virtual void              convertToPlanet ( const Usul::Math::Vec3d& orginal, Usul::Math::Vec3d& planetPoint ) const;
+  virtual void              convertToPlanet ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const;
   virtual void              convertFromPlanet ( const Usul::Math::Vec3d& planetPoint, Usul::Math::Vec3d& lonLatPoint ) const;
   
   // Matrix to place items on the planet (i.e. local coordinates to world coordinates).
@@ -164,6 +179,9 @@ public:
   void                      needsRedraw ( bool b );
   bool                      needsRedraw() const;
 
+  // Get the prefetcher.
+  Prefetch::RefPtr          prefetch() const;
+
   // Purge tiles that are ready.
   void                      purgeTiles();
 
@@ -281,6 +299,7 @@ private:
   unsigned int _numberOfRows;
   unsigned int _numberOfColumns;
   Extents _extents;
+  Prefetch::RefPtr _prefetch;
 
   SERIALIZE_XML_CLASS_NAME ( Body );
   SERIALIZE_XML_ADD_MEMBER_FUNCTION;
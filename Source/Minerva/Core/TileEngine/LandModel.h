@@ -43,6 +43,18 @@ public:
   virtual void        latLonHeightToXYZ ( double lat, double lon, double elevation, double& x, double& y, double& z ) const = 0;
   virtual void        xyzToLatLonHeight ( double x, double y, double z, double& lat, double& lon, double& elevation ) const = 0;
 
+  // Convert n points at once. The arrays may not overlap. By default each point is converted by itself.
+  virtual void        latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const
+  {
+    for ( unsigned int i = 0; i < n; ++i )
+      this->latLonHeightToXYZ ( lat[i], lon[i], elevation[i], x[i], y[i], z[i] );
+  }
+  virtual void        xyzToLatLonHeight ( const double* x, const double* y, const double* z, double* lat, double* lon, double* elevation, unsigned int n ) const
+  {
+    for ( unsigned int i = 0; i < n; ++i )
+      this->xyzToLatLonHeight ( x[i], y[i], z[i], lat[i], lon[i], elevation[i] );
+  }
+
   // Matrix to place items on the planet (i.e. local coordinates to world coordinates).
   virtual Matrix      planetRotationMatrix ( double lat, double lon, double elevation, double heading ) const = 0;
 
@@ -9,6 +9,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Core/TileEngine/LandModelEllipsoid.h"
+#include "Minerva/Core/Algorithms/SinCos.h"
 
 #include "Usul/Factory/RegisterCreator.h"
 #include "Usul/Math/Absolute.h"
@@ -20,6 +21,8 @@
 #include "osg/CoordinateSystemNode"
 #include "osg/Matrixd"
 
+#include <cmath>
+
 using namespace Minerva::Core::TileEngine;
 
 USUL_FACTORY_REGISTER_CREATOR ( LandModelEllipsoid );
@@ -86,6 +89,74 @@ void LandModelEllipsoid::xyzToLatLonHeight ( double x, double y, double z, doubl
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n points to x,y,z. This is the same formula as the ellipsoid's,
+//  but the sines and cosines are done a block at a time with a kernel that 
+//  vectorizes, and the lock is taken once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void LandModelEllipsoid::latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const
+{
+  double equator ( 0.0 ), polar ( 0.0 );
+  {
+    Guard guard ( this );
+    equator = _ellipsoid->getRadiusEquator();
+    polar = _ellipsoid->getRadiusPolar();
+  }
+
+  const double flattening ( ( equator - polar ) / equator );
+  const double eccentricitySquared ( 2.0 * flattening - flattening * flattening );
+
+  enum { BLOCK_SIZE = 256 };
+  double sinLat[BLOCK_SIZE], cosLat[BLOCK_SIZE], sinLon[BLOCK_SIZE], cosLon[BLOCK_SIZE];
+
+  for ( unsigned int first = 0; first < n; first += BLOCK_SIZE )
+  {
+    const unsigned int size ( Usul::Math::minimum<unsigned int> ( BLOCK_SIZE, n - first ) );
+
+    Minerva::Core::Algorithms::sinCosDegrees ( lat + first, sinLat, cosLat, size );
+    Minerva::Core::Algorithms::sinCosDegrees ( lon + first, sinLon, cosLon, size );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      const double height ( elevation[first + i] );
+      const double radius ( equator / std::sqrt ( 1.0 - eccentricitySquared * sinLat[i] * sinLat[i] ) );
+      const double r ( ( radius + height ) * cosLat[i] );
+
+      x[first + i] = r * cosLon[i];
+      y[first + i] = r * sinLon[i];
+      z[first + i] = ( radius * ( 1.0 - eccentricitySquared ) + height ) * sinLat[i];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n points to lat, lon, height. The lock is taken once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void LandModelEllipsoid::xyzToLatLonHeight ( const double* x, const double* y, const double* z, double* lat, double* lon, double* elevation, unsigned int n ) const
+{
+  {
+    Guard guard ( this );
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+      _ellipsoid->convertXYZToLatLongHeight ( x[i], y[i], z[i], lat[i], lon[i], elevation[i] );
+    }
+  }
+
+  for ( unsigned int i = 0; i < n; ++i )
+  {
+    lat[i] *= Usul::Math::RAD_TO_DEG;
+    lon[i] *= Usul::Math::RAD_TO_DEG;
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Serialize the members.
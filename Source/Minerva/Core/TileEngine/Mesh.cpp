@@ -18,21 +18,23 @@
 #include "Minerva/Core/TileEngine/LandModelEllipsoid.h"
 
 #include "Usul/Algorithms/TriStrip.h"
-#include "Usul/Math/Barycentric.h"
 #include "Usul/Math/MinMax.h"
-#include "Usul/Predicates/Tolerance.h"
+#include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
 
-#include "Minerva/OsgTools/ConvertVector.h"
 #include "Minerva/OsgTools/Group.h"
 #include "Minerva/OsgTools/StateSet.h"
 
 #include "osg/BlendFunc"
+#include "osg/BufferObject"
 #include "osg/ClusterCullingCallback"
 #include "osg/Geode"
 #include "osg/Depth"
 #include "osg/Hint"
 #include "osg/PolygonOffset"
 
+#include <map>
+
 using namespace Minerva::Core::TileEngine;
 
 
@@ -65,11 +67,11 @@ const int SKIRT_RENDER_BIN ( 0 );
 ///////////////////////////////////////////////////////////////////////////////
 
 Mesh::Mesh ( unsigned int rows, unsigned int columns, double skirtHeight, const Extents& extents ) :
-  _latLonPoints ( rows * columns * 2 ),
-  _points    ( rows * columns * 2 ),
-  _normals   ( rows * columns * 2 ),
-  _texCoords ( rows * columns * 2 ),
-  _meshPrimitives(),
+  _latLonPoints ( rows * columns ),
+  _points    ( new Points    ( rows * columns * 2 ) ),
+  _normals   ( new Normals   ( rows * columns * 2 ) ),
+  _texCoords ( new TexCoords ( rows * columns * 2 ) ),
+  _topology  ( Mesh::_getTopology ( rows, columns ) ),
   _rows      ( rows ),
   _columns   ( columns ),
   _skirtHeight ( skirtHeight ),
@@ -77,96 +79,72 @@ Mesh::Mesh ( unsigned int rows, unsigned int columns, double skirtHeight, const
   _borders ( new osg::Group ),
   _skirts ( new osg::Geode ),
   _ground ( new osg::Geode ),
-  _lowerLeft(),
+  _center(),
   _boundingSphere()
 {
-  // Make the draw elements now because they are only dependent on the rows and columns.
-  // There is one tri-strip for each adjacent pair of rows.
-  Usul::Algorithms::triStripIndices ( _rows, _columns, _meshPrimitives );
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Access to a single point.
+//  Get the topology for the size, making it the first time. The draw 
+//  elements only depend on the rows and columns, so all meshes of the same 
+//  size share them.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-Mesh::const_reference Mesh::_point ( size_type r, size_type c ) const
+namespace Detail
 {
-  return _points.at ( this->_index ( r, c ) );
-}
+  typedef std::pair<unsigned int, unsigned int> TopologyKey;
+  typedef std::map<TopologyKey, osg::ref_ptr<const osg::Referenced> > Topologies;
 
+  Usul::Threads::Mutex topologyMutex;
+  Topologies topologies;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-//  Build the mesh.
-//
-///////////////////////////////////////////////////////////////////////////////
+  // Give the draw elements one element buffer. Geometry only adds a buffer 
+  // to draw elements that have none, so once this is done the meshes that 
+  // share the list never write to it.
+  void attachBuffer ( osg::Geometry::PrimitiveSetList& primitives )
+  {
+    osg::ref_ptr<osg::ElementBufferObject> ebo ( new osg::ElementBufferObject );
+    for ( osg::Geometry::PrimitiveSetList::iterator iter = primitives.begin(); iter != primitives.end(); ++iter )
+    {
+      osg::DrawElements *elements ( iter->valid() ? (*iter)->getDrawElements() : 0x0 );
+      if ( 0x0 != elements )
+      {
+        elements->setElementBufferObject ( ebo.get() );
+      }
+    }
+  }
+}
 
-void Mesh::_buildGeometry ( osg::Geode& mesh, osg::Geode& skirts ) const
+Mesh::TopologyPtr Mesh::_getTopology ( unsigned int rows, unsigned int columns )
 {
-  // Allocate the points.
-  osg::ref_ptr<osg::Vec3Array> points  ( new osg::Vec3Array (  _points.begin(), _points.end() ) );
-  
-  // Allocate the normals.
-  osg::ref_ptr<osg::Vec3Array> normals ( new osg::Vec3Array ( _normals.begin(), _normals.end()  ) );
-  
-  // Allocation texture coordinates.
-  osg::ref_ptr<osg::Vec2Array> texCoords ( new osg::Vec2Array ( _texCoords.begin(), _texCoords.end() ) );
+  const Detail::TopologyKey key ( rows, columns );
 
-  // Make the main mesh.
   {
-    // Make the geometry.
-    osg::ref_ptr<osg::Geometry> geometry ( new osg::Geometry );
-    
-    // Set the points.
-    geometry->setVertexArray ( points.get() );
-    
-    // Set the normals.
-    geometry->setNormalArray ( normals.get() );
-    geometry->setNormalBinding ( osg::Geometry::BIND_PER_VERTEX );
-    
-    // Set the texture coordinates.
-    geometry->setTexCoordArray ( 0, texCoords.get() );
-
-    // Make the draw elements.
-    osg::Geometry::PrimitiveSetList primitives ( _meshPrimitives.size() );
-
-    for ( unsigned int i = 0; i < primitives.size(); ++i )
+    Usul::Threads::Guard<Usul::Threads::Mutex> guard ( Detail::topologyMutex );
+    Detail::Topologies::const_iterator iter ( Detail::topologies.find ( key ) );
+    if ( Detail::topologies.end() != iter )
     {
-      const Indices& indices ( _meshPrimitives.at ( i ) );
-
-      // Create the draw elements.
-      osg::ref_ptr<osg::DrawElementsUShort> drawElements ( new osg::DrawElementsUShort ( osg::PrimitiveSet::TRIANGLE_STRIP, indices.size(), &indices[0] ) );
-
-      // Assign the value.
-      primitives[i] = drawElements.get();
+      return TopologyPtr ( static_cast<const Topology*> ( iter->second.get() ) );
     }
-    
-    // Set the primitive-set list.
-    geometry->setPrimitiveSetList ( primitives );
-        
-    // Use vertex buffers.
-    geometry->setUseDisplayList ( false );
-    geometry->setUseVertexBufferObjects ( true );
-
-    // Add the drawable.
-    mesh.addDrawable ( geometry.get() );
+  }
 
-    // Get the state set.
-    osg::ref_ptr<osg::StateSet> ss ( mesh.getOrCreateStateSet() );
+  osg::ref_ptr<Topology> topology ( new Topology );
 
-    // Turn off back-face culling.
-    ss->setMode ( GL_CULL_FACE, osg::StateAttribute::OFF );
-
-    osg::ref_ptr<osg::PolygonOffset> offset ( new osg::PolygonOffset );
-    offset->setFactor ( MESH_POLYGON_OFFSET_FACTOR );
-    offset->setUnits  ( MESH_POLYGON_OFFSET_UNITS  );
-    ss->setAttributeAndModes ( offset.get(), osg::StateAttribute::OVERRIDE | osg::StateAttribute::PROTECTED | osg::StateAttribute::ON );
+  // There is one tri-strip for each adjacent pair of rows.
+  typedef std::vector<unsigned short> Indices;
+  typedef std::vector<Indices> Primitives;
+  Primitives primitives;
+  Usul::Algorithms::triStripIndices ( rows, columns, primitives );
 
-    if ( 0 != MESH_RENDER_BIN )
-      ss->setRenderBinDetails( MESH_RENDER_BIN, "RenderBin" );
+  for ( Primitives::const_iterator iter = primitives.begin(); iter != primitives.end(); ++iter )
+  {
+    const Indices& indices ( *iter );
+    Topology::Strip strip ( new osg::DrawElementsUShort ( osg::PrimitiveSet::TRIANGLE_STRIP, indices.size(), &indices[0] ) );
+    topology->strips.push_back ( strip );
+    topology->mesh.push_back ( strip.get() );
   }
 
   // Make the skirts.
@@ -187,7 +165,7 @@ void Mesh::_buildGeometry ( osg::Geode& mesh, osg::Geode& skirts ) const
   */
   {
     // Get the number of vertices.
-    const Vectors::size_type numVertices ( _rows * _columns );
+    const unsigned int numVertices ( rows * columns );
 
     // Make the draw elements.
     osg::ref_ptr<osg::DrawElementsUShort> AB ( new osg::DrawElementsUShort ( osg::PrimitiveSet::TRIANGLE_STRIP ) );
@@ -196,51 +174,131 @@ void Mesh::_buildGeometry ( osg::Geode& mesh, osg::Geode& skirts ) const
     osg::ref_ptr<osg::DrawElementsUShort> DA ( new osg::DrawElementsUShort ( osg::PrimitiveSet::TRIANGLE_STRIP ) );
 
     // Loop through all the columns.
-    for ( unsigned int j = 0; j < _columns; ++j )
+    for ( unsigned int j = 0; j < columns; ++j )
     {
-      AB->push_back ( ( ( ( _rows - 1 ) ) * _columns ) + j + numVertices );
-      AB->push_back ( ( ( ( _rows - 1 ) ) * _columns ) + j               );
+      AB->push_back ( ( ( ( rows - 1 ) ) * columns ) + j + numVertices );
+      AB->push_back ( ( ( ( rows - 1 ) ) * columns ) + j               );
 
       CD->push_back ( j + numVertices );
       CD->push_back ( j               );
     }
 
     // Loop through all the rows.
-    for ( unsigned int i = 0; i < _rows; ++i )
+    for ( unsigned int i = 0; i < rows; ++i )
     {
-      BC->push_back ( ( i * _columns ) + ( _columns - 1 ) + numVertices );
-      BC->push_back ( ( i * _columns ) + ( _columns - 1 )               );
+      BC->push_back ( ( i * columns ) + ( columns - 1 ) + numVertices );
+      BC->push_back ( ( i * columns ) + ( columns - 1 )               );
 
-      DA->push_back ( ( i * _columns ) + numVertices );
-      DA->push_back ( ( i * _columns )               );
+      DA->push_back ( ( i * columns ) + numVertices );
+      DA->push_back ( ( i * columns )               );
     }
 
-    osg::Geometry::PrimitiveSetList primSetList;
-    primSetList.push_back ( AB.get() );
-    primSetList.push_back ( BC.get() );
-    primSetList.push_back ( CD.get() );
-    primSetList.push_back ( DA.get() );
+    topology->skirts.push_back ( AB.get() );
+    topology->skirts.push_back ( BC.get() );
+    topology->skirts.push_back ( CD.get() );
+    topology->skirts.push_back ( DA.get() );
+  }
+
+  // Another thread may have made it first, in which case use that one.
+  Usul::Threads::Guard<Usul::Threads::Mutex> guard ( Detail::topologyMutex );
+  osg::ref_ptr<const osg::Referenced> &answer ( Detail::topologies[key] );
+  if ( false == answer.valid() )
+  {
+    // Attach the buffers before any other thread can see the topology.
+    Detail::attachBuffer ( topology->mesh );
+    Detail::attachBuffer ( topology->skirts );
+    answer = topology.get();
+  }
+  return TopologyPtr ( static_cast<const Topology*> ( answer.get() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Access to a single point.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Mesh::const_reference Mesh::_point ( size_type r, size_type c ) const
+{
+  return _points->at ( this->_index ( r, c ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the mesh.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Mesh::_buildGeometry ( osg::Geode& mesh, osg::Geode& skirts ) const
+{
+  // The vertex arrays are shared by both geometries, and the draw elements 
+  // by all meshes of the same size.
+  const Topology& topology ( *_topology );
+
+  // Make the main mesh.
+  {
+    // Make the geometry.
+    osg::ref_ptr<osg::Geometry> geometry ( new osg::Geometry );
+    
+    // Set the points.
+    geometry->setVertexArray ( _points.get() );
+    
+    // Set the normals.
+    geometry->setNormalArray ( _normals.get() );
+    geometry->setNormalBinding ( osg::Geometry::BIND_PER_VERTEX );
+    
+    // Set the texture coordinates.
+    geometry->setTexCoordArray ( 0, _texCoords.get() );
+
+    // Use vertex buffers.
+    geometry->setUseDisplayList ( false );
+    geometry->setUseVertexBufferObjects ( true );
+
+    // Set the primitive-set list. The element buffer is already attached.
+    geometry->setPrimitiveSetList ( topology.mesh );
+
+    // Add the drawable.
+    mesh.addDrawable ( geometry.get() );
+
+    // Get the state set.
+    osg::ref_ptr<osg::StateSet> ss ( mesh.getOrCreateStateSet() );
+
+    // Turn off back-face culling.
+    ss->setMode ( GL_CULL_FACE, osg::StateAttribute::OFF );
+
+    osg::ref_ptr<osg::PolygonOffset> offset ( new osg::PolygonOffset );
+    offset->setFactor ( MESH_POLYGON_OFFSET_FACTOR );
+    offset->setUnits  ( MESH_POLYGON_OFFSET_UNITS  );
+    ss->setAttributeAndModes ( offset.get(), osg::StateAttribute::OVERRIDE | osg::StateAttribute::PROTECTED | osg::StateAttribute::ON );
+
+    if ( 0 != MESH_RENDER_BIN )
+      ss->setRenderBinDetails( MESH_RENDER_BIN, "RenderBin" );
+  }
 
+  // Make the skirts.
+  {
     // Make the geometry.
     osg::ref_ptr<osg::Geometry> geometry ( new osg::Geometry );
 
     // Set the points.
-    geometry->setVertexArray ( points.get() );
+    geometry->setVertexArray ( _points.get() );
     
     // Set the normals.
-    geometry->setNormalArray ( normals.get() );
+    geometry->setNormalArray ( _normals.get() );
     geometry->setNormalBinding ( osg::Geometry::BIND_PER_VERTEX );
 
     // Set the texture coordinates.
-    geometry->setTexCoordArray ( 0, texCoords.get() );
+    geometry->setTexCoordArray ( 0, _texCoords.get() );
     
-    // Set the primitive-set list.
-    geometry->setPrimitiveSetList ( primSetList );
-        
     // Use vertex buffers.
     geometry->setUseDisplayList ( false );
     geometry->setUseVertexBufferObjects ( true );
 
+    // Set the primitive-set list. The element buffer is already attached.
+    geometry->setPrimitiveSetList ( topology.skirts );
+
     // Add the drawable.
     skirts.addDrawable ( geometry.get() );
 
@@ -340,24 +398,50 @@ osg::Node* Mesh::buildMesh ( const Body& body,
   const Extents::Vertex &mn ( extents.minimum() );
   const Extents::Vertex &mx ( extents.maximum() );
 
-  for ( int i = rows - 1; i >= 0; --i )
+  // The vertices are stored as offsets from the center, which keeps them 
+  // accurate as floats.
+  body.latLonHeightToXYZ ( extents.center()[1], extents.center()[0], 0.0, _center );
+
+  // Convert all the points with one call. The second half of the arrays is 
+  // one meter above the first, for the normals.
+  const size_type numVertices ( rows * columns );
+  std::vector<double> lat ( numVertices * 2 ), lon ( numVertices * 2 ), height ( numVertices * 2 );
+  std::vector<double> x ( numVertices * 2 ), y ( numVertices * 2 ), z ( numVertices * 2 );
+
+  for ( unsigned int i = 0; i < rows; ++i )
   {
     const double u ( 1.0 - static_cast<double> ( i ) / ( rows - 1 ) );
     for ( unsigned int j = 0; j < columns; ++j )
     {
       const double v ( static_cast<double> ( j ) / ( columns - 1 ) );
-      
-      const double lon ( mn[0] + u * ( mx[0] - mn[0] ) );
-      const double lat ( mn[1] + v * ( mx[1] - mn[1] ) );
+      const size_type index ( this->_index ( i, j ) );
+
+      lon[index] = lon[index + numVertices] = mn[0] + u * ( mx[0] - mn[0] );
+      lat[index] = lat[index + numVertices] = mn[1] + v * ( mx[1] - mn[1] );
+      height[index] = ( elevationValid ? elevation->value ( rows - i - 1, j ) : 0.0 );
+      height[index + numVertices] = height[index] + 1;
+    }
+  }
+
+  body.latLonHeightToXYZ ( &lat[0], &lon[0], &height[0], &x[0], &y[0], &z[0], numVertices * 2 );
 
-      const double heightAboveSeaLevel ( elevationValid ? elevation->value ( rows - i - 1, j ) : 0.0 );
+  for ( int i = rows - 1; i >= 0; --i )
+  {
+    const double u ( 1.0 - static_cast<double> ( i ) / ( rows - 1 ) );
+    for ( unsigned int j = 0; j < columns; ++j )
+    {
+      const double v ( static_cast<double> ( j ) / ( columns - 1 ) );
+      const size_type index ( this->_index ( i, j ) );
 
       // Calculate texture coordinate.  Lower left corner should be (0,0).
       const float s ( u );
       const float t ( v );
 
+      const Vector p  ( x[index], y[index], z[index] );
+      const Vector p0 ( x[index + numVertices], y[index + numVertices], z[index + numVertices] );
+
       // Set the data.
-      this->_setLocationData ( body, boundingSphere, i, j, lat, lon, heightAboveSeaLevel, s, t );
+      this->_setLocationData ( boundingSphere, i, j, lat[index], lon[index], height[index], p, p0, s, t );
     }
   }
 
@@ -381,7 +465,7 @@ osg::Node* Mesh::buildMesh ( const Body& body,
     const Vectors::size_type numVertices ( _rows * _columns );
     for ( Vectors::size_type i = 0; i < numVertices; ++i )
     {
-      const osg::Vec3d& n ( _normals[i] );
+      const osg::Vec3d n ( _normals->at ( i ) );
 
       const double angle ( ::acos ( n * centerNormal ) );
       maxAngle = Usul::Math::maximum ( maxAngle, angle );
@@ -395,24 +479,15 @@ osg::Node* Mesh::buildMesh ( const Body& body,
     {
       Vectors::value_type anchorPoint;
       model->latLonHeightToXYZ ( midLat, midLon, -maxClusterCullingHeight, anchorPoint[0], anchorPoint[1], anchorPoint[2] );
-      anchorPoint -= _points.at ( rows * columns );
+      anchorPoint -= _center;
 
       callback = new Detail::ClusterCulling ( -centerNormal, anchorPoint, maxAngle  );
     }
   }
 
-  // Move mesh vertices to local origin.
-  // The offset is the first point of the skirts.
-  Vector offset ( _points.at ( rows * columns ) );
-  for ( Vectors::iterator iter = _points.begin(); iter != _points.end(); ++iter )
-  {
-    Vector &p ( *iter );
-    p = p - offset;
-  }
-
   // Make group to hold the meshes.
   osg::ref_ptr < osg::MatrixTransform > mt ( new osg::MatrixTransform );
-  mt->setMatrix ( osg::Matrix::translate ( offset ) );
+  mt->setMatrix ( osg::Matrix::translate ( _center ) );
 
   // Make the geodes.
   osg::ref_ptr<osg::Geode> ground ( new osg::Geode );
@@ -429,7 +504,6 @@ osg::Node* Mesh::buildMesh ( const Body& body,
   mt->addChild ( _borders.get() );
 
   // Set needed variables.
-  _lowerLeft = offset;
   _skirts = skirts.get();
   _ground = ground.get();
   _boundingSphere = boundingSphere;
@@ -450,17 +524,22 @@ osg::Node* Mesh::buildMesh ( const Body& body,
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Mesh::_setLocationData ( const Body& body, osg::BoundingSphere& boundingSphere, unsigned int i, unsigned int j, double lat, double lon, double elevation, double s, double t )
+void Mesh::_setLocationData ( osg::BoundingSphere& boundingSphere, unsigned int i, unsigned int j, double lat, double lon, double elevation, const Vector& p, const Vector& p0, double s, double t )
 {
   // Get the index into the vectors.
-  const Vectors::size_type index ( this->_index ( i, j ) );
+  const size_type index ( this->_index ( i, j ) );
 
   // Get the number of vertices.
-  const Vectors::size_type numVertices ( _rows * _columns );
+  const size_type numVertices ( _rows * _columns );
 
-  // Convert lat-lon coordinates to xyz.
-  Vector &p ( _points.at ( index ) );
-  body.latLonHeightToXYZ ( lat, lon, elevation, p );
+  // The point is already in xyz.
+  _points->at ( index ) = p - _center;
+
+  // Keep the corners at full precision for the distance checks.
+  if ( ( 0 == i || _rows - 1 == i ) && ( 0 == j || _columns - 1 == j ) )
+  {
+    _corners[( 0 == i ? 0 : 2 ) + ( 0 == j ? 0 : 1 )] = p;
+  }
   
   // Save the lat/lon value.  
   // This value needs to be saved because going from x,y,z to lat,lon,height will not give us the same value due to inaccuracies in the conversion.
@@ -469,30 +548,26 @@ void Mesh::_setLocationData ( const Body& body, osg::BoundingSphere& boundingSph
   // Expand the bounding sphere by the point.
   boundingSphere.expandBy ( p );
 
-  // Assign normal vectors.
-  Vector &n ( _normals.at ( index ) );
-  
-  // Calculate the normal by offseting the elevation by one and substracting the point on the ground.
-  Vector p0;
-  body.latLonHeightToXYZ ( lat, lon, elevation + 1, p0 );
-  n = p0 - p;
+  // The normal is from the point on the ground to the point one above it.
+  Vector n ( p0 - p );
   n.normalize();
+  _normals->at ( index ) = n;
 
   // Assign texture coordinate.
-  _texCoords.at ( index ).set ( Usul::Math::clamp<float> ( s, 0.0f, 1.0f ), Usul::Math::clamp<float> ( t, 0.0f, 1.0f ) );
+  _texCoords->at ( index ).set ( Usul::Math::clamp<float> ( s, 0.0f, 1.0f ), Usul::Math::clamp<float> ( t, 0.0f, 1.0f ) );
 
   // Handle the skirt points.
-  Vector &pSkirt ( _points.at ( index + numVertices ) );
-  pSkirt = p - ( n * _skirtHeight );
+  const Vector pSkirt ( p - ( n * _skirtHeight ) );
+  _points->at ( index + numVertices ) = pSkirt - _center;
 
   // Expand the bounding sphere by the point.
   boundingSphere.expandBy ( pSkirt );
   
   // Set the normal.
-  _normals.at ( index + numVertices ) = n;
+  _normals->at ( index + numVertices ) = n;
 
   // Set the texture coordinate.
-  _texCoords.at ( index + numVertices ) = _texCoords.at ( index );
+  _texCoords->at ( index + numVertices ) = _texCoords->at ( index );
 }
 
 
@@ -648,10 +723,10 @@ osg::Node* Mesh::_buildBorder() const
 
 double Mesh::getSmallestDistanceSquared ( const osg::Vec3d& point ) const
 {
-  osg::Vec3d p00 ( _lowerLeft + this->_point ( 0, 0 ) );
-  osg::Vec3d p0N ( _lowerLeft + this->_point ( 0, this->columns() - 1 ) );
-  osg::Vec3d pN0 ( _lowerLeft + this->_point ( this->rows() - 1, 0 ) );
-  osg::Vec3d pNN ( _lowerLeft + this->_point ( this->rows() - 1, this->columns() - 1 ) );
+  const osg::Vec3d& p00 ( _corners[0] );
+  const osg::Vec3d& p0N ( _corners[1] );
+  const osg::Vec3d& pN0 ( _corners[2] );
+  const osg::Vec3d& pNN ( _corners[3] );
   const osg::Vec3d& pBC ( _boundingSphere.center() );
   
   // Squared distances from the eye to the points.
@@ -708,6 +783,11 @@ void Mesh::showSkirts ( bool show )
 //
 //  Get the elevation value from the triangles at a given lat,lon.
 //
+//  The mesh is a regular grid, so the cell comes straight from the position.
+//  Row 0 is at the maximum longitude and column 0 at the minimum latitude.
+//  The tri-strips split the cell from (i,j) to (i+1,j+1), so the same split
+//  is used here and the answer is on the rendered surface.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 double Mesh::elevation ( double lat, double lon, const LandModel& land ) const
@@ -716,101 +796,31 @@ double Mesh::elevation ( double lat, double lon, const LandModel& land ) const
   {
     return 0.0;
   }
-  
-  // Shortcuts.
-  Extents e ( _extents );
-  const Extents::Vertex &mn ( e.minimum() );
-  const Extents::Vertex &mx ( e.maximum() );
-
-  const double u ( ( lon - mn[0] ) / ( mx[0] - mn[0] ) );
-
-  // How many tri-strips there are.
-  const unsigned int numStrips ( _meshPrimitives.size() );
 
-  // Get the index.
-  const unsigned int index ( numStrips * u );
-
-  // Get the row of the tri-strip we need.
-  const unsigned int row ( index == numStrips ? 0 : numStrips - index - 1 );
-
-  // Get the tri-strip.
-  const Indices& triStrip ( _meshPrimitives.at ( row) );
-
-  // Loop over the triangles of the tristrip.
-  for ( unsigned int i = 0; i < triStrip.size() - 2; ++i )
+  if ( _rows < 2 || _columns < 2 )
   {
-    // Get the 3 points of the current triangle in lat-lon coordinates.
-    Vertex t0 ( _latLonPoints.at ( triStrip.at ( i ) ) );
-    Vertex t1 ( _latLonPoints.at ( triStrip.at ( i + 1 ) ) );
-    Vertex t2 ( _latLonPoints.at ( triStrip.at ( i + 2 ) ) );
-
-    // Weighted position.
-    Vertex weights;
-
-    // See if the lat/lon is inside this triangle.
-    if ( Mesh::_containsPoint ( t0, t1, t2, Vertex ( lon, lat, 0.0 ), weights ) )
-    {
-      const double elevation ( weights[0] * t0[2] + weights[1] * t1[2] + weights[2] * t2[2] );
-      return elevation;
-    }
-  }
-
-  return 0.0;
-}
-
-
-///////////////////////////////////////////////////////////////////////////////
-//
-//  See if the value is between 0 and 1.
-//
-///////////////////////////////////////////////////////////////////////////////
-
-namespace Detail
-{
-  bool isValueBetweenZeroAndOne ( double value )
-  {
-    Usul::Predicates::Tolerance<double> pred ( 1e-10 );
-
-    // First handle cases where the value is close to zero or one.
-    const bool isCloseToZero ( pred ( 0.0, value ) );
-    if ( isCloseToZero )
-      return true;
-
-    const bool isCloseToOne ( pred ( 1.0, value ) );
-    if ( isCloseToOne )
-      return true;
-
-    return 0.0 <= value && value <= 1.0;
-  }
-}
-
-
-///////////////////////////////////////////////////////////////////////////////
-//
-//  Is the point contained in the triangle?
-//
-///////////////////////////////////////////////////////////////////////////////
-
-bool Mesh::_containsPoint ( const Vertex& v0, const Vertex& v1, const Vertex& v2, const Vertex& point, Vertex& weights )
-{
-  Usul::Math::Vec3d t0 ( Usul::Convert::Type<Vertex,Usul::Math::Vec3d>::convert ( v0 ) );
-  Usul::Math::Vec3d t1 ( Usul::Convert::Type<Vertex,Usul::Math::Vec3d>::convert ( v1 ) );
-  Usul::Math::Vec3d t2 ( Usul::Convert::Type<Vertex,Usul::Math::Vec3d>::convert ( v2 ) );
-  Usul::Math::Vec3d p  ( Usul::Convert::Type<Vertex,Usul::Math::Vec3d>::convert ( point ) );
-
-  // Zero out the elevation, so the test is only in the lat/long plane.
-  t0[2] = 0; t1[2] = 0; t2[2] = 0; p[2] = 0;
-
-  Usul::Math::Vec3d barycentricCoords ( Usul::Math::barycentric ( t0, t1, t2, p ) );
-
-  // See if the all the values are between zero and one.  This means that the point is inside the triangle.
-  if ( Detail::isValueBetweenZeroAndOne ( barycentricCoords[0] ) &&
-       Detail::isValueBetweenZeroAndOne ( barycentricCoords[1] ) &&
-       Detail::isValueBetweenZeroAndOne ( barycentricCoords[2] ) )
-  {
-    weights.set ( barycentricCoords[0], barycentricCoords[1], barycentricCoords[2] );
-    return true;
+    return 0.0;
   }
-
-  return false;
+  
+  // Shortcuts.
+  const Extents::Vertex &mn ( _extents.minimum() );
+  const Extents::Vertex &mx ( _extents.maximum() );
+
+  // Position in grid units.
+  const double x ( ( ( mx[0] - lon ) / ( mx[0] - mn[0] ) ) * ( _rows - 1 ) );
+  const double y ( ( ( lat - mn[1] ) / ( mx[1] - mn[1] ) ) * ( _columns - 1 ) );
+
+  // The cell, with the far edges going to the last one.
+  const size_type i ( Usul::Math::minimum<size_type> ( static_cast<size_type> ( Usul::Math::maximum ( x, 0.0 ) ), _rows - 2 ) );
+  const size_type j ( Usul::Math::minimum<size_type> ( static_cast<size_type> ( Usul::Math::maximum ( y, 0.0 ) ), _columns - 2 ) );
+
+  // Where in the cell.
+  const double s ( x - i );
+  const double t ( y - j );
+
+  // Interpolate on the triangle that holds the point.
+  return Mesh::interpolate ( _latLonPoints[this->_index ( i,     j     )][2],
+                             _latLonPoints[this->_index ( i + 1, j     )][2],
+                             _latLonPoints[this->_index ( i,     j + 1 )][2],
+                             _latLonPoints[this->_index ( i + 1, j + 1 )][2], s, t );
 }
@@ -46,10 +46,9 @@ public:
   typedef osg::Vec3d Vector;
   typedef Vector Vertex;
   typedef std::vector<Vector> Vectors;
-  typedef Vectors::reference reference;
-  typedef Vectors::const_reference const_reference;
-  typedef Vectors::value_type value_type;
-  typedef Vectors::size_type size_type;
+  typedef osg::Vec3Array Points;
+  typedef Points::const_reference const_reference;
+  typedef Points::size_type size_type;
   typedef osg::ref_ptr<osg::Image> ImagePtr;
   typedef Minerva::Common::Extents Extents;
   typedef Minerva::Common::IElevationData::RefPtr ElevationDataPtr;
@@ -70,6 +69,13 @@ public:
   // Get the elevation value from the triangles at a given lat,lon.
   double              elevation ( double lat, double lon, const LandModel& land ) const;
 
+  // Interpolate the corner heights of a cell at (s,t). The cell is split from
+  // corner 00 to corner 11, the same way as the tri-strips.
+  static double       interpolate ( double h00, double h10, double h01, double h11, double s, double t )
+  {
+    return ( s >= t ) ? ( h00 + s * ( h10 - h00 ) + t * ( h11 - h10 ) ) : ( h00 + t * ( h01 - h00 ) + s * ( h11 - h01 ) );
+  }
+
   // The number of rows.
   unsigned int        rows() const { return _rows; }
 
@@ -87,35 +93,47 @@ private:
   // Build the geometries for the mesh and skirts.
   void                _buildGeometry ( osg::Geode& mesh, osg::Geode& skirts ) const;
 
-  // Is the point contained in the triangle?
-  static bool         _containsPoint ( const Vertex& v0, const Vertex& v1, const Vertex& v2, const Vertex& point, Vertex& weights );
+  // Shared index buffers for all meshes of one size. Never changed once made.
+  struct Topology : public osg::Referenced
+  {
+    typedef osg::ref_ptr<osg::DrawElementsUShort> Strip;
+    typedef std::vector<Strip> Strips;
+
+    Strips strips;
+    osg::Geometry::PrimitiveSetList mesh;
+    osg::Geometry::PrimitiveSetList skirts;
+  };
+  typedef osg::ref_ptr<const Topology> TopologyPtr;
+
+  // Get the topology for the size, making it the first time.
+  static TopologyPtr  _getTopology ( unsigned int rows, unsigned int columns );
 
   // Get the index for the row and column.
   inline size_type    _index ( size_type row, size_type column ) const { return row * _columns + column; }
   
-  // Access to a single point.
+  // Access to a single point, relative to the center.
   const_reference     _point ( size_type row, size_type column ) const;
 
-  // Set the location data.
-  void                _setLocationData ( const Body& body, osg::BoundingSphere& boundingSphere, unsigned int i, unsigned int j, double lat, double lon, double elevation, double s, double t );
+  // Set the location data. The point p0 is one above p, in xyz.
+  void                _setLocationData ( osg::BoundingSphere& boundingSphere, unsigned int i, unsigned int j, double lat, double lon, double elevation, const Vector& p, const Vector& p0, double s, double t );
 
   // Useful typedefs.
-  typedef osg::Vec2d TexCoord;
-  typedef std::vector<TexCoord> TexCoords;
-  typedef unsigned short IndexType;
-  typedef std::vector<IndexType> Indices;
-  typedef std::vector<Indices> Primitives;
+  typedef osg::Vec3Array Normals;
+  typedef osg::Vec2Array TexCoords;
   typedef std::vector<Vertex> LatLonPoints;
+  typedef osg::ref_ptr<Points> PointsPtr;
+  typedef osg::ref_ptr<Normals> NormalsPtr;
+  typedef osg::ref_ptr<TexCoords> TexCoordsPtr;
 
   Mesh();
   Mesh ( const Mesh & );
   Mesh &operator = ( const Mesh & );
 
   LatLonPoints _latLonPoints;
-  Vectors _points;
-  Vectors _normals;
-  TexCoords _texCoords;
-  Primitives _meshPrimitives;
+  PointsPtr _points;
+  NormalsPtr _normals;
+  TexCoordsPtr _texCoords;
+  TopologyPtr _topology;
   unsigned int _rows;
   unsigned int _columns;
   double _skirtHeight;
@@ -125,7 +143,8 @@ private:
   osg::ref_ptr<osg::Node>  _skirts;
   osg::ref_ptr<osg::Node>  _ground;
 
-  osg::Vec3d _lowerLeft;
+  osg::Vec3d _center;
+  Vector _corners[4];
   osg::BoundingSphere _boundingSphere;
 };
 
@@ -0,0 +1,589 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Fetches the rasters and elevation for the tiles the camera is about to
+//  reach.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/TileEngine/Prefetch.h"
+#include "Minerva/Core/TileEngine/Body.h"
+#include "Minerva/Core/Visitors/FindRasterLayers.h"
+
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Registry/Database.h"
+#include "Usul/Strings/Format.h"
+#include "Usul/System/Clock.h"
+#include "Usul/Threads/Safe.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Minerva::Core::TileEngine;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constants.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  // Prefetch jobs run after all the jobs for visible tiles.
+  const int PRIORITY ( 0x10000000 );
+
+  // Number of positions to predict.
+  const unsigned int NUM_PREDICTIONS ( 4 );
+
+  // Camera positions older than this are not used for extrapolating.
+  const Minerva::Core::TileEngine::Prefetch::Uint64 HISTORY_MILLISECONDS ( 1000 );
+
+  // Prefetched tiles that are remembered while waiting to be used.
+  const unsigned int MAX_REMEMBERED ( 1024 );
+
+  // By default prefetching uses at most one in this many of the threads, 
+  // so the jobs for visible tiles always have threads to run on.
+  const unsigned int POOL_FRACTION ( 4 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Job that fetches one tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class Prefetch::Request : public Usul::Jobs::Job
+{
+public:
+
+  typedef Usul::Jobs::Job BaseClass;
+
+  Request ( Prefetch::RefPtr prefetch, TileKey::RefPtr key ) : BaseClass(),
+    _prefetch ( prefetch ),
+    _key ( key )
+  {
+    this->priority ( Helper::PRIORITY + static_cast<int> ( key->level() ) );
+    this->name ( Usul::Strings::format ( "Prefetch, level: ", key->level(), ", row: ", key->row(), ", column: ", key->column() ) );
+  }
+
+protected:
+
+  virtual ~Request()
+  {
+  }
+
+  virtual void _started()
+  {
+    _prefetch->_fetch ( _key, Usul::Jobs::Job::RefPtr ( this ) );
+  }
+
+  virtual void _finished()
+  {
+    _prefetch->_fetchDone ( Prefetch::_id ( *_key ), false == this->canceled() );
+  }
+
+  virtual void _cancelled()
+  {
+    _prefetch->_fetchDone ( Prefetch::_id ( *_key ), false );
+  }
+
+  virtual void _error()
+  {
+    _prefetch->_fetchDone ( Prefetch::_id ( *_key ), false );
+  }
+
+private:
+
+  Prefetch::RefPtr _prefetch;
+  TileKey::RefPtr _key;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Prefetch::Prefetch ( Body *body ) : BaseClass(),
+  _body ( body ),
+  _enabled   ( Usul::Registry::Database::instance()["prefetch"]["enabled"].get<bool> ( true, true ) ),
+  _lookAhead ( Usul::Registry::Database::instance()["prefetch"]["look_ahead_seconds"].get<double> ( 2.0, true ) ),
+  _maxJobs   ( Usul::Registry::Database::instance()["prefetch"]["max_jobs"].get<unsigned int> ( 0, true ) ),
+  _maxPerSecond ( Usul::Registry::Database::instance()["prefetch"]["max_tiles_per_second"].get<double> ( 8.0, true ) ),
+  _tokens ( 0.0 ),
+  _lastToken ( Usul::System::Clock::milliseconds() ),
+  _samples(),
+  _path(),
+  _pathStep ( 0.0 ),
+  _pathStart ( 0 ),
+  _outstanding(),
+  _fetched(),
+  _fetchedOrder(),
+  _statistics()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Prefetch::~Prefetch()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Clear the state.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::clear()
+{
+  Guard guard ( this );
+  _body = 0x0;
+  _samples.clear();
+  _path.clear();
+  _fetched.clear();
+  _fetchedOrder.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set/get the enabled state.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::enabled ( bool b )
+{
+  Guard guard ( this );
+  _enabled = b;
+  Usul::Registry::Database::instance()["prefetch"]["enabled"] = b;
+}
+bool Prefetch::enabled() const
+{
+  Guard guard ( this );
+  return _enabled;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set/get how far ahead to look.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::lookAhead ( double seconds )
+{
+  Guard guard ( this );
+  _lookAhead = seconds;
+}
+double Prefetch::lookAhead() const
+{
+  Guard guard ( this );
+  return _lookAhead;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set/get the maximum number of prefetch jobs at once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::maxJobs ( unsigned int num )
+{
+  Guard guard ( this );
+  _maxJobs = num;
+}
+unsigned int Prefetch::maxJobs() const
+{
+  Guard guard ( this );
+  return _maxJobs;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set/get the maximum number of tiles to prefetch per second.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::maxPerSecond ( double num )
+{
+  Guard guard ( this );
+  _maxPerSecond = num;
+}
+double Prefetch::maxPerSecond() const
+{
+  Guard guard ( this );
+  return _maxPerSecond;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the path the camera is about to play.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::path ( const Positions &positions, double milliSecondsPerStep )
+{
+  Guard guard ( this );
+  _path = positions;
+  _pathStep = std::max ( milliSecondsPerStep, 1.0 );
+  _pathStart = Usul::System::Clock::milliseconds();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the counters.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Prefetch::Statistics Prefetch::statistics() const
+{
+  Guard guard ( this );
+  return _statistics;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the level the tiles split to at the altitude. A tile splits when the
+//  eye is closer than its split distance, which halves at every level.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Prefetch::levelForAltitude ( double altitude, double splitDistance, unsigned int maxLevel )
+{
+  if ( altitude <= 0.0 || splitDistance <= 0.0 )
+    return maxLevel;
+
+  const double level ( std::ceil ( std::log ( splitDistance / altitude ) / std::log ( 2.0 ) ) );
+  if ( level <= 0.0 )
+    return 0;
+
+  return ( level >= static_cast<double> ( maxLevel ) ) ? maxLevel : static_cast<unsigned int> ( level );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of prefetch jobs allowed at once. Zero asks for a 
+//  fraction of the pool, and there is always room for one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Prefetch::jobLimit ( unsigned int maxJobs, std::size_t poolSize )
+{
+  if ( 0 != maxJobs )
+    return maxJobs;
+
+  return std::max<unsigned int> ( 1, static_cast<unsigned int> ( poolSize / Helper::POOL_FRACTION ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make an id for the tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Prefetch::Uint64 Prefetch::_id ( const TileKey &key )
+{
+  return ( static_cast<Uint64> ( key.level() ) << 58 ) |
+         ( ( static_cast<Uint64> ( key.row() ) & 0x1fffffff ) << 29 ) |
+         ( static_cast<Uint64> ( key.column() ) & 0x1fffffff );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Predict where the camera will be.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::predict ( Positions &positions ) const
+{
+  Guard guard ( this );
+
+  const unsigned int num ( Helper::NUM_PREDICTIONS );
+
+  // Use the path if one is playing.
+  if ( false == _path.empty() )
+  {
+    const Uint64 elapsed ( Usul::System::Clock::milliseconds() - _pathStart );
+    const std::size_t current ( static_cast<std::size_t> ( static_cast<double> ( elapsed ) / _pathStep ) );
+    if ( current + 1 >= _path.size() )
+      return;
+
+    const std::size_t ahead ( std::max<std::size_t> ( 1, static_cast<std::size_t> ( _lookAhead * 1000.0 / _pathStep ) ) );
+    const std::size_t last ( std::min ( current + ahead, _path.size() - 1 ) );
+    const std::size_t steps ( last - current );
+    for ( unsigned int i = 1; i <= num; ++i )
+    {
+      const std::size_t index ( current + std::max<std::size_t> ( 1, ( steps * i ) / num ) );
+      positions.push_back ( _path.at ( std::min ( index, last ) ) );
+    }
+    return;
+  }
+
+  // Otherwise extrapolate the motion.
+  if ( _samples.size() < 2 )
+    return;
+
+  const Sample &first ( _samples.front() );
+  const Sample &latest ( _samples.back() );
+  const double seconds ( static_cast<double> ( latest.time - first.time ) / 1000.0 );
+  if ( seconds <= 0.0 )
+    return;
+
+  // Take the short way around.
+  double dLon ( latest.position[0] - first.position[0] );
+  if ( dLon > 180.0 )
+    dLon -= 360.0;
+  else if ( dLon < -180.0 )
+    dLon += 360.0;
+
+  const Vec3d velocity ( dLon / seconds,
+                         ( latest.position[1] - first.position[1] ) / seconds,
+                         ( latest.position[2] - first.position[2] ) / seconds );
+
+  // Nothing to do if the camera is not moving.
+  if ( 0.0 == velocity[0] && 0.0 == velocity[1] && 0.0 == velocity[2] )
+    return;
+
+  for ( unsigned int i = 1; i <= num; ++i )
+  {
+    const double t ( ( _lookAhead * i ) / num );
+
+    double lon ( latest.position[0] + velocity[0] * t );
+    while ( lon > 180.0 )  lon -= 360.0;
+    while ( lon < -180.0 ) lon += 360.0;
+
+    const double lat ( std::max ( -90.0, std::min ( 90.0, latest.position[1] + velocity[1] * t ) ) );
+    const double altitude ( std::max ( 1.0, latest.position[2] + velocity[2] * t ) );
+
+    positions.push_back ( Vec3d ( lon, lat, altitude ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called by the body each frame.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::cameraNotify ( double lon, double lat, double altitude )
+{
+  const Uint64 now ( Usul::System::Clock::milliseconds() );
+
+  Body::RefPtr body ( 0x0 );
+  {
+    Guard guard ( this );
+    if ( false == _enabled )
+      return;
+
+    // Remember the recent positions.
+    _samples.push_back ( Sample ( Vec3d ( lon, lat, altitude ), now ) );
+    while ( ( _samples.size() > 2 ) && ( now - _samples.front().time > Helper::HISTORY_MILLISECONDS ) )
+      _samples.pop_front();
+
+    // A finished path is no longer used.
+    if ( false == _path.empty() && ( static_cast<double> ( now - _pathStart ) > _pathStep * _path.size() ) )
+      _path.clear();
+
+    body = _body;
+  }
+
+  if ( false == body.valid() )
+    return;
+
+  Usul::Jobs::Manager *manager ( body->jobManager() );
+  if ( 0x0 == manager )
+    return;
+
+  Positions positions;
+  this->predict ( positions );
+  if ( true == positions.empty() )
+    return;
+
+  const double splitDistance ( body->splitDistance() );
+  const unsigned int maxLevel ( body->maxLevel() );
+  const unsigned int maxJobs ( Prefetch::jobLimit ( this->maxJobs(), manager->poolSize() ) );
+
+  for ( Positions::const_iterator iter = positions.begin(); iter != positions.end(); ++iter )
+  {
+    const Vec3d &p ( *iter );
+    const unsigned int level ( Prefetch::levelForAltitude ( p[2], splitDistance, maxLevel ) );
+    TileKey::RefPtr key ( body->keyAt ( p[0], p[1], level ) );
+    if ( false == key.valid() )
+      continue;
+
+    const Uint64 id ( Prefetch::_id ( *key ) );
+    {
+      Guard guard ( this );
+
+      // Already fetched or on the way.
+      if ( _outstanding.end() != _outstanding.find ( id ) || _fetched.end() != _fetched.find ( id ) )
+        continue;
+
+      // Stay within the budget.
+      if ( _outstanding.size() >= maxJobs || false == this->_takeToken ( now ) )
+      {
+        ++_statistics.dropped;
+        continue;
+      }
+
+      _outstanding.insert ( id );
+      ++_statistics.issued;
+    }
+
+    manager->addJob ( new Request ( Prefetch::RefPtr ( this ), key ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take a token from the bucket. Tokens come back at the maximum rate, and
+//  at most one second's worth is saved up.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Prefetch::_takeToken ( Uint64 now )
+{
+  Guard guard ( this );
+
+  const double seconds ( static_cast<double> ( now - _lastToken ) / 1000.0 );
+  _lastToken = now;
+  _tokens = std::min ( _maxPerSecond, _tokens + seconds * _maxPerSecond );
+
+  if ( _tokens < 1.0 )
+    return false;
+
+  _tokens -= 1.0;
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Fetch the rasters and elevation for the tile. The layers keep the
+//  results in their caches. Elevation layers are read the same way the
+//  tile reads them, so the cache that is warmed is the one the tile uses.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::_fetch ( TileKey::RefPtr key, Usul::Jobs::Job::RefPtr job )
+{
+  Body::RefPtr body ( Usul::Threads::Safe::get ( this->mutex(), _body ) );
+  if ( false == body.valid() || false == key.valid() )
+    return;
+
+  typedef Minerva::Core::Visitors::FindRasterLayers Visitor;
+  typedef Visitor::RasterLayers Rasters;
+  typedef Minerva::Core::Layers::RasterLayer RasterLayer;
+
+  const Extents extents ( key->extents() );
+
+  // The rasters use the image size and the elevation uses the mesh size.
+  Body::Container::RefPtr containers[] = { body->rasterData(), body->elevationData() };
+  const Usul::Math::Vec2ui sizes[] = { key->imageSize(), key->meshSize() };
+  const bool elevation[] = { false, true };
+
+  for ( unsigned int i = 0; i < 2; ++i )
+  {
+    if ( false == containers[i].valid() )
+      continue;
+
+    Rasters rasters;
+    Visitor::RefPtr visitor ( new Visitor ( extents, rasters ) );
+    containers[i]->accept ( *visitor );
+
+    for ( Rasters::iterator iter = rasters.begin(); iter != rasters.end(); ++iter )
+    {
+      if ( true == job->canceled() )
+        return;
+
+      RasterLayer::RefPtr raster ( *iter );
+      if ( raster.valid() && raster->visibility() && raster->isInLevelRange ( key->level() ) && extents.intersects ( raster->extents() ) )
+      {
+        if ( true == elevation[i] )
+          raster->elevationData ( *key, sizes[i][0], sizes[i][1], job.get(), 0x0 );
+        else
+          raster->texture ( *key, sizes[i][0], sizes[i][1], job.get(), 0x0 );
+      }
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a prefetch job is finished.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::_fetchDone ( Uint64 id, bool success )
+{
+  Guard guard ( this );
+
+  _outstanding.erase ( id );
+  if ( false == success )
+    return;
+
+  ++_statistics.completed;
+  if ( _fetched.end() != _fetched.find ( id ) )
+    return;
+
+  _fetched[id] = _fetchedOrder.insert ( _fetchedOrder.end(), id );
+
+  // Forget the oldest. Used ids are taken out of the order list, so each
+  // one here is still waiting.
+  while ( _fetchedOrder.size() > Helper::MAX_REMEMBERED )
+  {
+    _fetched.erase ( _fetchedOrder.front() );
+    _fetchedOrder.pop_front();
+    ++_statistics.unused;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a tile is built.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Prefetch::tileNotify ( const TileKey &key )
+{
+  Guard guard ( this );
+
+  ++_statistics.requests;
+
+  Fetched::iterator i ( _fetched.find ( Prefetch::_id ( key ) ) );
+  if ( _fetched.end() != i )
+  {
+    _fetchedOrder.erase ( i->second );
+    _fetched.erase ( i );
+    ++_statistics.hits;
+  }
+}
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Fetches the rasters and elevation for the tiles the camera is about to
+//  reach, so they come out of the caches when the tiles are built.
+//
+//  Where the camera is going comes from the path being played, if there is
+//  one, otherwise from extrapolating the last few camera positions. The
+//  level is picked from the altitude the same way the tiles split. Requests
+//  are low-priority jobs, limited in number and in rate.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_TILE_ENGINE_PREFETCH_H__
+#define __MINERVA_CORE_TILE_ENGINE_PREFETCH_H__
+
+#include "Minerva/Core/Export.h"
+
+#include "Minerva/Common/TileKey.h"
+
+#include "Usul/Base/Object.h"
+#include "Usul/Jobs/Job.h"
+#include "Usul/Math/Vector3.h"
+#include "Usul/Types/Types.h"
+
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+namespace TileEngine {
+
+class Body;
+
+
+class MINERVA_EXPORT Prefetch : public Usul::Base::Object
+{
+public:
+
+  // Useful typedefs.
+  typedef Usul::Base::Object BaseClass;
+  typedef Minerva::Common::TileKey TileKey;
+  typedef Usul::Math::Vec3d Vec3d;
+  typedef Usul::Types::Uint64 Uint64;
+  typedef std::vector<Vec3d> Positions;
+
+  // Smart-pointer definitions.
+  USUL_DECLARE_REF_POINTERS ( Prefetch );
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Counters. A hit is a prefetched tile that was later built.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  struct Statistics
+  {
+    Statistics() : requests ( 0 ), issued ( 0 ), completed ( 0 ), dropped ( 0 ), hits ( 0 ), unused ( 0 ) {}
+
+    Uint64 requests;
+    Uint64 issued;
+    Uint64 completed;
+    Uint64 dropped;
+    Uint64 hits;
+    Uint64 unused;
+  };
+
+  Prefetch ( Body *body );
+
+  // Called by the body each frame with the camera's longitude, latitude and altitude.
+  void                      cameraNotify ( double lon, double lat, double altitude );
+
+  // Clear the state. Call before the body goes away.
+  void                      clear();
+
+  // Set/get the enabled state.
+  void                      enabled ( bool );
+  bool                      enabled() const;
+
+  // Set/get how far ahead to look, in seconds.
+  void                      lookAhead ( double seconds );
+  double                    lookAhead() const;
+
+  // Set/get the maximum number of prefetch jobs at once. Zero means a 
+  // quarter of the job manager's threads.
+  void                      maxJobs ( unsigned int );
+  unsigned int              maxJobs() const;
+
+  // Set/get the maximum number of tiles to prefetch per second.
+  void                      maxPerSecond ( double );
+  double                    maxPerSecond() const;
+
+  // Set the path the camera is about to play, as longitude, latitude and
+  // altitude for each step. An empty path goes back to extrapolating.
+  void                      path ( const Positions &positions, double milliSecondsPerStep );
+
+  // Predict where the camera will be. Public for testing.
+  void                      predict ( Positions &positions ) const;
+
+  // Get the counters.
+  Statistics                statistics() const;
+
+  // Called when a tile is built.
+  void                      tileNotify ( const TileKey &key );
+
+  // Get the level the tiles split to at the altitude.
+  static unsigned int       levelForAltitude ( double altitude, double splitDistance, unsigned int maxLevel );
+
+  // Get the number of prefetch jobs allowed at once for the pool size.
+  static unsigned int       jobLimit ( unsigned int maxJobs, std::size_t poolSize );
+
+protected:
+
+  // Use reference counting.
+  virtual ~Prefetch();
+
+private:
+
+  struct Sample
+  {
+    Sample ( const Vec3d &p, Uint64 t ) : position ( p ), time ( t ) {}
+    Vec3d position;
+    Uint64 time;
+  };
+
+  class Request;
+  friend class Request;
+
+  typedef std::deque<Sample> Samples;
+  typedef std::set<Uint64> KeySet;
+  typedef std::list<Uint64> KeyList;
+  typedef std::map<Uint64,KeyList::iterator> Fetched;
+
+  // No copying or assignment.
+  Prefetch ( const Prefetch & );
+  Prefetch &operator = ( const Prefetch & );
+
+  void                      _fetch ( TileKey::RefPtr key, Usul::Jobs::Job::RefPtr job );
+  void                      _fetchDone ( Uint64 id, bool success );
+  bool                      _takeToken ( Uint64 now );
+
+  static Uint64             _id ( const TileKey &key );
+
+  Body *_body;
+  bool _enabled;
+  double _lookAhead;
+  unsigned int _maxJobs;
+  double _maxPerSecond;
+  double _tokens;
+  Uint64 _lastToken;
+  Samples _samples;
+  Positions _path;
+  double _pathStep;
+  Uint64 _pathStart;
+  KeySet _outstanding;
+  Fetched _fetched;
+  KeyList _fetchedOrder;
+  Statistics _statistics;
+};
+
+
+} // namespace TileEngine
+} // namespace Core
+} // namespace Minerva
+
+
+#endif // __MINERVA_CORE_TILE_ENGINE_PREFETCH_H__
@@ -43,7 +43,6 @@
 #include "Usul/Functions/SafeCall.h"
 #include "Usul/Math/MinMax.h"
 #include "Usul/Math/NaN.h"
-#include "Usul/Predicates/CloseFloat.h"
 #include "Usul/Threads/Safe.h"
 #include "Usul/Jobs/Manager.h"
 
@@ -57,6 +56,7 @@
 #include "boost/bind.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 using namespace Minerva::Core::TileEngine;
@@ -101,6 +101,7 @@ Tile::Tile ( TileKey::RefPtr info, double splitDistance,
   _body ( body ),
   _info ( info ),
   _splitDistance ( splitDistance ),
+  _eyeDistanceSquared ( 0.0 ),
   _mesh ( MeshPtr ( static_cast<Mesh*> ( 0x0 ) ) ),
   _flags ( Tile::ALL ),
   _children ( 4 ),
@@ -158,6 +159,7 @@ Tile::Tile ( const Tile &tile, const osg::CopyOp &option ) :
   _body ( tile._body ),
   _info ( tile._info ),
   _splitDistance ( tile._splitDistance ),
+  _eyeDistanceSquared ( tile._eyeDistanceSquared ),
   _mesh ( MeshPtr ( static_cast<Mesh*> ( 0x0 ) ) ),
   _flags ( Tile::ALL ),
   _children ( tile._children ),
@@ -657,6 +659,7 @@ void Tile::_cull ( osgUtil::CullVisitor &cv )
 
   // Check with smallest distance.
   const double dist ( mesh.getSmallestDistanceSquared ( eye ) );
+  Usul::Threads::Safe::set ( this->mutex(), dist, _eyeDistanceSquared );
   const bool farAway ( ( dist > ( splitDistance * splitDistance ) ) );
   const unsigned int numChildren ( this->getNumChildren() );
   USUL_ASSERT ( numChildren > 0 );
@@ -786,7 +789,8 @@ void Tile::_updateTiles()
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Split the tile.
+//  Split the tile. This builds the children one after the other on the 
+//  calling thread. The BuildTiles job builds them in parallel instead.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -803,14 +807,35 @@ void Tile::split ( Usul::Jobs::Job::RefPtr job )
   TileKey::ChildrenKeys keys;
   _info->split ( keys );
 
-  Tile::RefPtr t0 ( this->_buildTile ( keys[TileKey::LOWER_LEFT], half, job ) ); // lower left  tile
-  Tile::RefPtr t1 ( this->_buildTile ( keys[TileKey::LOWER_RIGHT], half, job ) ); // lower right tile
-  Tile::RefPtr t2 ( this->_buildTile ( keys[TileKey::UPPER_LEFT], half, job ) ); // upper left  tile
-  Tile::RefPtr t3 ( this->_buildTile ( keys[TileKey::UPPER_RIGHT], half, job ) ); // upper right tile
+  Tiles children ( 4 );
+  children[TileKey::LOWER_LEFT]  = this->_buildTile ( keys[TileKey::LOWER_LEFT], half, job );  // lower left  tile
+  children[TileKey::LOWER_RIGHT] = this->_buildTile ( keys[TileKey::LOWER_RIGHT], half, job ); // lower right tile
+  children[TileKey::UPPER_LEFT]  = this->_buildTile ( keys[TileKey::UPPER_LEFT], half, job );  // upper left  tile
+  children[TileKey::UPPER_RIGHT] = this->_buildTile ( keys[TileKey::UPPER_RIGHT], half, job ); // upper right tile
   
   // Have we been cancelled?
   if ( job.valid() && true == job->canceled() )
     job->cancel();
+
+  this->attachChildren ( children );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Use the tiles as the children. They are added at the next update.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Tile::attachChildren ( const Tiles& children )
+{
+  USUL_ASSERT ( 4 == children.size() );
+
+  Body::RefPtr body ( Usul::Threads::Safe::get ( this->mutex(), _body ) );
+  
+  // Handle no body.
+  if ( false == body.valid() )
+    return;
   
   // Need to notify vector data so it can re-adjust.
   Minerva::Core::Data::Container::RefPtr vector ( body->vectorData() );
@@ -819,18 +844,19 @@ void Tile::split ( Usul::Jobs::Job::RefPtr job )
     Usul::Interfaces::IUnknown::QueryPtr unknown ( body );
 
     // Notify that the elevation has changed.
-    vector->elevationChangedNotify ( t0->extents(), t0->level(), t0->elevationData(), unknown.get() );
-    vector->elevationChangedNotify ( t1->extents(), t1->level(), t1->elevationData(), unknown.get() );
-    vector->elevationChangedNotify ( t2->extents(), t2->level(), t2->elevationData(), unknown.get() );
-    vector->elevationChangedNotify ( t3->extents(), t3->level(), t3->elevationData(), unknown.get() );
+    for ( Tiles::const_iterator iter = children.begin(); iter != children.end(); ++iter )
+    {
+      Tile::RefPtr tile ( *iter );
+      vector->elevationChangedNotify ( tile->extents(), tile->level(), tile->elevationData(), unknown.get() );
+    }
   }
   
   {
     Guard guard ( this->mutex() );
-    _children[TileKey::LOWER_LEFT]  = t0.get();
-    _children[TileKey::LOWER_RIGHT] = t1.get();
-    _children[TileKey::UPPER_LEFT]  = t2.get();
-    _children[TileKey::UPPER_RIGHT] = t3.get();
+    _children[TileKey::LOWER_LEFT]  = children[TileKey::LOWER_LEFT];
+    _children[TileKey::LOWER_RIGHT] = children[TileKey::LOWER_RIGHT];
+    _children[TileKey::UPPER_LEFT]  = children[TileKey::UPPER_LEFT];
+    _children[TileKey::UPPER_RIGHT] = children[TileKey::UPPER_RIGHT];
   }
 }
 
@@ -845,14 +871,55 @@ Tile::RefPtr Tile::_buildTile ( TileKey::RefPtr info,
                                 double splitDistance, 
                                 Usul::Jobs::Job::RefPtr job )
 {
-  // If our logic is correct, this should be true.
-  USUL_ASSERT ( this->referenceCount() >= 1 );
-  USUL_ASSERT ( info.valid() );
+  // Have we been cancelled?
+  if ( job.valid() && true == job->canceled() )
+    job->cancel();
+
+  Tile::RefPtr tile ( this->makeChild ( info, splitDistance ) );
+
+  // Tell the tile to start building its elevation data.
+  this->buildChildElevation ( tile, job );
 
   // Have we been cancelled?
   if ( job.valid() && true == job->canceled() )
     job->cancel();
+
+  // Build the raster.  Make sure this is done before mesh is built and texture updated.
+  tile->buildRaster ( job );
+
+#if 0
+  //TODO: Make a copy of the sub image.
   
+  // Check to see if the tile has a valid image.
+  if ( false == tile->image().valid() && 0x0 != this->image() )
+  {
+    // Use the specified region of our image.
+    tile->textureData ( this->image().get(), region );
+  }
+#endif
+
+  // Have we been cancelled?
+  if ( job.valid() && true == job->canceled() )
+    job->cancel();
+
+  tile->buildDetail ( job );
+
+  return tile;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the child tile for the key. Only the vector data is set up.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Tile::RefPtr Tile::makeChild ( TileKey::RefPtr info, double splitDistance )
+{
+  // If our logic is correct, this should be true.
+  USUL_ASSERT ( this->referenceCount() >= 1 );
+  USUL_ASSERT ( info.valid() );
+
   Extents extents ( info->extents() );
 
   // Get this tile's vector data that falls within the extents.
@@ -871,7 +938,21 @@ Tile::RefPtr Tile::_buildTile ( TileKey::RefPtr info,
   
   tvd->updateNotify ( 0x0, planet.get(), elevation.get() );
 
-  // Tell the tile to start building its elevation data.
+  return tile;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the child's elevation. Falls back to a quarter of ours.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Tile::buildChildElevation ( Tile::RefPtr tile, Usul::Jobs::Job::RefPtr job )
+{
+  if ( false == tile.valid() )
+    return;
+
   tile->buildElevationData ( job );
 
   // Use a quarter of the parent's elevation for the child.
@@ -880,47 +961,33 @@ Tile::RefPtr Tile::_buildTile ( TileKey::RefPtr info,
     ElevationDataPtr parentElevation ( Usul::Threads::Safe::get ( this->mutex(), _elevation ) );
     if ( parentElevation.valid() )
     {
-      tile->elevationData ( Minerva::Core::Algorithms::resampleElevation ( Tile::RefPtr ( this ), extents ) );
+      tile->elevationData ( Minerva::Core::Algorithms::resampleElevation ( Tile::RefPtr ( this ), tile->extents() ) );
     }
   }
+}
 
-  // Have we been cancelled?
-  if ( job.valid() && true == job->canceled() )
-    job->cancel();
-
-  // Build the raster.  Make sure this is done before mesh is built and texture updated.
-  tile->buildRaster ( job );
-
-#if 0
-  //TODO: Make a copy of the sub image.
-  
-  // Check to see if the tile has a valid image.
-  if ( false == tile->image().valid() && 0x0 != this->image() )
-  {
-    // Use the specified region of our image.
-    tile->textureData ( this->image().get(), region );
-  }
-#endif
 
-  // Have we been cancelled?
-  if ( job.valid() && true == job->canceled() )
-    job->cancel();
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the mesh, texture and per-tile vector data.
+//
+///////////////////////////////////////////////////////////////////////////////
 
-  tile->updateMesh();
-  tile->updateTexture();
+void Tile::buildDetail ( Usul::Jobs::Job::RefPtr job )
+{
+  this->updateMesh();
+  this->updateTexture();
 
   // Have we been cancelled?
   if ( job.valid() && true == job->canceled() )
     job->cancel();
 
   // Now build the per-tile vector data.
-  tile->buildPerTileVectorData ( job );
+  this->buildPerTileVectorData ( job );
 
   // Have we been cancelled?
   if ( job.valid() && true == job->canceled() )
     job->cancel();
-
-  return tile;
 }
 
 
@@ -939,6 +1006,11 @@ void Tile::buildRaster ( Usul::Jobs::Job::RefPtr job )
   if ( false == body.valid() )
     return;
 
+  // Let the prefetcher know the tile was needed.
+  Prefetch::RefPtr prefetch ( body->prefetch() );
+  if ( prefetch.valid() )
+    prefetch->tileNotify ( *_info );
+
   // Width and height for the image.
   const ImageSize imageSize ( _info->imageSize() );
   const unsigned int width ( imageSize[0] );
@@ -1221,6 +1293,18 @@ void Tile::clear ( bool children )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the key.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Tile::TileKey::RefPtr Tile::key() const
+{
+  return _info;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the extents.
@@ -1303,6 +1387,32 @@ MeshSize Tile::meshSize() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Priority for jobs working on this tile. Lower numbers run first. Each 
+//  level gets a band of numbers and the eye distance, relative to the split 
+//  distance, picks the place in the band.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int Tile::jobPriority() const
+{
+  const int band ( 1024 );
+
+  double distanceSquared ( 0.0 ), splitDistance ( 0.0 );
+  {
+    Guard guard ( this );
+    distanceSquared = _eyeDistanceSquared;
+    splitDistance = _splitDistance;
+  }
+
+  const double ratio ( ( splitDistance > 0.0 ) ? ( ::sqrt ( distanceSquared ) / splitDistance ) : 0.0 );
+  const int offset ( static_cast<int> ( Usul::Math::clamp ( ratio, 0.0, 1.0 ) * ( band - 1 ) ) );
+
+  return ( -1 * band * static_cast<int> ( this->level() ) ) + offset;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the split distance.
@@ -1429,6 +1539,22 @@ Tile::RefPtr Tile::childAt ( unsigned int i ) const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the child at index i if this tile is split. This is the same as 
+//  checking isLeaf() and then calling childAt(), but with one lock.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Tile::RefPtr Tile::childIfSplit ( unsigned int i ) const
+{
+  Guard guard ( this->mutex() );
+
+  const bool split ( _children[0].valid() && _children[1].valid() && _children[2].valid() && _children[3].valid() );
+  return ( split && i < _children.size() ? _children[i] : 0x0 );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the elevation data.
@@ -1792,7 +1918,7 @@ void Tile::buildElevationData ( Usul::Jobs::Job::RefPtr job )
     Visitor::RefPtr visitor ( new Visitor ( extents, rasters ) );
     elevationData->accept ( *visitor );
     
-    Minerva::Common::IElevationData::RefPtr answer ( 0x0 );
+    Minerva::Core::ElevationData::RefPtr answer ( 0x0 );
     
     for ( Rasters::const_iterator iter = rasters.begin(); iter != rasters.end(); ++iter )
     {
@@ -1821,28 +1947,13 @@ void Tile::buildElevationData ( Usul::Jobs::Job::RefPtr job )
               answer = new Minerva::Core::ElevationData ( size[0], size[1] );
             }
             
-            for ( unsigned int i = 0; i < size[0]; ++i )
-            {
-              for ( unsigned int j = 0; j < size[1]; ++j )
-              {
-                // Get the current value.
-                const float value ( elevationData->value ( i, j ) );
-                
-                // See if the value is in the list of no data values.
-                const bool isNoData ( Usul::Predicates::CloseFloat<Minerva::Common::IElevationData::ValueType>::compare ( value, elevationData->noDataValue(), 10 ) );
-                
-                // Set the value, if it isn't a no data.
-                if ( false == isNoData )
-                {
-                  answer->value ( i, j, value );
-                }
-              }
-            }
+            // Copy the values that aren't the layer's no data value.
+            answer->merge ( *elevationData );
           }
         }
       }
     }
     
-    this->elevationData ( answer );
+    this->elevationData ( Minerva::Common::IElevationData::RefPtr ( answer ) );
   }
 }
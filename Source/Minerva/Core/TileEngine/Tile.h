@@ -116,11 +116,24 @@ public:
   // Get the child at index i.
   Tile::RefPtr              childAt ( unsigned int i ) const;
 
+  // Get the child at index i if this tile is split, or null if it's a leaf.
+  Tile::RefPtr              childIfSplit ( unsigned int i ) const;
+
+  // Use the tiles as the children. They are added at the next update.
+  void                      attachChildren ( const Tiles& children );
+
   // Build raster and vector data.
   void                      buildElevationData ( Usul::Jobs::Job::RefPtr );
   void                      buildPerTileVectorData ( Usul::Jobs::Job::RefPtr );
   void                      buildRaster ( Usul::Jobs::Job::RefPtr );
 
+  // Build the child's elevation. Falls back to a quarter of ours.
+  void                      buildChildElevation ( Tile::RefPtr child, Usul::Jobs::Job::RefPtr );
+
+  // Build the mesh, texture and per-tile vector data once the elevation 
+  // and raster are built.
+  void                      buildDetail ( Usul::Jobs::Job::RefPtr );
+
   // Compute the bounding sphere.
   virtual BSphere           computeBound() const;
 
@@ -150,15 +163,25 @@ public:
   // Is this tile a leaf?
   bool                      isLeaf() const;
 
+  // Make the child tile for the key. Only the vector data is set up.
+  Tile::RefPtr              makeChild ( TileKey::RefPtr key, double splitDistance );
+
   // Get the body's job manager.
   Usul::Jobs::Manager *     jobManager();
 
+  // Get the key.
+  TileKey::RefPtr           key() const;
+
   // Convience function that re-directs to the body.
   void                      latLonHeightToXYZ ( double lat, double lon, double elevation, osg::Vec3d& point ) const;
 
   // Return level of this tile. Zero is the top.
   unsigned int              level() const;
 
+  // Priority for jobs working on this tile. Deeper tiles come first, then 
+  // the ones that were closest to the eye at the last cull.
+  int                       jobPriority() const;
+
   // Return the mutex. Use with caution.
   Mutex &                   mutex() const;
 
@@ -246,6 +269,7 @@ private:
   Body *_body;
   const TileKey::RefPtr _info;
   double _splitDistance;
+  double _eyeDistanceSquared;
   MeshPtr _mesh;
   unsigned int _flags;
   Children _children;
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Base class for a store of encoded tiles. The disk cache uses this instead
+//  of one file per tile when a store is set.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_TILE_STORE_H__
+#define __MINERVA_CORE_TILE_STORE_H__
+
+#include "Minerva/Core/Export.h"
+
+#include "Minerva/Common/LayerKey.h"
+#include "Minerva/Common/TileKey.h"
+
+#include "Usul/Base/Referenced.h"
+#include "Usul/Pointers/Pointers.h"
+
+#include <string>
+#include <vector>
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT TileStore : public Usul::Base::Referenced
+{
+public:
+
+  typedef Usul::Base::Referenced BaseClass;
+  typedef Minerva::Common::LayerKey LayerKey;
+  typedef Minerva::Common::TileKey TileKey;
+  typedef std::vector<char> Buffer;
+
+  USUL_DECLARE_REF_POINTERS ( TileStore );
+
+  /// Is the tile in the store?
+  virtual bool contains ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension ) const = 0;
+
+  /// Read the encoded tile. Returns false if the tile is not in the store.
+  virtual bool read ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, Buffer& buffer ) const = 0;
+
+  /// Write the encoded tile. Replaces any existing entry.
+  virtual void write ( const LayerKey& layerKey, const TileKey& tileKey, unsigned int width, unsigned int height, const std::string& extension, const Buffer& buffer ) = 0;
+
+  /// Remove all tiles for the layer.
+  virtual void remove ( const LayerKey& layerKey ) = 0;
+
+protected:
+
+  TileStore() : BaseClass() {}
+  virtual ~TileStore() {}
+
+private:
+
+  TileStore ( const TileStore& );
+  TileStore& operator= ( const TileStore& );
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_TILE_STORE_H__
@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Archives mounted at directories.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/VirtualFileSystem.h"
+
+#include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
+
+#include "boost/algorithm/string/predicate.hpp"
+#include "boost/algorithm/string/replace.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "osgDB/FileNameUtils"
+#include "osgDB/Registry"
+
+#include <fstream>
+#include <sstream>
+
+using namespace Minerva::Core;
+
+typedef Usul::Threads::Guard<Usul::Threads::Mutex> Guard;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Initialize static data members.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem* VirtualFileSystem::_instance ( 0x0 );
+namespace Detail { boost::mutex instanceMutex; }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Send osgDB reads of mounted files to the virtual file system. Relative
+//  names are looked for in the database paths, the way osgDB does.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  class ReadFileCallback : public osgDB::Registry::ReadFileCallback
+  {
+  public:
+
+    typedef osgDB::Registry::ReadFileCallback BaseClass;
+    typedef osgDB::ReaderWriter::ReadResult ReadResult;
+    typedef osgDB::ReaderWriter::Options Options;
+
+    ReadFileCallback ( BaseClass *previous ) : BaseClass(), _previous ( previous )
+    {
+    }
+
+    virtual ReadResult readImage ( const std::string& filename, const Options* options )
+    {
+      const std::string file ( ReadFileCallback::_find ( filename, options ) );
+      if ( false == file.empty() )
+      {
+        VirtualFileSystem::ImagePtr image ( VirtualFileSystem::instance().readImage ( file ) );
+        return ( image.valid() ? ReadResult ( image.get() ) : ReadResult ( ReadResult::ERROR_IN_READING_FILE ) );
+      }
+
+      return ( _previous.valid() ? _previous->readImage ( filename, options ) : BaseClass::readImage ( filename, options ) );
+    }
+
+    virtual ReadResult readNode ( const std::string& filename, const Options* options )
+    {
+      const std::string file ( ReadFileCallback::_find ( filename, options ) );
+      if ( false == file.empty() )
+      {
+        VirtualFileSystem::NodePtr node ( VirtualFileSystem::instance().readNode ( file ) );
+        return ( node.valid() ? ReadResult ( node.get() ) : ReadResult ( ReadResult::ERROR_IN_READING_FILE ) );
+      }
+
+      return ( _previous.valid() ? _previous->readNode ( filename, options ) : BaseClass::readNode ( filename, options ) );
+    }
+
+  protected:
+
+    virtual ~ReadFileCallback()
+    {
+    }
+
+  private:
+
+    static std::string _find ( const std::string& filename, const Options* options )
+    {
+      VirtualFileSystem &vfs ( VirtualFileSystem::instance() );
+
+      if ( vfs.contains ( filename ) )
+        return filename;
+
+      if ( 0x0 != options )
+      {
+        const osgDB::FilePathList &paths ( options->getDatabasePathList() );
+        for ( osgDB::FilePathList::const_iterator iter = paths.begin(); iter != paths.end(); ++iter )
+        {
+          const std::string file ( *iter + "/" + filename );
+          if ( vfs.contains ( file ) )
+            return file;
+        }
+      }
+
+      return std::string();
+    }
+
+    osg::ref_ptr<BaseClass> _previous;
+  };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem& VirtualFileSystem::instance()
+{
+  // Layers read on job threads, so the first calls can race. The callback 
+  // has to be installed only once.
+  boost::mutex::scoped_lock lock ( Detail::instanceMutex );
+
+  if ( 0x0 == _instance )
+  {
+    _instance = new VirtualFileSystem;
+
+    // Route osgDB reads through us. Made after the instance is set so the callback can use it.
+    osgDB::Registry *registry ( osgDB::Registry::instance() );
+    registry->setReadFileCallback ( new Detail::ReadFileCallback ( registry->getReadFileCallback() ) );
+  }
+
+  return *_instance;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem::VirtualFileSystem() :
+  _mutex ( new Usul::Threads::Mutex ),
+  _mounts()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem::~VirtualFileSystem()
+{
+  _mounts.clear();
+  delete _mutex;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Use forward slashes, and end directories with one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string VirtualFileSystem::_normalize ( const std::string& path )
+{
+  std::string answer ( path );
+  boost::algorithm::replace_all ( answer, "\\", "/" );
+
+  while ( std::string::npos != answer.find ( "/./" ) )
+    boost::algorithm::replace_all ( answer, "/./", "/" );
+
+  while ( std::string::npos != answer.find ( "//" ) )
+    boost::algorithm::replace_all ( answer, "//", "/" );
+
+  return answer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Mount the archive.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Archive::RefPtr VirtualFileSystem::mount ( const std::string& directory, Archive::RefPtr archive )
+{
+  const std::string key ( VirtualFileSystem::_normalize ( directory + "/" ) );
+
+  Guard guard ( *_mutex );
+
+  Mount &m ( _mounts[key] );
+  if ( false == m.archive.valid() )
+    m.archive = archive;
+
+  if ( false == m.archive.valid() )
+  {
+    _mounts.erase ( key );
+    return Archive::RefPtr ( 0x0 );
+  }
+
+  ++m.count;
+  return m.archive;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take away one mount.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void VirtualFileSystem::unmount ( const std::string& directory )
+{
+  const std::string key ( VirtualFileSystem::_normalize ( directory + "/" ) );
+
+  Mount m;
+  {
+    Guard guard ( *_mutex );
+
+    Mounts::iterator iter ( _mounts.find ( key ) );
+    if ( _mounts.end() == iter )
+      return;
+
+    if ( iter->second.count > 1 )
+    {
+      --iter->second.count;
+      return;
+    }
+
+    m = iter->second;
+    _mounts.erase ( iter );
+  }
+
+  // Remove what was extracted, and the directories when they're empty.
+  boost::system::error_code ec;
+  for ( std::set<std::string>::const_iterator iter = m.extracted.begin(); iter != m.extracted.end(); ++iter )
+  {
+    boost::filesystem::remove ( *iter, ec );
+
+    boost::filesystem::path parent ( boost::filesystem::path ( *iter ).parent_path() );
+    while ( parent.string().size() >= key.size() - 1 && boost::filesystem::remove ( parent, ec ) )
+      parent = parent.parent_path();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the archive mounted at the directory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Archive::RefPtr VirtualFileSystem::archive ( const std::string& directory ) const
+{
+  const std::string key ( VirtualFileSystem::_normalize ( directory + "/" ) );
+
+  Guard guard ( *_mutex );
+  Mounts::const_iterator iter ( _mounts.find ( key ) );
+  return ( _mounts.end() != iter ? iter->second.archive : Archive::RefPtr ( 0x0 ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the mount directory and the entry for the filename.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool VirtualFileSystem::_find ( const std::string& filename, std::string& directory, std::string& entry ) const
+{
+  const std::string file ( VirtualFileSystem::_normalize ( filename ) );
+
+  Guard guard ( *_mutex );
+  for ( Mounts::const_iterator iter = _mounts.begin(); iter != _mounts.end(); ++iter )
+  {
+    if ( file.size() > iter->first.size() && boost::algorithm::starts_with ( file, iter->first ) )
+    {
+      directory = iter->first;
+      entry = file.substr ( iter->first.size() );
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the file in a mounted archive?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool VirtualFileSystem::contains ( const std::string& filename ) const
+{
+  std::string directory, entry;
+  if ( false == this->_find ( filename, directory, entry ) )
+    return false;
+
+  Archive::RefPtr a ( this->archive ( directory ) );
+  return ( a.valid() ? a->contains ( entry ) : false );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the file from its archive.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool VirtualFileSystem::read ( const std::string& filename, Buffer& buffer ) const
+{
+  std::string directory, entry;
+  if ( false == this->_find ( filename, directory, entry ) )
+    return false;
+
+  Archive::RefPtr a ( this->archive ( directory ) );
+  return ( a.valid() ? a->read ( entry, buffer ) : false );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Has the file been extracted?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool VirtualFileSystem::_isExtracted ( const std::string& filename ) const
+{
+  std::string directory, entry;
+  if ( false == this->_find ( filename, directory, entry ) )
+    return false;
+
+  Guard guard ( *_mutex );
+  Mounts::const_iterator iter ( _mounts.find ( directory ) );
+  return ( _mounts.end() != iter && iter->second.extracted.end() != iter->second.extracted.find ( directory + entry ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the file to the disk.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool VirtualFileSystem::extract ( const std::string& filename )
+{
+  if ( this->_isExtracted ( filename ) )
+    return true;
+
+  std::string directory, entry;
+  if ( false == this->_find ( filename, directory, entry ) )
+    return false;
+
+  Buffer buffer;
+  if ( false == this->read ( filename, buffer ) )
+    return false;
+
+  const std::string file ( directory + entry );
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories ( boost::filesystem::path ( file ).parent_path(), ec );
+
+  {
+    std::ofstream out ( file.c_str(), std::ios::out | std::ios::binary );
+    if ( false == out.is_open() )
+      return false;
+
+    if ( false == buffer.empty() )
+      out.write ( &buffer[0], buffer.size() );
+  }
+
+  Guard guard ( *_mutex );
+  Mounts::iterator iter ( _mounts.find ( directory ) );
+  if ( _mounts.end() != iter )
+    iter->second.extracted.insert ( file );
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read an image from its archive.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem::ImagePtr VirtualFileSystem::readImage ( const std::string& filename ) const
+{
+  osgDB::ReaderWriter *rw ( osgDB::Registry::instance()->getReaderWriterForExtension ( osgDB::getLowerCaseFileExtension ( filename ) ) );
+  if ( 0x0 == rw )
+    return ImagePtr ( 0x0 );
+
+  Buffer buffer;
+  if ( false == this->read ( filename, buffer ) || buffer.empty() )
+    return ImagePtr ( 0x0 );
+
+  std::istringstream in ( std::string ( buffer.begin(), buffer.end() ), std::ios::in | std::ios::binary );
+  osgDB::ReaderWriter::ReadResult result ( rw->readImage ( in ) );
+  if ( false == result.success() )
+    return ImagePtr ( 0x0 );
+
+  ImagePtr image ( result.getImage() );
+  if ( image.valid() )
+    image->setFileName ( filename );
+
+  return image;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read a node from its archive. Files the reader can't stream, and ones
+//  that have been extracted, are read from the disk.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+VirtualFileSystem::NodePtr VirtualFileSystem::readNode ( const std::string& filename )
+{
+  osgDB::ReaderWriter *rw ( osgDB::Registry::instance()->getReaderWriterForExtension ( osgDB::getLowerCaseFileExtension ( filename ) ) );
+  if ( 0x0 == rw )
+    return NodePtr ( 0x0 );
+
+  // Textures are found next to the file.
+  osg::ref_ptr<osgDB::ReaderWriter::Options> options ( new osgDB::ReaderWriter::Options );
+  options->setDatabasePath ( osgDB::getFilePath ( filename ) );
+
+  if ( false == this->_isExtracted ( filename ) )
+  {
+    Buffer buffer;
+    if ( false == this->read ( filename, buffer ) || buffer.empty() )
+      return NodePtr ( 0x0 );
+
+    std::istringstream in ( std::string ( buffer.begin(), buffer.end() ), std::ios::in | std::ios::binary );
+    osgDB::ReaderWriter::ReadResult result ( rw->readNode ( in, options.get() ) );
+    if ( result.success() )
+      return NodePtr ( result.getNode() );
+
+    if ( false == this->extract ( filename ) )
+      return NodePtr ( 0x0 );
+  }
+
+  // Call the reader directly so we don't come back here through the registry.
+  osgDB::ReaderWriter::ReadResult result ( rw->readNode ( filename, options.get() ) );
+  return ( result.success() ? NodePtr ( result.getNode() ) : NodePtr ( 0x0 ) );
+}
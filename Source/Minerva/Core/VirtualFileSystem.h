@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2009, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Archives mounted at directories. A file below a mount directory is read
+//  from the archive instead of the disk. Image and node reads through osgDB
+//  are routed here too, so plugins that load textures for a model find them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_CORE_VIRTUAL_FILE_SYSTEM_H__
+#define __MINERVA_CORE_VIRTUAL_FILE_SYSTEM_H__
+
+#include "Minerva/Core/Export.h"
+#include "Minerva/Core/Archive.h"
+
+#include "osg/Image"
+#include "osg/Node"
+#include "osg/ref_ptr"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace Usul { namespace Threads { class Mutex; } }
+
+namespace Minerva {
+namespace Core {
+
+
+class MINERVA_EXPORT VirtualFileSystem
+{
+public:
+
+  typedef Archive::Buffer Buffer;
+  typedef osg::ref_ptr<osg::Image> ImagePtr;
+  typedef osg::ref_ptr<osg::Node> NodePtr;
+
+  static VirtualFileSystem& instance();
+
+  /// Mount the archive at the directory. If an archive is already mounted
+  /// there it's kept and counted again. Returns the mounted archive.
+  Archive::RefPtr mount ( const std::string& directory, Archive::RefPtr archive );
+
+  /// Take away one mount. The last one removes the archive and any files extracted from it.
+  void unmount ( const std::string& directory );
+
+  /// Get the archive mounted at the directory, if any.
+  Archive::RefPtr archive ( const std::string& directory ) const;
+
+  /// Is the file in a mounted archive?
+  bool contains ( const std::string& filename ) const;
+
+  /// Read the file from its archive.
+  bool read ( const std::string& filename, Buffer& buffer ) const;
+
+  /// Write the file to the disk at its name, for readers that need a real file.
+  bool extract ( const std::string& filename );
+
+  /// Read an image or a node from its archive. Returns null if the file is not in one.
+  /// Nodes the reader can't stream are extracted first.
+  ImagePtr readImage ( const std::string& filename ) const;
+  NodePtr  readNode  ( const std::string& filename );
+
+private:
+
+  struct Mount
+  {
+    Mount() : archive ( 0x0 ), count ( 0 ), extracted() {}
+
+    Archive::RefPtr archive;
+    unsigned int count;
+    std::set<std::string> extracted;
+  };
+
+  typedef std::map<std::string,Mount> Mounts;
+
+  VirtualFileSystem();
+  ~VirtualFileSystem();
+
+  // Get the normalized directory and the entry for the filename.
+  bool _find ( const std::string& filename, std::string& directory, std::string& entry ) const;
+
+  bool _isExtracted ( const std::string& filename ) const;
+
+  static std::string _normalize ( const std::string& path );
+
+  Usul::Threads::Mutex *_mutex;
+  Mounts _mounts;
+
+  static VirtualFileSystem *_instance;
+};
+
+
+}
+}
+
+#endif // __MINERVA_CORE_VIRTUAL_FILE_SYSTEM_H__
@@ -24,7 +24,8 @@ using namespace Minerva::Core::Visitors;
 StackPoints::StackPoints( double multiplier ) : 
   BaseClass(),
   _counts( LessVector ( EqualPredicate() ) ),
-  _multiplier ( multiplier )
+  _multiplier ( multiplier ),
+  _parent ( 0x0 )
 {
 }
 
@@ -69,9 +70,6 @@ void StackPoints::visit ( Minerva::Core::Data::DataObject &dataObject )
       }
       else
       {
-        // Make sure it's using the right altitude mode.
-        point->altitudeMode ( Minerva::Core::Data::ALTITUDE_MODE_RELATIVE_TO_GROUND );
-
         unsigned int count ( countIter->second );
 
         float size ( 5.0 );
@@ -80,10 +78,17 @@ void StackPoints::visit ( Minerva::Core::Data::DataObject &dataObject )
           size = dataObject.style()->pointstyle()->size();
         }
 
-        Usul::Math::Vec3d location ( point->point() );
+        // Only the points that move are built again.
         const double distance ( count * _multiplier * size );
-        point->point ( Usul::Math::Vec3d ( location[0], location[1], distance ) );
-        dataObject.dirty ( true );
+        if ( distance != p[2] || Minerva::Core::Data::ALTITUDE_MODE_RELATIVE_TO_GROUND != point->altitudeMode() )
+        {
+          point->altitudeMode ( Minerva::Core::Data::ALTITUDE_MODE_RELATIVE_TO_GROUND );
+          point->point ( Usul::Math::Vec3d ( p[0], p[1], distance ) );
+          dataObject.dirty ( true );
+
+          if ( _parent.valid() )
+            _parent->featureChanged ( &dataObject );
+        }
 
         countIter->second = count + 1;
       }
@@ -102,7 +107,9 @@ void StackPoints::visit ( Minerva::Core::Data::Container &layer )
 {
   if ( layer.visibility() )
   {
+    Minerva::Core::Data::Container::RefPtr parent ( _parent );
+    _parent = &layer;
     layer.traverse ( *this );
-    layer.dirtyScene ( true );
+    _parent = parent;
   }
 }
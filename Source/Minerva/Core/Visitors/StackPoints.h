@@ -13,6 +13,7 @@
 
 #include "Minerva/Core/Export.h"
 #include "Minerva/Core/Visitor.h"
+#include "Minerva/Core/Data/Container.h"
 
 #include "Usul/Math/Vector3.h"
 #include "Usul/Predicates/LessVector.h"
@@ -48,6 +49,7 @@ private:
   
   Counts _counts;
   double _multiplier;
+  Minerva::Core::Data::Container::RefPtr _parent;
 };
       
       
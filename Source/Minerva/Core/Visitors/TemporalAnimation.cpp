@@ -10,6 +10,7 @@
 
 #include "Minerva/Core/Visitors/TemporalAnimation.h"
 
+#include "Minerva/Core/Data/Container.h"
 #include "Minerva/Core/Data/DataObject.h"
 #include "Minerva/Core/Data/TimeSpan.h"
 #include "Minerva/Core/Data/TimeStamp.h"
@@ -66,12 +67,13 @@ void TemporalAnimation::visit ( Minerva::Core::Data::Feature &object )
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Update min/max dates.
+//  Visit the container. It keeps an index of its features' times, so only 
+//  the ones that go in or out of the period are touched.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 void TemporalAnimation::visit ( Minerva::Core::Data::Container &object )
 {
   TemporalAnimation::visit ( (Minerva::Core::Data::Feature& ) object );
-  BaseClass::visit ( object );
+  object.temporalVisibility ( _period );
 }
@@ -756,6 +756,31 @@ bool MinervaDocument::busyStateGet() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait until there are no jobs. A job in one manager can add a job to the 
+//  other, so keep waiting until a pass finds both empty. Each wait blocks 
+//  until its manager's last job is done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void MinervaDocument::waitWhileBusy()
+{
+  Usul::Jobs::Manager &global ( Usul::Jobs::Manager::instance() );
+  Usul::Jobs::Manager *manager ( this->_getJobManager() );
+
+  while ( true )
+  {
+    global.wait();
+    if ( &global != manager )
+      manager->wait();
+
+    if ( ( 0 == global.numJobs() ) && ( 0 == manager->numJobs() ) )
+      return;
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the timespan of the data.
@@ -92,6 +92,10 @@ public:
   /// Get the busy state.
   bool                                     busyStateGet() const;
 
+  /// Block until the document's jobs and the global jobs are done. Layers 
+  /// queue their reads as global jobs, so this covers them too.
+  void                                     waitWhileBusy();
+
   /// Have visitor visit all layes.
   void                                     accept ( Minerva::Core::Visitor& visitor );
 
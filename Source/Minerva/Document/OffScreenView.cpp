@@ -16,10 +16,16 @@
 #include "Minerva/Document/OffScreenView.h"
 #include "Minerva/OsgTools/OffScreenRendererPBuffer.h"
 #include "Usul/Errors/Assert.h"
-#include "Usul/System/Sleep.h"
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Strings/Format.h"
 
 #include "osgDB/WriteFile"
 
+#include "boost/bind.hpp"
+
+#include <vector>
+
 using namespace Minerva::Document;
 
 
@@ -31,7 +37,12 @@ using namespace Minerva::Document;
 
 OffScreenView::OffScreenView ( Document::RefPtr document, unsigned int width, unsigned int height ) : BaseClass ( document ),
   _renderer ( new Minerva::OsgTools::OffScreenRendererPBuffer ( width, height ) ),
-  _frameDump ( new FrameDump )
+  _frameDump ( new FrameDump ),
+  _writers ( 0x0 ),
+  _maxWrites ( 0 ),
+  _numWrites ( 0 ),
+  _writeMutex(),
+  _writeCondition()
 {
   if ( !document )
   {
@@ -50,7 +61,12 @@ OffScreenView::OffScreenView ( Document::RefPtr document, unsigned int width, un
 
 OffScreenView::OffScreenView ( Document::RefPtr document, Minerva::OsgTools::OffScreenRenderer::RefPtr renderer ) : BaseClass ( document ),
   _renderer ( renderer ),
-  _frameDump ( new FrameDump )
+  _frameDump ( new FrameDump ),
+  _writers ( 0x0 ),
+  _maxWrites ( 0 ),
+  _numWrites ( 0 ),
+  _writeMutex(),
+  _writeCondition()
 {
   if ( !document )
   {
@@ -75,6 +91,7 @@ OffScreenView::OffScreenView ( Document::RefPtr document, Minerva::OsgTools::Off
 
 OffScreenView::~OffScreenView()
 {
+  Usul::Functions::safeCall ( boost::bind ( &OffScreenView::writeThreads, this, 0 ), "3081740592" );
 }
 
 
@@ -130,13 +147,41 @@ void OffScreenView::_render ( Minerva::Core::Data::Camera::RefPtr camera, bool d
 
     document->updateNotify ( camera );
 
+    // Without a frame to keep, only cull the scene so the tiles ask for what 
+    // they need. Nothing is drawn or read back.
+    if ( false == dumpFrame )
+    {
+      _renderer->cull();
+      document->postRenderNotify();
+      return;
+    }
+
     typedef Minerva::OsgTools::OffScreenRenderer::ImagePtr ImagePtr;
     ImagePtr image ( _renderer->render() );
 
-    if ( image && dumpFrame )
+    if ( image )
     {
       USUL_ASSERT ( _frameDump );
-      osgDB::writeImageFile ( *image, _frameDump->file() );
+      const std::string filename ( _frameDump->file() );
+
+      if ( 0x0 != _writers )
+      {
+        // Don't get too far ahead of the writers. Every frame waiting is a whole image.
+        {
+          boost::mutex::scoped_lock lock ( _writeMutex );
+          while ( _numWrites >= _maxWrites )
+          {
+            _writeCondition.wait ( lock );
+          }
+          ++_numWrites;
+        }
+
+        _writers->addJob ( Usul::Jobs::create ( boost::bind ( &OffScreenView::_writeFrame, this, image, filename ) ) );
+      }
+      else
+      {
+        osgDB::writeImageFile ( *image, filename );
+      }
     }
 
     document->postRenderNotify();
@@ -146,16 +191,121 @@ void OffScreenView::_render ( Minerva::Core::Data::Camera::RefPtr camera, bool d
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Render until all jobs are finished.
+//  Cull until all jobs are finished. Each pass may start jobs, and their 
+//  results are only used by the next pass. So block until the jobs are 
+//  done and cull again, until a pass starts nothing and nothing finished
+//  since it began. Only the frame that is kept gets drawn. The tiles use the 
+//  body's job manager, while layers like kml, PostGIS and GeoRSS use the 
+//  global one. The document waits on both.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace Helper
+{
+  typedef std::vector<Usul::Jobs::Manager*> Managers;
+
+  unsigned long numJobsFinished ( const Managers& managers )
+  {
+    unsigned long finished ( 0 );
+    for ( Managers::const_iterator iter = managers.begin(); iter != managers.end(); ++iter )
+      finished += (*iter)->numJobsFinished();
+    return finished;
+  }
+}
+
 void OffScreenView::waitForDetail ( Minerva::Core::Data::Camera::RefPtr camera )
 {
   Document::RefPtr document ( this->document() );
-  do
+  Document::Body::RefPtr body ( document->body() );
+
+  Helper::Managers managers;
+  managers.push_back ( &Usul::Jobs::Manager::instance() );
+  if ( body.valid() && 0x0 != body->jobManager() && managers.front() != body->jobManager() )
+    managers.push_back ( body->jobManager() );
+
+  bool changed ( true );
+  while ( true == changed )
   {
+    const unsigned long finished ( Helper::numJobsFinished ( managers ) );
+
     this->_render ( camera, false );
-    Usul::System::Sleep::seconds ( 1 );
-  } while ( document->busyStateGet() || document->body()->needsRedraw() );
+
+    document->waitWhileBusy();
+
+    changed = ( ( finished != Helper::numJobsFinished ( managers ) ) || 
+                ( body.valid() && body->needsRedraw() ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the number of threads that write frames.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OffScreenView::writeThreads ( unsigned int num )
+{
+  // Finish the frames from the old writers.
+  this->waitForWrites();
+
+  delete _writers;
+  _writers = 0x0;
+
+  if ( num > 0 )
+  {
+    _writers = new Usul::Jobs::Manager ( Usul::Strings::format ( "Frame writers ", this ), num );
+    _maxWrites = num * 2;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for the frames that are being written.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OffScreenView::waitForWrites()
+{
+  boost::mutex::scoped_lock lock ( _writeMutex );
+  while ( _numWrites > 0 )
+  {
+    _writeCondition.wait ( lock );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  void writeImage ( Minerva::OsgTools::OffScreenRenderer::ImagePtr image, const std::string& filename )
+  {
+    osgDB::writeImageFile ( *image, filename );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the frame. Called from a writer thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OffScreenView::_writeFrame ( Minerva::OsgTools::OffScreenRenderer::ImagePtr image, const std::string& filename )
+{
+  Usul::Functions::safeCall ( boost::bind ( &Detail::writeImage, image, filename ), "2276019453" );
+
+  {
+    boost::mutex::scoped_lock lock ( _writeMutex );
+    USUL_ASSERT ( _numWrites > 0 );
+    --_numWrites;
+  }
+
+  _writeCondition.notify_all();
 }
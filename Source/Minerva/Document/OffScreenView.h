@@ -28,6 +28,10 @@
 #include "Minerva/Core/Data/Camera.h"
 
 #include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+namespace Usul { namespace Jobs { class Manager; } }
 
 namespace Minerva {
 namespace Document {
@@ -56,6 +60,13 @@ public:
 
   void waitForDetail ( Minerva::Core::Data::Camera::RefPtr camera );
 
+  // Encode and write the frames on this many threads, so the next frame 
+  // can start while the last is written. Zero writes them as they render.
+  void writeThreads ( unsigned int num );
+
+  // Wait for the frames that are being written.
+  void waitForWrites();
+
 protected:
 
   virtual ~OffScreenView();
@@ -64,8 +75,15 @@ private:
 
   void _render ( Minerva::Core::Data::Camera::RefPtr camera, bool dumpFrame = true );
 
+  void _writeFrame ( Minerva::OsgTools::OffScreenRenderer::ImagePtr image, const std::string& filename );
+
   Minerva::OsgTools::OffScreenRenderer::RefPtr _renderer;
   FrameDumpPtr _frameDump;
+  Usul::Jobs::Manager *_writers;
+  unsigned int _maxWrites;
+  unsigned int _numWrites;
+  boost::mutex _writeMutex;
+  boost::condition_variable _writeCondition;
 };
 
 }
@@ -272,13 +272,14 @@ void View::intersectNotify ( const osgUtil::LineSegmentIntersector::Intersection
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Helper function to get the data object from the node path.
+//  Helper function to get the data object from the node path. Geometry that
+//  many objects were merged into needs the primitive that was hit.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 namespace Helper
 {
-  View::ObjectID findObjectID ( const osg::NodePath& path )
+  View::ObjectID findObjectID ( const osg::NodePath& path, unsigned int primitiveIndex )
   {
     osg::ref_ptr < Minerva::Core::Data::UserData > userdata ( 0x0 );
 
@@ -303,7 +304,7 @@ namespace Helper
 
     if ( userdata.valid() )
     {
-      return userdata->objectID();
+      return userdata->objectID ( primitiveIndex );
     }
 
     return "";
@@ -324,7 +325,7 @@ void View::displayBalloon ( const osgUtil::LineSegmentIntersector::Intersection
   // How we handle the scene needs to be refactored so that all osg objects are only deleted in the main thread.
 #if 0
   // Find the id for the object we intersected.
-  ObjectID objectID ( Helper::findObjectID ( hit.nodePath ) );
+  ObjectID objectID ( Helper::findObjectID ( hit.nodePath, hit.primitiveIndex ) );
 
   if ( false == objectID.empty() )
   {
@@ -25,6 +25,8 @@
 #include "boost/algorithm/string/replace.hpp"
 #include "boost/filesystem/operations.hpp"
 
+#include <stdexcept>
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Download file.
@@ -122,3 +124,37 @@ bool Minerva::Network::downloadToFile ( const std::string& href, const std::stri
 
   return success;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get a unique name in the same directory as the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string Minerva::Network::temporaryFile ( const std::string& file )
+{
+  return boost::filesystem::unique_path ( file + ".%%%%-%%%%-%%%%.tmp" ).string();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Rename the temporary file to the file. If another writer got there 
+//  first, theirs is kept and ours is removed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Minerva::Network::renameTemporaryFile ( const std::string& temporary, const std::string& file )
+{
+  boost::system::error_code ec;
+  boost::filesystem::rename ( temporary, file, ec );
+  if ( ec )
+  {
+    boost::system::error_code ignore;
+    boost::filesystem::remove ( temporary, ignore );
+
+    if ( false == boost::filesystem::exists ( file, ignore ) )
+      throw std::runtime_error ( "Error 1839572046: Failed to rename '" + temporary + "' to '" + file + "'. Reason: " + ec.message() );
+  }
+}
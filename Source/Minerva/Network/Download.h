@@ -31,6 +31,12 @@ namespace Network {
   // Download.  Filename is populated where href is downloaded to.
   MINERVA_NETWORK_EXPORT bool download ( const std::string& href, std::string& filename );
   MINERVA_NETWORK_EXPORT bool download ( const std::string& href, std::string& filename, bool useCache );
+
+  // Get a unique name in the same directory as the file. Write the download 
+  // there and then rename it to the file, so other threads and processes 
+  // using the same cache never see a file that's partly written.
+  MINERVA_NETWORK_EXPORT std::string temporaryFile ( const std::string& file );
+  MINERVA_NETWORK_EXPORT void        renameTemporaryFile ( const std::string& temporary, const std::string& file );
 }
 }
 
@@ -0,0 +1,912 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Shared asynchronous download engine built on a curl multi handle.
+//  See http://curl.haxx.se/libcurl/c/libcurl-multi.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Network/FetchEngine.h"
+#include "Minerva/Network/Download.h"
+
+#include "Usul/Exceptions/Canceled.h"
+#include "Usul/Exceptions/TimedOut.h"
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Interfaces/ICancel.h"
+#include "Usul/Interfaces/ICanceledStateGet.h"
+#include "Usul/Registry/Database.h"
+#include "Usul/Scope/RemoveFile.h"
+#include "Usul/Strings/Format.h"
+
+#include "curl/curl.h"
+
+#include "boost/algorithm/string/case_conv.hpp"
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace Minerva::Network;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Initialize static data members.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine* FetchEngine::_instance ( 0x0 );
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Guards making and destroying the instance. The first call to instance()
+//  is usually from a job thread, so two threads can get there together.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  boost::mutex instanceMutex;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Request constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::Request::Request ( const std::string& url, const std::string& host, int priority, unsigned int timeout, Uint64 sequence ) : BaseClass(),
+  _url ( url ),
+  _host ( host ),
+  _timeout ( timeout ),
+  _sequence ( sequence ),
+  _priority ( priority ),
+  _numWaiters ( 1 ),
+  _handle ( 0x0 ),
+  _data(),
+  _status ( PENDING ),
+  _responseCode ( 0 ),
+  _error(),
+  _doneMutex(),
+  _doneCondition()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Request destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::Request::~Request()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the url.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const std::string& FetchEngine::Request::url() const
+{
+  return _url;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the status.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::Status FetchEngine::Request::status() const
+{
+  boost::mutex::scoped_lock lock ( _doneMutex );
+  return _status;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the request finished?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool FetchEngine::Request::isDone() const
+{
+  const Status status ( this->status() );
+  return ( ( PENDING != status ) && ( RUNNING != status ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for the request to finish.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool FetchEngine::Request::wait ( unsigned int milliSeconds )
+{
+  const boost::system_time deadline ( boost::get_system_time() + boost::posix_time::milliseconds ( milliSeconds ) );
+
+  boost::mutex::scoped_lock lock ( _doneMutex );
+  while ( ( PENDING == _status ) || ( RUNNING == _status ) )
+  {
+    if ( false == _doneCondition.timed_wait ( lock, deadline ) )
+      return ( ( PENDING != _status ) && ( RUNNING != _status ) );
+  }
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the downloaded bytes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const FetchEngine::Buffer& FetchEngine::Request::data() const
+{
+  return _data;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the error message.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string FetchEngine::Request::error() const
+{
+  boost::mutex::scoped_lock lock ( _doneMutex );
+  return _error;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the http response code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+long FetchEngine::Request::responseCode() const
+{
+  boost::mutex::scoped_lock lock ( _doneMutex );
+  return _responseCode;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the final state and wake everyone waiting.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::Request::_finish ( Status status, long responseCode, const std::string& error )
+{
+  {
+    boost::mutex::scoped_lock lock ( _doneMutex );
+    _status = status;
+    _responseCode = responseCode;
+    _error = error;
+  }
+  _doneCondition.notify_all();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine& FetchEngine::instance()
+{
+  boost::mutex::scoped_lock lock ( Detail::instanceMutex );
+
+  if ( 0x0 == _instance )
+    _instance = new FetchEngine;
+
+  return *_instance;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destroy the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::destroy()
+{
+  FetchEngine *engine ( 0x0 );
+  {
+    boost::mutex::scoped_lock lock ( Detail::instanceMutex );
+    engine = _instance;
+    _instance = 0x0;
+  }
+
+  // Delete outside the lock, the worker thread is joined here.
+  delete engine;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::FetchEngine() :
+  _mutex(),
+  _wakeCondition(),
+  _multi ( ::curl_multi_init() ),
+  _thread ( 0x0 ),
+  _stopped ( false ),
+  _queue(),
+  _inFlight(),
+  _hostCounts(),
+  _running(),
+  _aborts(),
+  _idleHandles(),
+  _maxPerHost ( Usul::Registry::Database::instance()["network_download"]["fetch_engine"]["max_transfers_per_host"].get<unsigned int> ( 6, true ) ),
+  _maxTotal   ( Usul::Registry::Database::instance()["network_download"]["fetch_engine"]["max_transfers"].get<unsigned int> ( 32, true ) ),
+  _sequence ( 0 ),
+  _statistics()
+{
+  if ( 0x0 == _multi )
+  {
+    throw std::runtime_error ( "Error 1043869794: Failed to open curl multi handle" );
+  }
+
+  // Keep enough connections around to reuse one for every transfer.
+  ::curl_multi_setopt ( _multi, CURLMOPT_MAXCONNECTS, static_cast<long> ( _maxTotal ) );
+
+  _thread = new boost::thread ( boost::bind ( &FetchEngine::_run, this ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::~FetchEngine()
+{
+  Usul::Functions::safeCall ( boost::bind ( &FetchEngine::_stop, this ), "923447555" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop the worker thread and cancel everything that is left.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_stop()
+{
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    _stopped = true;
+  }
+  _wakeCondition.notify_all();
+
+  if ( 0x0 != _thread )
+  {
+    _thread->join();
+    delete _thread;
+    _thread = 0x0;
+  }
+
+  // The thread is gone so there is no need to lock.
+  for ( Running::iterator i = _running.begin(); i != _running.end(); ++i )
+  {
+    ::curl_multi_remove_handle ( _multi, i->first );
+    ::curl_easy_cleanup ( i->first );
+    i->second->_handle = 0x0;
+    i->second->_finish ( CANCELED, 0, "Fetch engine stopped" );
+  }
+  for ( Queue::iterator i = _queue.begin(); i != _queue.end(); ++i )
+  {
+    i->second->_finish ( CANCELED, 0, "Fetch engine stopped" );
+  }
+  for ( Handles::iterator i = _idleHandles.begin(); i != _idleHandles.end(); ++i )
+  {
+    ::curl_easy_cleanup ( *i );
+  }
+
+  _running.clear();
+  _queue.clear();
+  _inFlight.clear();
+  _hostCounts.clear();
+  _aborts.clear();
+  _idleHandles.clear();
+
+  ::curl_multi_cleanup ( _multi );
+  _multi = 0x0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the host part of the url, including the port.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string FetchEngine::host ( const std::string& url )
+{
+  std::string::size_type start ( url.find ( "://" ) );
+  start = ( ( std::string::npos == start ) ? 0 : start + 3 );
+
+  const std::string::size_type end ( url.find_first_of ( "/?#", start ) );
+  std::string host ( url.substr ( start, ( ( std::string::npos == end ) ? std::string::npos : end - start ) ) );
+
+  // Strip any user name and password.
+  const std::string::size_type at ( host.rfind ( '@' ) );
+  if ( std::string::npos != at )
+    host.erase ( 0, at + 1 );
+
+  boost::algorithm::to_lower ( host );
+  return host;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Request the url.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::Request::RefPtr FetchEngine::fetch ( const std::string& url, int priority, unsigned int timeoutMilliSeconds )
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+
+  ++_statistics.requests;
+
+  // Share the request if the url is already in flight.
+  InFlight::iterator i ( _inFlight.find ( url ) );
+  if ( _inFlight.end() != i )
+  {
+    Request::RefPtr request ( i->second );
+    ++request->_numWaiters;
+    ++_statistics.shared;
+
+    // Move it up the queue if this caller is in more of a hurry.
+    if ( priority < request->_priority )
+    {
+      Queue::iterator q ( _queue.find ( QueueKey ( request->_priority, request->_sequence ) ) );
+      request->_priority = priority;
+      if ( _queue.end() != q )
+      {
+        _queue.erase ( q );
+        _queue[QueueKey ( priority, request->_sequence )] = request;
+      }
+    }
+
+    return request;
+  }
+
+  Request::RefPtr request ( new Request ( url, FetchEngine::host ( url ), priority, timeoutMilliSeconds, ++_sequence ) );
+  _queue[QueueKey ( priority, request->_sequence )] = request;
+  _inFlight[url] = request;
+
+  _wakeCondition.notify_one();
+  return request;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Give up on the request.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::cancel ( Request::RefPtr request )
+{
+  if ( false == request.valid() )
+    return;
+
+  boost::mutex::scoped_lock lock ( _mutex );
+
+  if ( request->_numWaiters > 0 )
+    --request->_numWaiters;
+
+  // Someone else still wants it, or it's already finished.
+  if ( ( request->_numWaiters > 0 ) || ( true == request->isDone() ) )
+    return;
+
+  ++_statistics.canceled;
+
+  // New requests for this url should start over.
+  InFlight::iterator i ( _inFlight.find ( request->url() ) );
+  if ( ( _inFlight.end() != i ) && ( i->second.get() == request.get() ) )
+    _inFlight.erase ( i );
+
+  // If it's still queued then just take it out.
+  Queue::iterator q ( _queue.find ( QueueKey ( request->_priority, request->_sequence ) ) );
+  if ( _queue.end() != q )
+  {
+    _queue.erase ( q );
+    request->_finish ( CANCELED, 0, "Request canceled" );
+    return;
+  }
+
+  // Otherwise the worker thread has to stop the transfer.
+  _aborts.push_back ( request );
+  _wakeCondition.notify_one();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Download the url to the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::download ( const std::string &url, const std::string &file, int priority, unsigned int timeoutMilliSeconds, Unknown *caller )
+{
+  Buffer data;
+  FetchEngine::download ( url, data, priority, timeoutMilliSeconds, caller );
+
+  // Write next to the file and move it into place when it's complete, so 
+  // other processes sharing the cache never read part of a tile.
+  const std::string temporary ( Minerva::Network::temporaryFile ( file ) );
+
+  // Open file.
+  std::ofstream stream ( temporary.c_str(), std::ofstream::binary | std::ofstream::out );
+  if ( false == stream.is_open() )
+  {
+    throw std::runtime_error ( "Error 636035199: Failed to open file '" + temporary + "' for writing" );
+  }
+
+  // This will remove the file is there's an exception.
+  Usul::Scope::RemoveFile removeFile ( temporary );
+
+  if ( false == data.empty() )
+  {
+    stream.write ( &data[0], static_cast<std::streamsize> ( data.size() ) );
+  }
+  stream.close();
+
+  if ( true == stream.fail() )
+  {
+    throw std::runtime_error ( "Error 325305051: Failed to write file '" + temporary + "'" );
+  }
+
+  Minerva::Network::renameTemporaryFile ( temporary, file );
+
+  // Nothing to remove now.
+  removeFile.remove ( false );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Download the url into memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::download ( const std::string &url, Buffer &data, int priority, unsigned int timeoutMilliSeconds, Unknown *caller )
+{
+  FetchEngine &engine ( FetchEngine::instance() );
+  Request::RefPtr request ( engine.fetch ( url, priority, timeoutMilliSeconds ) );
+
+  // Wait for the transfer, checking now and then if the caller gave up.
+  Usul::Interfaces::ICanceledStateGet::QueryPtr canceledState ( caller );
+  while ( false == request->wait ( 50 ) )
+  {
+    if ( ( true == canceledState.valid() ) && ( true == canceledState->canceled() ) )
+    {
+      engine.cancel ( request );
+
+      Usul::Interfaces::ICancel::QueryPtr cancelJob ( caller );
+      if ( true == cancelJob.valid() )
+      {
+        cancelJob->cancel();
+      }
+
+      throw Usul::Exceptions::Canceled ( "Message 875832253: Download canceled, URL = " + url );
+    }
+  }
+
+  switch ( request->status() )
+  {
+    case SUCCEEDED:
+      break;
+    case TIMED_OUT:
+      throw Usul::Exceptions::TimedOut::NetworkDownload ( Usul::Strings::format ( "Error 648171314: ", request->error(), ", URL = ", url ) );
+    default:
+      throw std::runtime_error ( Usul::Strings::format ( "Error 284570223: ", request->error(), ", URL = ", url ) );
+  }
+
+  // The request may be shared, so copy the bytes.
+  data = request->data();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_run()
+{
+  while ( true )
+  {
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+
+      // Sleep until there is something to do.
+      while ( ( false == _stopped ) && ( true == _running.empty() ) && ( true == _queue.empty() ) && ( true == _aborts.empty() ) )
+      {
+        _wakeCondition.wait ( lock );
+      }
+
+      if ( true == _stopped )
+        return;
+    }
+
+    Usul::Functions::safeCall ( boost::bind ( &FetchEngine::_abort, this ), "357305164" );
+    Usul::Functions::safeCall ( boost::bind ( &FetchEngine::_start, this ), "1029648783" );
+
+    int numRunning ( 0 );
+    ::curl_multi_perform ( _multi, &numRunning );
+
+    Usul::Functions::safeCall ( boost::bind ( &FetchEngine::_processMessages, this ), "601817932" );
+
+    // Wait for activity on the sockets. The timeout keeps the queue moving.
+    int numFds ( 0 );
+    ::curl_multi_wait ( _multi, 0x0, 0, 10, &numFds );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start queued requests while there is room. Called by the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_start()
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+
+  Queue::iterator i ( _queue.begin() );
+  while ( ( _queue.end() != i ) && ( _running.size() < _maxTotal ) )
+  {
+    Request::RefPtr request ( i->second );
+
+    // Leave it in the queue if the host is busy.
+    unsigned int &count ( _hostCounts[request->_host] );
+    if ( count >= _maxPerHost )
+    {
+      ++i;
+      continue;
+    }
+
+    _queue.erase ( i++ );
+
+    // Reuse a handle if we can.
+    ::CURL *handle ( 0x0 );
+    if ( false == _idleHandles.empty() )
+    {
+      handle = _idleHandles.back();
+      _idleHandles.pop_back();
+    }
+    else
+    {
+      handle = ::curl_easy_init();
+    }
+
+    if ( 0x0 == handle )
+    {
+      this->_removeInFlight ( request );
+      request->_finish ( FAILED, 0, "Failed to open curl easy handle" );
+      continue;
+    }
+
+    ::curl_easy_setopt ( handle, CURLOPT_URL, request->_url.c_str() );
+    ::curl_easy_setopt ( handle, CURLOPT_WRITEDATA, request.get() );
+    ::curl_easy_setopt ( handle, CURLOPT_WRITEFUNCTION, &FetchEngine::_writeDataCB );
+    ::curl_easy_setopt ( handle, CURLOPT_NOSIGNAL, 1L );
+    ::curl_easy_setopt ( handle, CURLOPT_FOLLOWLOCATION, 1L );
+    ::curl_easy_setopt ( handle, CURLOPT_FAILONERROR, 1L );
+    if ( request->_timeout > 0 )
+      ::curl_easy_setopt ( handle, CURLOPT_TIMEOUT_MS, static_cast<long> ( request->_timeout ) );
+
+    {
+      boost::mutex::scoped_lock doneLock ( request->_doneMutex );
+      request->_status = RUNNING;
+    }
+
+    request->_handle = handle;
+    _running[handle] = request;
+    ++count;
+    ++_statistics.transfers;
+
+    ::curl_multi_add_handle ( _multi, handle );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop transfers nobody wants anymore. Called by the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_abort()
+{
+  Requests aborts;
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    aborts.swap ( _aborts );
+  }
+
+  for ( Requests::iterator i = aborts.begin(); i != aborts.end(); ++i )
+  {
+    Request::RefPtr request ( *i );
+
+    // It may have finished since it was canceled.
+    if ( true == request->isDone() )
+      continue;
+
+    if ( 0x0 != request->_handle )
+    {
+      this->_recycle ( request );
+    }
+    request->_finish ( CANCELED, 0, "Request canceled" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Handle the finished transfers. Called by the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_processMessages()
+{
+  int numLeft ( 0 );
+  ::CURLMsg *message ( 0x0 );
+  while ( 0x0 != ( message = ::curl_multi_info_read ( _multi, &numLeft ) ) )
+  {
+    if ( CURLMSG_DONE == message->msg )
+    {
+      this->_finish ( message->easy_handle, message->data.result );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Finish the transfer. Called by the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_finish ( ::CURL *handle, int code )
+{
+  Request::RefPtr request ( 0x0 );
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    Running::iterator i ( _running.find ( handle ) );
+    if ( _running.end() == i )
+      return;
+    request = i->second;
+  }
+
+  long responseCode ( 0 );
+  ::curl_easy_getinfo ( handle, CURLINFO_RESPONSE_CODE, &responseCode );
+
+  this->_recycle ( request );
+
+  Status status ( SUCCEEDED );
+  std::string error;
+  if ( CURLE_OK != code )
+  {
+    status = ( ( CURLE_OPERATION_TIMEDOUT == code ) ? TIMED_OUT : FAILED );
+    error = ( ( CURLE_HTTP_RETURNED_ERROR == code ) ?
+      Usul::Strings::format ( "HTTP response code ", responseCode ) :
+      std::string ( ::curl_easy_strerror ( static_cast< ::CURLcode > ( code ) ) ) );
+  }
+
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    this->_removeInFlight ( request );
+
+    if ( SUCCEEDED == status )
+    {
+      ++_statistics.succeeded;
+      _statistics.bytes += request->_data.size();
+    }
+    else
+    {
+      ++_statistics.failed;
+    }
+  }
+
+  request->_finish ( status, responseCode, error );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take the request's handle out of the multi handle and keep it for the
+//  next transfer. Called by the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_recycle ( Request::RefPtr request )
+{
+  ::CURL *handle ( request->_handle );
+  request->_handle = 0x0;
+
+  ::curl_multi_remove_handle ( _multi, handle );
+  ::curl_easy_reset ( handle );
+
+  boost::mutex::scoped_lock lock ( _mutex );
+
+  _running.erase ( handle );
+
+  HostCounts::iterator i ( _hostCounts.find ( request->_host ) );
+  if ( _hostCounts.end() != i )
+  {
+    if ( i->second > 1 )
+      --i->second;
+    else
+      _hostCounts.erase ( i );
+  }
+
+  if ( _idleHandles.size() < _maxTotal )
+    _idleHandles.push_back ( handle );
+  else
+    ::curl_easy_cleanup ( handle );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the request from the in-flight map. Call with the mutex locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::_removeInFlight ( Request::RefPtr request )
+{
+  InFlight::iterator i ( _inFlight.find ( request->url() ) );
+  if ( ( _inFlight.end() != i ) && ( i->second.get() == request.get() ) )
+    _inFlight.erase ( i );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called during a transfer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+size_t FetchEngine::_writeDataCB ( void *buffer, size_t sizeOfOne, size_t numElements, void *userData )
+{
+  Request *request ( reinterpret_cast<Request *> ( userData ) );
+  if ( 0x0 == request )
+    return 0;
+
+  const size_t totalBytes ( sizeOfOne * numElements );
+  const char *bytes ( reinterpret_cast<const char *> ( buffer ) );
+  request->_data.insert ( request->_data.end(), bytes, bytes + totalBytes );
+  return totalBytes;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the maximum number of transfers to one host.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::maxTransfersPerHost ( unsigned int value )
+{
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    _maxPerHost = ( ( value > 0 ) ? value : 1 );
+  }
+  _wakeCondition.notify_one();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the maximum number of transfers to one host.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int FetchEngine::maxTransfersPerHost() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return _maxPerHost;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the maximum number of transfers.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FetchEngine::maxTransfers ( unsigned int value )
+{
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    _maxTotal = ( ( value > 0 ) ? value : 1 );
+  }
+  _wakeCondition.notify_one();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the maximum number of transfers.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int FetchEngine::maxTransfers() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return _maxTotal;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of queued requests.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int FetchEngine::numQueued() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return static_cast<unsigned int> ( _queue.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of running requests.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int FetchEngine::numRunning() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return static_cast<unsigned int> ( _running.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the counters.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+FetchEngine::Statistics FetchEngine::statistics() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return _statistics;
+}
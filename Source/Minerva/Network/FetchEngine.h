@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Shared asynchronous download engine built on a curl multi handle.
+//
+//  All transfers run on one worker thread, so connections to a server are
+//  kept alive and reused between requests. Requests for a url that is
+//  already queued or downloading share the one transfer. Queued requests
+//  are started in priority order (lower numbers first), subject to a limit
+//  on the number of transfers per host and in total.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_NETWORK_FETCH_ENGINE_H__
+#define __MINERVA_NETWORK_FETCH_ENGINE_H__
+
+#include "Minerva/Network/Export.h"
+
+#include "Usul/Base/Referenced.h"
+#include "Usul/Interfaces/IUnknown.h"
+#include "Usul/Pointers/Pointers.h"
+#include "Usul/Types/Types.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+typedef void CURL;
+typedef void CURLM;
+
+namespace boost { class thread; }
+
+namespace Minerva {
+namespace Network {
+
+
+class MINERVA_NETWORK_EXPORT FetchEngine : public boost::noncopyable
+{
+public:
+
+  // Typedefs.
+  typedef Usul::Types::Uint64 Uint64;
+  typedef std::vector<char> Buffer;
+  typedef Usul::Interfaces::IUnknown Unknown;
+
+  enum Status
+  {
+    PENDING,
+    RUNNING,
+    SUCCEEDED,
+    FAILED,
+    TIMED_OUT,
+    CANCELED
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  A request for a url. It is shared by everyone that asked for the url
+  //  while it was in flight.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  class MINERVA_NETWORK_EXPORT Request : public Usul::Base::Referenced
+  {
+  public:
+
+    typedef Usul::Base::Referenced BaseClass;
+
+    USUL_DECLARE_REF_POINTERS ( Request );
+
+    /// Get the url.
+    const std::string&    url() const;
+
+    /// Get the status.
+    Status                status() const;
+
+    /// Is the request finished (successfully or not)?
+    bool                  isDone() const;
+
+    /// Wait for the request to finish. Returns false if it timed out.
+    bool                  wait ( unsigned int milliSeconds );
+
+    /// Get the downloaded bytes. Only valid once the request is done.
+    const Buffer&         data() const;
+
+    /// Get the error message.
+    std::string           error() const;
+
+    /// Get the http response code.
+    long                  responseCode() const;
+
+  protected:
+
+    virtual ~Request();
+
+  private:
+
+    friend class FetchEngine;
+
+    Request ( const std::string& url, const std::string& host, int priority, unsigned int timeout, Uint64 sequence );
+
+    void                  _finish ( Status status, long responseCode, const std::string& error );
+
+    const std::string _url;
+    const std::string _host;
+    const unsigned int _timeout;
+    const Uint64 _sequence;
+    int _priority;
+    unsigned int _numWaiters;
+    ::CURL *_handle;
+    Buffer _data;
+    Status _status;
+    long _responseCode;
+    std::string _error;
+    mutable boost::mutex _doneMutex;
+    boost::condition_variable _doneCondition;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Counters.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  struct Statistics
+  {
+    Statistics() : requests ( 0 ), shared ( 0 ), transfers ( 0 ), succeeded ( 0 ), failed ( 0 ), canceled ( 0 ), bytes ( 0 ) {}
+
+    Uint64 requests;
+    Uint64 shared;
+    Uint64 transfers;
+    Uint64 succeeded;
+    Uint64 failed;
+    Uint64 canceled;
+    Uint64 bytes;
+  };
+
+  /// Get the instance.
+  static FetchEngine&     instance();
+
+  /// Destroy the instance. Transfers in progress are canceled.
+  static void             destroy();
+
+  /// Request the url. If it is already in flight the existing request is
+  /// shared and its priority raised if the new one is more urgent.
+  Request::RefPtr         fetch ( const std::string& url, int priority, unsigned int timeoutMilliSeconds );
+
+  /// Give up on the request. The transfer stops when nobody else wants it.
+  void                    cancel ( Request::RefPtr request );
+
+  /// Download the url to the file. Blocks until the transfer is finished.
+  /// Throws if the caller is canceled while waiting, or if the download fails.
+  static void             download ( const std::string& url, const std::string& file, int priority, unsigned int timeoutMilliSeconds, Unknown *caller = 0x0 );
+
+  /// Download the url into memory. Blocks and throws like the file version.
+  static void             download ( const std::string& url, Buffer& data, int priority, unsigned int timeoutMilliSeconds, Unknown *caller = 0x0 );
+
+  /// Set/get the maximum number of transfers to one host.
+  void                    maxTransfersPerHost ( unsigned int );
+  unsigned int            maxTransfersPerHost() const;
+
+  /// Set/get the maximum number of transfers.
+  void                    maxTransfers ( unsigned int );
+  unsigned int            maxTransfers() const;
+
+  /// Get the number of queued and running requests.
+  unsigned int            numQueued() const;
+  unsigned int            numRunning() const;
+
+  /// Get the counters.
+  Statistics              statistics() const;
+
+  /// Get the host part of the url.
+  static std::string      host ( const std::string& url );
+
+private:
+
+  typedef std::pair<int,Uint64> QueueKey;
+  typedef std::map<QueueKey,Request::RefPtr> Queue;
+  typedef std::map<std::string,Request::RefPtr> InFlight;
+  typedef std::map<std::string,unsigned int> HostCounts;
+  typedef std::map< ::CURL*,Request::RefPtr> Running;
+  typedef std::vector<Request::RefPtr> Requests;
+  typedef std::vector< ::CURL*> Handles;
+
+  FetchEngine();
+  ~FetchEngine();
+
+  void                    _abort();
+  void                    _finish ( ::CURL *handle, int code );
+  void                    _processMessages();
+  void                    _recycle ( Request::RefPtr request );
+  void                    _removeInFlight ( Request::RefPtr request );
+  void                    _run();
+  void                    _start();
+  void                    _stop();
+
+  static size_t           _writeDataCB ( void *buffer, size_t sizeOfOne, size_t numElements, void *userData );
+
+  static FetchEngine *_instance;
+
+  mutable boost::mutex _mutex;
+  boost::condition_variable _wakeCondition;
+  ::CURLM *_multi;
+  boost::thread *_thread;
+  bool _stopped;
+  Queue _queue;
+  InFlight _inFlight;
+  HostCounts _hostCounts;
+  Running _running;
+  Requests _aborts;
+  Handles _idleHandles;
+  unsigned int _maxPerHost;
+  unsigned int _maxTotal;
+  Uint64 _sequence;
+  Statistics _statistics;
+};
+
+
+} // namespace Network
+} // namespace Minerva
+
+
+#endif // __MINERVA_NETWORK_FETCH_ENGINE_H__
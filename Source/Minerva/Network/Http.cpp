@@ -15,6 +15,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Network/Http.h"
+#include "Minerva/Network/Download.h"
 
 #include "Usul/Exceptions/Canceled.h"
 #include "Usul/Exceptions/TimedOut.h"
@@ -192,20 +193,27 @@ void Http::post ( unsigned int timeoutMilliSeconds, const std::string& post )
 
 void Http::download ( const std::string &url, const std::string &file, unsigned int timeoutMilliSeconds, Unknown *caller )
 {
-  // Open file.
-  std::ofstream stream ( file.c_str(), std::ofstream::binary | std::ofstream::out );
-  if ( false == stream.is_open() )
+  // Write next to the file and move it into place when it's complete.
+  const std::string temporary ( Minerva::Network::temporaryFile ( file ) );
+
+  // This will remove the file is there's an exception.
+  Usul::Scope::RemoveFile removeFile ( temporary );
+
   {
-    throw std::runtime_error ( "Error 2742979881: Failed to open file '" + file + "' for writing" );
+    // Open file.
+    std::ofstream stream ( temporary.c_str(), std::ofstream::binary | std::ofstream::out );
+    if ( false == stream.is_open() )
+    {
+      throw std::runtime_error ( "Error 2742979881: Failed to open file '" + temporary + "' for writing" );
+    }
+
+    Http http ( url, &stream, caller );
+    http.download( timeoutMilliSeconds );
   }
- 
-  // This will remove the file is there's an exception.
-  Usul::Scope::RemoveFile removeFile ( file );
-  
-  Http http ( url, &stream, caller );
-  http.download( timeoutMilliSeconds );
-  
-  // Keep the file.
+
+  Minerva::Network::renameTemporaryFile ( temporary, file );
+
+  // Nothing to remove now.
   removeFile.remove ( false );
 }
 
@@ -40,3 +40,15 @@ OffScreenRenderer::OffScreenRenderer() : BaseClass()
 OffScreenRenderer::~OffScreenRenderer()
 {
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Cull the scene. Renderers that can't cull on their own draw a frame.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OffScreenRenderer::cull() const
+{
+  this->render();
+}
@@ -44,6 +44,9 @@ public:
   // Render.
   virtual ImagePtr render() const = 0;
 
+  // Update and cull the scene without drawing it. Renders by default.
+  virtual void cull() const;
+
   // Set the view matrix.
   virtual void viewMatrix ( const Usul::Math::Matrix44d& matrix ) = 0;
 
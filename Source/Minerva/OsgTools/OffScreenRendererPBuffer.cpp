@@ -23,6 +23,9 @@
 #include "osg/Texture2D"
 #include "osg/Multisample"
 
+#include "osgUtil/SceneView"
+#include "osgViewer/Renderer"
+
 #include <iostream>
 
 using namespace Minerva::OsgTools;
@@ -36,7 +39,8 @@ using namespace Minerva::OsgTools;
 
 OffScreenRendererPBuffer::OffScreenRendererPBuffer ( unsigned int width, unsigned int height ) : BaseClass(),
   _viewer ( new osgViewer::Viewer ),
-  _image ( 0x0 )
+  _image ( 0x0 ),
+  _rendered ( false )
 {
   _viewer->setThreadingModel ( osgViewer::Viewer::SingleThreaded );
   _viewer->setCameraManipulator ( 0x0 );
@@ -189,11 +193,49 @@ OffScreenRendererPBuffer::ImagePtr OffScreenRendererPBuffer::render() const
 
   // Render the frame.
   _viewer->frame();
+  _rendered = true;
 
   return ImagePtr ( reinterpret_cast<osg::Image*> ( _image->clone ( osg::CopyOp::DEEP_COPY_ALL ) ) );
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Update and cull the scene, so the tiles ask for what they need, without 
+//  drawing or reading the pixels back. The viewer sets itself up in its 
+//  first frame, so that one is rendered.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OffScreenRendererPBuffer::cull() const
+{
+  USUL_ASSERT ( _viewer.valid() );
+
+  if ( false == _rendered )
+  {
+    this->render();
+    return;
+  }
+
+  _viewer->advance();
+  _viewer->eventTraversal();
+  _viewer->updateTraversal();
+
+  // The single threaded viewer culls and draws with the first scene view.
+  osgViewer::ViewerBase::Cameras cameras;
+  _viewer->getCameras ( cameras );
+  for ( osgViewer::ViewerBase::Cameras::iterator iter = cameras.begin(); iter != cameras.end(); ++iter )
+  {
+    osgViewer::Renderer *renderer ( dynamic_cast<osgViewer::Renderer*> ( (*iter)->getRenderer() ) );
+    osgUtil::SceneView *sceneView ( 0x0 != renderer ? renderer->getSceneView ( 0 ) : 0x0 );
+    if ( 0x0 != sceneView )
+    {
+      sceneView->cull();
+    }
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Set view matrix.
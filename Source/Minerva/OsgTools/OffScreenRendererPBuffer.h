@@ -44,6 +44,9 @@ public:
   // Render.
   virtual ImagePtr       render() const;
 
+  // Update and cull the scene without drawing it.
+  virtual void           cull() const;
+
   // Set the view matrix.
   virtual void           viewMatrix ( const Usul::Math::Matrix44d& matrix );
 
@@ -58,6 +61,7 @@ private:
 
   osg::ref_ptr<osgViewer::Viewer> _viewer;
   osg::ref_ptr<osg::Image> _image;
+  mutable bool _rendered;
 };
 
 
@@ -0,0 +1,402 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Writes tiles to the disk cache in a background thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/GDAL/CacheWriter.h"
+#include "Minerva/Plugins/GDAL/Common.h"
+
+#include "Minerva/Core/DiskCache.h"
+
+#include "Usul/Functions/SafeCall.h"
+#include "Usul/Registry/Database.h"
+#include "Usul/Strings/Format.h"
+
+#include "boost/bind.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "cpl_vsi.h"
+#include "gdal_priv.h"
+
+#include <vector>
+
+using namespace Minerva::Layers::GDAL;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Initialize static data members.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CacheWriter* CacheWriter::_instance ( 0x0 );
+
+// Qualified where it's used, since Common.h has a Minerva::Detail too.
+namespace Detail { boost::mutex instanceMutex; }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CacheWriter& CacheWriter::instance()
+{
+  // The first call is likely from a job thread.
+  boost::mutex::scoped_lock lock ( ::Detail::instanceMutex );
+
+  if ( 0x0 == _instance )
+    _instance = new CacheWriter;
+
+  return *_instance;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destroy the instance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::destroy()
+{
+  CacheWriter *writer ( 0x0 );
+  {
+    boost::mutex::scoped_lock lock ( ::Detail::instanceMutex );
+    writer = _instance;
+    _instance = 0x0;
+  }
+
+  // The queued tiles are written before this returns.
+  delete writer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CacheWriter::Request::Request() : 
+  tile ( 0x0 ),
+  filename(),
+  compression(),
+  layerKey ( 0x0 ),
+  tileKey ( 0x0 ),
+  width ( 0 ),
+  height ( 0 ),
+  extension()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CacheWriter::CacheWriter() :
+  _mutex(),
+  _wakeCondition(),
+  _idleCondition(),
+  _thread ( 0x0 ),
+  _stopped ( false ),
+  _writing ( false ),
+  _queue(),
+  _maxQueued ( Usul::Registry::Database::instance()["disk_cache"]["writer"]["max_queued"].get<unsigned int> ( 64, true ) )
+{
+  _thread = new boost::thread ( boost::bind ( &CacheWriter::_run, this ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CacheWriter::~CacheWriter()
+{
+  Usul::Functions::safeCall ( boost::bind ( &CacheWriter::_stop, this ), "1749230580" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write what is queued, then stop the thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::_stop()
+{
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    _stopped = true;
+  }
+  _wakeCondition.notify_all();
+
+  if ( 0x0 != _thread )
+  {
+    _thread->join();
+    delete _thread;
+    _thread = 0x0;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Queue the tile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool CacheWriter::add ( const Request& request )
+{
+  const bool useStore ( request.layerKey.valid() && request.tileKey.valid() );
+  if ( false == request.tile.valid() || ( true == request.filename.empty() && false == useStore ) )
+    return false;
+
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    if ( true == _stopped || _queue.size() >= _maxQueued )
+      return false;
+
+    _queue.push_back ( request );
+  }
+
+  _wakeCondition.notify_one();
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the maximum number of queued tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::maxQueued ( unsigned int value )
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  _maxQueued = value;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the maximum number of queued tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int CacheWriter::maxQueued() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return _maxQueued;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of tiles waiting to be written.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int CacheWriter::numQueued() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return static_cast<unsigned int> ( _queue.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait until all the queued tiles are written.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::wait()
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  while ( ( false == _queue.empty() ) || ( true == _writing ) )
+  {
+    _idleCondition.wait ( lock );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The writer thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::_run()
+{
+  while ( true )
+  {
+    Request request;
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+      _writing = false;
+
+      while ( ( false == _stopped ) && ( true == _queue.empty() ) )
+      {
+        _idleCondition.notify_all();
+        _wakeCondition.wait ( lock );
+      }
+
+      // Stop once everything is written.
+      if ( true == _queue.empty() )
+      {
+        _idleCondition.notify_all();
+        return;
+      }
+
+      request = _queue.front();
+      _queue.pop_front();
+      _writing = true;
+    }
+
+    Usul::Functions::safeCall ( boost::bind ( &CacheWriter::_write, boost::cref ( request ) ), "3480915067" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the tile to its file, or into the tile store if there is one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void CacheWriter::_write ( const Request& request )
+{
+  Minerva::Core::DiskCache& cache ( Minerva::Core::DiskCache::instance() );
+  const bool useStore ( cache.tileStore().valid() && request.layerKey.valid() && request.tileKey.valid() );
+
+  if ( false == useStore )
+  {
+    CacheWriter::write ( request.tile->dataset(), request.filename, request.compression );
+    return;
+  }
+
+  Buffer buffer;
+  if ( true == CacheWriter::encode ( request.tile->dataset(), request.compression, buffer ) )
+  {
+    cache.storeTile ( *request.layerKey, *request.tileKey, request.width, request.height, request.extension, buffer );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the data set as a GeoTIFF under a temporary name, then rename it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool CacheWriter::write ( GDALDataset *data, const std::string& filename, const std::string& compression )
+{
+  if ( 0x0 == data || true == filename.empty() )
+    return false;
+
+  const std::string compress ( Usul::Strings::format ( "COMPRESS=", compression ) );
+  std::vector<char*> options;
+  if ( false == compression.empty() )
+    options.push_back ( const_cast<char*> ( compress.c_str() ) );
+  options.push_back ( 0x0 );
+
+  // Unique, so processes sharing the cache don't write the same file.
+  const std::string temp ( boost::filesystem::unique_path ( filename + ".%%%%-%%%%-%%%%.partial" ).string() );
+
+  {
+    // Writing and closing use GDAL's global state.
+    SCOPED_GDAL_LOCK;
+
+    GDALDriver *driver ( GetGDALDriverManager()->GetDriverByName ( "GTiff" ) );
+    if ( 0x0 == driver )
+      return false;
+
+    GDALDataset *file ( driver->CreateCopy ( temp.c_str(), data, FALSE, &options[0], NULL, NULL ) );
+    if ( 0x0 == file )
+    {
+      boost::system::error_code ec;
+      boost::filesystem::remove ( temp, ec );
+      return false;
+    }
+
+    // Close the dataset to finish writing to the file.
+    ::GDALClose ( static_cast<GDALDatasetH> ( file ) );
+  }
+
+  // Renaming is atomic, so the file is either all there or not there.
+  boost::system::error_code ec;
+  boost::filesystem::rename ( temp, filename, ec );
+  if ( ec )
+  {
+    boost::filesystem::remove ( temp, ec );
+    return false;
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Encode the data set as a GeoTIFF in GDAL's in-memory file system.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool CacheWriter::encode ( GDALDataset *data, const std::string& compression, Buffer& buffer )
+{
+  if ( 0x0 == data )
+    return false;
+
+  const std::string compress ( Usul::Strings::format ( "COMPRESS=", compression ) );
+  std::vector<char*> options;
+  if ( false == compression.empty() )
+    options.push_back ( const_cast<char*> ( compress.c_str() ) );
+  options.push_back ( 0x0 );
+
+  // Unique, since writes from other threads share the in-memory file system.
+  const std::string name ( Usul::Strings::format ( "/vsimem/", boost::filesystem::unique_path ( "tile-%%%%-%%%%-%%%%-%%%%.tif" ).string() ) );
+
+  // Writing, closing, and reading the memory use GDAL's global state.
+  SCOPED_GDAL_LOCK;
+
+  GDALDriver *driver ( GetGDALDriverManager()->GetDriverByName ( "GTiff" ) );
+  if ( 0x0 == driver )
+    return false;
+
+  GDALDataset *file ( driver->CreateCopy ( name.c_str(), data, FALSE, &options[0], NULL, NULL ) );
+  if ( 0x0 == file )
+  {
+    ::VSIUnlink ( name.c_str() );
+    return false;
+  }
+
+  // Close the dataset to finish writing.
+  ::GDALClose ( static_cast<GDALDatasetH> ( file ) );
+
+  vsi_l_offset size ( 0 );
+  const GByte *bytes ( ::VSIGetMemFileBuffer ( name.c_str(), &size, FALSE ) );
+  if ( 0x0 != bytes && size > 0 )
+  {
+    buffer.assign ( reinterpret_cast<const char*> ( bytes ), reinterpret_cast<const char*> ( bytes ) + size );
+  }
+
+  ::VSIUnlink ( name.c_str() );
+  return ( false == buffer.empty() );
+}
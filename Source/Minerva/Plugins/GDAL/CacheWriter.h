@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Writes tiles to the disk cache in a background thread, so tiles can be 
+//  shown as soon as they are made. The queue is bounded; when it is full 
+//  the tile is not cached. Files are written under a temporary name and 
+//  renamed when done, so a partly written file is never seen as a cache hit.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _MINERVA_GDAL_CACHE_WRITER_H_
+#define _MINERVA_GDAL_CACHE_WRITER_H_
+
+#include "Minerva/Plugins/GDAL/Export.h"
+#include "Minerva/Plugins/GDAL/Dataset.h"
+
+#include "Minerva/Common/LayerKey.h"
+#include "Minerva/Common/TileKey.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace boost { class thread; }
+
+class GDALDataset;
+
+namespace Minerva {
+namespace Layers {
+namespace GDAL {
+
+
+class MINERVA_GDAL_EXPORT CacheWriter : public boost::noncopyable
+{
+public:
+
+  typedef Minerva::Common::LayerKey LayerKey;
+  typedef Minerva::Common::TileKey TileKey;
+  typedef std::vector<char> Buffer;
+
+  struct Request
+  {
+    Request();
+
+    Dataset::RefPtr tile;
+    std::string filename;
+    std::string compression;
+
+    // Used to write into the tile store, if there is one. The filename is 
+    // empty then.
+    LayerKey::RefPtr layerKey;
+    TileKey::RefPtr tileKey;
+    unsigned int width;
+    unsigned int height;
+    std::string extension;
+  };
+
+  /// Get the instance.
+  static CacheWriter&     instance();
+
+  /// Destroy the instance. Queued tiles are written first. This is called 
+  /// by usul_plugin_finalize when the plugin manager releases the library.
+  static void             destroy();
+
+  /// Queue the tile. Returns false if the queue is full.
+  bool                    add ( const Request& );
+
+  /// Set/get the maximum number of queued tiles.
+  void                    maxQueued ( unsigned int );
+  unsigned int            maxQueued() const;
+
+  /// Get the number of tiles waiting to be written.
+  unsigned int            numQueued() const;
+
+  /// Wait until all the queued tiles are written.
+  void                    wait();
+
+  /// Write the data set as a GeoTIFF. It is written to a temporary file 
+  /// in the same directory and then renamed. The compression is a GDAL 
+  /// GTiff option like "DEFLATE" or "LZW"; empty for none.
+  static bool             write ( GDALDataset *data, const std::string& filename, const std::string& compression );
+
+  /// Encode the data set as a GeoTIFF in memory.
+  static bool             encode ( GDALDataset *data, const std::string& compression, Buffer& buffer );
+
+private:
+
+  typedef std::deque<Request> Queue;
+
+  CacheWriter();
+  ~CacheWriter();
+
+  void                    _run();
+  void                    _stop();
+  static void             _write ( const Request& );
+
+  static CacheWriter *_instance;
+
+  mutable boost::mutex _mutex;
+  boost::condition_variable _wakeCondition;
+  boost::condition_variable _idleCondition;
+  boost::thread *_thread;
+  bool _stopped;
+  bool _writing;
+  Queue _queue;
+  unsigned int _maxQueued;
+};
+
+
+} // namespace GDAL
+} // namespace Layers
+} // namespace Minerva
+
+
+#endif // _MINERVA_GDAL_CACHE_WRITER_H_
@@ -14,6 +14,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Plugins/GDAL/Dataset.h"
+#include "Minerva/Plugins/GDAL/Common.h"
 #include "Minerva/Plugins/GDAL/Convert.h"
 #include "Minerva/Core/ElevationData.h"
 
@@ -55,6 +56,9 @@ Dataset::Dataset ( GDALDataset * data ) : BaseClass(),
 Dataset::Dataset ( const std::string& filename, const Extents& extents, unsigned int width, unsigned int height, int bands, unsigned int type ) : BaseClass(),
   _data ( 0x0 )
 {
+  // Creating touches GDAL's global state.
+  SCOPED_GDAL_LOCK;
+
   // Make an in memory raster.
   const std::string format ( "MEM" );
 
@@ -115,6 +119,8 @@ Dataset::~Dataset()
 
 void Dataset::close()
 {
+  SCOPED_GDAL_LOCK;
+
   if ( 0x0 != _data )
     ::GDALClose ( _data );
 
@@ -0,0 +1,289 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pool of open handles to the same raster file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/GDAL/DatasetPool.h"
+#include "Minerva/Plugins/GDAL/Common.h"
+
+#include "Usul/Math/MinMax.h"
+#include "Usul/Strings/Format.h"
+
+#include "boost/thread/thread.hpp"
+
+#include "gdal_priv.h"
+#include "gdalwarper.h"
+#include "ogr_spatialref.h"
+
+#include <stdexcept>
+
+using namespace Minerva::Layers::GDAL;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::DatasetPool ( const std::string& filename, unsigned int maxHandles ) : BaseClass(),
+  _filename ( filename ),
+  _maxHandles ( Usul::Math::maximum ( 1u, ( 0 == maxHandles ) ? boost::thread::hardware_concurrency() : maxHandles ) ),
+  _numOpen ( 0 ),
+  _available(),
+  _mutex(),
+  _availableCondition()
+{
+  // Open the first one now so that a bad file is found right away.
+  Entry entry ( DatasetPool::_open ( _filename ) );
+  if ( 0x0 == entry.first )
+    throw std::runtime_error ( Usul::Strings::format ( "Error 2218406513: Could not open file: ", _filename ) );
+
+  _available.push_back ( entry );
+  _numOpen = 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::~DatasetPool()
+{
+  // No handles are borrowed because they hold a reference to us.
+  for ( Entries::iterator iter = _available.begin(); iter != _available.end(); ++iter )
+  {
+    DatasetPool::_close ( *iter );
+  }
+  _available.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Open the file, and warp it if it's not geographic.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::Entry DatasetPool::_open ( const std::string& filename )
+{
+  // Opening touches GDAL's global state.
+  SCOPED_GDAL_LOCK;
+
+  Entry entry ( static_cast<GDALDataset*> ( ::GDALOpen ( filename.c_str(), GA_ReadOnly ) ), 0x0 );
+  GDALDataset *data ( entry.first );
+  if ( 0x0 == data )
+    return entry;
+
+  const char* projection ( data->GetProjectionRef() );
+  OGRSpatialReference src ( projection );
+
+  if ( false == src.IsGeographic() )
+  {
+    OGRSpatialReference dst;
+    dst.SetWellKnownGeogCS ( "WGS84" );
+
+    char *dstProjection ( 0x0 );
+    dst.exportToWkt ( &dstProjection );
+
+    entry.second = static_cast<GDALDataset*> ( ::GDALAutoCreateWarpedVRT (
+                    data,
+                    projection,
+                    dstProjection,
+                    /*GRA_NearestNeighbour*/ GRA_Bilinear,
+                    5.0,
+                    NULL ) );
+
+    ::CPLFree ( dstProjection );
+  }
+  else
+  {
+    entry.second = data;
+  }
+
+  return entry;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Close the handle.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DatasetPool::_close ( Entry& entry )
+{
+  SCOPED_GDAL_LOCK;
+
+  const bool same ( entry.second == entry.first );
+  if ( 0x0 != entry.second )
+    ::GDALClose ( entry.second );
+
+  if ( 0x0 != entry.first && !same )
+    ::GDALClose ( entry.first );
+
+  entry.first = 0x0;
+  entry.second = 0x0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Borrow a handle. Waits if they are all in use.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::Entry DatasetPool::_acquire()
+{
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+
+    while ( _available.empty() && _numOpen >= _maxHandles )
+    {
+      _availableCondition.wait ( lock );
+    }
+
+    if ( false == _available.empty() )
+    {
+      Entry entry ( _available.back() );
+      _available.pop_back();
+      return entry;
+    }
+
+    // Count it now so that other threads don't open too many.
+    ++_numOpen;
+  }
+
+  // Open a new one without holding the lock.
+  Entry entry ( DatasetPool::_open ( _filename ) );
+  if ( 0x0 == entry.second )
+  {
+    DatasetPool::_close ( entry );
+
+    boost::mutex::scoped_lock lock ( _mutex );
+    --_numOpen;
+    _availableCondition.notify_one();
+  }
+
+  return entry;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Give the handle back.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void DatasetPool::_release ( const Entry& entry )
+{
+  if ( 0x0 == entry.second )
+    return;
+
+  {
+    boost::mutex::scoped_lock lock ( _mutex );
+    _available.push_back ( entry );
+  }
+  _availableCondition.notify_one();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the file name.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+const std::string& DatasetPool::filename() const
+{
+  return _filename;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the maximum number of handles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int DatasetPool::maxHandles() const
+{
+  return _maxHandles;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of handles that are open.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int DatasetPool::numOpen() const
+{
+  boost::mutex::scoped_lock lock ( _mutex );
+  return _numOpen;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Borrow a handle.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::Handle::Handle ( DatasetPool& pool ) : 
+  _pool ( &pool ),
+  _original ( 0x0 ),
+  _warped ( 0x0 )
+{
+  const Entry entry ( _pool->_acquire() );
+  _original = entry.first;
+  _warped = entry.second;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Give the handle back.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+DatasetPool::Handle::~Handle()
+{
+  _pool->_release ( Entry ( _original, _warped ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the dataset in geographic coordinates.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GDALDataset* DatasetPool::Handle::dataset() const
+{
+  return _warped;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the dataset as it is in the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+GDALDataset* DatasetPool::Handle::original() const
+{
+  return _original;
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pool of open handles to the same raster file. A GDALDataset can only be 
+//  used by one thread at a time, so each thread borrows its own handle and 
+//  reads from it without locking. Handles are opened as needed, up to the 
+//  maximum, and are warped to geographic coordinates if the file isn't.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _MINERVA_GDAL_DATASET_POOL_H_
+#define _MINERVA_GDAL_DATASET_POOL_H_
+
+#include "Minerva/Plugins/GDAL/Export.h"
+
+#include "Usul/Base/Referenced.h"
+#include "Usul/Pointers/Pointers.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <string>
+#include <vector>
+
+class GDALDataset;
+
+namespace Minerva {
+namespace Layers {
+namespace GDAL {
+
+class MINERVA_GDAL_EXPORT DatasetPool : public Usul::Base::Referenced
+{
+public:
+
+  typedef Usul::Base::Referenced BaseClass;
+
+  USUL_DECLARE_REF_POINTERS ( DatasetPool );
+
+  // Open the first handle. Throws if the file can't be opened.
+  // A maximum of zero means one per hardware thread.
+  DatasetPool ( const std::string& filename, unsigned int maxHandles = 0 );
+
+  // A handle borrowed from the pool. It goes back when this is destroyed.
+  class MINERVA_GDAL_EXPORT Handle : public boost::noncopyable
+  {
+  public:
+
+    // Waits if all the handles are in use.
+    Handle ( DatasetPool& );
+    ~Handle();
+
+    // The dataset in geographic coordinates.
+    GDALDataset*        dataset() const;
+
+    // The dataset as it is in the file.
+    GDALDataset*        original() const;
+
+  private:
+
+    DatasetPool::RefPtr _pool;
+    GDALDataset *_original;
+    GDALDataset *_warped;
+  };
+
+  // Get the file name.
+  const std::string&    filename() const;
+
+  // Get the maximum number of handles.
+  unsigned int          maxHandles() const;
+
+  // Get the number of handles that are open.
+  unsigned int          numOpen() const;
+
+protected:
+
+  virtual ~DatasetPool();
+
+  typedef std::pair<GDALDataset*,GDALDataset*> Entry;
+  typedef std::vector<Entry> Entries;
+
+  Entry                 _acquire();
+  void                  _release ( const Entry& );
+
+  static void           _close ( Entry& );
+  static Entry          _open ( const std::string& filename );
+
+private:
+
+  const std::string _filename;
+  const unsigned int _maxHandles;
+  unsigned int _numOpen;
+  Entries _available;
+  mutable boost::mutex _mutex;
+  boost::condition_variable _availableCondition;
+};
+
+
+} // namespace GDAL
+} // namespace Layers
+} // namespace Minerva
+
+
+#endif // _MINERVA_GDAL_DATASET_POOL_H_
@@ -18,6 +18,8 @@
 #include "ogr_spatialref.h"
 #include "ogr_srs_api.h"
 
+#include <algorithm>
+
 using namespace Minerva::Layers::GDAL;
 
 
@@ -90,6 +92,44 @@ void FlatLandModel::xyzToLatLonHeight ( double x, double y, double z, double& la
   }
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n lat, lon, heights to x,y,z. The transformation takes arrays.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FlatLandModel::latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const
+{
+  std::copy ( lon, lon + n, x );
+  std::copy ( lat, lat + n, y );
+  std::copy ( elevation, elevation + n, z );
+
+  if ( _toSRStransform && n > 0 )
+  {
+    _toSRStransform->Transform ( n, x, y, z );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Convert n x,y,z to lat, lon, heights.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void FlatLandModel::xyzToLatLonHeight ( const double* x, const double* y, const double* z, double* lat, double* lon, double* elevation, unsigned int n ) const
+{
+  std::copy ( x, x + n, lon );
+  std::copy ( y, y + n, lat );
+  std::copy ( z, z + n, elevation );
+
+  if ( _fromSRStransform && n > 0 )
+  {
+    _fromSRStransform->Transform ( n, lon, lat, elevation );
+  }
+}
+
  
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -42,6 +42,10 @@ public:
   virtual void        latLonHeightToXYZ ( double lat, double lon, double elevation, double& x, double& y, double& z ) const;
   virtual void        xyzToLatLonHeight ( double x, double y, double z, double& lat, double& lon, double& elevation ) const;
 
+  // Convert n points at once with one call to the transformation.
+  virtual void        latLonHeightToXYZ ( const double* lat, const double* lon, const double* elevation, double* x, double* y, double* z, unsigned int n ) const;
+  virtual void        xyzToLatLonHeight ( const double* x, const double* y, const double* z, double* lat, double* lon, double* elevation, unsigned int n ) const;
+
   // Matrix to place items on the planet (i.e. local coordinates to world coordinates).
   virtual Matrix      planetRotationMatrix ( double lat, double lon, double elevation, double heading ) const;
 
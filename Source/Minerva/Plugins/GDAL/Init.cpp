@@ -9,6 +9,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Config.h"
+#include "Minerva/Plugins/GDAL/CacheWriter.h"
+#include "Minerva/Plugins/GDAL/Export.h"
 
 #include "Usul/CommandLine/Arguments.h"
 #include "Usul/System/Environment.h"
@@ -94,3 +96,17 @@ namespace
     
   } _init;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called by the plugin manager before the library is released. The cache 
+//  writer's thread is stopped here, because it can't be joined while the 
+//  library's static objects are destroyed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" MINERVA_GDAL_EXPORT void usul_plugin_finalize()
+{
+  Minerva::Layers::GDAL::CacheWriter::destroy();
+}
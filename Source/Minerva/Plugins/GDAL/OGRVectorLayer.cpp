@@ -68,6 +68,9 @@ OGRVectorLayer::OGRVectorLayer() : BaseClass(),
   this->_addMember ( "filename", _filename );
   this->_addMember ( "style", _defaultStyle );
   this->_addMember ( "verticalOffset", _verticalOffset );
+
+  // Files can have many thousands of lines and polygons with the same style.
+  this->batching ( true );
 }
 
 
@@ -31,6 +31,7 @@
 
 #include "boost/algorithm/string/erase.hpp"
 #include "boost/bind.hpp"
+#include "boost/functional/hash.hpp"
 
 #include "ogr_api.h"
 #include "ogr_geometry.h"
@@ -41,6 +42,7 @@
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <set>
 
 using namespace Minerva::Layers::GDAL;
 
@@ -66,7 +68,8 @@ PostGISLayer::PostGISLayer() : BaseClass(),
   _updating ( false ),
   _firstDateColumn(),
   _lastDateColumn(),
-  _style ( 0x0 )
+  _style ( 0x0 ),
+  _rowHashes()
 {
   this->_registerMembers();
   
@@ -92,7 +95,8 @@ PostGISLayer::PostGISLayer ( const PostGISLayer& layer )  :
   _updating ( false ),
   _firstDateColumn( layer._firstDateColumn ),
   _lastDateColumn( layer._lastDateColumn ),
-  _style ( layer._style )
+  _style ( layer._style ),
+  _rowHashes ( layer._rowHashes )
 {
   this->_registerMembers();
   
@@ -323,17 +327,11 @@ void PostGISLayer::buildVectorData()
     boost::bind ( &PostGISLayer::updating, this, true ),
     boost::bind ( &PostGISLayer::updating, this, false ) ) );
   
-  // Clear what we have.
-  this->clear();
-
-  // Build the data objects.
+  // Build the data objects. Only the rows that changed are touched.
   this->_buildDataObjects();
   
   // Our data is no longer dirty.
   this->dirtyData ( false );
-  
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
 }
 
 
@@ -345,16 +343,9 @@ void PostGISLayer::buildVectorData()
 
 void PostGISLayer::modifyVectorData()
 {
-  // For now clear what we have and then rebuild.
-  // Need a way to tell if the query has changed.  Then I think this can be handled better.
-  this->clear();
+  // The rows are compared with the ones we have, so only the data objects 
+  // of the rows that were added, removed or changed are touched.
   this->buildVectorData();
-  
-  // Our data is no longer dirty.
-  this->dirtyData ( false );
-  
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
 }
 
 
@@ -504,7 +495,40 @@ bool PostGISLayer::isUpdating() const
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Build the data objects.
+//  Hash the row's fields and geometry, and the settings used to make its 
+//  data object.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  std::size_t rowHash ( OGRFeature& feature, const std::string& settings )
+  {
+    std::size_t seed ( 0 );
+    boost::hash_combine ( seed, settings );
+
+    for ( int i = 0; i < feature.GetFieldCount(); ++i )
+    {
+      boost::hash_combine ( seed, std::string ( feature.GetFieldAsString ( i ) ) );
+    }
+
+    OGRGeometry *geometry ( feature.GetGeometryRef() );
+    if ( 0x0 != geometry && geometry->WkbSize() > 0 )
+    {
+      std::vector<unsigned char> wkb ( geometry->WkbSize() );
+      geometry->exportToWkb ( wkbNDR, &wkb[0] );
+      boost::hash_range ( seed, wkb.begin(), wkb.end() );
+    }
+
+    return seed;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Build the data objects. Rows that are the same as last time keep their 
+//  data object, so their nodes are not built again.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -542,6 +566,14 @@ void PostGISLayer::_buildDataObjects()
   
   // The data table.
   std::string dataTable ( this->tablename() );
+
+  // A row is made again when any of these change.
+  const std::string settings ( Usul::Strings::format ( this->labelColumn(), ",", this->showLabel(), ",", 
+    this->firstDateColumn(), ",", this->lastDateColumn(), ",", this->renderBin(), ",", this->style().get() ) );
+
+  RowHashes hashes ( Usul::Threads::Safe::get ( this->mutex(), _rowHashes ) );
+  typedef std::set<ObjectID> Ids;
+  Ids ids;
   
   // Loop through the results.
   OGRFeature *feature ( 0x0 );
@@ -549,6 +581,19 @@ void PostGISLayer::_buildDataObjects()
   {
     try
     {
+      // Rows without a feature id are known by their hash.
+      const std::size_t hash ( Helper::rowHash ( *feature, settings ) );
+      const ObjectID id ( OGRNullFID == feature->GetFID() ? 
+        Usul::Strings::format ( dataTable, ".#", hash ) : 
+        Usul::Strings::format ( dataTable, ".", feature->GetFID() ) );
+      ids.insert ( id );
+
+      // Keep the data object if the row is the same.
+      Feature::RefPtr existing ( this->find ( id ) );
+      RowHashes::const_iterator row ( hashes.find ( id ) );
+      if ( true == existing.valid() && hashes.end() != row && hash == row->second )
+        continue;
+
       // Make the data object.
       Minerva::Core::Data::DataObject::RefPtr data ( new Minerva::Core::Data::DataObject );
       
@@ -590,9 +635,13 @@ void PostGISLayer::_buildDataObjects()
 
       // Set the common members.
       this->_setDataObjectMembers ( data.get(), feature, ogrGeometry );
-      
-      // Add the data to the container.
+      data->objectId ( id );
+
+      // Replace the data object of the row. Only its node is built again.
+      if ( true == existing.valid() )
+        this->remove ( existing.get() );
       this->add ( data.get(), false );
+      hashes[id] = hash;
     }
     catch ( const std::exception& e )
     {
@@ -603,6 +652,21 @@ void PostGISLayer::_buildDataObjects()
       std::cout << "Error 1112177078: Exception caught while adding data to layer." << std::endl;
     }
   }
+
+  // Remove the data objects of the rows that are gone.
+  Features doomed;
+  for ( unsigned int i = 0; i < this->size(); ++i )
+  {
+    Feature::RefPtr object ( this->feature ( i ) );
+    if ( true == object.valid() && ids.end() == ids.find ( object->objectId() ) )
+      doomed.push_back ( object );
+  }
+  for ( Features::iterator iter = doomed.begin(); iter != doomed.end(); ++iter )
+  {
+    hashes.erase ( (*iter)->objectId() );
+    this->remove ( iter->get() );
+  }
+  Usul::Threads::Safe::set ( this->mutex(), hashes, _rowHashes );
   
   // Notify now that the data has changed.
   this->_notifyDataChangedListeners();
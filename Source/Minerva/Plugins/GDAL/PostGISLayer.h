@@ -32,6 +32,7 @@
 #  pragma warning ( disable : 4561 )
 #endif
 
+#include <map>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -56,6 +57,7 @@ public:
   typedef Minerva::Core::Data::Geometry             Geometry;
   typedef Minerva::Core::Data::Date              Date;
   typedef Minerva::Core::Data::Style                Style;
+  typedef std::map<ObjectID, std::size_t>           RowHashes;
 
   /// Smart-pointer definitions.
   USUL_DECLARE_REF_POINTERS ( PostGISLayer );
@@ -154,6 +156,7 @@ private:
   std::string                  _firstDateColumn;
   std::string                  _lastDateColumn;
   Style::RefPtr                _style;
+  RowHashes                    _rowHashes;
 
   SERIALIZE_XML_CLASS_NAME ( PostGISLayer );
 };
@@ -9,6 +9,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Plugins/GDAL/RasterLayerGDAL.h"
+#include "Minerva/Plugins/GDAL/CacheWriter.h"
 #include "Minerva/Plugins/GDAL/Convert.h"
 #include "Minerva/Plugins/GDAL/Common.h"
 #include "Minerva/Plugins/GDAL/MakeImage.h"
@@ -55,13 +56,14 @@ USUL_FACTORY_REGISTER_CREATOR_WITH_NAME ( "RasterLayerGDAL", RasterLayerGDAL );
 
 RasterLayerGDAL::RasterLayerGDAL() : 
   BaseClass(),
-  _data ( 0x0 ),
-  _warpedData ( 0x0 ),
+  _pool ( 0x0 ),
   _geoTransform ( 6, 0 ),
   _invGeoTransform ( 6, 0 ),
-  _filename()
+  _filename(),
+  _cacheCompression()
 {
   this->_addMember ( "filename", _filename );
+  this->_addMember ( "cache_compression", _cacheCompression );
   
   // Sanity check.  TODO: Change from using built in types directy to Usul::Types
   USUL_STATIC_ASSERT ( sizeof ( GByte )   == sizeof ( unsigned char ) );
@@ -80,10 +82,14 @@ RasterLayerGDAL::RasterLayerGDAL() :
 
 RasterLayerGDAL::RasterLayerGDAL ( const RasterLayerGDAL& rhs ) :
   BaseClass ( rhs ),
-  _data ( rhs._data ),
-  _warpedData ( rhs._warpedData ),
-  _filename ( rhs._filename )
+  _pool ( rhs._pool ),
+  _geoTransform ( rhs._geoTransform ),
+  _invGeoTransform ( rhs._invGeoTransform ),
+  _filename ( rhs._filename ),
+  _cacheCompression ( rhs._cacheCompression )
 {
+  this->_addMember ( "filename", _filename );
+  this->_addMember ( "cache_compression", _cacheCompression );
 }
 
 
@@ -95,13 +101,8 @@ RasterLayerGDAL::RasterLayerGDAL ( const RasterLayerGDAL& rhs ) :
 
 RasterLayerGDAL::~RasterLayerGDAL()
 {
-  const bool same ( _warpedData == _data );
-  if ( 0x0 != _warpedData )
-    ::GDALClose ( _warpedData );
-
-  // Clean up.
-  if ( 0x0 != _data && !same )
-    ::GDALClose ( _data );
+  // The pool closes the files.
+  _pool = 0x0;
 }
 
 
@@ -131,34 +132,49 @@ RasterLayerGDAL::ImagePtr RasterLayerGDAL::_textureImplementation (
                                                                    Usul::Jobs::Job * job,
                                                                    IUnknown *caller )
 {
-  SCOPED_GDAL_LOCK;
-  
-  // Create the dataset.
-  Dataset::RefPtr tile ( this->_createTile ( "", key.extents(), width, height ) );
-  if ( false == tile.valid() )
+  DatasetPool::RefPtr pool ( Usul::Threads::Safe::get ( this->mutex(), _pool ) );
+  if ( false == pool.valid() )
     return 0x0;
 
-  // Convert to an osg image.
-  ImagePtr image ( Minerva::convert ( tile->dataset() ) );
-
-  // Cache the image.
-  const std::string format ( "GTiff" );
+  // Create the dataset with our own handle to the file, so other tiles 
+  // can read at the same time.
+  Dataset::RefPtr tile ( 0x0 );
+  {
+    DatasetPool::Handle handle ( *pool );
+    tile = this->_createTile ( handle.dataset(), "", key.extents(), width, height );
+  }
 
-  // Find a driver for in memory raster.
-  GDALDriver *driver ( GetGDALDriverManager()->GetDriverByName ( format.c_str() ) );
+  if ( false == tile.valid() )
+    return 0x0;
 
-  if ( driver )
+  // Convert to an osg image.
+  ImagePtr image ( 0x0 );
   {
-    GDALDataset *cacheFile ( driver->CreateCopy ( file.c_str(), tile->dataset(), FALSE, NULL, NULL, NULL ) );
-
-    // Close the dataset to write to file.
-    if ( cacheFile != 0x0 )
-      ::GDALClose( (GDALDatasetH) cacheFile );
+    SCOPED_GDAL_LOCK;
+    image = Minerva::convert ( tile->dataset() );
   }
-  //Minerva::Core::DiskCache::instance().writeImage ( file, image );
 
-  // Close the file.
-  tile->close();
+  // Cache the image in the background. The tile can be shown now. There's 
+  // no file when it goes into the tile store.
+  const bool useStore ( Minerva::Core::DiskCache::instance().tileStore().valid() );
+  if ( true == image.valid() && ( false == file.empty() || true == useStore ) )
+  {
+    CacheWriter::Request request;
+    request.tile = tile;
+    request.filename = file;
+    request.compression = Usul::Threads::Safe::get ( this->mutex(), _cacheCompression );
+    request.layerKey = this->cacheKey();
+    request.tileKey = new TileKey;
+    request.tileKey->level ( key.level() );
+    request.tileKey->row ( key.row() );
+    request.tileKey->column ( key.column() );
+    request.tileKey->extents ( key.extents() );
+    request.width = width;
+    request.height = height;
+    request.extension = this->_cacheFileExtension();
+
+    CacheWriter::instance().add ( request );
+  }
 
   return image;
 }
@@ -177,8 +193,6 @@ RasterLayerGDAL::IElevationData::RefPtr RasterLayerGDAL::elevationData (
   Usul::Jobs::Job* job,
   Usul::Interfaces::IUnknown* caller )
 {
-  SCOPED_GDAL_LOCK;
-  
   Extents extents ( key.extents() );
 #if 0
   // Get the filename for the cache.
@@ -195,11 +209,22 @@ RasterLayerGDAL::IElevationData::RefPtr RasterLayerGDAL::elevationData (
   Usul::Scope::RemoveFile removeFile ( tempFilename );
 #endif
   
-  // Now guard.
-  Guard guard ( this );
+  DatasetPool::RefPtr pool ( 0x0 );
+  GeoTransform invGeoTransform;
+  {
+    Guard guard ( this );
+    pool = _pool;
+    invGeoTransform = _invGeoTransform;
+  }
+
+  if ( false == pool.valid() )
+    return 0x0;
+
+  // Use our own handle to the file, so other tiles can read at the same time.
+  DatasetPool::Handle handle ( *pool );
 
   // Get the data set.
-  GDALDataset *data ( _warpedData );
+  GDALDataset *data ( handle.dataset() );
 
   // Return if no data.
   if ( 0x0 == data )
@@ -240,7 +265,7 @@ RasterLayerGDAL::IElevationData::RefPtr RasterLayerGDAL::elevationData (
       const double lon ( mn[0] + u * ( mx[0] - mn[0] ) );
       const double lat ( mn[1] + v * ( mx[1] - mn[1] ) );
 
-      const float result ( this->_getElevationData ( band, lon, lat, noDataValue ) );
+      const float result ( RasterLayerGDAL::_getElevationData ( band, invGeoTransform, lon, lat, noDataValue ) );
 
       elevationData->value ( i, j, result );
     }
@@ -298,12 +323,10 @@ namespace Detail {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-float RasterLayerGDAL::_getElevationData ( GDALRasterBand* band, double longitude, double latitude, float noDataValue )
+float RasterLayerGDAL::_getElevationData ( GDALRasterBand* band, const GeoTransform& invGeoTransform, double longitude, double latitude, float noDataValue )
 {
-  Guard guard ( this );
-
   double currentRow ( 0 ), currentColumn ( 0 );
-  ::GDALApplyGeoTransform ( &_invGeoTransform[0], longitude, latitude, &currentColumn, &currentRow );
+  ::GDALApplyGeoTransform ( const_cast<double*> ( &invGeoTransform[0] ), longitude, latitude, &currentColumn, &currentRow );
 
   const int width ( band->GetXSize() );
   const int height ( band->GetYSize() );
@@ -322,12 +345,16 @@ float RasterLayerGDAL::_getElevationData ( GDALRasterBand* band, double longitud
   const int urRow    ( Usul::Math::maximum ( Usul::Math::minimum ( static_cast<int> ( ::ceil ( currentRow ) ), ( height - 1 ) ), 0 ) );
   const int urColumn ( Usul::Math::maximum ( Usul::Math::minimum ( static_cast<int> ( ::ceil ( currentColumn ) ), ( width - 1 ) ), 0) );
 
-  // Get the four values needed.
+  // Get the four values needed. Without thread support the block cache 
+  // is shared by all data sets, so the reads need the lock.
   double urHeight ( noDataValue ), llHeight ( noDataValue ), ulHeight ( noDataValue ), lrHeight ( noDataValue );
-  band->RasterIO ( GF_Read, llColumn, llRow, 1, 1, &llHeight, 1, 1, GDT_Float64, 0, 0 );
-  band->RasterIO ( GF_Read, llColumn, urRow, 1, 1, &ulHeight, 1, 1, GDT_Float64, 0, 0 );
-  band->RasterIO ( GF_Read, urColumn, llRow, 1, 1, &lrHeight, 1, 1, GDT_Float64, 0, 0 );
-  band->RasterIO ( GF_Read, urColumn, urRow, 1, 1, &urHeight, 1, 1, GDT_Float64, 0, 0 );
+  {
+    SCOPED_GDAL_LOCK;
+    band->RasterIO ( GF_Read, llColumn, llRow, 1, 1, &llHeight, 1, 1, GDT_Float64, 0, 0 );
+    band->RasterIO ( GF_Read, llColumn, urRow, 1, 1, &ulHeight, 1, 1, GDT_Float64, 0, 0 );
+    band->RasterIO ( GF_Read, urColumn, llRow, 1, 1, &lrHeight, 1, 1, GDT_Float64, 0, 0 );
+    band->RasterIO ( GF_Read, urColumn, urRow, 1, 1, &urHeight, 1, 1, GDT_Float64, 0, 0 );
+  }
 
   // Don't interpolate if any values are no data.
   Usul::Predicates::CloseFloat<double> close ( 3 );
@@ -349,11 +376,13 @@ float RasterLayerGDAL::_getElevationData ( GDALRasterBand* band, double longitud
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Create raster data for given extents.
+//  Create raster data for given extents. The source data set is only used 
+//  by the calling thread.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 Dataset::RefPtr RasterLayerGDAL::_createTile ( 
+    GDALDataset* data,
     const std::string& filename, 
     const Extents& extents, 
     unsigned int requestedWidth, 
@@ -364,6 +393,10 @@ Dataset::RefPtr RasterLayerGDAL::_createTile (
   int tile_offset_left = 0;
   int tile_offset_top = 0;
 
+  // Return if no data.
+  if ( 0x0 == data )
+    return 0x0;
+
   std::vector<double> geoTransform ( 6 );
 
   {
@@ -391,8 +424,8 @@ Dataset::RefPtr RasterLayerGDAL::_createTile (
   int height = anSrcWin[3];
 #endif
 
-  const int rasterXSize ( _warpedData->GetRasterXSize() );
-  const int rasterYSize ( _warpedData->GetRasterYSize() );
+  const int rasterXSize ( data->GetRasterXSize() );
+  const int rasterYSize ( data->GetRasterYSize() );
 
   if (off_x + width > rasterXSize )
   {
@@ -426,13 +459,6 @@ Dataset::RefPtr RasterLayerGDAL::_createTile (
     off_y = 0;
   }
 
-  // Get the data set.
-  GDALDataset *data ( Usul::Threads::Safe::get ( this->mutex(), _warpedData ) );
-
-  // Return if no data.
-  if ( 0x0 == data )
-    return 0x0;
-
   // This shouldn't happen, but does, so I think the logic above is incorrect.
     if ( width <=0 || height <=0 || target_width <=0 || target_height <=0 )
       return 0x0;
@@ -448,13 +474,14 @@ Dataset::RefPtr RasterLayerGDAL::_createTile (
 
   std::vector<unsigned char> buffer ( target_width * target_height, 0 );
 
+  // The data sets are our own, but without thread support the block cache 
+  // is shared by all of them.
+  SCOPED_GDAL_LOCK;
+
   for ( int i = 1; i <= bands; ++i )
   {
     GDALRasterBand* band ( data->GetRasterBand ( i ) );
-    {
-      Guard guard ( this );
-      band->RasterIO ( GF_Read, off_x, off_y, width, height, &buffer[0], target_width, target_height, GDT_Byte, 0, 0 );
-    }
+    band->RasterIO ( GF_Read, off_x, off_y, width, height, &buffer[0], target_width, target_height, GDT_Byte, 0, 0 );
     tile->GetRasterBand ( i )->RasterIO ( GF_Write, tile_offset_left, tile_offset_top, target_width, target_height, &buffer[0], target_width, target_height, GDT_Byte, 0, 0 );
   }
   
@@ -493,8 +520,6 @@ void RasterLayerGDAL::deserialize ( const XmlTree::Node &node )
 
 void RasterLayerGDAL::read ( const std::string& filename )
 {
-  SCOPED_GDAL_LOCK;
-
   // Add an error handler.
   Minerva::Detail::PushPopErrorHandler error;
   
@@ -503,57 +528,33 @@ void RasterLayerGDAL::read ( const std::string& filename )
   
   Guard guard ( this );
   _filename = filename;
+  _pool = 0x0;
   
-  // Open the dataset.
-  _data = static_cast< GDALDataset* > ( ::GDALOpen ( filename.c_str(), GA_ReadOnly ) );
-  
-  if ( 0x0 != _data )
-  {
-    const char* projection ( _data->GetProjectionRef() );
-    OGRSpatialReference src ( projection );
+  // Open the dataset. This throws if the file can't be opened.
+  DatasetPool::RefPtr pool ( new DatasetPool ( filename ) );
+  _pool = pool;
 
-    if ( false == src.IsGeographic() )
-    {
-      OGRSpatialReference dst;
-      dst.SetWellKnownGeogCS ( "WGS84" );
-
-      char *dstProjection ( 0x0 );
-      dst.exportToWkt ( &dstProjection );
+  DatasetPool::Handle handle ( *pool );
+  GDALDataset *data ( handle.dataset() );
 
-      _warpedData = (GDALDataset*) GDALAutoCreateWarpedVRT (
-                      _data,
-                      projection,
-                      dstProjection,
-                      /*GRA_NearestNeighbour*/ GRA_Bilinear,
-                      5.0,
-                      NULL);
-
-      ::CPLFree ( dstProjection );
-    }
-    else
-    {
-      _warpedData = _data;
-    }
-
-    if ( CE_None == _warpedData->GetGeoTransform ( &_geoTransform[0] ) )
-    {
-      const unsigned int width ( _warpedData->GetRasterXSize() );
-      const unsigned int height ( _warpedData->GetRasterYSize() );
-      
-      const double x ( _geoTransform[0] ), y ( _geoTransform[3] );
-      
-      const double xLength ( width * _geoTransform[1] );
-      const double yLength ( height * _geoTransform[5] );
-      
-      Extents::Vertex ll ( x, y + yLength ), ur ( x + xLength, y );
-      
-      Extents extents ( ll, ur );
-      this->extents ( extents );
-    }
-
-    // Store the inverse of the geo tranform.
-    ::GDALInvGeoTransform ( &_geoTransform[0], &_invGeoTransform[0] );
+  if ( 0x0 != data && CE_None == data->GetGeoTransform ( &_geoTransform[0] ) )
+  {
+    const unsigned int width ( data->GetRasterXSize() );
+    const unsigned int height ( data->GetRasterYSize() );
+    
+    const double x ( _geoTransform[0] ), y ( _geoTransform[3] );
+    
+    const double xLength ( width * _geoTransform[1] );
+    const double yLength ( height * _geoTransform[5] );
+    
+    Extents::Vertex ll ( x, y + yLength ), ur ( x + xLength, y );
+    
+    Extents extents ( ll, ur );
+    this->extents ( extents );
   }
+
+  // Store the inverse of the geo tranform.
+  ::GDALInvGeoTransform ( &_geoTransform[0], &_invGeoTransform[0] );
 }
 
 
@@ -595,13 +596,17 @@ std::string RasterLayerGDAL::_cacheFileExtension() const
 
 Usul::Math::Vec2ui RasterLayerGDAL::size() const
 {
-  Guard guard ( this );
   Usul::Math::Vec2ui size ( 0, 0 );
 
-  if ( 0x0 != _data )
+  DatasetPool::RefPtr pool ( Usul::Threads::Safe::get ( this->mutex(), _pool ) );
+  if ( true == pool.valid() )
   {
-    size[0] = _data->GetRasterXSize();
-    size[1] = _data->GetRasterYSize();
+    DatasetPool::Handle handle ( *pool );
+    if ( 0x0 != handle.original() )
+    {
+      size[0] = handle.original()->GetRasterXSize();
+      size[1] = handle.original()->GetRasterYSize();
+    }
   }
 
   return size;
@@ -616,10 +621,12 @@ Usul::Math::Vec2ui RasterLayerGDAL::size() const
 
 std::string RasterLayerGDAL::projection() const
 {
-  Guard guard ( this );
-  if ( 0x0 != _data )
+  DatasetPool::RefPtr pool ( Usul::Threads::Safe::get ( this->mutex(), _pool ) );
+  if ( true == pool.valid() )
   {
-    return std::string ( _data->GetProjectionRef() );
+    DatasetPool::Handle handle ( *pool );
+    if ( 0x0 != handle.original() )
+      return std::string ( handle.original()->GetProjectionRef() );
   }
 
   return "";
@@ -13,6 +13,7 @@
 
 #include "Minerva/Plugins/GDAL/Export.h"
 #include "Minerva/Plugins/GDAL/Dataset.h"
+#include "Minerva/Plugins/GDAL/DatasetPool.h"
 
 #include "Minerva/Core/Layers/RasterLayer.h"
 
@@ -76,23 +77,24 @@ protected:
     IUnknown *caller );
 
   Dataset::RefPtr _createTile ( 
+    GDALDataset* data,
     const std::string& filename, 
     const Extents& extents, 
     unsigned int requestedWidth, 
     unsigned int requestedHeight );
 
-  float _getElevationData ( GDALRasterBand* band, double longitude, double latitude, float noDataValue );
+  static float _getElevationData ( GDALRasterBand* band, const GeoTransform& invGeoTransform, double longitude, double latitude, float noDataValue );
 
 private:
   
   // No assignment.
   RasterLayerGDAL& operator= ( const RasterLayerGDAL& );
   
-  GDALDataset *_data;
-  GDALDataset *_warpedData;
+  DatasetPool::RefPtr _pool;
   std::vector<double> _geoTransform;
   std::vector<double> _invGeoTransform;
   std::string _filename;
+  std::string _cacheCompression;
   
   SERIALIZE_XML_CLASS_NAME( RasterLayerGDAL ) 
 };
@@ -297,8 +297,17 @@ RasterPolygonLayer::ImagePtr RasterPolygonLayer::_textureImplementation (
   // Initialize.
   ImagePtr image ( this->_rasterize ( key.extents(), width, height, key.level() ) );
     
-  // Cache the file.
-  this->_writeImageFile ( image, filename );
+  // Cache the file. There's no file when it goes into the tile store.
+  if ( true == filename.empty() )
+  {
+    LayerKey::RefPtr layerKey ( this->cacheKey() );
+    if ( true == layerKey.valid() )
+      DiskCache::instance().storeImage ( *layerKey, key, width, height, this->_cacheFileExtension(), image );
+  }
+  else
+  {
+    this->_writeImageFile ( image, filename );
+  }
   
   return image;
 }
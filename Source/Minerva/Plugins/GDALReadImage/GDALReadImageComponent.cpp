@@ -116,6 +116,22 @@ bool GDALReadImageComponent::canRead ( const std::string &file ) const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Close the data set.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  void closeDataset ( GDALDataset *data )
+  {
+    SCOPED_GDAL_LOCK;
+    ::GDALClose ( data );
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Read a filename and return an image (IReadImageFile).
@@ -124,17 +140,23 @@ bool GDALReadImageComponent::canRead ( const std::string &file ) const
 
 GDALReadImageComponent::ImagePtr GDALReadImageComponent::readImageFile ( const std::string& filename ) const
 {
-  SCOPED_GDAL_LOCK;
-  
-	// Open the file.
-	GDALDataset *data ( static_cast<GDALDataset*> ( ::GDALOpen ( filename.c_str(), GA_ReadOnly ) ) );
+  // Open the file.
+  GDALDataset *data ( 0x0 );
+  {
+    SCOPED_GDAL_LOCK;
+    data = static_cast<GDALDataset*> ( ::GDALOpen ( filename.c_str(), GA_ReadOnly ) );
+  }
 
 	// Return if no data.
   if ( 0x0 == data )
     return 0x0;
   
 	// Make sure data set is closed.
-  Usul::Scope::Caller::RefPtr closeDataSet ( Usul::Scope::makeCaller ( boost::bind<void> ( GDALClose, boost::ref ( data ) ) ) );
+  Usul::Scope::Caller::RefPtr closeDataSet ( Usul::Scope::makeCaller ( boost::bind<void> ( &Detail::closeDataset, data ) ) );
   
+  // Without thread support the block cache is shared by all data sets, 
+  // so reading needs the lock too. It's released before the data set is 
+  // closed.
+  SCOPED_GDAL_LOCK;
   return ImagePtr ( Minerva::convert ( data ) );
 }
@@ -40,6 +40,7 @@
 #include "boost/regex.hpp"
 
 #include <limits>
+#include <set>
 
 using namespace Minerva::Layers::GeoRSS;
 
@@ -101,6 +102,36 @@ GeoRSSLayer::~GeoRSSLayer()
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helper functions to identify an item.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  std::string childValue ( const XmlTree::Node& node, const std::string& name )
+  {
+    Children children ( node.find ( name, false ) );
+    return ( children.empty() ? "" : children.front()->value() );
+  }
+
+  // The guid, or the link, or the title and date when there is neither.
+  std::string itemId ( const XmlTree::Node& node )
+  {
+    const std::string guid ( Helper::childValue ( node, "guid" ) );
+    if ( false == guid.empty() )
+      return guid;
+
+    const std::string link ( Helper::childValue ( node, "link" ) );
+    if ( false == link.empty() )
+      return link;
+
+    return Helper::childValue ( node, "title" ) + Helper::childValue ( node, "pubDate" );
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Read the file.
@@ -147,34 +178,73 @@ void GeoRSSLayer::_read ( const std::string &filename, Usul::Interfaces::IUnknow
     }
   }
 
-  // Clear what we have.
-  this->clear();
+  // Items that are still in the feed are kept, so only the nodes of the new 
+  // and old items are touched. They are all made again if a setting changed.
+  const bool settingsChanged ( this->dirtyData() );
+  const boost::posix_time::time_duration maximumAge ( Usul::Threads::Safe::get ( this->mutex(), _maximumAge ) );
+  const boost::posix_time::ptime now ( boost::posix_time::second_clock::universal_time() );
+  const unsigned int maximumItems ( this->maximumItems() );
 
-  unsigned int i ( 0 );
+  typedef std::set<ObjectID> Ids;
+  Ids ids;
 
   // Get all the items.
   Children children ( doc->find ( "item", true ) );
   BOOST_FOREACH ( XmlTree::Node::ValidRefPtr node, children )
   {
-    std::cout << "Adding item " << ++i << " of " << children.size() << std::endl;
-    this->_parseItem( *node );
-    
-    if ( this->size() >= this->maximumItems() )
+    if ( ids.size() >= maximumItems )
       break;
+
+    // Check the age of the item.
+    const boost::posix_time::ptime date ( Minerva::Core::Data::Date::createFromRSS ( Helper::childValue ( *node, "pubDate" ) ) );
+    if ( ( now - maximumAge ) > date )
+      continue;
+
+    const ObjectID id ( Helper::itemId ( *node ) );
+    if ( ids.end() != ids.find ( id ) )
+      continue;
+
+    Feature::RefPtr existing ( this->find ( id ) );
+    if ( true == existing.valid() && false == settingsChanged )
+    {
+      ids.insert ( id );
+      continue;
+    }
+
+    if ( true == existing.valid() )
+      this->remove ( existing.get() );
+
+    DataObject::RefPtr object ( this->_parseItem ( *node ) );
+    if ( true == object.valid() )
+    {
+      std::cout << "Adding item " << id << std::endl;
+      object->objectId ( id );
+      this->add ( object.get() );
+      ids.insert ( id );
+    }
   }
 
-  // Stack the points.
+  // Remove the items that are no longer in the feed.
+  Features doomed;
+  for ( unsigned int i = 0; i < this->size(); ++i )
+  {
+    Feature::RefPtr item ( this->feature ( i ) );
+    if ( true == item.valid() && ids.end() == ids.find ( item->objectId() ) )
+      doomed.push_back ( item );
+  }
+  for ( Features::iterator iter = doomed.begin(); iter != doomed.end(); ++iter )
+  {
+    this->remove ( iter->get() );
+  }
+
+  // Stack the points. Only the points that move are built again.
   Minerva::Core::Visitors::StackPoints::RefPtr stack ( new Minerva::Core::Visitors::StackPoints );
   this->accept ( *stack );
 
   // Our data is no longer dirty.
   this->dirtyData ( false );
 
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
-
   // Update last time.
-  const boost::posix_time::ptime now ( boost::posix_time::second_clock::universal_time() );
   Usul::Threads::Safe::set ( this->mutex(), now, _lastDataUpdate );
 }
 
@@ -216,7 +286,7 @@ namespace Helper
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void GeoRSSLayer::_parseItem ( const XmlTree::Node& node )
+GeoRSSLayer::DataObject::RefPtr GeoRSSLayer::_parseItem ( const XmlTree::Node& node )
 {
   Item::RefPtr object ( new Item );
   
@@ -234,12 +304,6 @@ void GeoRSSLayer::_parseItem ( const XmlTree::Node& node )
   
   boost::posix_time::ptime date ( Minerva::Core::Data::Date::createFromRSS ( pubDate ) );
   object->timePrimitive ( new Minerva::Core::Data::TimeStamp ( date ) );
-  
-  // Check the age of the item.
-  boost::posix_time::time_duration maximumAge ( Usul::Threads::Safe::get ( this->mutex(), _maximumAge ) );
-  const boost::posix_time::ptime now ( boost::posix_time::second_clock::universal_time() );
-  if ( ( now - maximumAge ) > date )
-    return;
 
   // Look for an image.
   Children imageNode ( node.find ( "media:content", true ) );
@@ -354,12 +418,8 @@ void GeoRSSLayer::_parseItem ( const XmlTree::Node& node )
 		}
 	}
 
-  // Add the data object.
-	if ( false == filtered )
-		this->add ( object );
-
-  // Our scene needs rebuilt.
-  this->dirtyScene ( true );
+  // The caller adds the data object. Only its node is added to the scene.
+	return ( filtered ? DataObject::RefPtr ( 0x0 ) : DataObject::RefPtr ( object.get() ) );
 }
 
 
@@ -105,8 +105,8 @@ protected:
   // Read.
   void                        _read ( const std::string &filename, Usul::Interfaces::IUnknown *caller, Usul::Interfaces::IUnknown *progress );
 
-  // Parse the item.
-  void                        _parseItem ( const XmlTree::Node& );
+  // Parse the item. Returns null if it is filtered.
+  DataObject::RefPtr          _parseItem ( const XmlTree::Node& );
   
   // Update link.
   void                        _updateLink ( Usul::Interfaces::IUnknown* caller = 0x0 );
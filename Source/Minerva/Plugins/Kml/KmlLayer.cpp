@@ -11,7 +11,8 @@
 #include "Minerva/Plugins/Kml/KmlLayer.h"
 #include "Minerva/Plugins/Kml/LoadModel.h"
 #include "Minerva/Plugins/Kml/Factory.h"
-#include "Minerva/Plugins/Kml/ZipFile.h"
+#include "Minerva/Plugins/Kml/Parser.h"
+#include "Minerva/Plugins/Kml/KmzArchive.h"
 #include "Minerva/Core/Data/DataObject.h"
 #include "Minerva/Core/Data/Line.h"
 #include "Minerva/Core/Data/Model.h"
@@ -19,11 +20,12 @@
 #include "Minerva/Core/Data/Polygon.h"
 #include "Minerva/Core/Data/ModelCache.h"
 #include "Minerva/Core/Data/NetworkLink.h"
+#include "Minerva/Core/VirtualFileSystem.h"
 #include "Minerva/Network/Download.h"
 
 #include "Minerva/Common/ITimerFactory.h"
 
-#include "XmlTree/Document.h"
+#include "XmlTree/Node.h"
 
 #include "Usul/Bits/Bits.h"
 #include "Usul/Components/Manager.h"
@@ -36,6 +38,7 @@
 #include "Usul/Jobs/Manager.h"
 #include "Usul/Scope/Caller.h"
 #include "Usul/Scope/Reset.h"
+#include "Usul/Strings/Format.h"
 #include "Usul/System/Clock.h"
 #include "Usul/Threads/Safe.h"
 
@@ -45,6 +48,7 @@
 #include "boost/algorithm/string/replace.hpp"
 #include "boost/algorithm/string/trim.hpp"
 #include "boost/filesystem/operations.hpp"
+#include "boost/functional/hash.hpp"
 
 #include <sstream>
 
@@ -78,7 +82,8 @@ KmlLayer::KmlLayer() :
   _flags ( 0 ),
 	_styles(),
   _modelCache ( new ModelCache, true ),
-  _timer()
+  _timer(),
+  _mounted()
 {
   this->_addMember ( "filename", _filename );
 }
@@ -99,7 +104,8 @@ KmlLayer::KmlLayer ( const std::string& filename, const std::string& directory,
   _flags ( 0 ),
 	_styles ( styles ),
   _modelCache ( cache, false ),
-  _timer()
+  _timer(),
+  _mounted()
 {
   this->_addMember ( "filename", _filename );
 }
@@ -120,7 +126,8 @@ KmlLayer::KmlLayer ( Link* link, const Styles& styles, ModelCache* cache ) :
   _flags ( 0 ),
   _styles ( styles ),
   _modelCache ( cache, false ),
-  _timer()
+  _timer(),
+  _mounted()
 {
   this->_addMember ( "filename", _filename );
   
@@ -173,6 +180,53 @@ KmlLayer::~KmlLayer()
   // Delete the model cache if we own it.
   if ( _modelCache.second )
     delete _modelCache.first;
+
+  Usul::Functions::safeCall ( boost::bind ( &KmlLayer::_unmount, this ), "1702938846" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the directory to mount the kmz at. The path is hashed in so kmz 
+//  files with the same name in different directories don't collide. The 
+//  size and modified time are too, so a kmz that changed on disk gets a 
+//  new archive instead of the one mounted for the old file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string KmlLayer::_archiveDirectory ( const std::string& filename )
+{
+  std::size_t hashValue ( boost::hash<std::string>() ( filename ) );
+
+  boost::system::error_code ec;
+  const boost::uintmax_t size ( boost::filesystem::file_size ( filename, ec ) );
+  boost::hash_combine ( hashValue, ec ? 0 : size );
+
+  const std::time_t modified ( boost::filesystem::last_write_time ( filename, ec ) );
+  boost::hash_combine ( hashValue, ec ? 0 : modified );
+
+  std::string dir ( Usul::Strings::format ( Usul::File::Temp::directory(), "/", Usul::File::base ( filename ), "_", hashValue, "/" ) );
+  boost::algorithm::replace_all ( dir, " ", "_" );
+  return dir;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Unmount the archive, if any.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void KmlLayer::_unmount()
+{
+  std::string dir;
+  {
+    Guard guard ( this->mutex() );
+    std::swap ( dir, _mounted );
+  }
+
+  if ( false == dir.empty() )
+    Minerva::Core::VirtualFileSystem::instance().unmount ( dir );
 }
 
 
@@ -254,69 +308,48 @@ void KmlLayer::_read ( const std::string &filename )
   
   // Clear what we have.
   this->clear();
+
+  // Let go of the archive from the last read.
+  this->_unmount();
   
   // See if we need to unzip...
   if ( ".kmz" == ext )
   {
-    std::string dir ( Usul::File::Temp::directory() + "/" + Usul::File::base ( filename ) + "/" );
-    boost::algorithm::replace_all ( dir, " ", "_" );
-    
 #ifdef HAVE_ZLIB
-    
-    // Make sure the directory is created.
-    if ( false == boost::filesystem::exists ( dir ) )
-      boost::filesystem::create_directory ( dir );
-
-    // Open the zip file.
-    ZipFile zipFile;
-    zipFile.open ( filename );
 
-    // Get the all the filenames contained in the file.
-    typedef ZipFile::Strings Strings;
-    Strings contents;
-    zipFile.contents ( contents );
+    // The files in the kmz are read from the archive where the kml expects 
+    // to find them. Layers reading the same kmz share one archive.
+    const std::string dir ( KmlLayer::_archiveDirectory ( filename ) );
 
-    typedef std::vector<std::string> FileContents;
-    FileContents kmlFiles;
+    Minerva::Core::VirtualFileSystem &vfs ( Minerva::Core::VirtualFileSystem::instance() );
+    Minerva::Core::Archive::RefPtr archive ( vfs.archive ( dir ) );
+    if ( false == archive.valid() )
+      archive = new KmzArchive ( filename );
 
-    // Loop over the contents and write them to a temporary file.
-    for ( Strings::const_iterator iter = contents.begin(); iter != contents.end(); ++iter )
-    {
-      const std::string filename ( *iter );
+    archive = vfs.mount ( dir, archive );
+    Usul::Threads::Safe::set ( this->mutex(), dir, _mounted );
 
-      // Read the file into a buffer.
-      std::string buffer;
-      zipFile.readFile ( filename, buffer );
-
-      if ( ".kml" == Usul::File::extension ( filename ) )
-      {
-        kmlFiles.push_back ( buffer );
-      }
-      else
-      {
-        // Create the path.
-        const std::string path ( dir + "\\" + filename );
-
-        // Make sure the directory is created.
-        boost::filesystem::create_directory ( Usul::File::directory ( path ) );
-
-        // Write the buffer to file.
-        std::ofstream out ( path.c_str(), std::ios::binary );
-        out << buffer;
-      }
-    }
-
-    // Set the directory to where the .kmz was expanded to.
+    // Set the directory to where the archive is mounted.
     Usul::Scope::Reset<std::string> reset ( _directory, dir, _directory );
 
-    for ( FileContents::const_iterator iter = kmlFiles.begin(); iter != kmlFiles.end(); ++iter )
+    // Parse the kml files.
+    typedef Minerva::Core::Archive::Entries Entries;
+    Entries entries;
+    archive->entries ( entries );
+
+    for ( Entries::const_iterator iter = entries.begin(); iter != entries.end(); ++iter )
     {
-      XmlTree::Document::ValidRefPtr document ( new XmlTree::Document );
-      document->loadFromMemory ( *iter );
-  
+      if ( ".kml" != boost::algorithm::to_lower_copy ( Usul::File::extension ( *iter ) ) )
+        continue;
+
       USUL_TRY_BLOCK
       {
-        this->_parseKml ( *document );
+        Minerva::Core::Archive::Buffer buffer;
+        if ( archive->read ( *iter, buffer ) && false == buffer.empty() )
+        {
+          Parser parser ( this );
+          parser.parseBuffer ( std::string ( buffer.begin(), buffer.end() ) );
+        }
       }
       USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "2567846007" );
     }
@@ -350,38 +383,28 @@ void KmlLayer::_parseKml ( const std::string& filename )
 {
   Usul::Scope::Reset<std::string> reset ( _directory, Usul::File::directory ( filename ), _directory );
   
-  XmlTree::Document::ValidRefPtr document ( new XmlTree::Document );
-  document->load ( filename );
-  
-  this->_parseKml ( *document );
+  // Stream the file, so only one placemark at a time is held as xml.
+  Parser parser ( this );
+  parser.parseFile ( filename );
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Load a kml file using the node.
+//  Make a layer for a folder inside this one.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void KmlLayer::_parseKml ( const XmlTree::Node& node )
+KmlLayer* KmlLayer::_createFolder() const
 {
-  // Loop over the children.
-  Children children ( node.children() );
-  for ( Children::iterator iter = children.begin(); iter != children.end(); ++iter )
-  {
-    XmlTree::Node::RefPtr node ( *iter );
+  // Get the filename and directory.
+  const std::string filename ( Usul::Threads::Safe::get ( this->mutex(), _filename ) );
+  const std::string directory ( Usul::Threads::Safe::get ( this->mutex(), _directory ) );
 
-    if ( node.valid() )
-    {
-      std::string name ( node->name() );
-      
-      // Handle folders or documents at the top level.
-      if ( "Folder" == name || "Document" == name )
-        this->parseFolder( *node );
-      else
-        this->_parseNode( *node );
-    }
-  }
+  // Get the current styles map.
+  Styles styles ( Usul::Threads::Safe::get ( this->mutex(), _styles ) );
+
+  return new KmlLayer ( filename, directory, styles, this->modelCache() );
 }
 
 
@@ -505,6 +528,21 @@ void KmlLayer::parseFolder ( const XmlTree::Node& node )
 ///////////////////////////////////////////////////////////////////////////////
 
 void KmlLayer::_parsePlacemark ( const XmlTree::Node& node )
+{
+  DataObject::RefPtr object ( this->_createPlacemark ( node ) );
+
+  // Add the data object.
+  this->add ( object );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the data object for a placemark.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+KmlLayer::DataObject* KmlLayer::_createPlacemark ( const XmlTree::Node& node ) const
 {
   // Make the data object.
   DataObject::RefPtr object ( Factory::instance().createPlaceMark ( node ) );
@@ -533,8 +571,29 @@ void KmlLayer::_parsePlacemark ( const XmlTree::Node& node )
     this->_loadModel ( model );
   }
 
-  // Add the data object.
-  this->add ( object );
+  return object.release();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the features. Listeners are told once for all of them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void KmlLayer::_addFeatures ( const DataObjects& features )
+{
+  if ( true == features.empty() )
+    return;
+
+  this->reserve ( this->size() + static_cast<unsigned int> ( features.size() ) );
+
+  for ( DataObjects::const_iterator iter = features.begin(); iter != features.end(); ++iter )
+  {
+    this->add ( iter->get(), false );
+  }
+
+  this->_notifyDataChangedListeners();
 }
 
 
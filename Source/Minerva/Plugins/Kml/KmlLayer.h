@@ -11,6 +11,8 @@
 #ifndef __MINERVA_LAYERS_KML_H__
 #define __MINERVA_LAYERS_KML_H__
 
+#include "Minerva/Plugins/Kml/Export.h"
+
 #include "Minerva/Core/Data/Container.h"
 #include "Minerva/Core/Data/Geometry.h"
 #include "Minerva/Core/Data/Link.h"
@@ -29,8 +31,9 @@ namespace Layers {
 namespace Kml {
   
   class NetworkLink;
+  class Parser;
 
-class KmlLayer : public Minerva::Core::Data::Container,
+class MINERVA_KML_EXPORT KmlLayer : public Minerva::Core::Data::Container,
                  public Minerva::Common::IRefreshData
 {
 public:
@@ -43,6 +46,7 @@ public:
   typedef Minerva::Core::Data::Style                 Style;
   typedef std::map<std::string,Style::RefPtr>        Styles;
   typedef Minerva::Core::Data::Link Link;
+  typedef std::vector<USUL_REF_POINTER(DataObject)> DataObjects;
 
   /// Smart-pointer definitions.
   USUL_DECLARE_QUERY_POINTERS ( KmlLayer );
@@ -82,6 +86,8 @@ public:
 
 protected:
 
+  friend class Parser;
+
   KmlLayer ( Link* link, const Styles& styles, ModelCache* );
   KmlLayer ( const std::string& filename, const std::string& directory, const Styles& styles, ModelCache* );
   virtual ~KmlLayer();
@@ -89,6 +95,9 @@ protected:
   // Add a timer callback.
   void                        _addTimer();
 
+  // Add the features and notify once.
+  void                        _addFeatures ( const DataObjects& features );
+
   // Filename from link.  Will download if needed.
   std::string                 _buildFilename ( Link *link ) const;
   
@@ -100,14 +109,23 @@ protected:
   // Read.
   void                        _read ( const std::string &filename );
   
+  // Get the directory to mount a kmz at.
+  static std::string          _archiveDirectory ( const std::string& filename );
+
+  // Unmount the kmz from the last read, if any.
+  void                        _unmount();
+
+  // Make a layer for a folder inside this one.
+  KmlLayer*                   _createFolder() const;
+
   // Load a kml file.
   void                        _parseKml ( const std::string& filename );
-  void                        _parseKml ( const XmlTree::Node& node );
   
   // Parse xml nodes.
   void                        _parseNode         ( const XmlTree::Node& node );
   void                        _parseStyle        ( const XmlTree::Node& node );
   void                        _parsePlacemark    ( const XmlTree::Node& node );
+  DataObject*                 _createPlacemark   ( const XmlTree::Node& node ) const;
 
 	Style*                      _style ( const std::string& name ) const;
   
@@ -133,6 +151,7 @@ private:
 	Styles _styles;
   std::pair<ModelCache*,bool> _modelCache;
   Minerva::Common::ITimer::RefPtr _timer;
+  std::string _mounted;
   
   SERIALIZE_XML_CLASS_NAME ( KmlLayer );
 };
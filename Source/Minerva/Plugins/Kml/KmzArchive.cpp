@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2008, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Archive for a kmz file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/Kml/KmzArchive.h"
+
+#include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
+
+#include "boost/algorithm/string/replace.hpp"
+
+using namespace Minerva::Layers::Kml;
+
+typedef Usul::Threads::Guard<Usul::Threads::Mutex> Guard;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+KmzArchive::KmzArchive ( const std::string& filename ) : BaseClass(),
+  _mutex ( new Mutex ),
+  _zipFile(),
+  _names(),
+  _order(),
+  _cache(),
+  _cacheSize ( 0 )
+{
+  _zipFile.open ( filename );
+
+  // Only the names are read now. Keep the name in the zip file for reading.
+  ZipFile::Strings contents;
+  _zipFile.contents ( contents );
+
+  for ( ZipFile::Strings::const_iterator iter = contents.begin(); iter != contents.end(); ++iter )
+  {
+    const std::string name ( KmzArchive::_normalize ( *iter ) );
+    if ( _names.insert ( Names::value_type ( name, *iter ) ).second )
+      _order.push_back ( name );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+KmzArchive::~KmzArchive()
+{
+  _cache.clear();
+  delete _mutex; _mutex = 0x0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the file open?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool KmzArchive::isOpen() const
+{
+  Guard guard ( *_mutex );
+  return _zipFile.isOpen();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Use forward slashes and no leading "./" or "/".
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string KmzArchive::_normalize ( const std::string& entry )
+{
+  std::string answer ( entry );
+  boost::algorithm::replace_all ( answer, "\\", "/" );
+
+  while ( 0 == answer.find ( "./" ) || 0 == answer.find ( "/" ) )
+    answer.erase ( 0, ( '/' == answer[0] ) ? 1 : 2 );
+
+  return answer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the entry in the archive?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool KmzArchive::contains ( const std::string& entry ) const
+{
+  // The names don't change after construction.
+  return _names.end() != _names.find ( KmzArchive::_normalize ( entry ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the names of all the entries, in the order of the zip file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void KmzArchive::entries ( Entries& names ) const
+{
+  names.insert ( names.end(), _order.begin(), _order.end() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the entry.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool KmzArchive::read ( const std::string& entry, Buffer& buffer ) const
+{
+  const std::string name ( KmzArchive::_normalize ( entry ) );
+  Names::const_iterator found ( _names.find ( name ) );
+  if ( _names.end() == found )
+    return false;
+
+  Guard guard ( *_mutex );
+
+  // Already read?
+  Cache::const_iterator iter ( _cache.find ( name ) );
+  if ( _cache.end() != iter )
+  {
+    buffer = iter->second;
+    return true;
+  }
+
+  std::string contents;
+  if ( false == _zipFile.readFile ( found->second, contents ) )
+    return false;
+
+  buffer.assign ( contents.begin(), contents.end() );
+
+  // Keep the small ones.
+  if ( buffer.size() <= MAX_CACHED_ENTRY_SIZE && _cacheSize + buffer.size() <= MAX_CACHED_SIZE )
+  {
+    _cache[name] = buffer;
+    _cacheSize += static_cast<unsigned int> ( buffer.size() );
+  }
+
+  return true;
+}
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2008, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Archive for a kmz file. Entries are decompressed when first read. Small
+//  ones are kept so the next read, from this or another layer, is free.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_LAYERS_KML_KMZ_ARCHIVE_H__
+#define __MINERVA_LAYERS_KML_KMZ_ARCHIVE_H__
+
+#include "Minerva/Plugins/Kml/ZipFile.h"
+
+#include "Minerva/Core/Archive.h"
+
+#include <map>
+#include <string>
+
+namespace Usul { namespace Threads { class Mutex; } }
+
+namespace Minerva {
+namespace Layers {
+namespace Kml {
+
+
+class KmzArchive : public Minerva::Core::Archive
+{
+public:
+
+  typedef Minerva::Core::Archive BaseClass;
+  typedef Usul::Threads::Mutex Mutex;
+
+  USUL_DECLARE_REF_POINTERS ( KmzArchive );
+
+  KmzArchive ( const std::string& filename );
+
+  /// Is the file open?
+  bool isOpen() const;
+
+  /// Archive interface.
+  virtual bool contains ( const std::string& entry ) const;
+  virtual void entries ( Entries& names ) const;
+  virtual bool read ( const std::string& entry, Buffer& buffer ) const;
+
+protected:
+
+  virtual ~KmzArchive();
+
+private:
+
+  enum
+  {
+    MAX_CACHED_ENTRY_SIZE = 4 * 1024 * 1024,
+    MAX_CACHED_SIZE       = 64 * 1024 * 1024
+  };
+
+  typedef std::map<std::string,std::string> Names;
+  typedef std::map<std::string,Buffer> Cache;
+
+  static std::string _normalize ( const std::string& entry );
+
+  mutable Mutex *_mutex;
+  mutable ZipFile _zipFile;
+  Names _names;
+  Entries _order;
+  mutable Cache _cache;
+  mutable unsigned int _cacheSize;
+};
+
+
+}
+}
+}
+
+#endif // __MINERVA_LAYERS_KML_KMZ_ARCHIVE_H__
@@ -11,6 +11,7 @@
 #include "Minerva/Plugins/Kml/LoadModel.h"
 #include "Minerva/Plugins/Kml/ModelPostProcess.h"
 #include "Minerva/Core/Data/ModelCache.h"
+#include "Minerva/Core/VirtualFileSystem.h"
 #include "Minerva/Network/Download.h"
 
 #include "Minerva/OsgTools/Visitor.h"
@@ -91,7 +92,14 @@ osg::Node* LoadModel::operator() ( const std::string& filename, ModelCache *cach
     return cache->model ( filename );
 
   Guard guard ( Detail::_readMutex );
-  osg::ref_ptr<osg::Node> node ( osgDB::readNodeFile ( filename ) );
+
+  // Models in a kmz are read from the archive.
+  Minerva::Core::VirtualFileSystem &vfs ( Minerva::Core::VirtualFileSystem::instance() );
+  osg::ref_ptr<osg::Node> node;
+  if ( vfs.contains ( filename ) )
+    node = vfs.readNode ( filename );
+  else
+    node = osgDB::readNodeFile ( filename );
   if ( node.valid() )
   {
     // Post-process.
@@ -124,6 +132,11 @@ void LoadModel::_preProcessCollada ( const std::string& filename )
 #ifdef HAVE_COLLADA
   // Make sure only one thread reads at a time.
   Guard guard ( Detail::_readMutex );
+
+  // The file is changed below, so it has to be on the disk.
+  Minerva::Core::VirtualFileSystem &vfs ( Minerva::Core::VirtualFileSystem::instance() );
+  if ( vfs.contains ( filename ) && false == vfs.extract ( filename ) )
+    return;
   
   DAE dae;
 
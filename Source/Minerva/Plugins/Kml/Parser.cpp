@@ -0,0 +1,319 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2008, Arizona State University
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//  Created by: Adam Kubach
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sax parser for kml.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/Kml/Parser.h"
+#include "Minerva/Plugins/Kml/Factory.h"
+#include "Minerva/Core/Data/DataObject.h"
+
+#include "XmlTree/Functions.h"
+
+#include "Usul/Exceptions/Thrower.h"
+
+#include "xercesc/framework/LocalFileInputSource.hpp"
+#include "xercesc/framework/MemBufInputSource.hpp"
+#include "xercesc/sax/SAXParseException.hpp"
+#include "xercesc/sax2/SAX2XMLReader.hpp"
+#include "xercesc/sax2/XMLReaderFactory.hpp"
+#include "xercesc/util/OutOfMemoryException.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace Minerva::Layers::Kml;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Parser::Parser ( KmlLayer *layer, unsigned int batchSize ) : BaseClass(),
+  _layer ( layer ),
+  _batchSize ( ( batchSize > 0 ) ? batchSize : 1 ),
+  _levels(),
+  _elements(),
+  _nodes(),
+  _text()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Parser::~Parser()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Parse the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::parseFile ( const std::string& filename )
+{
+  xercesc::LocalFileInputSource input ( XmlTree::fromNative ( filename ).c_str() );
+  this->_parse ( input, filename );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Parse the buffer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::parseBuffer ( const std::string& buffer )
+{
+  xercesc::MemBufInputSource input ( reinterpret_cast<const XMLByte*> ( buffer.c_str() ), buffer.length(), "kml in memory parse", false );
+  this->_parse ( input, "kml in memory parse" );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Parse the input.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::_parse ( xercesc::InputSource& input, const std::string& name )
+{
+  if ( false == _layer.valid() )
+    return;
+
+  // Start from nothing in case we're used again.
+  _levels.clear();
+  _elements.clear();
+  _nodes.clear();
+  _text.clear();
+
+  std::auto_ptr<xercesc::SAX2XMLReader> reader ( xercesc::XMLReaderFactory::createXMLReader() );
+  reader->setContentHandler ( this );
+  reader->setErrorHandler ( this );
+
+  try
+  {
+    reader->parse ( input );
+  }
+
+  // Catch and re-throw exceptions.
+  catch ( const xercesc::OutOfMemoryException & )
+  {
+    Usul::Exceptions::Thrower<std::runtime_error>
+      ( "Error 3350921674: Ran out of memory while parsing kml: ", name );
+  }
+  catch ( const xercesc::SAXParseException &e )
+  {
+    Usul::Exceptions::Thrower<std::runtime_error>
+      ( "Error 1820573946: Failed to parse kml '", name, "' at line ", e.getLineNumber(), ", ", XmlTree::Functions::translate ( e.getMessage() ) );
+  }
+  catch ( const xercesc::XMLException &e )
+  {
+    Usul::Exceptions::Thrower<std::runtime_error>
+      ( "Error 2403815597: Failed to parse kml '", name, "', ", XmlTree::Functions::message ( e ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Beginning of element.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::startElement (
+  const XMLCh* const uri,
+  const XMLCh* const localname,
+  const XMLCh* const qname,
+  const xercesc::Attributes&	attributes )
+{
+  const std::string name ( XmlTree::toNative ( localname ) );
+
+  // The document's element. What we find in it goes in the layer.
+  if ( true == _elements.empty() )
+  {
+    _elements.push_back ( ROOT );
+    _levels.push_back ( Level ( _layer.get(), false, false ) );
+    return;
+  }
+
+  // Folders and documents are read as they come. The ones at the top
+  // go in the layer, the ones below them get layers of their own.
+  if ( true == _nodes.empty() && ( "Folder" == name || "Document" == name ) )
+  {
+    Level& parent ( _levels.back() );
+
+    if ( 1 == _levels.size() )
+    {
+      _levels.push_back ( Level ( parent.layer.get(), true, false ) );
+    }
+    else
+    {
+      // Keep the order of the parent's features.
+      this->_flush ( parent );
+
+      KmlLayer::RefPtr layer ( parent.layer->_createFolder() );
+      _levels.push_back ( Level ( layer.get(), true, true ) );
+    }
+
+    _elements.push_back ( FOLDER );
+    return;
+  }
+
+  // Everything else is collected until it closes.
+  XmlTree::Node::RefPtr node ( new XmlTree::Node ( name ) );
+
+  const XMLSize_t num ( attributes.getLength() );
+  for ( XMLSize_t i = 0; i < num; ++i )
+  {
+    node->attributes()[XmlTree::toNative ( attributes.getQName ( i ) )] = XmlTree::toNative ( attributes.getValue ( i ) );
+  }
+
+  if ( false == _nodes.empty() )
+    _nodes.back()->append ( node.get() );
+
+  _nodes.push_back ( node );
+  _text.push_back ( XmlTree::XercesString() );
+  _elements.push_back ( NODE );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  End of element.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::endElement (
+  const XMLCh* const uri,
+  const XMLCh* const localname,
+  const XMLCh* const qname )
+{
+  if ( true == _elements.empty() )
+    return;
+
+  const ElementType type ( _elements.back() );
+  _elements.pop_back();
+
+  if ( NODE == type )
+  {
+    XmlTree::Node::RefPtr node ( _nodes.back() );
+    _nodes.pop_back();
+
+    // Same as the tree loader, ignore text that is only white space.
+    const std::string value ( XmlTree::toNative ( _text.back() ) );
+    _text.pop_back();
+    if ( XmlTree::Functions::hasContent ( value ) )
+      node->value ( value );
+
+    // Hand it off when it's a child of the folder.
+    if ( true == _nodes.empty() && false == _levels.empty() )
+      this->_dispatch ( _levels.back(), *node );
+  }
+  else
+  {
+    Level level ( _levels.back() );
+    _levels.pop_back();
+
+    this->_flush ( level );
+
+    if ( true == level.nested && false == _levels.empty() )
+    {
+      KmlLayer::RefPtr parent ( _levels.back().layer );
+
+      level.layer->dirtyData ( false );
+      level.layer->dirtyScene ( true );
+
+      parent->add ( level.layer.get() );
+      parent->dirtyScene ( true );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Text of the element.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::characters ( const XMLCh* const chars, const XMLSize_t length )
+{
+  if ( false == _text.empty() )
+    _text.back().append ( chars, length );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Handle a child of the current folder.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::_dispatch ( Level& level, const XmlTree::Node& node )
+{
+  const std::string name ( node.name() );
+
+  if ( "Placemark" == name )
+  {
+    DataObject::RefPtr object ( level.layer->_createPlacemark ( node ) );
+    if ( object.valid() )
+      level.features.push_back ( object );
+
+    if ( level.features.size() >= _batchSize )
+      this->_flush ( level );
+  }
+  else if ( true == level.folder && "name" == name )
+  {
+    level.layer->name ( node.value() );
+  }
+  else if ( true == level.folder && "visibility" == name )
+  {
+    level.layer->visibilitySet ( "0" != node.value() );
+  }
+  else
+  {
+    // Network links add a layer.
+    if ( "NetworkLink" == name )
+      this->_flush ( level );
+
+    level.layer->_parseNode ( node );
+  }
+
+  if ( true == level.nested )
+    Factory::instance().setFeatureDataMembers ( *level.layer, node );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the waiting placemarks to the layer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Parser::_flush ( Level& level )
+{
+  if ( false == level.features.empty() )
+  {
+    level.layer->_addFeatures ( level.features );
+    level.features.clear();
+  }
+}
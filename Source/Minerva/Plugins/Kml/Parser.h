@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2008, Arizona State University
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//  Created by: Adam Kubach
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sax parser for kml. Folders and documents become layers as soon as they
+//  open. Every other element is collected into a small tree that is handed
+//  to the factory when it closes, so only one placemark or style is in
+//  memory at a time. Placemarks are added to their layer in batches.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MINERVA_LAYERS_KML_PARSER_H__
+#define __MINERVA_LAYERS_KML_PARSER_H__
+
+#include "Minerva/Plugins/Kml/KmlLayer.h"
+
+#include "XmlTree/Node.h"
+#include "XmlTree/XercesString.h"
+
+#include "xercesc/sax/InputSource.hpp"
+#include "xercesc/sax2/Attributes.hpp"
+#include "xercesc/sax2/DefaultHandler.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Minerva {
+namespace Layers {
+namespace Kml {
+
+
+class Parser : public xercesc::DefaultHandler
+{
+public:
+
+  /// Typedefs.
+  typedef xercesc::DefaultHandler BaseClass;
+  typedef KmlLayer::DataObject DataObject;
+  typedef KmlLayer::DataObjects DataObjects;
+
+  /// Constructor.
+  Parser ( KmlLayer *layer, unsigned int batchSize = 256 );
+
+  virtual ~Parser();
+
+  // Parse the file or the buffer into the layer.
+  void parseFile   ( const std::string& filename );
+  void parseBuffer ( const std::string& buffer );
+
+  virtual void startElement (
+    const XMLCh* const uri,
+    const XMLCh* const localname,
+    const XMLCh* const qname,
+    const xercesc::Attributes&	attributes );
+
+  virtual void endElement (
+    const XMLCh* const uri,
+    const XMLCh* const localname,
+    const XMLCh* const qname );
+
+  virtual void characters ( const XMLCh* const chars, const XMLSize_t length );
+
+private:
+
+  enum ElementType
+  {
+    ROOT,
+    FOLDER,
+    NODE
+  };
+
+  // A folder or document that is being read.
+  struct Level
+  {
+    Level ( KmlLayer *layer_, bool folder_, bool nested_ ) : layer ( layer_ ), folder ( folder_ ), nested ( nested_ ), features()
+    {
+    }
+
+    KmlLayer::RefPtr layer;
+    bool folder;
+    bool nested;
+    DataObjects features;
+  };
+
+  typedef std::vector<Level> Levels;
+  typedef std::vector<ElementType> Elements;
+  typedef std::vector<XmlTree::Node::RefPtr> Nodes;
+  typedef std::vector<XmlTree::XercesString> Text;
+
+  // No copying or assignment.
+  Parser ( const Parser& );
+  Parser& operator = ( const Parser& );
+
+  void _parse ( xercesc::InputSource& input, const std::string& name );
+
+  // Handle a child of the current folder once it's closed.
+  void _dispatch ( Level& level, const XmlTree::Node& node );
+
+  // Add the waiting placemarks to the layer.
+  void _flush ( Level& level );
+
+  KmlLayer::RefPtr _layer;
+  const unsigned int _batchSize;
+  Levels _levels;
+  Elements _elements;
+  Nodes _nodes;
+  Text _text;
+};
+
+
+}
+}
+}
+
+#endif // __MINERVA_LAYERS_KML_PARSER_H__
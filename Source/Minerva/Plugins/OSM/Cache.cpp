@@ -15,8 +15,13 @@
 #include "Usul/Convert/WellKnownBinary.h"
 #include "Usul/Functions/SafeCall.h"
 
+#include <iomanip>
+#include <sstream>
+
 using namespace Minerva::Layers::OSM;
 
+typedef CadKit::Database::SQLite::Statement Statement;
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -247,6 +252,17 @@ void Cache::addNodeData ( const std::string& key, const Extents& extents, const
 
 void Cache::_addNodeData ( const std::string& key, const Extents& extents, const Nodes& nodes )
 {
+  if ( false == _connection.valid() )
+    return;
+
+  const std::string sql ( Usul::Strings::format ( 
+    "INSERT INTO ", NODE_TABLE_NAME, 
+    " ( ", KEY_COLUMN, ", ", LOCACTION_COLUMN, ", ", OBJECT_ID_COLUMN, ", ", DATE_COLUMN, " )",
+    " values ( ?, GeomFromText ( ?, 4326 ), ?, ? )" ) );
+
+  // Prepare once for all the nodes.
+  Statement::RefPtr statement ( _connection->prepare ( sql ) );
+
   for ( Nodes::const_iterator iter = nodes.begin(); iter != nodes.end(); ++iter )
   {
     OSMNodePtr node ( *iter );
@@ -257,16 +273,13 @@ void Cache::_addNodeData ( const std::string& key, const Extents& extents, const
       Node::Tags tags ( node->tags() );
       Node::Location location ( node->location() );
 
-      const std::string sql ( Usul::Strings::format ( 
-        "INSERT INTO ", NODE_TABLE_NAME, 
-        " ( ", KEY_COLUMN, ", ", LOCACTION_COLUMN, ", ", OBJECT_ID_COLUMN, ", ", DATE_COLUMN, " ) values (",
-        " \"", key, "\", ",
-        " ", Cache::_createPointText ( location ), ",", 
-        " \"", id, "\", \"", timestamp.toString(), "\" )" ) );
-      
       USUL_TRY_BLOCK
       {
-        _connection->execute ( sql );
+        statement->bind ( 0, key );
+        statement->bind ( 1, Cache::_createPointText ( location ) );
+        statement->bind ( 2, id );
+        statement->bind ( 3, timestamp.toString() );
+        statement->execute();
       }
       USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "2633836923" );
 
@@ -393,6 +406,35 @@ void Cache::_createTagsTable ( const std::string& tableName )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Binds one row of the tags table.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  struct TagBinder
+  {
+    TagBinder ( Cache::OSMObject::IdType id ) : _id ( id )
+    {
+    }
+
+    bool operator () ( Statement& statement, const Cache::OSMObject::Tags::value_type& tag ) const
+    {
+      statement.bind ( 0, _id );
+      statement.bind ( 1, tag.first );
+      statement.bind ( 2, tag.second );
+      return true;
+    }
+
+  private:
+
+    Cache::OSMObject::IdType _id;
+  };
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Add the tags for the id.
@@ -406,23 +448,18 @@ void Cache::_addTags ( const std::string& tableName, OSMObject::IdType id, const
 
   // No transaction here!  Nested transactions cause a crash.
 
-  for ( Node::Tags::const_iterator iter = tags.begin(); iter != tags.end(); ++iter )
+  if ( true == tags.empty() )
+    return;
+
+  const std::string sql ( Usul::Strings::format ( 
+    "INSERT INTO ", tableName, 
+    " ( ", OBJECT_ID_COLUMN, ", ", KEY_COLUMN, ", ", VALUE_COLUMN, " ) values ( ?, ?, ? )" ) );
+
+  USUL_TRY_BLOCK
   {
-    const std::string key ( iter->first );
-    const std::string value ( iter->second );
-    const std::string sql ( Usul::Strings::format ( 
-      "INSERT INTO ", tableName, 
-      " ( ", OBJECT_ID_COLUMN, ", ", KEY_COLUMN, ", ", VALUE_COLUMN, " ) values (",
-      " \"", id, "\", ",
-      " \"", key, "\",",
-      " \"", value, "\" )" ) );
-
-    USUL_TRY_BLOCK
-    {
-      _connection->execute ( sql );
-    }
-    USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "3992404744" );
+    _connection->executeMany ( sql, tags.begin(), tags.end(), Helper::TagBinder ( id ) );
   }
+  USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "3992404744" );
 }
 
 
@@ -463,7 +500,7 @@ void Cache::_getTags ( const std::string& tableName, OSMObject::IdType id, OSMOb
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Create sql for creating a line.
+//  Create well-known text for a line. Bind it to GeomFromText.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -471,30 +508,29 @@ std::string Cache::_createLineText ( const LineString::Vertices& vertices )
 {
   typedef Usul::Convert::Type<double,std::string> ToString;
 
-  std::string sql ( "GeomFromText ( 'LINESTRING ( " );
+  std::string text ( "LINESTRING ( " );
+  text.reserve ( text.size() + vertices.size() * 32 );
 
-  if ( vertices.size() > 0 )
+  for ( LineString::Vertices::const_iterator iter = vertices.begin(); iter != vertices.end(); ++iter )
   {
-    for ( LineString::Vertices::const_iterator iter = vertices.begin(); iter != vertices.end() - 1; ++iter )
-    {
-      Node::Location translated ( *iter );
-      Cache::_translate ( translated );
-      sql = Usul::Strings::format ( sql, ToString::convert ( translated[0] ), " ", ToString::convert ( translated[1] ), ", " );
-    }
+    if ( iter != vertices.begin() )
+      text += ", ";
 
-    Node::Location translated ( vertices.back() );
+    Node::Location translated ( *iter );
     Cache::_translate ( translated );
-    sql = Usul::Strings::format ( sql, ToString::convert ( translated[0] ), " ", ToString::convert ( translated[1] ) );
+    text += ToString::convert ( translated[0] );
+    text += ' ';
+    text += ToString::convert ( translated[1] );
   }
   
-  sql = Usul::Strings::format ( sql, " )', 4326 )" );
-  return sql;
+  text += " )";
+  return text;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Create sql for creating a point.
+//  Create well-known text for a point. Bind it to GeomFromText.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -503,7 +539,7 @@ std::string Cache::_createPointText ( const Node::Location& location )
   typedef Usul::Convert::Type<double,std::string> ToString;
   Node::Location translated ( location );
   Cache::_translate ( translated );
-  return Usul::Strings::format ( "GeomFromText ( 'POINT ( ", ToString::convert ( translated[0] ), ' ', ToString::convert ( translated[1] ), " )', 4326 )" );
+  return Usul::Strings::format ( "POINT ( ", ToString::convert ( translated[0] ), ' ', ToString::convert ( translated[1] ), " )" );
 }
 
 
@@ -552,6 +588,21 @@ std::string Cache::_createIndexQuery ( const std::string& tableName, const std::
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the key for data that belongs to a level. The tolerance is part of
+//  the key, so changing the simplify pixels doesn't use the old lines.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string Cache::_levelKey ( const std::string& key, unsigned int level, double tolerance )
+{
+  std::ostringstream out;
+  out << std::setprecision ( 17 ) << key << "_level_" << level << "_tolerance_" << tolerance;
+  return out.str();
+}
+
+
 SQL_LITE_WRAP_DEFINE_VECTOR_BINDER ( LineString::NodeIds );
 
 
@@ -570,7 +621,23 @@ void Cache::addLineData ( const std::string& key, const Extents& extents, const
   // Cache that we have these extents.
   const int entryId ( this->_addLineEntry ( key, extents ) );
 
+  const std::string columns ( Usul::Strings::format ( 
+      KEY_COLUMN, ", ", 
+      ENTRY_ID, ", ",
+      OBJECT_ID_COLUMN, ", ", 
+      DATE_COLUMN, ", ", 
+      NUM_NODES_COLUMN, ", ", 
+      NODE_IDS_COLUMN, ", ", 
+      GEOMETRY_COLUMN ) );
+
+  const std::string sql ( Usul::Strings::format ( 
+    "INSERT INTO ", LINE_STRING_TABLE_NAME, " ( ", columns, " ) values ( ?, ?, ?, ?, ?, ?, GeomFromText ( ?, 4326 ) )" ) );
+
   CadKit::Database::SQLite::Transaction<CadKit::Database::SQLite::Connection::RefPtr> transaction ( _connection );
+
+  // Prepare once for all the lines.
+  Statement::RefPtr statement ( _connection->prepare ( sql ) );
+
   for ( Lines::const_iterator iter = lines.begin(); iter != lines.end(); ++iter )
   {
     LineString::RefPtr line ( *iter );
@@ -580,37 +647,21 @@ void Cache::addLineData ( const std::string& key, const Extents& extents, const
       LineString::Date timestamp ( line->timestamp() );
       LineString::Tags tags ( line->tags() );
       
-      const std::string geometry ( Cache::_createLineText ( line->vertices() ) );
-
-      LineString::NodeIds ids ( line->ids() );
+      const LineString::NodeIds& ids ( line->ids() );
       unsigned int numNodes ( ids.size() );
 
       if ( numNodes >= 2 )
       {
-        const std::string columns ( Usul::Strings::format ( 
-            KEY_COLUMN, ", ", 
-            ENTRY_ID, ", ",
-            OBJECT_ID_COLUMN, ", ", 
-            DATE_COLUMN, ", ", 
-            NUM_NODES_COLUMN, ", ", 
-            NODE_IDS_COLUMN, ", ", 
-            GEOMETRY_COLUMN ) );
-
-        const std::string values ( Usul::Strings::format ( 
-            "\"", key, "\", ", 
-            entryId, ", ",
-            id, ", ", 
-            "\"", timestamp.toString(), "\", ", 
-            numNodes, ", ", 
-            "?", ", ", 
-            "", geometry, "" ) );
-
-        const std::string sql ( Usul::Strings::format ( 
-          "INSERT INTO ", LINE_STRING_TABLE_NAME, " ( ", columns, " ) values (", values, " )" ) );
-        
         USUL_TRY_BLOCK
         {
-          _connection->execute ( sql, ids );
+          statement->bind ( 0, key );
+          statement->bind ( 1, entryId );
+          statement->bind ( 2, id );
+          statement->bind ( 3, timestamp.toString() );
+          statement->bind ( 4, numNodes );
+          statement->bindValue ( 5, ids );
+          statement->bind ( 6, Cache::_createLineText ( line->vertices() ) );
+          statement->execute();
         }
         USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "6077392060" );
 
@@ -724,6 +775,42 @@ bool Cache::hasLineData ( const std::string& key, const Extents& extents ) const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add line data for a level and tolerance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Cache::addLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents, const Lines& lines )
+{
+  this->addLineData ( Cache::_levelKey ( key, level, tolerance ), extents, lines );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the line data for a level and tolerance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Cache::getLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents, Lines& lines ) const
+{
+  this->getLineData ( Cache::_levelKey ( key, level, tolerance ), extents, lines );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Does the line data for a level and tolerance exist in the cache?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Cache::hasLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents ) const
+{
+  return this->hasLineData ( Cache::_levelKey ( key, level, tolerance ), extents );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Add an entry in the cache for this key and extents.
@@ -740,26 +827,24 @@ int Cache::_addLineEntry ( const std::string& key, const Extents& extents )
     MIN_LON, ", ", MIN_LAT, ", ", 
     MAX_LON, ", ", MAX_LAT ) );
 
-  typedef Usul::Convert::Type<double,std::string> ToString;
-  const std::string values ( Usul::Strings::format ( "\"", key, "\", ", 
-    ToString::convert ( extents.minLon() ), ", ", ToString::convert ( extents.minLat() ), ", ", 
-    ToString::convert ( extents.maxLon() ), ", ", ToString::convert ( extents.maxLat() ) ) );
-
   const std::string sql ( Usul::Strings::format ( 
-    "INSERT INTO ", LINE_STRING_CACHE_ENTRIES, " ( ", columns, " ) values (", values, " )" ) );
+    "INSERT INTO ", LINE_STRING_CACHE_ENTRIES, " ( ", columns, " ) values ( ?, ?, ?, ?, ? )" ) );
 
   USUL_TRY_BLOCK
   {
-    _connection->execute ( sql );
+    // Keep the connection locked so the row id is ours.
+    Guard connectionGuard ( _connection->mutex() );
+
+    Statement::RefPtr statement ( _connection->prepare ( sql ) );
+    statement->bind ( 0, key );
+    statement->bind ( 1, extents.minLon() );
+    statement->bind ( 2, extents.minLat() );
+    statement->bind ( 3, extents.maxLon() );
+    statement->bind ( 4, extents.maxLat() );
+    statement->execute();
 
     // Get the row id that was just inserted.
-    CadKit::Database::SQLite::Result::RefPtr result ( _connection->execute ( "SELECT last_insert_rowid()" ) );
-    if ( result->prepareNextRow() )
-    {
-      int id ( -1 );
-      *result >> id;
-      return id;
-    }
+    return static_cast<int> ( _connection->lastInsertRowId() );
   }
   USUL_DEFINE_SAFE_CALL_CATCH_BLOCKS ( "3363880230" );
 
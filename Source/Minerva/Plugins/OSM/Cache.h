@@ -50,6 +50,11 @@ public:
   void getLineData ( const std::string& key, const Extents& extents, Lines& lines ) const;
   bool hasLineData ( const std::string& key, const Extents& extents ) const;
 
+  /// Lines that have been simplified for a level and tolerance are kept apart from the full lines.
+  void addLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents, const Lines& line );
+  void getLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents, Lines& lines ) const;
+  bool hasLineData ( const std::string& key, unsigned int level, double tolerance, const Extents& extents ) const;
+
 protected:
 
   virtual ~Cache();
@@ -69,6 +74,7 @@ protected:
   static std::string _createLineText ( const LineString::Vertices& vertices );
   static std::string _createPointText ( const Node::Location& location );
   static std::string _createIndexQuery ( const std::string& tableName, const std::string& columnName, const Extents& extents );
+  static std::string _levelKey ( const std::string& key, unsigned int level, double tolerance );
 
   static void _translate ( Node::Location& location );
   static void _unTranslate ( Node::Location& location );
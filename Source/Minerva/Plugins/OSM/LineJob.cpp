@@ -20,13 +20,30 @@
 
 #include "Minerva/Core/Data/DataObject.h"
 #include "Minerva/Core/Data/Line.h"
+#include "Minerva/Core/Data/MultiGeometry.h"
 
 #include "Minerva/Common/IElevationDatabase.h"
 #include "Minerva/Common/IPlanetCoordinates.h"
 
+#include "Usul/Registry/Database.h"
+
+#include <algorithm>
+
 using namespace Minerva::Layers::OSM;
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The number of pixels across a tile when it is drawn.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+  const double TILE_SIZE_PIXELS ( 256.0 );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Constructor.
@@ -72,7 +89,7 @@ void LineJob::_started()
   XAPIMapQuery query ( this->_makeQuery() );
 
   Lines lines;
-  query.makeLinesQuery ( lines, this );
+  query.makeLinesQuery ( lines, this->level(), this->_tolerance(), this );
 
   this->_setStatus ( "Building data objects" );
 
@@ -94,31 +111,23 @@ void LineJob::_buildDataObjects ( const Lines& lines )
   Minerva::Core::Data::Style::RefPtr style ( new Minerva::Core::Data::Style );
   style->linestyle ( lineStyle );
 
-  DataObject::RefPtr object ( new DataObject );
-
-  // TODO: change the stride based of the current level. (Or interpolate a NURBS curve and evaluate the desired number of points.)
-#ifdef _DEBUG
-  const unsigned int stride ( 8 );
-#else
-
-  unsigned int stride ( 1 );
+  // All the lines for the tile go in one geometry.
+  Minerva::Core::Data::MultiGeometry::RefPtr geometry ( new Minerva::Core::Data::MultiGeometry );
+  geometry->reserveGeometry ( lines.size() );
 
-  if ( this->level() < 10 )
-    stride = 5;
-#endif
-
-  // Add all the nodes.
   for ( Lines::const_iterator iter = lines.begin(); iter != lines.end(); ++iter )
   {
     LineString::RefPtr line ( *iter );
     if ( line.valid() )
     {
-      // Make a line.
-      object->geometry ( line->buildGeometry ( stride ) );
-      object->style ( style );
+      geometry->addGeometry ( line->buildGeometry() );
     }
   }
 
+  DataObject::RefPtr object ( new DataObject );
+  object->geometry ( geometry.get() );
+  object->style ( style );
+
   Minerva::Common::IElevationDatabase::QueryPtr elevation ( _caller );
   Minerva::Common::IPlanetCoordinates::QueryPtr planet ( _caller );
 
@@ -127,6 +136,24 @@ void LineJob::_buildDataObjects ( const Lines& lines )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the simplification tolerance in degrees for this tile. Dropping a
+//  vertex moves the line by less than the allowed number of pixels when the
+//  tile is drawn at its level.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double LineJob::_tolerance() const
+{
+  const Extents extents ( this->extents() );
+  const double size ( std::max ( extents.maxLon() - extents.minLon(), extents.maxLat() - extents.minLat() ) );
+  const double pixels ( Usul::Registry::Database::instance()["osm_lines"]["simplify_pixels"].get<double> ( 1.0, true ) );
+
+  return pixels * size / Detail::TILE_SIZE_PIXELS;
+}
+
+
 /// Set/get the line style.
 void LineJob::lineStyle ( LineStyle::RefPtr style )
 {
@@ -54,6 +54,9 @@ protected:
 
   void _buildDataObjects ( const Lines& lines );
 
+  /// Get the simplification tolerance in degrees for this tile.
+  double _tolerance() const;
+
 private:
 
   Usul::Interfaces::IUnknown::RefPtr _caller;
@@ -15,6 +15,7 @@
 
 #include "Minerva/Plugins/OSM/LineString.h"
 
+#include "Minerva/Core/Algorithms/Simplify.h"
 #include "Minerva/Core/Data/Line.h"
 
 using namespace Minerva::Layers::OSM;
@@ -104,22 +105,16 @@ LineString* LineString::create ( Way::IdType id, const Date& timestamp, const Ta
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-Minerva::Core::Data::Line* LineString::buildGeometry ( unsigned int stride ) const
+Minerva::Core::Data::Line* LineString::buildGeometry() const
 {
   // Make a line.
   Minerva::Core::Data::Line::RefPtr line ( new Minerva::Core::Data::Line );
   Minerva::Core::Data::Line::Vertices vertices;
   vertices.reserve ( _vertices.size() );
 
-  for ( unsigned int i = 0; i < _vertices.size(); i += stride )
+  for ( Vertices::const_iterator iter = _vertices.begin(); iter != _vertices.end(); ++iter )
   {
-    Node::Location location ( _vertices.at ( i ) );
-    vertices.push_back ( Usul::Math::Vec3d ( location[0], location[1], 0.0 ) );
-  }
-
-  if ( ( 1 != stride ) && ( false == _vertices.empty() ) && ( 0 != ( _vertices.size() % stride ) ) )
-  {
-    Node::Location location ( _vertices.back() );
+    const Node::Location& location ( *iter );
     vertices.push_back ( Usul::Math::Vec3d ( location[0], location[1], 0.0 ) );
   }
 
@@ -130,6 +125,36 @@ Minerva::Core::Data::Line* LineString::buildGeometry ( unsigned int stride ) con
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a copy without the vertices that are within the tolerance of the
+//  line (Douglas-Peucker). The node ids are kept with their vertices.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+LineString* LineString::simplify ( double tolerance ) const
+{
+  std::vector<unsigned int> keep;
+  Minerva::Core::Algorithms::simplify ( _vertices, tolerance, keep );
+
+  const bool hasIds ( _ids.size() == _vertices.size() );
+
+  Vertices vertices;
+  NodeIds ids;
+  vertices.reserve ( keep.size() );
+  ids.reserve ( hasIds ? keep.size() : 0 );
+
+  for ( std::vector<unsigned int>::const_iterator iter = keep.begin(); iter != keep.end(); ++iter )
+  {
+    vertices.push_back ( _vertices[*iter] );
+    if ( hasIds )
+      ids.push_back ( _ids[*iter] );
+  }
+
+  return new LineString ( _id, this->timestamp(), this->tags(), vertices, ids );
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the ids.
@@ -40,7 +40,10 @@ public:
   static LineString* create ( IdType id, const Date& timestamp, const Tags& tags, const Vertices& vertices, const NodeIds& ids );
   
   /// Build the geometry.
-  Minerva::Core::Data::Line* buildGeometry ( unsigned int stride ) const;
+  Minerva::Core::Data::Line* buildGeometry() const;
+
+  /// Make a copy without the vertices that are within the tolerance of the line.
+  LineString* simplify ( double tolerance ) const;
 
   const NodeIds& ids() const;
   const Vertices& vertices() const;
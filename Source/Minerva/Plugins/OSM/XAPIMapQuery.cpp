@@ -78,8 +78,7 @@ void XAPIMapQuery::makeNodesQuery ( Nodes& nodes, Usul::Interfaces::IUnknown::Qu
 
   Usul::Interfaces::IStatusBar::UpdateStatusBar status ( unknown.get() );
 
-  std::string cacheKey ( _predicate.first + "_" + _predicate.second );
-  std::replace ( cacheKey.begin(), cacheKey.end(), '*', '_' );
+  const std::string cacheKey ( this->_cacheKey() );
 
   status ( "Checking cache" );
   if ( _cache.valid() && _cache->hasNodeData ( cacheKey, _extents ) )
@@ -129,8 +128,7 @@ void XAPIMapQuery::makeLinesQuery ( Lines& lines, Usul::Interfaces::IUnknown::Qu
 
   Usul::Interfaces::IStatusBar::UpdateStatusBar status ( unknown.get() );
 
-  std::string cacheKey ( _predicate.first + "_" + _predicate.second );
-  std::replace ( cacheKey.begin(), cacheKey.end(), '*', '_' );
+  const std::string cacheKey ( this->_cacheKey() );
 
   status ( "Checking cache" );
   if ( _cache.valid() && _cache->hasLineData ( cacheKey, _extents ) )
@@ -167,6 +165,50 @@ void XAPIMapQuery::makeLinesQuery ( Lines& lines, Usul::Interfaces::IUnknown::Qu
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Gets the ways simplified to the tolerance.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void XAPIMapQuery::makeLinesQuery ( Lines& lines, unsigned int level, double tolerance, Usul::Interfaces::IUnknown::QueryPtr unknown )
+{
+  Usul::Interfaces::IStatusBar::UpdateStatusBar status ( unknown.get() );
+
+  const std::string cacheKey ( this->_cacheKey() );
+
+  status ( "Checking cache" );
+  if ( _cache.valid() && _cache->hasLineData ( cacheKey, level, tolerance, _extents ) )
+  {
+    status ( "Reading cache" );
+    _cache->getLineData ( cacheKey, level, tolerance, _extents, lines );
+    return;
+  }
+
+  Lines all;
+  this->makeLinesQuery ( all, unknown );
+
+  status ( "Simplifying" );
+  lines.reserve ( lines.size() + all.size() );
+  for ( Lines::const_iterator iter = all.begin(); iter != all.end(); ++iter )
+  {
+    LineString::RefPtr line ( *iter );
+    if ( line.valid() )
+    {
+      lines.push_back ( line->simplify ( tolerance ) );
+    }
+  }
+
+  // Only cache the simplified lines if the full lines made it into the cache,
+  // otherwise a failed download would be remembered.
+  if ( _cache.valid() && _cache->hasLineData ( cacheKey, _extents ) )
+  {
+    status ( "Caching data" );
+    _cache->addLineData ( cacheKey, level, tolerance, _extents, lines );
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Build the request url.
@@ -180,3 +222,17 @@ std::string XAPIMapQuery::_buildRequestUrl ( const std::string& requestType ) co
   const std::string request ( Usul::Strings::format ( _url, "/api/0.6/", requestType, bbox, predicateString ) );
   return request;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the key for the cache.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string XAPIMapQuery::_cacheKey() const
+{
+  std::string cacheKey ( _predicate.first + "_" + _predicate.second );
+  std::replace ( cacheKey.begin(), cacheKey.end(), '*', '_' );
+  return cacheKey;
+}
@@ -40,9 +40,13 @@ public:
   void makeNodesQuery ( Nodes& nodes, Usul::Interfaces::IUnknown::QueryPtr unknown );
   void makeLinesQuery ( Lines& lines, Usul::Interfaces::IUnknown::QueryPtr unknown );
 
+  /// Get the lines simplified to the tolerance. They are cached for the level.
+  void makeLinesQuery ( Lines& lines, unsigned int level, double tolerance, Usul::Interfaces::IUnknown::QueryPtr unknown );
+
 private:
 
   std::string _buildRequestUrl ( const std::string& requestType ) const;
+  std::string _cacheKey() const;
   
   Cache::RefPtr _cache;
   const std::string& _url;
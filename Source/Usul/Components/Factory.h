@@ -28,7 +28,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Macro for functions needed in Cadkit plugins.
+//  Macro for functions needed in Cadkit plugins. A library can also define 
+//  extern "C" void usul_plugin_finalize(), which the manager calls before 
+//  the library is released.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
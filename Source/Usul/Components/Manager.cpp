@@ -11,6 +11,7 @@
 #include "Usul/DLL/Library.h"
 #include "Usul/Interfaces/IPlugin.h"
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <set>
@@ -69,6 +70,36 @@ std::string _buildMode ( bool debug )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Let the library clean up before it is released. This is the place to 
+//  stop threads, which can't be joined while the library is unloading.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _finalize ( const LibPtr &lib )
+{
+  try
+  {
+    typedef void (*Finalize)();
+    Finalize finalize ( (Finalize) lib->function ( "usul_plugin_finalize" ) );
+    if ( 0x0 != finalize )
+    {
+      finalize();
+    }
+  }
+  catch ( const std::exception& e )
+  {
+    std::cout << "Error 3317460927: Exception caught while finalizing " << lib->filename() << std::endl;
+    std::cout << "Message: " << e.what() << std::endl;
+  }
+  catch ( ... )
+  {
+    std::cout << "Error 1178943250: Unknown exception caught while finalizing " << lib->filename() << std::endl;
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  End of details.
@@ -200,6 +231,7 @@ void Manager::clear ( std::ostream *out )
   if ( 0x0 == out )
   {
     _unknowns.clear(); 
+    std::for_each ( Helper::_pool.begin(), Helper::_pool.end(), Helper::_finalize );
     Helper::_pool.clear();
     return;
   }
@@ -214,6 +246,9 @@ void Manager::clear ( std::ostream *out )
     _unknowns.erase ( i );
   }
 
+  // The libraries may use each other, so all are finalized before any is released.
+  std::for_each ( Helper::_pool.begin(), Helper::_pool.end(), Helper::_finalize );
+
   while ( false == Helper::_pool.empty() )
   {
     Helper::LibraryPool::iterator i ( Helper::_pool.begin() );
@@ -57,7 +57,7 @@ public:
   unsigned long             id() const;
 
   // Is the job done?
-  bool                      isDone() const;
+  virtual bool              isDone() const;
 
   // Get/Set the priority.
   void                      priority( int );
@@ -203,10 +203,10 @@ unsigned long Manager::nextJobId()
 void Manager::wait()
 {
   this->_logEvent ( "Waiting for tasks... " );
-  {
-    Guard guard ( this );
-    _pool.waitForTasks();
-  }
+
+  // Don't hold our mutex. Running jobs may need it to add more jobs.
+  _pool.waitForTasks();
+
   this->_logEvent ( "Done waiting for tasks" );
 }
 
@@ -290,6 +290,18 @@ std::size_t Manager::numJobsQueued() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Number of jobs finished.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned long Manager::numJobsFinished() const
+{
+  return _pool.numTasksFinished();
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Number of jobs executing.
@@ -311,8 +323,9 @@ std::size_t Manager::numJobsExecuting() const
 
 std::size_t Manager::numJobs() const
 {
-  Guard guard ( this );
-  return ( this->numJobsQueued() + this->numJobsExecuting() );
+  // The pool's count is updated together with its queues. The sum of queued 
+  // and executing can miss a job between being dequeued and starting.
+  return _pool.numTasks();
 }
 
 
@@ -84,6 +84,9 @@ public:
   std::size_t             numJobsExecuting() const;
   std::size_t             numJobsQueued() const;
 
+  // Get the number of jobs that have finished. This only goes up.
+  unsigned long           numJobsFinished() const;
+
   // Return the mutex. Use with caution.
   Mutex &                 mutex() const;
 
@@ -93,7 +96,7 @@ public:
   // Remove the queued job. Has no effect on running jobs.
   void                    removeQueuedJob ( Job::RefPtr );
 
-  // Wait for all jobs to complete.
+  // Wait for all jobs to complete, including any they add while we wait.
   void                    wait();
 
 private:
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Class that queries the instruction sets the processor supports.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/System/Processor.h"
+
+#if defined ( _MSC_VER ) && ( defined ( _M_IX86 ) || defined ( _M_X64 ) )
+# include <intrin.h>
+# define USUL_PROCESSOR_X86
+#elif defined ( __GNUC__ ) && ( defined ( __i386__ ) || defined ( __x86_64__ ) )
+# include <cpuid.h>
+# define USUL_PROCESSOR_X86
+#endif
+
+using namespace Usul::System;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helper functions that read the cpuid registers.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef USUL_PROCESSOR_X86
+
+namespace Helper
+{
+  struct Registers
+  {
+    unsigned int eax, ebx, ecx, edx;
+  };
+
+  inline bool cpuid ( unsigned int leaf, unsigned int subLeaf, Registers& r )
+  {
+    r.eax = r.ebx = r.ecx = r.edx = 0;
+
+#ifdef _MSC_VER
+
+    int info[4] = { 0, 0, 0, 0 };
+    ::__cpuid ( info, 0 );
+    if ( static_cast<unsigned int> ( info[0] ) < leaf )
+      return false;
+
+    ::__cpuidex ( info, static_cast<int> ( leaf ), static_cast<int> ( subLeaf ) );
+    r.eax = info[0]; r.ebx = info[1]; r.ecx = info[2]; r.edx = info[3];
+    return true;
+
+#else
+
+    if ( ::__get_cpuid_max ( 0, 0x0 ) < leaf )
+      return false;
+
+    __cpuid_count ( leaf, subLeaf, r.eax, r.ebx, r.ecx, r.edx );
+    return true;
+
+#endif
+  }
+
+  // Has the operating system enabled saving the AVX registers?
+  inline bool osSavesYmm()
+  {
+    Registers r;
+    if ( false == Helper::cpuid ( 1, 0, r ) )
+      return false;
+
+    // OSXSAVE and AVX.
+    if ( ( 0 == ( r.ecx & ( 1u << 27 ) ) ) || ( 0 == ( r.ecx & ( 1u << 28 ) ) ) )
+      return false;
+
+#ifdef _MSC_VER
+    const unsigned long long xcr0 ( ::_xgetbv ( 0 ) );
+#else
+    unsigned int lo ( 0 ), hi ( 0 );
+    __asm__ __volatile__ ( "xgetbv" : "=a" ( lo ), "=d" ( hi ) : "c" ( 0 ) );
+    const unsigned long long xcr0 ( ( static_cast<unsigned long long> ( hi ) << 32 ) | lo );
+#endif
+
+    // XMM and YMM state.
+    return ( 0x6 == ( xcr0 & 0x6 ) );
+  }
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Does the processor support SSE2?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Processor::hasSSE2()
+{
+#ifdef USUL_PROCESSOR_X86
+  Helper::Registers r;
+  return ( Helper::cpuid ( 1, 0, r ) && ( 0 != ( r.edx & ( 1u << 26 ) ) ) );
+#else
+  return false;
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Does the processor support SSE4.1?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Processor::hasSSE41()
+{
+#ifdef USUL_PROCESSOR_X86
+  Helper::Registers r;
+  return ( Helper::cpuid ( 1, 0, r ) && ( 0 != ( r.ecx & ( 1u << 19 ) ) ) );
+#else
+  return false;
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Does the processor support AVX2? The operating system also has to save 
+//  the wide registers when switching threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Processor::hasAVX2()
+{
+#ifdef USUL_PROCESSOR_X86
+  Helper::Registers r;
+  return ( Helper::osSavesYmm() && Helper::cpuid ( 7, 0, r ) && ( 0 != ( r.ebx & ( 1u << 5 ) ) ) );
+#else
+  return false;
+#endif
+}
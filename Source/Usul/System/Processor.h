@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Class that queries the instruction sets the processor supports.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_SYSTEM_PROCESSOR_CLASS_H_
+#define _USUL_SYSTEM_PROCESSOR_CLASS_H_
+
+#include "Usul/Export/Export.h"
+
+namespace Usul {
+namespace System {
+
+
+struct USUL_EXPORT Processor
+{
+  // Does the processor (and operating system) support the instruction set?
+  static bool                      hasSSE2();
+  static bool                      hasSSE41();
+  static bool                      hasAVX2();
+};
+
+
+} // namespace System
+} // namespace Usul
+
+
+#endif // _USUL_SYSTEM_PROCESSOR_CLASS_H_
@@ -15,7 +15,6 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Usul/System/Sleep.h"
-#include "Usul/Math/MinMax.h"
 
 #ifdef _MSC_VER
 # define NOMINMAX
@@ -43,9 +42,13 @@ void Usul::System::Sleep::milliseconds ( unsigned long duration )
   // Convert to microseconds
   duration *= 1000;
   
-  // Cap just shy of a million.
+  // usleep only takes values under a million, so sleep whole seconds first.
   // http://www.opengroup.org/onlinepubs/007908799/xsh/usleep.html
-  duration = Usul::Math::maximum<unsigned long> ( duration, 999999 );
+  if ( duration >= 1000000 )
+  {
+    ::sleep ( static_cast<unsigned int> ( duration / 1000000 ) );
+    duration %= 1000000;
+  }
 
   ::usleep ( duration );
 
@@ -9,7 +9,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Thread pool class.
+//  Thread pool class. Each worker thread owns a queue of tasks sorted by 
+//  priority. Idle workers steal from the other queues and block on a 
+//  condition variable when there is nothing to do.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -17,7 +19,6 @@
 #include "Usul/Errors/Assert.h"
 #include "Usul/Exceptions/Canceled.h"
 #include "Usul/Functions/SafeCall.h"
-#include "Usul/System/Sleep.h"
 #include "Usul/Threads/ThreadName.h"
 #include "Usul/Threads/Safe.h"
 
@@ -46,16 +47,31 @@ using namespace Usul::Threads;
 Pool::Pool ( const std::string &n, unsigned int numThreads ) :
   _mutex(),
   _pool       (),
-  _queue      (),
+  _queues     (),
   _executing  (),
   _nextTaskId ( 0 ),
-  _sleep      ( 10 ), // Was 100. Rational Quantify said it was a bottleneck.
+  _numStolen  ( 0 ),
+  _sleep      ( 10 ),
   _numThreads ( numThreads ),
+  _wakeMutex  (),
+  _wakeCondition(),
+  _idleCondition(),
+  _numQueued  ( 0 ),
+  _numOutstanding ( 0 ),
+  _numFinished ( 0 ),
+  _numWaiting ( 0 ),
   _runThreads ( true ),
   _started    ( false ),
   _log        ( 0x0 ),
   _name ( n )
 {
+  // Always have at least one queue so that tasks can be added.
+  const unsigned int numQueues ( std::max<unsigned int> ( 1, numThreads ) );
+  _queues.reserve ( numQueues );
+  for ( unsigned int i = 0; i < numQueues; ++i )
+  {
+    _queues.push_back ( new WorkerQueue );
+  }
 }
 
 
@@ -81,8 +97,12 @@ void Pool::_destroy()
 {
   // Do not lock mutex up here! Threads waiting for this mutex will never finish.
 
-  // Turn off the switch.
-  Usul::Threads::Safe::set ( this->mutex(), false, _runThreads );
+  // Turn off the switch and wake up any threads that are waiting for work.
+  {
+    boost::mutex::scoped_lock lock ( _wakeMutex );
+    _runThreads = false;
+  }
+  _wakeCondition.notify_all();
 
   // Clear all queued tasks and cancel running threads.
   this->cancel();
@@ -91,7 +111,7 @@ void Pool::_destroy()
   this->_waitForThreads();
 
   // Should be true.
-  USUL_ASSERT ( true == _queue.empty() );
+  USUL_ASSERT ( 0 == this->numTasksQueued() );
   USUL_ASSERT ( true == _executing.empty() );
 
   for ( ThreadPool::iterator iter = _pool.begin(); iter != _pool.end(); ++iter )
@@ -100,6 +120,13 @@ void Pool::_destroy()
     *iter = 0x0;
   }
   _pool.clear();
+
+  for ( WorkerQueues::iterator iter = _queues.begin(); iter != _queues.end(); ++iter )
+  {
+    delete *iter;
+    *iter = 0x0;
+  }
+  _queues.clear();
 }
 
 
@@ -118,15 +145,50 @@ Pool::TaskHandle Pool::addTask ( int priority, Task::RefPtr task )
   // Make handle.
   TaskHandle key ( priority, task->id() );
 
+  // Pick the queue from the task id. The ids go up by one, so the tasks 
+  // are spread over the queues in turn, and a task that is added again 
+  // always lands in the queue that already holds it. That makes the 
+  // duplicate check below see every queue. Idle workers will steal from 
+  // the queue if the owner is busy. Count the task before it is visible 
+  // to the workers so that the counters never go negative. A worker that 
+  // starts to wait after this sees the count and doesn't, so only the 
+  // ones waiting now need to be woken.
+  const std::size_t index ( static_cast < std::size_t > ( task->id() ) % _queues.size() );
+  bool wake ( false );
+  {
+    boost::mutex::scoped_lock lock ( _wakeMutex );
+    ++_numOutstanding;
+    ++_numQueued;
+    wake = ( _numWaiting > 0 );
+  }
+
   // Add task.
+  bool replaced ( false );
   {
-    Guard guard ( this );
-    _queue[key] = task;
+    WorkerQueue &queue ( *_queues.at ( index ) );
+    WorkerQueue::Guard guard ( queue.mutex() );
+    replaced = ( false == queue._tasks.insert ( TaskMap::value_type ( key, task ) ).second );
+    if ( true == replaced )
+    {
+      queue._tasks[key] = task;
+    }
   }
 
   // Make sure the threads are started.
   this->_startThreads();
 
+  // Wake up a worker, unless we replaced a task that is already counted.
+  if ( true == replaced )
+  {
+    boost::mutex::scoped_lock lock ( _wakeMutex );
+    --_numOutstanding;
+    --_numQueued;
+  }
+  else if ( true == wake )
+  {
+    _wakeCondition.notify_one();
+  }
+
   // Return key.
   return key;
 }
@@ -167,9 +229,16 @@ void Pool::cancel()
 
 bool Pool::hasQueuedTask ( TaskHandle id ) const
 {
-  Guard guard ( this );
-  TaskMap::const_iterator i ( _queue.find ( id ) );
-  return ( _queue.end() != i );
+  for ( WorkerQueues::const_iterator i = _queues.begin(); i != _queues.end(); ++i )
+  {
+    const WorkerQueue &queue ( **i );
+    WorkerQueue::Guard guard ( queue.mutex() );
+    if ( queue._tasks.end() != queue._tasks.find ( id ) )
+    {
+      return true;
+    }
+  }
+  return false;
 }
 
 
@@ -205,9 +274,41 @@ std::size_t Pool::numThreads() const
 ///////////////////////////////////////////////////////////////////////////////
 
 std::size_t Pool::numTasksQueued() const
+{
+  std::size_t num ( 0 );
+  for ( WorkerQueues::const_iterator i = _queues.begin(); i != _queues.end(); ++i )
+  {
+    const WorkerQueue &queue ( **i );
+    WorkerQueue::Guard guard ( queue.mutex() );
+    num += queue._tasks.size();
+  }
+  return num;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of tasks that were taken from another worker's queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned long Pool::numTasksStolen() const
 {
   Guard guard ( this );
-  return _queue.size();
+  return _numStolen;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of tasks that have finished executing.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned long Pool::numTasksFinished() const
+{
+  boost::mutex::scoped_lock lock ( _wakeMutex );
+  return _numFinished;
 }
 
 
@@ -251,15 +352,10 @@ void Pool::executingNames ( Strings &names ) const
 
 std::size_t Pool::numTasks() const
 {
-  // Lock so that the answers are in sync.
-  Guard guard ( this );
-
-  // Get the numbers.
-  const std::size_t queued ( this->numTasksQueued() );
-  const std::size_t executing ( this->numTasksExecuting() );
-
-  // Return the sum.
-  return ( queued + executing );
+  // This counter covers both queued and executing tasks, and is updated 
+  // together with the queues so that the answer is in sync.
+  boost::mutex::scoped_lock lock ( _wakeMutex );
+  return _numOutstanding;
 }
 
 
@@ -271,12 +367,76 @@ std::size_t Pool::numTasks() const
 
 void Pool::removeQueuedTask ( TaskHandle id )
 {
-  Guard guard ( this );
+  for ( WorkerQueues::iterator i = _queues.begin(); i != _queues.end(); ++i )
+  {
+    WorkerQueue &queue ( **i );
+    bool removed ( false );
+    {
+      WorkerQueue::Guard guard ( queue.mutex() );
+      removed = ( queue._tasks.erase ( id ) > 0 );
+    }
+    if ( true == removed )
+    {
+      this->_taskDequeued ( 1, false );
+      return;
+    }
+  }
+}
 
-  TaskMap::iterator i ( _queue.find ( id ) );
-  if ( _queue.end() != i )
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when tasks are taken out of the queues.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Pool::_taskDequeued ( std::size_t num, bool executing )
+{
+  if ( 0 == num )
+    return;
+
+  bool idle ( false );
+  {
+    boost::mutex::scoped_lock lock ( _wakeMutex );
+    USUL_ASSERT ( _numQueued >= num );
+    _numQueued -= num;
+
+    // If the tasks are not going to be executed then they are done.
+    if ( false == executing )
+    {
+      USUL_ASSERT ( _numOutstanding >= num );
+      _numOutstanding -= num;
+      idle = ( 0 == _numOutstanding );
+    }
+  }
+
+  if ( true == idle )
   {
-    _queue.erase ( i );
+    _idleCondition.notify_all();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when an executing task is done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Pool::_taskFinished()
+{
+  bool idle ( false );
+  {
+    boost::mutex::scoped_lock lock ( _wakeMutex );
+    USUL_ASSERT ( _numOutstanding > 0 );
+    --_numOutstanding;
+    ++_numFinished;
+    idle = ( 0 == _numOutstanding );
+  }
+
+  if ( true == idle )
+  {
+    _idleCondition.notify_all();
   }
 }
 
@@ -287,15 +447,21 @@ void Pool::removeQueuedTask ( TaskHandle id )
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Pool::_threadStarted()
+void Pool::_threadStarted ( std::size_t worker )
 {
   // Do not lock mutex here!
 
   // Loop until told otherwise.
-  while ( true == Usul::Threads::Safe::get ( this->mutex(), _runThreads ) )
+  while ( true )
   {
+    {
+      boost::mutex::scoped_lock lock ( _wakeMutex );
+      if ( false == _runThreads )
+        return;
+    }
+
     // Get the next task.
-    Task::RefPtr task ( this->_nextTask() );
+    Task::RefPtr task ( this->_nextTask ( worker ) );
     if ( true == task.valid() )
     {
       // Process any queued tasks. Catch and eat all exceptions.
@@ -307,14 +473,23 @@ void Pool::_threadStarted()
         USUL_ASSERT ( false == _executing.empty() );
         _executing.erase ( task );
       }
+      this->_taskFinished();
       
       task = 0x0;
     }
     
-    // We have no work to do, so sleep.
+    // We have no work to do, so wait until a task is added or we are told 
+    // to stop. If the counter says there are tasks then one was added to a 
+    // queue after we looked at it, so look again.
     else
     {
-      boost::this_thread::sleep ( boost::posix_time::milliseconds ( this->sleepDuration() ) );
+      boost::mutex::scoped_lock lock ( _wakeMutex );
+      while ( ( true == _runThreads ) && ( 0 == _numQueued ) )
+      {
+        ++_numWaiting;
+        _wakeCondition.wait ( lock );
+        --_numWaiting;
+      }
     }
   }
 }
@@ -366,37 +541,76 @@ void Pool::_threadProcessTask ( Usul::Threads::Task *task )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take the task at the front of the queue, if there is one. The front has 
+//  the best priority, and the lowest id among those. Since the task id 
+//  numbers always increase, the map acts like a queue if we always grab 
+//  from the beginning.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Usul::Threads::Task::RefPtr Pool::_popTask ( std::size_t index )
+{
+  WorkerQueue &queue ( *_queues[index] );
+  WorkerQueue::Guard guard ( queue.mutex() );
+  if ( true == queue._tasks.empty() )
+    return Usul::Threads::Task::RefPtr ( 0x0 );
+
+  Task::RefPtr task ( queue._tasks.begin()->second );
+  queue._tasks.erase ( queue._tasks.begin() );
+  return task;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get the next task. Make sure you return a copy of the smart-pointer! 
 //  Otherwise, with multiple threads running at once, the task could be 
 //  decremented by a different thread but after it's released here.
 //
+//  The worker takes from its own queue first, so the workers don't contend 
+//  for one lock. When its queue is empty it steals from the others in turn. 
+//  Priority is kept within each queue, but not across them. Since addTask 
+//  deals the tasks out in turn, each queue gets its share of the important 
+//  ones. isHigherPriorityTaskWaiting looks at every queue, so long jobs 
+//  that check it still give way.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
-Usul::Threads::Task::RefPtr Pool::_nextTask()
+Usul::Threads::Task::RefPtr Pool::_nextTask ( std::size_t worker )
 {
-  Guard guard ( this );
-
-  if ( false == _queue.empty() )
+  const std::size_t numQueues ( _queues.size() );
+  const std::size_t own ( worker % numQueues );
+
+  // Each pop is done under the queue's lock, so the task can't be taken 
+  // by another worker in between. Only when every queue was empty is 
+  // nothing returned.
+  Task::RefPtr task ( 0x0 );
+  std::size_t i ( 0 );
+  for ( ; ( i < numQueues ) && ( false == task.valid() ); ++i )
   {
-    // Since the task id numbers always increase, the map acts like 
-    // a queue if we always grab from the beginning.
-    Task::RefPtr task ( _queue.begin()->second );
-
-    // Remove the task from the queue.
-    _queue.erase ( _queue.begin() );
+    task = this->_popTask ( ( own + i ) % numQueues );
+  }
 
-    // While we have the lock...
-    _executing.insert ( task );
+  // Nothing to do.
+  if ( false == task.valid() )
+    return Usul::Threads::Task::RefPtr ( 0x0 );
 
-    // Return task.
-    return task;
-  }
-  else
+  // Move it to the executing set. It was stolen unless it came from the 
+  // first queue we looked at.
   {
-    return Usul::Threads::Task::RefPtr ( 0x0 );
+    Guard guard ( this );
+    _executing.insert ( task );
+    if ( i > 1 )
+    {
+      ++_numStolen;
+    }
   }
+  this->_taskDequeued ( 1, true );
+
+  // Return task.
+  return task;
 }
 
 
@@ -434,8 +648,15 @@ void Pool::sleepDuration ( unsigned long duration )
 
 void Pool::clearQueuedTasks()
 {
-  Guard guard ( this );
-  _queue.clear();
+  std::size_t num ( 0 );
+  for ( WorkerQueues::iterator i = _queues.begin(); i != _queues.end(); ++i )
+  {
+    WorkerQueue &queue ( **i );
+    WorkerQueue::Guard guard ( queue.mutex() );
+    num += queue._tasks.size();
+    queue._tasks.clear();
+  }
+  this->_taskDequeued ( num, false );
 }
 
 
@@ -447,15 +668,13 @@ void Pool::clearQueuedTasks()
 
 void Pool::waitForTasks()
 {
-  // While there are tasks...
-  std::size_t num ( this->numTasks() );
-  while ( num > 0 )
-  {
-    // Sleep some so that we don't spike the cpu.
-    Usul::System::Sleep::milliseconds ( this->sleepDuration() );
+  const unsigned long duration ( this->sleepDuration() );
 
-    // Get the number of tasks left.
-    num = this->numTasks();
+  // Block until the last task is done. The timeout is only a safety net.
+  boost::mutex::scoped_lock lock ( _wakeMutex );
+  while ( _numOutstanding > 0 )
+  {
+    _idleCondition.timed_wait ( lock, boost::posix_time::milliseconds ( duration ) );
   }
 }
 
@@ -517,7 +736,7 @@ void Pool::_startThreads()
     _pool.reserve ( _numThreads );
     for ( unsigned int i = 0; i < _numThreads; ++i )
     {
-      Thread *thread ( new Thread ( boost::bind ( &Pool::_threadStarted, this ) ) );
+      Thread *thread ( new Thread ( boost::bind ( &Pool::_threadStarted, this, static_cast < std::size_t > ( i ) ) ) );
       _pool.push_back ( thread );
 
       // This is an attempt to set the name.  Not working.
@@ -595,14 +814,17 @@ void Pool::_logEvent ( const std::string &s, std::ostream *stream )
 
 bool Pool::isHigherPriorityTaskWaiting ( int priority ) const
 {
-  Guard guard ( this );
-
-  if ( false == _queue.empty() )
+  for ( WorkerQueues::const_iterator i = _queues.begin(); i != _queues.end(); ++i )
   {
-    const TaskHandle &taskHandle ( _queue.begin()->first );
-    if ( taskHandle.first < priority )
+    const WorkerQueue &queue ( **i );
+    WorkerQueue::Guard guard ( queue.mutex() );
+    if ( false == queue._tasks.empty() )
     {
-      return true;
+      const TaskHandle &taskHandle ( queue._tasks.begin()->first );
+      if ( taskHandle.first < priority )
+      {
+        return true;
+      }
     }
   }
 
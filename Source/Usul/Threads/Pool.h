@@ -9,7 +9,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Thread pool class.
+//  Thread pool class. Each worker thread owns a queue of tasks sorted by 
+//  priority. Idle workers steal from the other queues and block on a 
+//  condition variable when there is nothing to do.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -20,6 +22,10 @@
 #include "Usul/Threads/Task.h"
 #include "Usul/Threads/RecursiveMutex.h"
 #include "Usul/Threads/Guard.h"
+#include "Usul/Threads/Mutex.h"
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
 
 #include <map>
 #include <set>
@@ -47,6 +53,21 @@ public:
   typedef std::vector < std::string > Strings;
   typedef Usul::File::Log::RefPtr LogPtr;
 
+  // Per-worker queue of tasks.
+  struct WorkerQueue
+  {
+    typedef Usul::Threads::Mutex Mutex;
+    typedef Usul::Threads::Guard<Mutex> Guard;
+
+    WorkerQueue() : _mutex(), _tasks() {}
+
+    Mutex &mutex() const { return _mutex; }
+
+    mutable Mutex _mutex;
+    TaskMap _tasks;
+  };
+  typedef std::vector < WorkerQueue* > WorkerQueues;
+
   // Constructor
   Pool ( const std::string &name, unsigned int numThreads );
   ~Pool();
@@ -95,11 +116,18 @@ public:
   // Get the number of tasks that are waiting to be executed.
   std::size_t             numTasksQueued() const;
 
+  // Get the number of tasks that were taken from another worker's queue.
+  unsigned long           numTasksStolen() const;
+
+  // Get the number of tasks that have finished executing. This only goes up, 
+  // so a waiting caller can tell if anything ran since it last looked.
+  unsigned long           numTasksFinished() const;
+
   // Remove the task from the queue. Has no effect on running tasks.
   void                    removeQueuedTask ( TaskHandle );
 
-  // Set/get the sleep duration. This is the amount of time (in milliseconds) 
-  // that the internal worker threads will sleep during a loop.
+  // Set/get the sleep duration. This is the longest amount of time (in 
+  // milliseconds) that waitForTasks will block before checking again.
   void                    sleepDuration ( unsigned long );
   unsigned long           sleepDuration() const;
 
@@ -116,23 +144,35 @@ private:
 
   void                    _logEvent ( const std::string &s, std::ostream *optional = 0x0 );
 
-  Task::RefPtr            _nextTask();
+  Task::RefPtr            _nextTask ( std::size_t worker );
+  Task::RefPtr            _popTask ( std::size_t index );
 
   void                    _startThreads();
 
+  void                    _taskDequeued ( std::size_t num, bool executing );
+  void                    _taskFinished();
+
   void                    _threadProcessTask ( Usul::Threads::Task *task );
-  void                    _threadStarted();
+  void                    _threadStarted ( std::size_t worker );
 
   void                    _waitForThreads();
 
   // Data members.
   mutable Mutex _mutex;
   ThreadPool _pool;
-  TaskMap _queue;
+  WorkerQueues _queues;
   TaskSet _executing;
   unsigned long _nextTaskId;
+  unsigned long _numStolen;
   unsigned long _sleep;
   unsigned int _numThreads;
+  mutable boost::mutex _wakeMutex;
+  boost::condition_variable _wakeCondition;
+  boost::condition_variable _idleCondition;
+  std::size_t _numQueued;
+  std::size_t _numOutstanding;
+  unsigned long _numFinished;
+  std::size_t _numWaiting;
   bool _runThreads;
   bool _started;
   LogPtr _log;
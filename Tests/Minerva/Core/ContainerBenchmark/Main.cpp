@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark for Container::getItemsWithinExtents. Fills a container with
+//  random points and then asks it for the items in tiles the way the tiles
+//  do when they split.
+//
+//  Usage: ContainerBenchmark [num features] [num levels]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Data/Container.h"
+#include "Minerva/Core/Data/DataObject.h"
+#include "Minerva/Core/Data/Point.h"
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace Minerva::Core::Data;
+
+namespace Detail
+{
+  typedef boost::posix_time::ptime Time;
+  typedef Container::Extents Extents;
+
+  Time now()
+  {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  double milliseconds ( const Time &start, const Time &stop )
+  {
+    return static_cast<double> ( ( stop - start ).total_microseconds() ) / 1000.0;
+  }
+
+  unsigned int argument ( int argc, char **argv, int which, unsigned int defaultValue )
+  {
+    return ( argc > which ) ? static_cast<unsigned int> ( std::abs ( ::atoi ( argv[which] ) ) ) : defaultValue;
+  }
+
+  double random ( double mn, double mx )
+  {
+    return mn + ( mx - mn ) * ( static_cast<double> ( ::rand() ) / RAND_MAX );
+  }
+
+  struct Counts
+  {
+    Counts() : queries ( 0 ), found ( 0 ) {}
+    unsigned int queries;
+    unsigned int found;
+  };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a container of random points.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Container::RefPtr _makeContainer ( unsigned int numFeatures )
+{
+  Container::RefPtr container ( new Container );
+  container->reserve ( numFeatures );
+
+  for ( unsigned int i = 0; i < numFeatures; ++i )
+  {
+    Point::RefPtr point ( new Point );
+    point->point ( Usul::Math::Vec3d ( Detail::random ( -180.0, 180.0 ), Detail::random ( -90.0, 90.0 ), 0.0 ) );
+
+    DataObject::RefPtr object ( new DataObject );
+    object->geometry ( point.get() );
+
+    container->add ( object.get(), false );
+  }
+
+  return container;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Ask the container for the items in the tile, then do the same for the
+//  children with the answer, like the tiles do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _split ( Container &container, const Detail::Extents &extents, unsigned int level, unsigned int numLevels, Detail::Counts &counts )
+{
+  Feature::RefPtr answer ( container.getItemsWithinExtents ( extents.minLon(), extents.minLat(), extents.maxLon(), extents.maxLat() ) );
+  ++counts.queries;
+
+  Container::RefPtr items ( ( answer.valid() ) ? answer->asContainer() : 0x0 );
+  if ( false == items.valid() )
+    return;
+
+  if ( level + 1 == numLevels )
+  {
+    counts.found += items->size();
+    return;
+  }
+
+  Detail::Extents ll, lr, ul, ur;
+  extents.split ( ll, lr, ul, ur );
+  _split ( *items, ll, level + 1, numLevels, counts );
+  _split ( *items, lr, level + 1, numLevels, counts );
+  _split ( *items, ul, level + 1, numLevels, counts );
+  _split ( *items, ur, level + 1, numLevels, counts );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Ask the big container directly for every tile at the level.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _tiles ( Container &container, unsigned int level )
+{
+  const unsigned int n ( 1u << level );
+  const double width ( 360.0 / ( 2 * n ) );
+  const double height ( 180.0 / n );
+
+  Detail::Counts counts;
+  const Detail::Time start ( Detail::now() );
+
+  for ( unsigned int row = 0; row < n; ++row )
+  {
+    for ( unsigned int column = 0; column < 2 * n; ++column )
+    {
+      const double lon ( -180.0 + column * width );
+      const double lat (  -90.0 + row * height );
+
+      Feature::RefPtr answer ( container.getItemsWithinExtents ( lon, lat, lon + width, lat + height ) );
+      Container::RefPtr items ( ( answer.valid() ) ? answer->asContainer() : 0x0 );
+
+      ++counts.queries;
+      counts.found += ( items.valid() ? items->size() : 0 );
+    }
+  }
+
+  const double elapsed ( Detail::milliseconds ( start, Detail::now() ) );
+
+  std::cout << "Level " << level << ": " << counts.queries << " tiles, " << counts.found << " found, "
+            << elapsed << " ms, " << elapsed / counts.queries << " ms/tile" << std::endl;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  const unsigned int numFeatures ( Detail::argument ( argc, argv, 1, 1000000 ) );
+  const unsigned int numLevels   ( Detail::argument ( argc, argv, 2, 6 ) );
+
+  ::srand ( 10 );
+
+  Detail::Time start ( Detail::now() );
+  Container::RefPtr container ( _makeContainer ( numFeatures ) );
+  std::cout << "Made " << numFeatures << " features in " << Detail::milliseconds ( start, Detail::now() ) << " ms" << std::endl;
+
+  // The first query makes the index.
+  start = Detail::now();
+  container->getItemsWithinExtents ( 0.0, 0.0, 0.0, 0.0 );
+  std::cout << "First query: " << Detail::milliseconds ( start, Detail::now() ) << " ms" << std::endl;
+
+  // Tiles asking the big container.
+  for ( unsigned int level = 0; level < numLevels; ++level )
+  {
+    _tiles ( *container, level );
+  }
+
+  // Tiles asking their parent's answer.
+  {
+    Detail::Counts counts;
+    start = Detail::now();
+
+    _split ( *container, Detail::Extents ( -180.0, -90.0, 0.0, 90.0 ), 0, numLevels, counts );
+    _split ( *container, Detail::Extents (    0.0, -90.0, 180.0, 90.0 ), 0, numLevels, counts );
+
+    const double elapsed ( Detail::milliseconds ( start, Detail::now() ) );
+    std::cout << "Split to level " << numLevels - 1 << ": " << counts.queries << " tiles, " << counts.found
+              << " found, " << elapsed << " ms" << std::endl;
+  }
+
+  return 0;
+}
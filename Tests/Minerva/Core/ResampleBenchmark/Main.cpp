@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark for resampleElevation. Makes the four children's heights from
+//  a parent grid the way a tile does when it splits without its own data.
+//  The old way, which searched a tri-strip for the triangle under each 
+//  sample, is kept here to compare against.
+//
+//  Usage: ResampleBenchmark [mesh size] [iterations]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/ResampleElevation.h"
+#include "Minerva/Core/ElevationData.h"
+
+#include "Usul/Algorithms/TriStrip.h"
+#include "Usul/Math/Barycentric.h"
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef Minerva::Common::Extents Extents;
+typedef Minerva::Common::IElevationData IElevationData;
+typedef Minerva::Core::ElevationData ElevationData;
+
+namespace Detail
+{
+  typedef boost::posix_time::ptime Time;
+  typedef Usul::Math::Vec3d Vertex;
+  typedef std::vector<Vertex> Vertices;
+  typedef std::vector<std::vector<unsigned int> > Strips;
+
+  Time now()
+  {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  double milliseconds ( const Time &start, const Time &stop )
+  {
+    return static_cast<double> ( ( stop - start ).total_microseconds() ) / 1000.0;
+  }
+
+  unsigned int argument ( int argc, char **argv, int which, unsigned int defaultValue )
+  {
+    return ( argc > which ) ? static_cast<unsigned int> ( std::abs ( ::atoi ( argv[which] ) ) ) : defaultValue;
+  }
+
+  bool between ( double value )
+  {
+    return ( -1e-10 <= value && value <= 1.0 + 1e-10 );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The old way: lay the grid out like the mesh and search the tri-strip.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Old
+{
+  struct Mesh
+  {
+    Mesh ( const IElevationData& grid, const Extents& extents ) : rows ( grid.height() ), columns ( grid.width() ), extents ( extents ), points ( rows * columns ), strips()
+    {
+      const Extents::Vertex &mn ( extents.minimum() );
+      const Extents::Vertex &mx ( extents.maximum() );
+
+      for ( unsigned int i = 0; i < rows; ++i )
+      {
+        const double u ( 1.0 - static_cast<double> ( i ) / ( rows - 1 ) );
+        for ( unsigned int j = 0; j < columns; ++j )
+        {
+          const double v ( static_cast<double> ( j ) / ( columns - 1 ) );
+          points[i * columns + j] = Detail::Vertex ( mn[0] + u * ( mx[0] - mn[0] ), mn[1] + v * ( mx[1] - mn[1] ), grid.value ( rows - i - 1, j ) );
+        }
+      }
+
+      Usul::Algorithms::triStripIndices ( rows, columns, strips );
+    }
+
+    double elevation ( double lat, double lon ) const
+    {
+      if ( false == extents.contains ( Extents::Vertex ( lon, lat ) ) )
+        return 0.0;
+
+      const Extents::Vertex &mn ( extents.minimum() );
+      const Extents::Vertex &mx ( extents.maximum() );
+
+      const double u ( ( lon - mn[0] ) / ( mx[0] - mn[0] ) );
+      const unsigned int numStrips ( strips.size() );
+      const unsigned int index ( numStrips * u );
+      const std::vector<unsigned int>& strip ( strips.at ( index == numStrips ? 0 : numStrips - index - 1 ) );
+
+      for ( unsigned int i = 0; i < strip.size() - 2; ++i )
+      {
+        Detail::Vertex t0 ( points.at ( strip.at ( i ) ) );
+        Detail::Vertex t1 ( points.at ( strip.at ( i + 1 ) ) );
+        Detail::Vertex t2 ( points.at ( strip.at ( i + 2 ) ) );
+        Detail::Vertex p ( lon, lat, 0.0 );
+
+        const double h0 ( t0[2] ), h1 ( t1[2] ), h2 ( t2[2] );
+        t0[2] = 0; t1[2] = 0; t2[2] = 0;
+
+        const Detail::Vertex w ( Usul::Math::barycentric ( t0, t1, t2, p ) );
+        if ( Detail::between ( w[0] ) && Detail::between ( w[1] ) && Detail::between ( w[2] ) )
+          return w[0] * h0 + w[1] * h1 + w[2] * h2;
+      }
+
+      return 0.0;
+    }
+
+    unsigned int rows;
+    unsigned int columns;
+    Extents extents;
+    Detail::Vertices points;
+    Detail::Strips strips;
+  };
+
+  IElevationData* resampleElevation ( const Mesh& mesh, const Extents& request, unsigned int rows, unsigned int columns )
+  {
+    ElevationData::RefPtr answer ( new ElevationData ( rows, columns ) );
+
+    const Extents::Vertex &mn ( request.minimum() );
+    const Extents::Vertex &mx ( request.maximum() );
+
+    for ( int i = rows - 1; i >= 0; --i )
+    {
+      const double u ( 1.0 - static_cast<double> ( i ) / ( rows - 1 ) );
+      for ( unsigned int j = 0; j < columns; ++j )
+      {
+        const double v ( static_cast<double> ( j ) / ( columns - 1 ) );
+        answer->value ( rows - i - 1, j, mesh.elevation ( mn[1] + v * ( mx[1] - mn[1] ), mn[0] + u * ( mx[0] - mn[0] ) ) );
+      }
+    }
+
+    return answer.release();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  const unsigned int size       ( Detail::argument ( argc, argv, 1, 17 ) );
+  const unsigned int iterations ( Detail::argument ( argc, argv, 2, 1000 ) );
+
+  if ( size < 2 )
+  {
+    std::cout << "Mesh size must be at least 2" << std::endl;
+    return 1;
+  }
+
+  // A bumpy parent grid.
+  ElevationData::RefPtr grid ( new ElevationData ( size, size ) );
+  for ( unsigned int r = 0; r < size; ++r )
+  {
+    for ( unsigned int c = 0; c < size; ++c )
+    {
+      grid->value ( r, c, static_cast<float> ( 1000.0 * std::sin ( r * 0.7 ) * std::cos ( c * 0.3 ) + 10.0 * r ) );
+    }
+  }
+
+  const Extents extents ( -112.5, 33.75, -101.25, 45.0 );
+  Extents quarters[4];
+  extents.split ( quarters[0], quarters[1], quarters[2], quarters[3] );
+
+  // The old way.
+  std::vector<IElevationData::RefPtr> old;
+  Detail::Time start ( Detail::now() );
+  {
+    const Old::Mesh mesh ( *grid, extents );
+    for ( unsigned int i = 0; i < iterations; ++i )
+    {
+      for ( unsigned int q = 0; q < 4; ++q )
+      {
+        IElevationData::RefPtr answer ( Old::resampleElevation ( mesh, quarters[q], size, size ) );
+        if ( 0 == i )
+          old.push_back ( answer );
+      }
+    }
+  }
+  const double oldTime ( Detail::milliseconds ( start, Detail::now() ) );
+
+  // The new way.
+  std::vector<IElevationData::RefPtr> direct;
+  start = Detail::now();
+  for ( unsigned int i = 0; i < iterations; ++i )
+  {
+    for ( unsigned int q = 0; q < 4; ++q )
+    {
+      IElevationData::RefPtr answer ( Minerva::Core::Algorithms::resampleElevation ( *grid, extents, quarters[q], size, size ) );
+      if ( 0 == i )
+        direct.push_back ( answer );
+    }
+  }
+  const double directTime ( Detail::milliseconds ( start, Detail::now() ) );
+
+  // They should agree.
+  double difference ( 0.0 );
+  for ( unsigned int q = 0; q < direct.size() && q < old.size(); ++q )
+  {
+    for ( unsigned int r = 0; r < size; ++r )
+    {
+      for ( unsigned int c = 0; c < size; ++c )
+      {
+        difference = std::max ( difference, static_cast<double> ( std::fabs ( direct[q]->value ( r, c ) - old[q]->value ( r, c ) ) ) );
+      }
+    }
+  }
+
+  const unsigned int samples ( iterations * 4 * size * size );
+  std::cout << size << "x" << size << " mesh, " << iterations << " splits, " << samples << " samples" << std::endl;
+  std::cout << "Strip search: " << oldTime << " ms" << std::endl;
+  std::cout << "Direct:       " << directTime << " ms" << std::endl;
+  std::cout << "Speedup:      " << ( directTime > 0.0 ? oldTime / directTime : 0.0 ) << "x" << std::endl;
+  std::cout << "Largest difference: " << difference << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark for reading tiles from a GDAL raster layer with different 
+//  job-manager pool sizes. With each job reading from its own data set 
+//  handle the tiles per second should go up with the pool size.
+//
+//  Usage: RasterBenchmark [file] [level] [max pool size]
+//
+//  If no file is given a world-wide GeoTIFF is made in the temp directory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/GDAL/RasterLayerGDAL.h"
+
+#include "Minerva/Common/TileKey.h"
+
+#include "Usul/File/Temp.h"
+#include "Usul/Jobs/Job.h"
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Math/MinMax.h"
+#include "Usul/Scope/RemoveFile.h"
+#include "Usul/Threads/Atomic.h"
+
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "gdal_priv.h"
+#include "ogr_spatialref.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef Minerva::Layers::GDAL::RasterLayerGDAL RasterLayerGDAL;
+typedef Minerva::Common::TileKey TileKey;
+typedef Minerva::Common::Extents Extents;
+
+namespace Detail
+{
+  typedef boost::posix_time::ptime Time;
+  typedef std::vector<TileKey::RefPtr> Keys;
+  typedef Usul::Threads::Atomic<unsigned int> Counter;
+
+  Time now()
+  {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  double seconds ( const Time &start, const Time &stop )
+  {
+    return static_cast<double> ( ( stop - start ).total_microseconds() ) / 1000000.0;
+  }
+
+  unsigned int argument ( int argc, char **argv, int which, unsigned int defaultValue )
+  {
+    return ( argc > which ) ? static_cast<unsigned int> ( std::abs ( ::atoi ( argv[which] ) ) ) : defaultValue;
+  }
+
+  // Read one tile the way the elevation jobs do.
+  void readTile ( RasterLayerGDAL *layer, TileKey *key, Counter *counter )
+  {
+    if ( layer->elevationData ( *key, 65, 65, 0x0, 0x0 ).valid() )
+      counter->fetch_and_increment();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a world-wide elevation file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool _makeFile ( const std::string& filename, int width, int height )
+{
+  GDALDriver *driver ( GetGDALDriverManager()->GetDriverByName ( "GTiff" ) );
+  if ( 0x0 == driver )
+    return false;
+
+  char *options[] = { const_cast<char*> ( "TILED=YES" ), 0x0 };
+  GDALDataset *data ( driver->Create ( filename.c_str(), width, height, 1, GDT_Float32, options ) );
+  if ( 0x0 == data )
+    return false;
+
+  double transform[6] = { -180.0, 360.0 / width, 0.0, 90.0, 0.0, -180.0 / height };
+  data->SetGeoTransform ( transform );
+
+  OGRSpatialReference srs;
+  srs.SetWellKnownGeogCS ( "WGS84" );
+  char *wkt ( 0x0 );
+  srs.exportToWkt ( &wkt );
+  data->SetProjection ( wkt );
+  ::CPLFree ( wkt );
+
+  std::vector<float> row ( width );
+  GDALRasterBand *band ( data->GetRasterBand ( 1 ) );
+  for ( int j = 0; j < height; ++j )
+  {
+    for ( int i = 0; i < width; ++i )
+      row[i] = static_cast<float> ( 1000.0 * std::sin ( i * 0.01 ) * std::cos ( j * 0.01 ) );
+    band->RasterIO ( GF_Write, 0, j, width, 1, &row[0], width, 1, GDT_Float32, 0, 0 );
+  }
+
+  ::GDALClose ( data );
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the keys for every tile at the level.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _makeKeys ( unsigned int level, Detail::Keys& keys )
+{
+  const unsigned int n ( 1u << level );
+  const double width ( 360.0 / ( 2 * n ) );
+  const double height ( 180.0 / n );
+
+  for ( unsigned int row = 0; row < n; ++row )
+  {
+    for ( unsigned int column = 0; column < 2 * n; ++column )
+    {
+      const double lon ( -180.0 + column * width );
+      const double lat (  -90.0 + row * height );
+
+      TileKey::RefPtr key ( new TileKey );
+      key->level ( level );
+      key->row ( row );
+      key->column ( column );
+      key->extents ( Extents ( lon, lat, lon + width, lat + height ) );
+      keys.push_back ( key );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read all the tiles with the given pool size.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _run ( RasterLayerGDAL& layer, const Detail::Keys& keys, unsigned int poolSize )
+{
+  Detail::Counter counter;
+  Usul::Jobs::Manager manager ( "RasterBenchmark", poolSize );
+
+  const Detail::Time start ( Detail::now() );
+
+  for ( Detail::Keys::const_iterator iter = keys.begin(); iter != keys.end(); ++iter )
+  {
+    manager.addJob ( Usul::Jobs::create ( boost::bind ( &Detail::readTile, &layer, iter->get(), &counter ) ) );
+  }
+  manager.wait();
+
+  const double elapsed ( Detail::seconds ( start, Detail::now() ) );
+  const unsigned int numTiles ( counter );
+
+  std::cout << "Pool size " << poolSize << ": " << numTiles << " tiles in " << elapsed << " s, " 
+            << ( ( elapsed > 0.0 ) ? numTiles / elapsed : 0.0 ) << " tiles/s" << std::endl;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  ::GDALAllRegister();
+
+  const unsigned int level ( Detail::argument ( argc, argv, 2, 4 ) );
+  const unsigned int maxPoolSize ( Detail::argument ( argc, argv, 3, Usul::Math::maximum ( 1u, boost::thread::hardware_concurrency() ) ) );
+
+  std::string filename ( ( argc > 1 ) ? argv[1] : "" );
+  const std::string temp ( filename.empty() ? Usul::File::Temp::file() + ".tif" : "" );
+  Usul::Scope::RemoveFile removeFile ( temp );
+
+  if ( true == filename.empty() )
+  {
+    filename = temp;
+    if ( false == _makeFile ( filename, 8192, 4096 ) )
+    {
+      std::cout << "Could not make file: " << filename << std::endl;
+      return 1;
+    }
+  }
+
+  RasterLayerGDAL::RefPtr layer ( new RasterLayerGDAL );
+  layer->read ( filename );
+
+  Detail::Keys keys;
+  _makeKeys ( level, keys );
+  std::cout << "Reading " << keys.size() << " tiles at level " << level << " from " << filename << std::endl;
+
+  for ( unsigned int poolSize = 1; poolSize <= maxPoolSize; poolSize *= 2 )
+  {
+    _run ( *layer, keys, poolSize );
+  }
+
+  return 0;
+}
@@ -0,0 +1,359 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark for polygon tessellation. Times osgUtil::Tessellator, the way
+//  polygons used to be built, against the ear-clipping tessellator, on one
+//  thread and then on the job manager with different pool sizes.
+//
+//  Usage: TessellateBenchmark [file] [max pool size]
+//
+//  The file is anything OGR can read, like a shapefile of countries or
+//  parcels. If no file is given, star-shaped polygons with holes are made.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Plugins/GDAL/OGRConvert.h"
+
+#include "Minerva/Core/Algorithms/Tessellate.h"
+#include "Minerva/Core/Data/MultiGeometry.h"
+#include "Minerva/Core/Data/Polygon.h"
+#include "Minerva/Core/Jobs/TessellatePolygons.h"
+
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Math/MinMax.h"
+
+#include "osg/Geometry"
+#include "osgUtil/Tessellator"
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "ogrsf_frmts.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef Minerva::Core::Data::Polygon Polygon;
+typedef Minerva::Core::Data::Line Line;
+typedef Minerva::Common::Coordinates Coordinates;
+typedef Minerva::Core::Jobs::Polygons Polygons;
+
+namespace Detail
+{
+  typedef boost::posix_time::ptime Time;
+  typedef std::vector<Coordinates::RefPtr> Rings;
+
+  // The rings of one polygon. The outer ring is first.
+  typedef std::vector<Rings> Shapes;
+
+  Time now()
+  {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  double seconds ( const Time &start, const Time &stop )
+  {
+    return static_cast<double> ( ( stop - start ).total_microseconds() ) / 1000000.0;
+  }
+
+  unsigned int argument ( int argc, char **argv, int which, unsigned int defaultValue )
+  {
+    return ( argc > which ) ? static_cast<unsigned int> ( std::abs ( ::atoi ( argv[which] ) ) ) : defaultValue;
+  }
+
+  void report ( const std::string& name, unsigned int numTriangles, const Time& start )
+  {
+    std::cout << name << ": " << numTriangles << " triangles in " << Detail::seconds ( start, Detail::now() ) << " s" << std::endl;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the rings of the polygon.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _addPolygon ( Minerva::Core::Data::Geometry *geometry, Detail::Shapes& shapes )
+{
+  if ( Polygon *polygon = dynamic_cast<Polygon*> ( geometry ) )
+  {
+    Line::RefPtr outer ( polygon->outerBoundary() );
+    if ( false == outer.valid() || false == outer->coordinates().valid() )
+      return;
+
+    Detail::Rings rings;
+    rings.push_back ( outer->coordinates() );
+
+    const Polygon::Boundaries inner ( polygon->innerBoundaries() );
+    for ( Polygon::Boundaries::const_iterator iter = inner.begin(); iter != inner.end(); ++iter )
+    {
+      if ( iter->valid() && ( *iter )->coordinates().valid() )
+        rings.push_back ( ( *iter )->coordinates() );
+    }
+
+    shapes.push_back ( rings );
+  }
+  else if ( Minerva::Core::Data::MultiGeometry *multi = dynamic_cast<Minerva::Core::Data::MultiGeometry*> ( geometry ) )
+  {
+    const Minerva::Core::Data::MultiGeometry::Geometries geometries ( multi->geometries() );
+    for ( Minerva::Core::Data::MultiGeometry::Geometries::const_iterator iter = geometries.begin(); iter != geometries.end(); ++iter )
+    {
+      _addPolygon ( iter->get(), shapes );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Read the polygons from the file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool _readFile ( const std::string& filename, Detail::Shapes& shapes )
+{
+  OGRDataSource *dataSource ( OGRSFDriverRegistrar::Open ( filename.c_str(), FALSE ) );
+  if ( 0x0 == dataSource )
+    return false;
+
+  for ( int i = 0; i < dataSource->GetLayerCount(); ++i )
+  {
+    OGRLayer *layer ( dataSource->GetLayer ( i ) );
+    if ( 0x0 == layer )
+      continue;
+
+    OGRSpatialReference dst;
+    dst.SetWellKnownGeogCS ( "WGS84" );
+    OGRCoordinateTransformation *transform ( 0x0 != layer->GetSpatialRef() ? ::OGRCreateCoordinateTransformation ( layer->GetSpatialRef(), &dst ) : 0x0 );
+
+    layer->ResetReading();
+
+    OGRFeature *feature ( 0x0 );
+    while ( 0x0 != ( feature = layer->GetNextFeature() ) )
+    {
+      Minerva::Core::Data::Geometry::RefPtr geometry ( Minerva::Layers::GDAL::OGRConvert::geometry ( feature->GetGeometryRef(), transform ) );
+      _addPolygon ( geometry.get(), shapes );
+      OGRFeature::DestroyFeature ( feature );
+    }
+
+    if ( 0x0 != transform )
+      ::OCTDestroyCoordinateTransformation ( transform );
+  }
+
+  OGRDataSource::DestroyDataSource ( dataSource );
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a ring around the center.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Coordinates::RefPtr _makeRing ( double lon, double lat, double radius, unsigned int numPoints, bool clockwise )
+{
+  Coordinates::RefPtr coordinates ( new Coordinates );
+  coordinates->reserve ( numPoints + 1 );
+
+  for ( unsigned int i = 0; i <= numPoints; ++i )
+  {
+    const unsigned int which ( i % numPoints );
+    const double angle ( 2.0 * M_PI * ( clockwise ? numPoints - which : which ) / numPoints );
+    const double r ( radius * ( ( 0 == which % 2 ) ? 1.0 : 0.7 ) );
+    coordinates->addPoint ( lon + r * std::cos ( angle ), lat + r * std::sin ( angle ), 0.0 );
+  }
+
+  return coordinates;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a grid of star-shaped polygons, each with a hole.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _makeShapes ( unsigned int numPolygons, unsigned int numPoints, Detail::Shapes& shapes )
+{
+  const unsigned int columns ( static_cast<unsigned int> ( std::sqrt ( 2.0 * numPolygons ) ) + 1 );
+  const double size ( 360.0 / columns );
+
+  for ( unsigned int i = 0; i < numPolygons; ++i )
+  {
+    const double lon ( -180.0 + ( i % columns + 0.5 ) * size );
+    const double lat (  -90.0 + ( i / columns + 0.5 ) * size );
+
+    Detail::Rings rings;
+    rings.push_back ( _makeRing ( lon, lat, size * 0.45, numPoints, false ) );
+    rings.push_back ( _makeRing ( lon, lat, size * 0.15, numPoints / 4, true ) );
+    shapes.push_back ( rings );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate with osgUtil::Tessellator, one ring per GL_POLYGON.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _runOsg ( const Detail::Shapes& shapes )
+{
+  const Detail::Time start ( Detail::now() );
+  unsigned int numTriangles ( 0 );
+
+  for ( Detail::Shapes::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape )
+  {
+    osg::ref_ptr<osg::Vec3Array> vertices ( new osg::Vec3Array );
+    osg::ref_ptr<osg::Geometry> geometry ( new osg::Geometry );
+    geometry->setVertexArray ( vertices.get() );
+
+    for ( Detail::Rings::const_iterator ring = shape->begin(); ring != shape->end(); ++ring )
+    {
+      const unsigned int first ( vertices->size() );
+      for ( Coordinates::const_iterator iter = ( *ring )->begin(); iter != ( *ring )->end(); ++iter )
+        vertices->push_back ( osg::Vec3 ( ( *iter )[0], ( *iter )[1], ( *iter )[2] ) );
+      geometry->addPrimitiveSet ( new osg::DrawArrays ( GL_POLYGON, first, vertices->size() - first ) );
+    }
+
+    osg::ref_ptr<osgUtil::Tessellator> tessellator ( new osgUtil::Tessellator );
+    tessellator->setTessellationType ( osgUtil::Tessellator::TESS_TYPE_GEOMETRY );
+    tessellator->setWindingType ( osgUtil::Tessellator::TESS_WINDING_ODD );
+    tessellator->retessellatePolygons ( *geometry );
+
+    for ( unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i )
+    {
+      const osg::PrimitiveSet *primitives ( geometry->getPrimitiveSet ( i ) );
+      const unsigned int num ( primitives->getNumIndices() );
+      switch ( primitives->getMode() )
+      {
+        case GL_TRIANGLES:      numTriangles += num / 3; break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:   numTriangles += ( num > 2 ? num - 2 : 0 ); break;
+      }
+    }
+  }
+
+  Detail::report ( "osgUtil::Tessellator", numTriangles, start );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate with the ear-clipping tessellator on this thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _runEarClipping ( const Detail::Shapes& shapes )
+{
+  const Detail::Time start ( Detail::now() );
+  unsigned int numTriangles ( 0 );
+
+  Minerva::Core::Algorithms::TessellatePoints points;
+  Minerva::Core::Algorithms::TessellateIndices sizes, triangles;
+
+  for ( Detail::Shapes::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape )
+  {
+    points.clear();
+    sizes.clear();
+    triangles.clear();
+
+    for ( Detail::Rings::const_iterator ring = shape->begin(); ring != shape->end(); ++ring )
+    {
+      points.insert ( points.end(), ( *ring )->begin(), ( *ring )->end() );
+      sizes.push_back ( ( *ring )->size() );
+    }
+
+    Minerva::Core::Algorithms::tessellate ( points, sizes, triangles );
+    numTriangles += triangles.size() / 3;
+  }
+
+  Detail::report ( "Ear clipping", numTriangles, start );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tessellate polygons on the job manager. New polygons are made each time
+//  so that nothing is cached.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void _runJobs ( const Detail::Shapes& shapes, unsigned int poolSize )
+{
+  Polygons polygons;
+  polygons.reserve ( shapes.size() );
+
+  for ( Detail::Shapes::const_iterator shape = shapes.begin(); shape != shapes.end(); ++shape )
+  {
+    Polygon::RefPtr polygon ( new Polygon );
+    for ( Detail::Rings::const_iterator ring = shape->begin(); ring != shape->end(); ++ring )
+    {
+      Line::RefPtr line ( new Line );
+      line->coordinates ( *ring );
+
+      if ( ring == shape->begin() )
+        polygon->outerBoundary ( line );
+      else
+        polygon->addInnerBoundary ( line );
+    }
+    polygons.push_back ( polygon );
+  }
+
+  Usul::Jobs::Manager manager ( "TessellateBenchmark", poolSize );
+
+  const Detail::Time start ( Detail::now() );
+  Minerva::Core::Jobs::tessellatePolygons ( polygons, manager );
+  const double elapsed ( Detail::seconds ( start, Detail::now() ) );
+
+  std::cout << "Ear clipping, pool size " << poolSize << ": " << polygons.size() << " polygons in " << elapsed << " s" << std::endl;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  ::OGRRegisterAll();
+
+  const std::string filename ( ( argc > 1 ) ? argv[1] : "" );
+  const unsigned int maxPoolSize ( Detail::argument ( argc, argv, 2, Usul::Math::maximum ( 1u, boost::thread::hardware_concurrency() ) ) );
+
+  Detail::Shapes shapes;
+  if ( true == filename.empty() )
+  {
+    _makeShapes ( 20000, 200, shapes );
+  }
+  else if ( false == _readFile ( filename, shapes ) )
+  {
+    std::cout << "Could not read file: " << filename << std::endl;
+    return 1;
+  }
+
+  std::cout << "Tessellating " << shapes.size() << " polygons" << std::endl;
+
+  _runOsg ( shapes );
+  _runEarClipping ( shapes );
+
+  for ( unsigned int poolSize = 1; poolSize <= maxPoolSize; poolSize *= 2 )
+  {
+    _runJobs ( shapes, poolSize );
+  }
+
+  return 0;
+}
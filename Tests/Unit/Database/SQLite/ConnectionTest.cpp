@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Database/SQLite/Connection.h"
+#include "Database/SQLite/Transaction.h"
+
+#include "Usul/Strings/Format.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <stdexcept>
+
+typedef CadKit::Database::SQLite::Connection Connection;
+typedef CadKit::Database::SQLite::Statement Statement;
+typedef CadKit::Database::SQLite::Result Result;
+typedef std::map<std::string,std::string> Tags;
+
+namespace Helper
+{
+  unsigned int count ( Connection& connection, const std::string& sql )
+  {
+    Result::RefPtr result ( connection.execute ( sql ) );
+    unsigned int n ( 0 );
+    if ( result->prepareNextRow() )
+      *result >> n;
+    return n;
+  }
+
+  struct TagBinder
+  {
+    bool operator () ( Statement& statement, const Tags::value_type& tag ) const
+    {
+      if ( tag.second.empty() )
+        return false;
+
+      statement.bind ( 0, Usul::Types::Uint64 ( 42 ) );
+      statement.bind ( 1, tag.first );
+      statement.bind ( 2, tag.second );
+      return true;
+    }
+  };
+
+  struct ThrowingBinder
+  {
+    bool operator () ( Statement& statement, const Tags::value_type& tag ) const
+    {
+      if ( "bad" == tag.second )
+        throw std::runtime_error ( "Error 3994201457: bad tag" );
+
+      return TagBinder() ( statement, tag );
+    }
+  };
+}
+
+
+TEST(ConnectionTest,ExecuteMany)
+{
+  Connection::RefPtr connection ( new Connection ( ":memory:" ) );
+  connection->execute ( "CREATE TABLE tags ( object_id integer, key text, value text )" );
+
+  Tags tags;
+  tags["highway"] = "primary";
+  tags["name"] = "Main \"Street\"";
+  tags["oneway"] = "";
+
+  {
+    CadKit::Database::SQLite::Transaction<Connection::RefPtr> transaction ( connection );
+    EXPECT_EQ ( 2u, connection->executeMany ( "INSERT INTO tags ( object_id, key, value ) values ( ?, ?, ? )", tags.begin(), tags.end(), Helper::TagBinder() ) );
+    transaction.commit();
+  }
+
+  EXPECT_EQ ( 2u, Helper::count ( *connection, "SELECT count(*) FROM tags WHERE object_id = 42" ) );
+  EXPECT_EQ ( 1u, Helper::count ( *connection, "SELECT count(*) FROM tags WHERE value = 'Main \"Street\"'" ) );
+}
+
+
+TEST(ConnectionTest,StatementReuse)
+{
+  Connection::RefPtr connection ( new Connection ( ":memory:" ) );
+  connection->execute ( "CREATE TABLE entries ( id integer primary key, x double precision not null )" );
+
+  const std::string sql ( "INSERT INTO entries ( x ) values ( ? )" );
+  {
+    Statement::RefPtr statement ( connection->prepare ( sql ) );
+    statement->bind ( 0, 1.5 );
+    statement->execute();
+    EXPECT_EQ ( 1, connection->lastInsertRowId() );
+
+    // The values are cleared after each execute.
+    EXPECT_THROW ( statement->execute(), std::exception );
+
+    statement->bind ( 0, 2.5 );
+    statement->execute();
+    EXPECT_EQ ( 2, connection->lastInsertRowId() );
+  }
+
+  // The released statement is used again.
+  Statement::RefPtr statement ( connection->prepare ( sql ) );
+  statement->bind ( 0, 3.5 );
+  statement->execute();
+
+  EXPECT_EQ ( 3u, Helper::count ( *connection, "SELECT count(*) FROM entries" ) );
+  EXPECT_THROW ( connection->prepare ( "INSERT INTO missing values ( 1 )" ), std::exception );
+}
+
+
+TEST(ConnectionTest,ExecuteManyRollsBack)
+{
+  Connection::RefPtr connection ( new Connection ( ":memory:" ) );
+  connection->execute ( "CREATE TABLE tags ( object_id integer, key text, value text )" );
+
+  const std::string sql ( "INSERT INTO tags ( object_id, key, value ) values ( ?, ?, ? )" );
+
+  Tags tags;
+  tags["a"] = "first";
+  tags["b"] = "bad";
+  tags["c"] = "last";
+
+  // On its own, none of the rows are kept.
+  EXPECT_THROW ( connection->executeMany ( sql, tags.begin(), tags.end(), Helper::ThrowingBinder() ), std::runtime_error );
+  EXPECT_EQ ( 0u, Helper::count ( *connection, "SELECT count(*) FROM tags" ) );
+
+  // Inside a transaction, only the rows of the failed call are undone.
+  {
+    CadKit::Database::SQLite::Transaction<Connection::RefPtr> transaction ( connection );
+    connection->execute ( "INSERT INTO tags ( object_id, key, value ) values ( 1, 'kept', 'yes' )" );
+    EXPECT_THROW ( connection->executeMany ( sql, tags.begin(), tags.end(), Helper::ThrowingBinder() ), std::runtime_error );
+
+    tags["b"] = "fine";
+    EXPECT_EQ ( 3u, connection->executeMany ( sql, tags.begin(), tags.end(), Helper::ThrowingBinder() ) );
+    transaction.commit();
+  }
+
+  EXPECT_EQ ( 4u, Helper::count ( *connection, "SELECT count(*) FROM tags" ) );
+}
+
+
+TEST(ConnectionTest,StatementCache)
+{
+  Connection::RefPtr connection ( new Connection ( ":memory:" ) );
+  connection->execute ( "CREATE TABLE entries ( id integer primary key, x integer not null )" );
+
+  // Use more statements than are cached, more than once each, so the 
+  // oldest are dropped and prepared again.
+  for ( unsigned int pass = 0; pass < 3; ++pass )
+  {
+    for ( unsigned int i = 0; i < 100; ++i )
+    {
+      connection->execute ( Usul::Strings::format ( "INSERT INTO entries ( x ) values ( ", i, " )" ) );
+    }
+  }
+
+  EXPECT_EQ ( 300u, Helper::count ( *connection, "SELECT count(*) FROM entries" ) );
+  EXPECT_EQ ( 3u, Helper::count ( *connection, "SELECT count(*) FROM entries WHERE x = 0" ) );
+}
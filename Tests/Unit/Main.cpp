@@ -16,6 +16,9 @@
 
 #include "gtest/gtest.h"
 
+#include "Minerva/Core/ImageCache.h"
+#include "Minerva/Network/FetchEngine.h"
+
 #include "Usul/Factory/ObjectFactory.h"
 #include "Usul/Jobs/Manager.h"
 #include "Usul/Registry/Database.h"
@@ -43,6 +46,12 @@ int main ( int argc, char** argv )
 
   const int result ( RUN_ALL_TESTS() );
 
+  // Stop the download thread.
+  Minerva::Network::FetchEngine::destroy();
+
+  // Free the decoded tiles.
+  Minerva::Core::ImageCache::destroy();
+
   // Clear the registry.
   Usul::Registry::Database::destroy();
 
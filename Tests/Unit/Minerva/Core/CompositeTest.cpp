@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/Composite.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace Composite = Minerva::Core::Algorithms::Composite;
+typedef std::map < Usul::Types::Uint32, unsigned short > Alphas;
+
+namespace Helper
+{
+  osg::ref_ptr<osg::Image> makeImage ( GLenum format, unsigned int seed )
+  {
+    osg::ref_ptr<osg::Image> image ( new osg::Image );
+    image->allocateImage ( 67, 33, 1, format, GL_UNSIGNED_BYTE );
+
+    // Half of the values come from a short list so that colors repeat and 
+    // hit the alpha table.
+    ::srand ( seed );
+    const unsigned int bytes ( image->getImageSizeInBytes() );
+    for ( unsigned int i = 0; i < bytes; ++i )
+      image->data()[i] = static_cast<unsigned char> ( ( 0 == ::rand() % 2 ) ? ( ::rand() % 256 ) : ( ( ::rand() % 4 ) * 85 ) );
+
+    return image;
+  }
+
+  osg::ref_ptr<osg::Image> copy ( const osg::Image& image )
+  {
+    osg::ref_ptr<osg::Image> result ( new osg::Image );
+    result->allocateImage ( image.s(), image.t(), 1, image.getPixelFormat(), GL_UNSIGNED_BYTE );
+    ::memcpy ( result->data(), image.data(), image.getImageSizeInBytes() );
+    return result;
+  }
+
+  void reference ( osg::Image& result, const osg::Image& image, const Alphas& alphas, float alpha )
+  {
+    switch ( image.getPixelFormat() )
+    {
+      case GL_LUMINANCE:       Composite::Compositor<Alphas,1>::composite ( result, image, alphas, alpha ); break;
+      case GL_LUMINANCE_ALPHA: Composite::Compositor<Alphas,2>::composite ( result, image, alphas, alpha ); break;
+      case GL_RGB:             Composite::Compositor<Alphas,3>::composite ( result, image, alphas, alpha ); break;
+      case GL_RGBA:            Composite::Compositor<Alphas,4>::composite ( result, image, alphas, alpha ); break;
+    }
+  }
+
+  void check ( const Alphas& alphas )
+  {
+    const GLenum formats[] = { GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB, GL_RGBA };
+    const float overall[] = { 1.0f, 0.5f, 0.1f, 0.0f };
+    const Composite::Kernel kernels[] = { Composite::KERNEL_SCALAR, Composite::KERNEL_SSE2, Composite::KERNEL_AVX2 };
+
+    for ( unsigned int f = 0; f < 4; ++f )
+    {
+      for ( unsigned int o = 0; o < 4; ++o )
+      {
+        osg::ref_ptr<osg::Image> image ( Helper::makeImage ( formats[f], f * 4 + o ) );
+        osg::ref_ptr<osg::Image> background ( Helper::makeImage ( GL_RGBA, 100 + f * 4 + o ) );
+
+        osg::ref_ptr<osg::Image> expected ( Helper::copy ( *background ) );
+        Helper::reference ( *expected, *image, alphas, overall[o] );
+
+        for ( unsigned int k = 0; k < 3; ++k )
+        {
+          if ( false == Composite::isSupported ( kernels[k] ) )
+            continue;
+
+          osg::ref_ptr<osg::Image> result ( Helper::copy ( *background ) );
+          Composite::blend ( *result, *image, Composite::AlphaTable ( alphas ), overall[o], kernels[k] );
+
+          EXPECT_EQ ( 0, ::memcmp ( expected->data(), result->data(), expected->getImageSizeInBytes() ) )
+            << "format: " << formats[f] << ", alpha: " << overall[o] << ", kernel: " << kernels[k];
+        }
+      }
+    }
+  }
+}
+
+TEST(CompositeTest,NoAlphaTable)
+{
+  Helper::check ( Alphas() );
+}
+
+TEST(CompositeTest,SmallAlphaTable)
+{
+  Alphas alphas;
+  alphas[Usul::Functions::Color::pack ( 0, 0, 0, 0 )] = 0;
+  alphas[Usul::Functions::Color::pack ( 85, 85, 85, 0 )] = 128;
+  alphas[Usul::Functions::Color::pack ( 170, 0, 255, 0 )] = 300;
+  Helper::check ( alphas );
+}
+
+TEST(CompositeTest,LargeAlphaTable)
+{
+  Alphas alphas;
+  for ( unsigned int r = 0; r < 4; ++r )
+    for ( unsigned int g = 0; g < 4; ++g )
+      alphas[Usul::Functions::Color::pack ( r * 85, g * 85, 85, 0 )] = static_cast<unsigned short> ( r * 60 + g );
+  Helper::check ( alphas );
+}
+
+TEST(CompositeTest,AlphaTable)
+{
+  Composite::AlphaTable table;
+  EXPECT_TRUE ( table.empty() );
+
+  for ( unsigned int i = 0; i < 100; ++i )
+    table.insert ( i * 7919, static_cast<unsigned char> ( i ) );
+  table.insert ( 7919, 200 );
+
+  EXPECT_EQ ( 100u, table.size() );
+
+  unsigned char alpha ( 0 );
+  EXPECT_TRUE ( table.find ( 7919, alpha ) );
+  EXPECT_EQ ( 200, alpha );
+  EXPECT_TRUE ( table.find ( 99 * 7919, alpha ) );
+  EXPECT_EQ ( 99, alpha );
+  EXPECT_FALSE ( table.find ( 5, alpha ) );
+}
@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Data/Container.h"
+#include "Minerva/Core/Data/DataObject.h"
+#include "Minerva/Core/Data/Point.h"
+#include "Minerva/Core/Data/TimeSpan.h"
+
+#include "osg/Group"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::Data::Container Container;
+typedef Minerva::Core::Data::DataObject DataObject;
+typedef Minerva::Core::Data::Feature Feature;
+typedef Minerva::Core::Data::Point Point;
+typedef Minerva::Core::Data::TimeSpan TimeSpan;
+typedef Minerva::Core::Data::Date Date;
+
+namespace Helper
+{
+  DataObject::RefPtr makeDataObject ( double lon, double lat )
+  {
+    Point::RefPtr point ( new Point );
+    point->point ( Usul::Math::Vec3d ( lon, lat, 0.0 ) );
+
+    DataObject::RefPtr dataObject ( new DataObject );
+    dataObject->geometry ( point.get() );
+    return dataObject;
+  }
+
+  // Get the features near the location.
+  Container::Features query ( const Container& container, double lon, double lat )
+  {
+    Container::Features answer;
+
+    Feature::RefPtr items ( container.getItemsWithinExtents ( lon - 1.0, lat - 1.0, lon + 1.0, lat + 1.0 ) );
+    Container::RefPtr found ( true == items.valid() ? items->asContainer() : 0x0 );
+    if ( true == found.valid() )
+    {
+      for ( unsigned int i = 0; i < found->size(); ++i )
+        answer.push_back ( found->feature ( i ) );
+    }
+
+    return answer;
+  }
+
+  // Hands back its node and counts how many times it was built.
+  class CountBuilds : public DataObject
+  {
+  public:
+    USUL_DECLARE_REF_POINTERS ( CountBuilds );
+
+    CountBuilds() : DataObject(), builds ( 0 ), node ( new osg::Group )
+    {
+    }
+
+    virtual osg::Node* buildScene ( Minerva::Common::IPlanetCoordinates *, Minerva::Common::IElevationDatabase * )
+    {
+      ++builds;
+      return node.get();
+    }
+
+    unsigned int builds;
+    osg::ref_ptr<osg::Node> node;
+
+  protected:
+    virtual ~CountBuilds()
+    {
+    }
+  };
+
+  void build ( Container& container )
+  {
+    container.updateNotify ( 0x0, 0x0, 0x0 );
+  }
+
+  osg::Group* scene ( Container& container )
+  {
+    osg::Node *node ( container.getScene() );
+    return ( 0x0 != node ? node->asGroup() : 0x0 );
+  }
+
+  bool hasChild ( Container& container, const CountBuilds& object )
+  {
+    osg::Group *group ( Helper::scene ( container ) );
+    return ( 0x0 != group && group->containsNode ( object.node.get() ) );
+  }
+
+  TimeSpan::RefPtr makeTimeSpan ( const std::string& begin, const std::string& end )
+  {
+    return TimeSpan::RefPtr ( new TimeSpan ( Date ( begin ), Date ( end ) ) );
+  }
+
+  Container::Period makePeriod ( const std::string& begin, const std::string& end )
+  {
+    return TimeSpan::RefPtr ( Helper::makeTimeSpan ( begin, end ) )->period();
+  }
+}
+
+
+TEST(ContainerTest,QueryExtents)
+{
+  Container::RefPtr container ( new Container );
+  DataObject::RefPtr a ( Helper::makeDataObject ( 10.0, 10.0 ) );
+  DataObject::RefPtr b ( Helper::makeDataObject ( 50.0, 50.0 ) );
+  container->add ( a.get() );
+  container->add ( b.get() );
+
+  Container::Features found ( Helper::query ( *container, 10.0, 10.0 ) );
+  ASSERT_EQ ( 1u, found.size() );
+  EXPECT_EQ ( a.get(), found.front().get() );
+
+  EXPECT_TRUE ( Helper::query ( *container, -40.0, -40.0 ).empty() );
+
+  // Removed features are not found.
+  container->remove ( a.get() );
+  EXPECT_TRUE ( Helper::query ( *container, 10.0, 10.0 ).empty() );
+}
+
+
+TEST(ContainerTest,MoveFeatureExtents)
+{
+  Container::RefPtr container ( new Container );
+  DataObject::RefPtr a ( Helper::makeDataObject ( 10.0, 10.0 ) );
+  container->add ( a.get() );
+
+  // Make the index.
+  ASSERT_EQ ( 1u, Helper::query ( *container, 10.0, 10.0 ).size() );
+
+  // Move it by setting the extents.
+  a->extents ( Feature::Extents ( -20.5, -20.5, -19.5, -19.5 ) );
+
+  EXPECT_TRUE ( Helper::query ( *container, 10.0, 10.0 ).empty() );
+
+  Container::Features found ( Helper::query ( *container, -20.0, -20.0 ) );
+  ASSERT_EQ ( 1u, found.size() );
+  EXPECT_EQ ( a.get(), found.front().get() );
+}
+
+
+TEST(ContainerTest,MoveFeatureGeometry)
+{
+  Container::RefPtr container ( new Container );
+  DataObject::RefPtr a ( Helper::makeDataObject ( 10.0, 10.0 ) );
+  DataObject::RefPtr b ( Helper::makeDataObject ( 30.0, 30.0 ) );
+  container->add ( a.get() );
+  container->add ( b.get() );
+
+  ASSERT_EQ ( 1u, Helper::query ( *container, 10.0, 10.0 ).size() );
+
+  // Move it by giving it a new geometry.
+  Point::RefPtr point ( new Point );
+  point->point ( Usul::Math::Vec3d ( 30.0, 30.0, 0.0 ) );
+  a->geometry ( point.get() );
+
+  EXPECT_TRUE ( Helper::query ( *container, 10.0, 10.0 ).empty() );
+
+  // Both are found, in the order they were added.
+  Container::Features found ( Helper::query ( *container, 30.0, 30.0 ) );
+  ASSERT_EQ ( 2u, found.size() );
+  EXPECT_EQ ( a.get(), found.at ( 0 ).get() );
+  EXPECT_EQ ( b.get(), found.at ( 1 ).get() );
+
+  // A removed feature no longer moves in the index.
+  container->remove ( a.get() );
+  a->extents ( Feature::Extents ( 9.5, 9.5, 10.5, 10.5 ) );
+  EXPECT_TRUE ( Helper::query ( *container, 10.0, 10.0 ).empty() );
+}
+
+
+TEST(ContainerTest,AddBuildsOnlyNewChild)
+{
+  Container::RefPtr container ( new Container );
+  Helper::CountBuilds::RefPtr a ( new Helper::CountBuilds );
+  Helper::CountBuilds::RefPtr b ( new Helper::CountBuilds );
+  container->add ( a.get() );
+  container->add ( b.get() );
+  Helper::build ( *container );
+
+  ASSERT_TRUE ( 0x0 != Helper::scene ( *container ) );
+  EXPECT_EQ ( 2u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_TRUE ( Helper::hasChild ( *container, *a ) );
+  EXPECT_TRUE ( Helper::hasChild ( *container, *b ) );
+
+  // Only the new child is built.
+  Helper::CountBuilds::RefPtr c ( new Helper::CountBuilds );
+  container->add ( c.get() );
+  Helper::build ( *container );
+
+  EXPECT_EQ ( 3u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_EQ ( a->node.get(), Helper::scene ( *container )->getChild ( 0 ) );
+  EXPECT_EQ ( b->node.get(), Helper::scene ( *container )->getChild ( 1 ) );
+  EXPECT_EQ ( c->node.get(), Helper::scene ( *container )->getChild ( 2 ) );
+  EXPECT_EQ ( 1u, a->builds );
+  EXPECT_EQ ( 1u, b->builds );
+  EXPECT_EQ ( 1u, c->builds );
+}
+
+
+TEST(ContainerTest,RemoveKeepsSiblings)
+{
+  Container::RefPtr container ( new Container );
+  Helper::CountBuilds::RefPtr a ( new Helper::CountBuilds );
+  Helper::CountBuilds::RefPtr b ( new Helper::CountBuilds );
+  Helper::CountBuilds::RefPtr c ( new Helper::CountBuilds );
+  container->add ( a.get() );
+  container->add ( b.get() );
+  container->add ( c.get() );
+  Helper::build ( *container );
+
+  // The last child takes the place of the removed one.
+  container->remove ( a.get() );
+  Helper::build ( *container );
+
+  ASSERT_EQ ( 2u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_FALSE ( Helper::hasChild ( *container, *a ) );
+  EXPECT_EQ ( c->node.get(), Helper::scene ( *container )->getChild ( 0 ) );
+  EXPECT_EQ ( b->node.get(), Helper::scene ( *container )->getChild ( 1 ) );
+
+  // The moved child is still known by its new place.
+  container->remove ( c.get() );
+  Helper::build ( *container );
+
+  ASSERT_EQ ( 1u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_EQ ( b->node.get(), Helper::scene ( *container )->getChild ( 0 ) );
+
+  // Nothing was built again.
+  EXPECT_EQ ( 1u, a->builds );
+  EXPECT_EQ ( 1u, b->builds );
+  EXPECT_EQ ( 1u, c->builds );
+
+  // Removing a feature that was never built doesn't touch the scene.
+  Helper::CountBuilds::RefPtr d ( new Helper::CountBuilds );
+  container->add ( d.get() );
+  container->remove ( d.get() );
+  Helper::build ( *container );
+
+  ASSERT_EQ ( 1u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_EQ ( b->node.get(), Helper::scene ( *container )->getChild ( 0 ) );
+  EXPECT_EQ ( 0u, d->builds );
+}
+
+
+TEST(ContainerTest,ChangeOneChild)
+{
+  Container::RefPtr container ( new Container );
+  Helper::CountBuilds::RefPtr a ( new Helper::CountBuilds );
+  Helper::CountBuilds::RefPtr b ( new Helper::CountBuilds );
+  Helper::CountBuilds::RefPtr c ( new Helper::CountBuilds );
+  container->add ( a.get() );
+  container->add ( b.get() );
+  container->add ( c.get() );
+  Helper::build ( *container );
+
+  // Give the middle one a new node.
+  osg::ref_ptr<osg::Node> old ( b->node );
+  b->node = new osg::Group;
+  container->featureChanged ( b.get() );
+  Helper::build ( *container );
+
+  ASSERT_EQ ( 3u, Helper::scene ( *container )->getNumChildren() );
+  EXPECT_EQ ( a->node.get(), Helper::scene ( *container )->getChild ( 0 ) );
+  EXPECT_EQ ( b->node.get(), Helper::scene ( *container )->getChild ( 1 ) );
+  EXPECT_EQ ( c->node.get(), Helper::scene ( *container )->getChild ( 2 ) );
+  EXPECT_FALSE ( Helper::scene ( *container )->containsNode ( old.get() ) );
+
+  // The siblings were not built again.
+  EXPECT_EQ ( 1u, a->builds );
+  EXPECT_EQ ( 2u, b->builds );
+  EXPECT_EQ ( 1u, c->builds );
+
+  // Nothing is built when nothing changed.
+  Helper::build ( *container );
+  EXPECT_EQ ( 1u, a->builds );
+  EXPECT_EQ ( 2u, b->builds );
+  EXPECT_EQ ( 1u, c->builds );
+}
+
+
+TEST(ContainerTest,TimeChangeMovesFeature)
+{
+  Container::RefPtr container ( new Container );
+  DataObject::RefPtr a ( Helper::makeDataObject ( 10.0, 10.0 ) );
+  DataObject::RefPtr b ( Helper::makeDataObject ( 20.0, 20.0 ) );
+  a->timePrimitive ( Helper::makeTimeSpan ( "2010-01-01", "2010-01-10" ).get() );
+  b->timePrimitive ( Helper::makeTimeSpan ( "2010-01-01", "2010-01-10" ).get() );
+  container->add ( a.get() );
+  container->add ( b.get() );
+
+  container->temporalVisibility ( Helper::makePeriod ( "2010-01-02", "2010-01-03" ) );
+  EXPECT_TRUE ( a->visibility() );
+  EXPECT_TRUE ( b->visibility() );
+
+  // Give one a later time after the index is made.
+  a->timePrimitive ( Helper::makeTimeSpan ( "2010-02-01", "2010-02-10" ).get() );
+
+  container->temporalVisibility ( Helper::makePeriod ( "2010-01-04", "2010-01-05" ) );
+  EXPECT_FALSE ( a->visibility() );
+  EXPECT_TRUE ( b->visibility() );
+
+  container->temporalVisibility ( Helper::makePeriod ( "2010-02-02", "2010-02-03" ) );
+  EXPECT_TRUE ( a->visibility() );
+  EXPECT_FALSE ( b->visibility() );
+
+  // Taking the time away shows it always.
+  b->timePrimitive ( 0x0 );
+  container->temporalVisibility ( Helper::makePeriod ( "2010-03-01", "2010-03-02" ) );
+  EXPECT_FALSE ( a->visibility() );
+  EXPECT_TRUE ( b->visibility() );
+}
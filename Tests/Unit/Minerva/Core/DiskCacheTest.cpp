@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/DiskCache.h"
+
+#include "Usul/Registry/Database.h"
+
+#include "boost/filesystem.hpp"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::DiskCache DiskCache;
+typedef Minerva::Common::LayerKey LayerKey;
+typedef Minerva::Common::TileKey TileKey;
+
+namespace Helper
+{
+  const std::string DIRECTORY ( "disk_cache_test" );
+
+  TileKey::RefPtr makeKey ( unsigned int column )
+  {
+    TileKey::RefPtr key ( new TileKey );
+    key->level ( 3 );
+    key->row ( 1 );
+    key->column ( column );
+    return key;
+  }
+}
+
+TEST(DiskCacheTest,PackedStoreFromRegistry)
+{
+  DiskCache &cache ( DiskCache::instance() );
+  const std::string oldDirectory ( cache.cacheDirectory() );
+  Usul::Registry::Node &enabled ( Usul::Registry::Database::instance()["disk_cache"]["packed_store"]["enabled"] );
+  const bool wasEnabled ( enabled.get<bool> ( false ) );
+
+  boost::filesystem::remove_all ( Helper::DIRECTORY );
+
+  // The store is opened in the cache directory.
+  enabled = true;
+  Usul::Registry::Database::instance()["disk_cache"]["packed_store"]["segment_size_mb"] = 1u;
+  cache.cacheDirectory ( Helper::DIRECTORY );
+  {
+    DiskCache::TileStore::RefPtr store ( cache.tileStore() );
+    ASSERT_TRUE ( store.valid() );
+    EXPECT_TRUE ( boost::filesystem::exists ( Helper::DIRECTORY + "/Packed" ) );
+
+    // Layers write into the store, not a file.
+    LayerKey::RefPtr layer ( new LayerKey ( "test", 1 ) );
+    std::string filename ( "not empty" );
+    EXPECT_EQ ( DiskCache::CACHE_STATUS_FILE_DOES_NOT_EXIST, cache.getAndCheckCacheFilename ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", filename ) );
+    EXPECT_TRUE ( filename.empty() );
+
+    cache.storeTile ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", DiskCache::TileStore::Buffer ( 100, 'a' ) );
+    EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+    EXPECT_FALSE ( boost::filesystem::exists ( Helper::DIRECTORY + "/test" ) );
+  }
+
+  // Without the setting there is no store.
+  enabled = false;
+  cache.cacheDirectory ( Helper::DIRECTORY + "/Files" );
+  EXPECT_FALSE ( cache.tileStore().valid() );
+
+  enabled = wasEnabled;
+  cache.cacheDirectory ( oldDirectory );
+  boost::filesystem::remove_all ( Helper::DIRECTORY );
+}
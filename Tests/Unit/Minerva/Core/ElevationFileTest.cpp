@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/ElevationFile.h"
+
+#include "boost/filesystem.hpp"
+
+#include "gtest/gtest.h"
+
+#include <fstream>
+
+typedef Minerva::Core::ElevationData ElevationData;
+typedef Minerva::Core::ElevationFile ElevationFile;
+
+namespace Helper
+{
+  ElevationData::RefPtr makeData ( float step )
+  {
+    ElevationData::RefPtr data ( new ElevationData ( 5, 7 ) );
+    data->noDataValue ( -9999.0f );
+    for ( unsigned int i = 0; i < 5; ++i )
+      for ( unsigned int j = 0; j < 7; ++j )
+        data->value ( i, j, step * ( i * 10 + j ) );
+    data->value ( 2, 3, -9999.0f );
+    return data;
+  }
+
+  ElevationData::RefPtr roundTrip ( const ElevationData& data, ElevationFile::Format format )
+  {
+    ElevationFile::Buffer buffer;
+    ElevationFile::encode ( data, buffer, format );
+    return ElevationFile::decode ( &buffer[0], buffer.size() );
+  }
+}
+
+
+TEST(ElevationFileTest,RoundTrip)
+{
+  ElevationData::RefPtr whole ( Helper::makeData ( 1.0f ) );
+  ElevationData::RefPtr fraction ( Helper::makeData ( 0.37f ) );
+
+  // Whole numbers are exact in every format. Fractions are exact as float32.
+  const ElevationFile::Format formats[] = { ElevationFile::FORMAT_AUTO, ElevationFile::FORMAT_FLOAT32, ElevationFile::FORMAT_INT16 };
+  for ( unsigned int f = 0; f < 3; ++f )
+  {
+    ElevationData::RefPtr a ( Helper::roundTrip ( *whole, formats[f] ) );
+    ElevationData::RefPtr b ( Helper::roundTrip ( *fraction, formats[f] ) );
+    ASSERT_TRUE ( a.valid() );
+    ASSERT_TRUE ( b.valid() );
+    EXPECT_EQ ( 5u, a->width() );
+    EXPECT_EQ ( 7u, a->height() );
+    EXPECT_EQ ( -9999.0f, a->noDataValue() );
+
+    const float tolerance ( ElevationFile::FORMAT_INT16 == formats[f] ? 0.001f : 0.0f );
+    for ( unsigned int i = 0; i < 5; ++i )
+    {
+      for ( unsigned int j = 0; j < 7; ++j )
+      {
+        EXPECT_EQ ( whole->value ( i, j ), a->value ( i, j ) );
+        EXPECT_NEAR ( fraction->value ( i, j ), b->value ( i, j ), tolerance );
+      }
+    }
+
+    // The no data sample comes back exactly.
+    EXPECT_EQ ( -9999.0f, b->value ( 2, 3 ) );
+  }
+
+  EXPECT_FALSE ( ElevationFile::decode ( "not an elevation tile", 21 ).valid() );
+}
+
+
+TEST(ElevationFileTest,Merge)
+{
+  ElevationData::RefPtr source ( Helper::makeData ( 1.0f ) );
+  ElevationData::RefPtr answer ( new ElevationData ( 5, 7 ) );
+
+  answer->value ( 2, 3, 123.0f );
+  answer->merge ( *source );
+
+  // The no data sample is skipped.
+  EXPECT_EQ ( 123.0f, answer->value ( 2, 3 ) );
+  EXPECT_EQ ( 46.0f, answer->value ( 4, 6 ) );
+  EXPECT_EQ ( 0.0f, answer->value ( 0, 0 ) );
+}
+
+
+TEST(ElevationFileTest,ReadFile)
+{
+  const std::string filename ( "elevation_file_test.mel" );
+  boost::filesystem::remove ( filename );
+
+  // Missing and empty files aren't tiles.
+  EXPECT_FALSE ( ElevationFile::read ( filename ).valid() );
+  std::ofstream ( filename.c_str() ).close();
+  EXPECT_FALSE ( ElevationFile::read ( filename ).valid() );
+
+  ElevationData::RefPtr data ( Helper::makeData ( 0.37f ) );
+  ASSERT_TRUE ( ElevationFile::write ( filename, *data ) );
+
+  ElevationData::RefPtr answer ( ElevationFile::read ( filename ) );
+  boost::filesystem::remove ( filename );
+
+  ASSERT_TRUE ( answer.valid() );
+  EXPECT_EQ ( data->value ( 4, 6 ), answer->value ( 4, 6 ) );
+}
@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Data/GeometryBatch.h"
+#include "Minerva/Core/Data/DataObject.h"
+#include "Minerva/Core/Data/UserData.h"
+
+#include "osg/Geode"
+#include "osg/Geometry"
+#include "osg/MatrixTransform"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::Data::GeometryBatch GeometryBatch;
+typedef Minerva::Core::Data::DataObject DataObject;
+typedef Minerva::Core::Data::BatchUserData BatchUserData;
+
+namespace Helper
+{
+  const GeometryBatch::Color RED ( 1.0f, 0.0f, 0.0f, 1.0f );
+
+  DataObject::RefPtr makeFeature ( const std::string& id )
+  {
+    DataObject::RefPtr feature ( new DataObject );
+    feature->objectId ( id );
+    return feature;
+  }
+
+  // A line with two points, starting at the given point.
+  GeometryBatch::Vertices makeLine ( double x, double y, double z )
+  {
+    GeometryBatch::Vertices line;
+    line.push_back ( GeometryBatch::Vertex ( x, y, z ) );
+    line.push_back ( GeometryBatch::Vertex ( x + 10.0, y, z ) );
+    return line;
+  }
+
+  osg::Group* scene ( GeometryBatch& batch )
+  {
+    osg::Node *node ( batch.buildScene() );
+    return ( 0x0 != node ? node->asGroup() : 0x0 );
+  }
+
+  osg::MatrixTransform* transform ( osg::Group& group, unsigned int i )
+  {
+    return dynamic_cast<osg::MatrixTransform*> ( group.getChild ( i ) );
+  }
+
+  osg::Geode* geode ( osg::Group& group, unsigned int i )
+  {
+    osg::MatrixTransform *mt ( Helper::transform ( group, i ) );
+    return ( 0x0 != mt ? dynamic_cast<osg::Geode*> ( mt->getChild ( 0 ) ) : 0x0 );
+  }
+
+  osg::Geometry* geometry ( osg::Group& group, unsigned int i )
+  {
+    osg::Geode *geode ( Helper::geode ( group, i ) );
+    return ( 0x0 != geode ? dynamic_cast<osg::Geometry*> ( geode->getDrawable ( 0 ) ) : 0x0 );
+  }
+
+  unsigned int numVertices ( osg::Group& group, unsigned int i )
+  {
+    osg::Geometry *geometry ( Helper::geometry ( group, i ) );
+    osg::Vec3Array *vertices ( 0x0 != geometry ? dynamic_cast<osg::Vec3Array*> ( geometry->getVertexArray() ) : 0x0 );
+    return ( 0x0 != vertices ? vertices->size() : 0 );
+  }
+}
+
+
+TEST(GeometryBatchTest,MergeSameState)
+{
+  DataObject::RefPtr a ( Helper::makeFeature ( "a" ) );
+  DataObject::RefPtr b ( Helper::makeFeature ( "b" ) );
+
+  GeometryBatch batch;
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 1.0f, 0 );
+  batch.lines ( b.get(), Helper::makeLine ( 0.0, 100.0, 0.0 ), Helper::RED, 1.0f, 0 );
+  EXPECT_TRUE ( batch.contains ( a.get() ) );
+  EXPECT_TRUE ( batch.dirty() );
+
+  osg::ref_ptr<osg::Group> group ( Helper::scene ( batch ) );
+  ASSERT_TRUE ( group.valid() );
+  EXPECT_FALSE ( batch.dirty() );
+
+  // One geometry for both.
+  EXPECT_EQ ( 1u, batch.numBatches() );
+  ASSERT_EQ ( 1u, group->getNumChildren() );
+  EXPECT_EQ ( 4u, Helper::numVertices ( *group, 0 ) );
+  ASSERT_TRUE ( 0x0 != Helper::geometry ( *group, 0 ) );
+  EXPECT_EQ ( 1u, Helper::geometry ( *group, 0 )->getNumPrimitiveSets() );
+
+  // The picked primitive maps back to its feature.
+  BatchUserData *userData ( dynamic_cast<BatchUserData*> ( Helper::geode ( *group, 0 )->getUserData() ) );
+  ASSERT_TRUE ( 0x0 != userData );
+  EXPECT_EQ ( "a", userData->objectID ( a.get() < b.get() ? 0 : 1 ) );
+  EXPECT_EQ ( "b", userData->objectID ( a.get() < b.get() ? 1 : 0 ) );
+}
+
+
+TEST(GeometryBatchTest,SplitByState)
+{
+  DataObject::RefPtr a ( Helper::makeFeature ( "a" ) );
+
+  GeometryBatch::Vertices vertices ( Helper::makeLine ( 0.0, 0.0, 0.0 ) );
+  vertices.push_back ( GeometryBatch::Vertex ( 0.0, 10.0, 0.0 ) );
+  GeometryBatch::Indices indices;
+  indices.push_back ( 0 );
+  indices.push_back ( 1 );
+  indices.push_back ( 2 );
+
+  GeometryBatch batch;
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 1.0f, 0 );
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 2.0f, 0 );
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 1.0f, 5 );
+  batch.triangles ( a.get(), vertices, indices, Helper::RED, 0, true );
+  batch.triangles ( a.get(), vertices, indices, Helper::RED, 0, false );
+
+  // The color is in the vertices, so it doesn't split the batch.
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), GeometryBatch::Color ( 0.0f, 1.0f, 0.0f, 1.0f ), 1.0f, 0 );
+
+  osg::ref_ptr<osg::Group> group ( Helper::scene ( batch ) );
+  ASSERT_TRUE ( group.valid() );
+  EXPECT_EQ ( 5u, batch.numBatches() );
+  EXPECT_EQ ( 5u, group->getNumChildren() );
+}
+
+
+TEST(GeometryBatchTest,SplitByTile)
+{
+  DataObject::RefPtr a ( Helper::makeFeature ( "a" ) );
+  DataObject::RefPtr b ( Helper::makeFeature ( "b" ) );
+
+  // Continents apart, in planet coordinates.
+  const double far ( 5000000.0 );
+
+  GeometryBatch batch;
+  batch.lines ( a.get(), Helper::makeLine ( 10.0, 10.0, 10.0 ), Helper::RED, 1.0f, 0 );
+  batch.lines ( b.get(), Helper::makeLine ( far, far, far ), Helper::RED, 1.0f, 0 );
+
+  osg::ref_ptr<osg::Group> group ( Helper::scene ( batch ) );
+  ASSERT_TRUE ( group.valid() );
+  ASSERT_EQ ( 2u, group->getNumChildren() );
+  EXPECT_EQ ( 2u, batch.numBatches() );
+
+  // Each tile has its own origin, near its vertices.
+  for ( unsigned int i = 0; i < group->getNumChildren(); ++i )
+  {
+    osg::Geometry *geometry ( Helper::geometry ( *group, i ) );
+    ASSERT_TRUE ( 0x0 != geometry );
+    osg::Vec3Array *vertices ( dynamic_cast<osg::Vec3Array*> ( geometry->getVertexArray() ) );
+    ASSERT_TRUE ( 0x0 != vertices );
+
+    for ( unsigned int j = 0; j < vertices->size(); ++j )
+    {
+      for ( unsigned int k = 0; k < 3; ++k )
+        EXPECT_LE ( std::fabs ( vertices->at ( j )[k] ), GeometryBatch::tileSize() );
+    }
+
+    const osg::Vec3d origin ( Helper::transform ( *group, i )->getMatrix().getTrans() );
+    const double expected ( ( origin[0] > GeometryBatch::tileSize() ) ? far : 10.0 );
+    EXPECT_NEAR ( expected, origin[0] + vertices->at ( 0 )[0], 1e-3 );
+  }
+}
+
+
+TEST(GeometryBatchTest,RebuildOnlyChanged)
+{
+  DataObject::RefPtr a ( Helper::makeFeature ( "a" ) );
+  DataObject::RefPtr b ( Helper::makeFeature ( "b" ) );
+  DataObject::RefPtr c ( Helper::makeFeature ( "c" ) );
+
+  GeometryBatch batch;
+  batch.lines ( a.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 1.0f, 0 );
+  batch.lines ( b.get(), Helper::makeLine ( 0.0, 0.0, 0.0 ), Helper::RED, 2.0f, 0 );
+
+  osg::ref_ptr<osg::Group> group ( Helper::scene ( batch ) );
+  ASSERT_TRUE ( group.valid() );
+  ASSERT_EQ ( 2u, group->getNumChildren() );
+  osg::ref_ptr<osg::Node> first ( group->getChild ( 0 ) );
+  osg::ref_ptr<osg::Node> second ( group->getChild ( 1 ) );
+
+  // Nothing changed, nothing is built.
+  EXPECT_EQ ( group.get(), Helper::scene ( batch ) );
+  EXPECT_EQ ( first.get(), group->getChild ( 0 ) );
+  EXPECT_EQ ( second.get(), group->getChild ( 1 ) );
+
+  // Adding to one batch leaves the other alone.
+  batch.lines ( c.get(), Helper::makeLine ( 0.0, 50.0, 0.0 ), Helper::RED, 2.0f, 0 );
+  EXPECT_EQ ( group.get(), Helper::scene ( batch ) );
+  ASSERT_EQ ( 2u, group->getNumChildren() );
+  EXPECT_EQ ( first.get(), group->getChild ( 0 ) );
+  EXPECT_NE ( second.get(), group->getChild ( 1 ) );
+  osg::ref_ptr<osg::Node> third ( group->getChild ( 1 ) );
+
+  // Hiding a feature only merges its batch again.
+  a->visibilitySet ( false );
+  EXPECT_TRUE ( batch.dirty() );
+  EXPECT_EQ ( group.get(), Helper::scene ( batch ) );
+  ASSERT_EQ ( 1u, group->getNumChildren() );
+  EXPECT_EQ ( third.get(), group->getChild ( 0 ) );
+
+  a->visibilitySet ( true );
+  EXPECT_EQ ( group.get(), Helper::scene ( batch ) );
+  ASSERT_EQ ( 2u, group->getNumChildren() );
+  EXPECT_TRUE ( group->containsNode ( third.get() ) );
+
+  // Removing the last feature of a batch removes its node.
+  EXPECT_TRUE ( batch.remove ( b.get() ) );
+  EXPECT_TRUE ( batch.remove ( c.get() ) );
+  EXPECT_FALSE ( batch.remove ( c.get() ) );
+  EXPECT_EQ ( group.get(), Helper::scene ( batch ) );
+  EXPECT_EQ ( 1u, group->getNumChildren() );
+  EXPECT_EQ ( 1u, batch.numBatches() );
+  EXPECT_FALSE ( group->containsNode ( third.get() ) );
+
+  // Nothing to draw.
+  batch.clear();
+  EXPECT_TRUE ( 0x0 == batch.buildScene() );
+  EXPECT_EQ ( 0u, batch.numBatches() );
+}
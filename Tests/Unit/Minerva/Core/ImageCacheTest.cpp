@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/ImageCache.h"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::ImageCache ImageCache;
+typedef Minerva::Common::LayerKey LayerKey;
+typedef Minerva::Common::TileKey TileKey;
+
+namespace Helper
+{
+  osg::ref_ptr<osg::Image> makeImage()
+  {
+    osg::ref_ptr<osg::Image> image ( new osg::Image );
+    image->allocateImage ( 256, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE );
+    return image;
+  }
+
+  TileKey::RefPtr makeKey ( unsigned int column )
+  {
+    TileKey::RefPtr key ( new TileKey );
+    key->level ( 3 );
+    key->row ( 1 );
+    key->column ( column );
+    return key;
+  }
+}
+
+TEST(ImageCacheTest,FindAndEvict)
+{
+  ImageCache &cache ( ImageCache::instance() );
+  cache.clear();
+
+  const ImageCache::Uint64 oldMaximum ( cache.maximumBytes() );
+
+  // Room for a few images per shard.
+  const ImageCache::Uint64 imageBytes ( 256 * 256 * 4 );
+  cache.maximumBytes ( imageBytes * 4 * 16 );
+
+  LayerKey::RefPtr layer ( new LayerKey ( "test", 1 ) );
+  LayerKey::RefPtr other ( new LayerKey ( "test", 2 ) );
+
+  const ImageCache::Statistics before ( cache.statistics() );
+
+  osg::ref_ptr<osg::Image> image ( Helper::makeImage() );
+  cache.insert ( *layer, *Helper::makeKey ( 0 ), 256, 256, image );
+
+  EXPECT_EQ ( image.get(), cache.find ( *layer, *Helper::makeKey ( 0 ), 256, 256 ).get() );
+  EXPECT_FALSE ( cache.find ( *layer, *Helper::makeKey ( 0 ), 128, 128 ).valid() );
+  EXPECT_FALSE ( cache.find ( *other, *Helper::makeKey ( 0 ), 256, 256 ).valid() );
+
+  const ImageCache::Statistics after ( cache.statistics() );
+  EXPECT_EQ ( 1u, after.hits - before.hits );
+  EXPECT_EQ ( 2u, after.misses - before.misses );
+
+  // Fill well past the budget.
+  for ( unsigned int i = 1; i < 1000; ++i )
+  {
+    cache.insert ( *layer, *Helper::makeKey ( i ), 256, 256, Helper::makeImage() );
+  }
+
+  const ImageCache::Statistics full ( cache.statistics() );
+  EXPECT_LE ( full.bytes, cache.maximumBytes() );
+  EXPECT_GT ( full.evictions, 0u );
+
+  // Removing the layer empties the cache.
+  cache.remove ( *layer );
+  EXPECT_EQ ( 0u, cache.statistics().entries );
+
+  cache.maximumBytes ( oldMaximum );
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/IntervalIndex.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+typedef Minerva::Core::Algorithms::IntervalIndex<int,unsigned int> IntervalIndex;
+typedef std::pair<int,int> Interval;
+
+namespace Helper
+{
+  Interval makeInterval ( int maxSize )
+  {
+    const int begin ( ::rand() % 1000 );
+    return Interval ( begin, begin + 1 + ::rand() % maxSize );
+  }
+
+  IntervalIndex::Values sorted ( IntervalIndex::Values values )
+  {
+    std::sort ( values.begin(), values.end() );
+    return values;
+  }
+}
+
+
+TEST(IntervalIndexTest,ChangesMatchLinearSearch)
+{
+  ::srand ( 10 );
+
+  IntervalIndex index;
+  std::vector<Interval> all;
+  for ( unsigned int i = 0; i < 2000; ++i )
+  {
+    all.push_back ( Helper::makeInterval ( 50 ) );
+    EXPECT_TRUE ( index.insert ( i, all.back().first, all.back().second ) );
+  }
+
+  // Remove some.
+  std::vector<bool> present ( all.size(), true );
+  for ( unsigned int i = 0; i < all.size(); i += 7 )
+  {
+    EXPECT_TRUE ( index.remove ( i, all[i].first, all[i].second ) );
+    present[i] = false;
+  }
+  EXPECT_FALSE ( index.remove ( 0, all[0].first, all[0].second ) );
+
+  // Move the query forward, backward and across, and compare with checking everything.
+  Interval from ( 100, 130 );
+  for ( unsigned int step = 0; step < 200; ++step )
+  {
+    const Interval to ( ( step % 5 == 4 ) ? Helper::makeInterval ( 200 ) : Interval ( from.first + 10, from.second + 10 ) );
+
+    IntervalIndex::Values entered, left, expectedEntered, expectedLeft;
+    index.changes ( from.first, from.second, to.first, to.second, entered, left );
+
+    for ( unsigned int i = 0; i < all.size(); ++i )
+    {
+      if ( false == present[i] )
+        continue;
+
+      const bool was ( IntervalIndex::overlaps ( all[i].first, all[i].second, from.first, from.second ) );
+      const bool is  ( IntervalIndex::overlaps ( all[i].first, all[i].second, to.first, to.second ) );
+
+      if ( is && !was )
+        expectedEntered.push_back ( i );
+      else if ( was && !is )
+        expectedLeft.push_back ( i );
+    }
+
+    EXPECT_EQ ( expectedEntered, Helper::sorted ( entered ) );
+    EXPECT_EQ ( expectedLeft, Helper::sorted ( left ) );
+
+    from = to;
+  }
+}
+
+
+TEST(IntervalIndexTest,Query)
+{
+  IntervalIndex index;
+  EXPECT_TRUE ( index.insert ( 0, 0, 10 ) );
+  EXPECT_TRUE ( index.insert ( 1, 10, 20 ) );
+  EXPECT_TRUE ( index.insert ( 2, 5, 15 ) );
+  EXPECT_FALSE ( index.insert ( 3, 5, 5 ) );
+  EXPECT_EQ ( 3u, index.size() );
+
+  // The end isn't in the interval.
+  IntervalIndex::Values inside, outside;
+  index.query ( 10, 12, inside, outside );
+  EXPECT_EQ ( 2u, inside.size() );
+  EXPECT_EQ ( 1u, outside.size() );
+  EXPECT_EQ ( 0u, outside.front() );
+}
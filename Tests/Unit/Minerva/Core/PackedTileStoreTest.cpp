@@ -0,0 +1,325 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/PackedTileStore.h"
+
+#include "boost/filesystem.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+typedef Minerva::Core::PackedTileStore PackedTileStore;
+typedef Minerva::Common::LayerKey LayerKey;
+typedef Minerva::Common::TileKey TileKey;
+typedef PackedTileStore::Buffer Buffer;
+
+namespace Helper
+{
+  const std::string DIRECTORY ( "packed_tile_store_test" );
+  const PackedTileStore::Uint64 SEGMENT_SIZE ( 64 * 1024 );
+
+  TileKey::RefPtr makeKey ( unsigned int column )
+  {
+    TileKey::RefPtr key ( new TileKey );
+    key->level ( 3 );
+    key->row ( 1 );
+    key->column ( column );
+    return key;
+  }
+
+  Buffer makeBuffer ( unsigned int size, char value )
+  {
+    return Buffer ( size, value );
+  }
+
+  std::string segmentFilename ( unsigned int index = 0 )
+  {
+    std::ostringstream out;
+    out << DIRECTORY << "/segment_" << std::setw ( 5 ) << std::setfill ( '0' ) << index << ".mts";
+    return out.str();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start each test with an empty directory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class PackedTileStoreTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    boost::filesystem::remove_all ( Helper::DIRECTORY );
+    layer = new LayerKey ( "test", 1 );
+  }
+
+  virtual void TearDown()
+  {
+    boost::filesystem::remove_all ( Helper::DIRECTORY );
+  }
+
+  LayerKey::RefPtr layer;
+};
+
+
+TEST_F(PackedTileStoreTest,WriteRead)
+{
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+
+  store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 100, 'a' ) );
+
+  Buffer buffer;
+  EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 100, 'a' ) == buffer );
+
+  // Any part of the key that differs is a miss.
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png" ) );
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 128, 128, "png" ) );
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "jpg" ) );
+  EXPECT_FALSE ( store->contains ( *LayerKey::RefPtr ( new LayerKey ( "test", 2 ) ), *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+
+  // Fill more than one segment.
+  for ( unsigned int i = 1; i < 100; ++i )
+  {
+    store->write ( *layer, *Helper::makeKey ( i ), 256, 256, "png", Helper::makeBuffer ( 2000, static_cast<char> ( i ) ) );
+  }
+
+  EXPECT_EQ ( 100u, store->numTiles() );
+  EXPECT_GT ( store->numSegments(), 1u );
+
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 99 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 2000, static_cast<char> ( 99 ) ) == buffer );
+}
+
+
+TEST_F(PackedTileStoreTest,Overwrite)
+{
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+
+  store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 100, 'a' ) );
+  store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 50, 'b' ) );
+
+  Buffer buffer;
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 50, 'b' ) == buffer );
+  EXPECT_EQ ( 1u, store->numTiles() );
+
+  // The last write also wins after the segments are scanned again.
+  store = 0x0;
+  store = new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE );
+
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 50, 'b' ) == buffer );
+}
+
+
+TEST_F(PackedTileStoreTest,Remove)
+{
+  LayerKey::RefPtr other ( new LayerKey ( "other", 2 ) );
+
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+  store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 100, 'a' ) );
+  store->write ( *other, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 100, 'b' ) );
+
+  store->remove ( *layer );
+
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+  EXPECT_TRUE ( store->contains ( *other, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+
+  // The removal is recorded, so the tile does not come back.
+  store = 0x0;
+  store = new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE );
+
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+  EXPECT_TRUE ( store->contains ( *other, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+
+  // Tiles written after the removal are kept.
+  store->write ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png", Helper::makeBuffer ( 100, 'c' ) );
+  store = 0x0;
+  store = new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE );
+
+  EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png" ) );
+}
+
+
+TEST_F(PackedTileStoreTest,Reopen)
+{
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    for ( unsigned int i = 0; i < 50; ++i )
+    {
+      store->write ( *layer, *Helper::makeKey ( i ), 256, 256, "png", Helper::makeBuffer ( 2000, static_cast<char> ( i ) ) );
+    }
+  }
+
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+  EXPECT_EQ ( 50u, store->numTiles() );
+
+  Buffer buffer;
+  for ( unsigned int i = 0; i < 50; ++i )
+  {
+    EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( i ), 256, 256, "png", buffer ) );
+    EXPECT_TRUE ( Helper::makeBuffer ( 2000, static_cast<char> ( i ) ) == buffer );
+  }
+
+  // Writing carries on after the last record.
+  const unsigned int segments ( store->numSegments() );
+  store->write ( *layer, *Helper::makeKey ( 50 ), 256, 256, "png", Helper::makeBuffer ( 10, 'z' ) );
+  EXPECT_EQ ( segments, store->numSegments() );
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 2000, static_cast<char> ( 0 ) ) == buffer );
+}
+
+
+TEST_F(PackedTileStoreTest,TruncatedLastRecord)
+{
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 1000, 'a' ) );
+    store->write ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png", Helper::makeBuffer ( 1000, 'b' ) );
+  }
+
+  // Cut the file in the middle of the second tile, like a crash would.
+  Buffer contents;
+  {
+    std::ifstream in ( Helper::segmentFilename().c_str(), std::ios::binary );
+    contents.assign ( std::istreambuf_iterator<char> ( in ), std::istreambuf_iterator<char>() );
+  }
+  const Buffer second ( Helper::makeBuffer ( 1000, 'b' ) );
+  const Buffer::iterator start ( std::search ( contents.begin(), contents.end(), second.begin(), second.end() ) );
+  ASSERT_TRUE ( contents.end() != start );
+  boost::filesystem::resize_file ( Helper::segmentFilename(), ( start - contents.begin() ) + 500 );
+
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+    EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png" ) );
+
+    // The torn record is written over.
+    store->write ( *layer, *Helper::makeKey ( 2 ), 256, 256, "png", Helper::makeBuffer ( 3000, 'c' ) );
+  }
+
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+  EXPECT_EQ ( 2u, store->numTiles() );
+
+  Buffer buffer;
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 1000, 'a' ) == buffer );
+  EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( 2 ), 256, 256, "png", buffer ) );
+  EXPECT_TRUE ( Helper::makeBuffer ( 3000, 'c' ) == buffer );
+}
+
+
+TEST_F(PackedTileStoreTest,SingleWriter)
+{
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+
+  EXPECT_THROW ( PackedTileStore::RefPtr ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) ), std::runtime_error );
+  EXPECT_THROW ( PackedTileStore::RefPtr ( new PackedTileStore ( Helper::DIRECTORY + "/.", Helper::SEGMENT_SIZE ) ), std::runtime_error );
+
+  // Closing the store lets the next one open.
+  store = 0x0;
+  EXPECT_NO_THROW ( store = new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+}
+
+
+TEST_F(PackedTileStoreTest,Compact)
+{
+  LayerKey::RefPtr other ( new LayerKey ( "other", 2 ) );
+
+  unsigned int segments ( 0 );
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+
+    // Write every tile three times, so only the last third is live.
+    for ( unsigned int pass = 0; pass < 3; ++pass )
+    {
+      for ( unsigned int i = 0; i < 40; ++i )
+      {
+        store->write ( *layer, *Helper::makeKey ( i ), 256, 256, "png", Helper::makeBuffer ( 2000, static_cast<char> ( pass * 40 + i ) ) );
+      }
+    }
+
+    // A removed layer is not copied either.
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      store->write ( *other, *Helper::makeKey ( i ), 256, 256, "png", Helper::makeBuffer ( 2000, 'o' ) );
+    }
+    store->remove ( *other );
+
+    segments = store->numSegments();
+  }
+
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+  EXPECT_LT ( store->numSegments(), segments );
+  EXPECT_EQ ( 40u, store->numTiles() );
+  EXPECT_FALSE ( boost::filesystem::exists ( Helper::DIRECTORY + "/compact" ) );
+  EXPECT_FALSE ( boost::filesystem::exists ( Helper::segmentFilename ( segments - 1 ) ) );
+
+  Buffer buffer;
+  for ( unsigned int i = 0; i < 40; ++i )
+  {
+    EXPECT_TRUE ( store->read ( *layer, *Helper::makeKey ( i ), 256, 256, "png", buffer ) );
+    EXPECT_TRUE ( Helper::makeBuffer ( 2000, static_cast<char> ( 80 + i ) ) == buffer );
+  }
+  EXPECT_FALSE ( store->contains ( *other, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+
+  // Writing carries on in the compacted segments.
+  store->write ( *layer, *Helper::makeKey ( 40 ), 256, 256, "png", Helper::makeBuffer ( 10, 'z' ) );
+  store = 0x0;
+  store = new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE );
+  EXPECT_EQ ( 41u, store->numTiles() );
+}
+
+
+TEST_F(PackedTileStoreTest,CompactCutShort)
+{
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    store->write ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png", Helper::makeBuffer ( 100, 'a' ) );
+  }
+
+  // A copy without the marker is thrown away.
+  boost::filesystem::create_directories ( Helper::DIRECTORY + "/compact" );
+  boost::filesystem::copy_file ( Helper::segmentFilename(), Helper::DIRECTORY + "/compact/segment_00000.mts" );
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    store->write ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png", Helper::makeBuffer ( 100, 'b' ) );
+  }
+  EXPECT_FALSE ( boost::filesystem::exists ( Helper::DIRECTORY + "/compact" ) );
+
+  // A copy with the marker replaces the segments.
+  const std::string copy ( Helper::DIRECTORY + "/copy.mts" );
+  boost::filesystem::copy_file ( Helper::segmentFilename(), copy );
+  {
+    PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+    store->write ( *layer, *Helper::makeKey ( 2 ), 256, 256, "png", Helper::makeBuffer ( 100, 'c' ) );
+  }
+  boost::filesystem::create_directories ( Helper::DIRECTORY + "/compact" );
+  boost::filesystem::rename ( copy, Helper::DIRECTORY + "/compact/segment_00000.mts" );
+  {
+    std::ofstream done ( ( Helper::DIRECTORY + "/compact/done" ).c_str() );
+    done << 1;
+  }
+
+  PackedTileStore::RefPtr store ( new PackedTileStore ( Helper::DIRECTORY, Helper::SEGMENT_SIZE ) );
+  EXPECT_FALSE ( boost::filesystem::exists ( Helper::DIRECTORY + "/compact" ) );
+  EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 0 ), 256, 256, "png" ) );
+  EXPECT_TRUE ( store->contains ( *layer, *Helper::makeKey ( 1 ), 256, 256, "png" ) );
+  EXPECT_FALSE ( store->contains ( *layer, *Helper::makeKey ( 2 ), 256, 256, "png" ) );
+}
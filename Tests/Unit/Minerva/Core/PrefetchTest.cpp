@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/TileEngine/Prefetch.h"
+
+#include "Usul/System/Sleep.h"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::TileEngine::Prefetch Prefetch;
+
+
+TEST(PrefetchTest,LevelForAltitude)
+{
+  // The top tiles split when closer than the split distance.
+  EXPECT_EQ ( 0u, Prefetch::levelForAltitude ( 2000.0, 1000.0, 20 ) );
+  EXPECT_EQ ( 0u, Prefetch::levelForAltitude ( 1000.0, 1000.0, 20 ) );
+  EXPECT_EQ ( 1u, Prefetch::levelForAltitude ( 999.0, 1000.0, 20 ) );
+  EXPECT_EQ ( 2u, Prefetch::levelForAltitude ( 300.0, 1000.0, 20 ) );
+  EXPECT_EQ ( 10u, Prefetch::levelForAltitude ( 1.0, 1000.0, 20 ) );
+  EXPECT_EQ ( 5u, Prefetch::levelForAltitude ( 1.0, 1000.0, 5 ) );
+  EXPECT_EQ ( 5u, Prefetch::levelForAltitude ( 0.0, 1000.0, 5 ) );
+}
+
+
+TEST(PrefetchTest,JobLimit)
+{
+  // By default only part of the pool is used, and never none of it.
+  EXPECT_EQ ( 1u, Prefetch::jobLimit ( 0, 1 ) );
+  EXPECT_EQ ( 1u, Prefetch::jobLimit ( 0, 4 ) );
+  EXPECT_EQ ( 4u, Prefetch::jobLimit ( 0, 16 ) );
+
+  // A setting is used as is.
+  EXPECT_EQ ( 6u, Prefetch::jobLimit ( 6, 16 ) );
+}
+
+
+TEST(PrefetchTest,Extrapolate)
+{
+  Prefetch::RefPtr prefetch ( new Prefetch ( 0x0 ) );
+  prefetch->lookAhead ( 2.0 );
+
+  Prefetch::Positions positions;
+  prefetch->predict ( positions );
+  EXPECT_TRUE ( positions.empty() );
+
+  // Moving east and down.
+  prefetch->cameraNotify ( 10.0, 20.0, 1000.0 );
+  Usul::System::Sleep::milliseconds ( 100 );
+  prefetch->cameraNotify ( 10.1, 20.0, 900.0 );
+
+  prefetch->predict ( positions );
+  ASSERT_EQ ( 4u, positions.size() );
+  for ( unsigned int i = 0; i < positions.size(); ++i )
+  {
+    EXPECT_GT ( positions[i][0], 10.1 );
+    EXPECT_DOUBLE_EQ ( 20.0, positions[i][1] );
+    EXPECT_GE ( positions[i][2], 1.0 );
+    EXPECT_LT ( positions[i][2], 900.0 );
+    if ( i > 0 )
+    {
+      EXPECT_GT ( positions[i][0], positions[i - 1][0] );
+    }
+  }
+}
+
+
+TEST(PrefetchTest,FollowPath)
+{
+  Prefetch::RefPtr prefetch ( new Prefetch ( 0x0 ) );
+  prefetch->lookAhead ( 1.0 );
+
+  // One step every 10 milliseconds, so a second looks 100 steps ahead.
+  Prefetch::Positions path;
+  for ( unsigned int i = 0; i < 1000; ++i )
+  {
+    path.push_back ( Prefetch::Vec3d ( i * 0.01, 0.0, 500.0 ) );
+  }
+  prefetch->path ( path, 10.0 );
+
+  Prefetch::Positions positions;
+  prefetch->predict ( positions );
+  ASSERT_EQ ( 4u, positions.size() );
+  EXPECT_GT ( positions.front()[0], 0.0 );
+  EXPECT_LE ( positions.back()[0], 1.0 + 0.05 );
+  EXPECT_GE ( positions.back()[0], 1.0 - 0.05 );
+
+  // An empty path goes back to extrapolating, which needs camera positions.
+  prefetch->path ( Prefetch::Positions(), 10.0 );
+  positions.clear();
+  prefetch->predict ( positions );
+  EXPECT_TRUE ( positions.empty() );
+}
+
+
+TEST(PrefetchTest,Statistics)
+{
+  Prefetch::RefPtr prefetch ( new Prefetch ( 0x0 ) );
+
+  Minerva::Common::TileKey::RefPtr key ( new Minerva::Common::TileKey );
+  key->level ( 3 );
+  prefetch->tileNotify ( *key );
+
+  const Prefetch::Statistics stats ( prefetch->statistics() );
+  EXPECT_EQ ( 1u, stats.requests );
+  EXPECT_EQ ( 0u, stats.hits );
+  EXPECT_EQ ( 0u, stats.issued );
+}
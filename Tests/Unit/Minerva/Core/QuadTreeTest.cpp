@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/QuadTree.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+typedef Minerva::Common::Extents Extents;
+typedef Minerva::Core::Algorithms::QuadTree<unsigned int> QuadTree;
+
+namespace Helper
+{
+  double random ( double mn, double mx )
+  {
+    return mn + ( mx - mn ) * ( static_cast<double> ( ::rand() ) / RAND_MAX );
+  }
+
+  Extents makeExtents ( double maxSize )
+  {
+    const double lon ( Helper::random ( -185.0, 185.0 ) );
+    const double lat ( Helper::random ( -95.0, 95.0 ) );
+    return Extents ( lon, lat, lon + Helper::random ( 0.0, maxSize ), lat + Helper::random ( 0.0, maxSize ) );
+  }
+
+  QuadTree::Values linear ( const std::vector<Extents>& all, const std::vector<bool>& present, const Extents& query )
+  {
+    QuadTree::Values answer;
+    for ( unsigned int i = 0; i < all.size(); ++i )
+    {
+      if ( present[i] && all[i].intersects ( query ) )
+        answer.push_back ( i );
+    }
+    return answer;
+  }
+
+  QuadTree::Values query ( const QuadTree& tree, const Extents& extents )
+  {
+    QuadTree::Values answer;
+    tree.query ( extents, answer );
+    std::sort ( answer.begin(), answer.end() );
+    return answer;
+  }
+}
+
+
+TEST(QuadTreeTest,MatchesLinearSearch)
+{
+  ::srand ( 10 );
+
+  QuadTree tree;
+  std::vector<Extents> all;
+  std::vector<bool> present;
+
+  // Mostly points and small features, with a few that are large or cross the date line.
+  for ( unsigned int i = 0; i < 5000; ++i )
+  {
+    all.push_back ( Helper::makeExtents ( 0 == i % 100 ? 90.0 : 0.5 ) );
+    present.push_back ( true );
+    tree.insert ( i, all.back() );
+  }
+  EXPECT_EQ ( 5000u, tree.size() );
+
+  // Remove every third one.
+  for ( unsigned int i = 0; i < all.size(); i += 3 )
+  {
+    EXPECT_TRUE ( tree.remove ( i, all[i] ) );
+    present[i] = false;
+  }
+  EXPECT_FALSE ( tree.remove ( 0, all[0] ) );
+  EXPECT_EQ ( 5000u - 1667u, tree.size() );
+
+  for ( unsigned int i = 0; i < 200; ++i )
+  {
+    const Extents query ( Helper::makeExtents ( 0 == i % 10 ? 60.0 : 5.0 ) );
+    EXPECT_EQ ( Helper::linear ( all, present, query ), Helper::query ( tree, query ) );
+  }
+
+  // Everything.
+  EXPECT_EQ ( tree.size(), Helper::query ( tree, Extents ( -1000, -1000, 1000, 1000 ) ).size() );
+}
+
+
+TEST(QuadTreeTest,Clear)
+{
+  QuadTree tree;
+  tree.insert ( 1, Extents ( 10, 10, 10, 10 ) );
+  tree.insert ( 2, Extents ( -10, -10, 10, 10 ) );
+  EXPECT_EQ ( 2u, Helper::query ( tree, Extents ( 5, 5, 15, 15 ) ).size() );
+
+  tree.clear();
+  EXPECT_EQ ( 0u, tree.size() );
+  EXPECT_TRUE ( Helper::query ( tree, Extents ( 5, 5, 15, 15 ) ).empty() );
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/Simplify.h"
+
+#include "Usul/Math/Vector2.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+typedef Usul::Math::Vec2d Point;
+typedef std::vector<Point> Points;
+typedef std::vector<unsigned int> Indices;
+
+
+TEST(SimplifyTest,Straight)
+{
+  Points points;
+  for ( unsigned int i = 0; i < 100; ++i )
+    points.push_back ( Point ( -110.0 + i * 0.01, 40.0 + i * 0.005 ) );
+
+  Indices keep;
+  Minerva::Core::Algorithms::simplify ( points, 1e-6, keep );
+
+  ASSERT_EQ ( 2u, keep.size() );
+  EXPECT_EQ ( 0u, keep.front() );
+  EXPECT_EQ ( 99u, keep.back() );
+}
+
+
+TEST(SimplifyTest,Tolerance)
+{
+  Points points;
+  for ( unsigned int i = 0; i <= 1000; ++i )
+  {
+    const double x ( i * 0.001 );
+    points.push_back ( Point ( x, 0.1 * std::sin ( x * 6.283185307179586 ) ) );
+  }
+
+  Indices coarse, fine;
+  Minerva::Core::Algorithms::simplify ( points, 1e-2, coarse );
+  Minerva::Core::Algorithms::simplify ( points, 1e-4, fine );
+
+  EXPECT_LT ( coarse.size(), fine.size() );
+  EXPECT_LT ( fine.size(), points.size() );
+
+  // Every point that was dropped is within the tolerance of the simplified line.
+  for ( unsigned int k = 0; k + 1 < coarse.size(); ++k )
+  {
+    EXPECT_LT ( coarse[k], coarse[k + 1] );
+    for ( unsigned int i = coarse[k] + 1; i < coarse[k + 1]; ++i )
+    {
+      const double d ( Minerva::Core::Algorithms::Detail::distanceSquared ( points[i], points[coarse[k]], points[coarse[k + 1]] ) );
+      EXPECT_LE ( std::sqrt ( d ), 1e-2 );
+    }
+  }
+}
+
+
+TEST(SimplifyTest,Short)
+{
+  Points points;
+  Indices keep;
+
+  Minerva::Core::Algorithms::simplify ( points, 1.0, keep );
+  EXPECT_TRUE ( keep.empty() );
+
+  points.push_back ( Point ( 0.0, 0.0 ) );
+  points.push_back ( Point ( 1.0, 1.0 ) );
+  Minerva::Core::Algorithms::simplify ( points, 1.0, keep );
+  EXPECT_EQ ( 2u, keep.size() );
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/SinCos.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <vector>
+
+namespace Helper
+{
+  // Converting large angles to radians first loses a little, so std::sin 
+  // and std::cos aren't exact here either.
+  void expectSinCos ( double degrees, double s, double c )
+  {
+    const double radians ( degrees * Usul::Math::DEG_TO_RAD );
+    EXPECT_NEAR ( std::sin ( radians ), s, 1e-14 ) << degrees << " degrees";
+    EXPECT_NEAR ( std::cos ( radians ), c, 1e-14 ) << degrees << " degrees";
+  }
+}
+
+
+TEST(SinCosTest,SingleAngles)
+{
+  // The quarter turns and the halfway points between them.
+  for ( int i = -16; i <= 16; ++i )
+  {
+    const double degrees ( i * 45.0 );
+    double s ( 0.0 ), c ( 0.0 );
+    Minerva::Core::Algorithms::sinCosDegrees ( degrees, s, c );
+    Helper::expectSinCos ( degrees, s, c );
+  }
+
+  // Exact at the quarter turns.
+  double s ( 0.0 ), c ( 0.0 );
+  Minerva::Core::Algorithms::sinCosDegrees ( 90.0, s, c );
+  EXPECT_EQ ( 1.0, s );
+  EXPECT_EQ ( 0.0, c );
+  Minerva::Core::Algorithms::sinCosDegrees ( -180.0, s, c );
+  EXPECT_EQ ( 0.0, s );
+  EXPECT_EQ ( -1.0, c );
+}
+
+
+TEST(SinCosTest,Arrays)
+{
+  std::vector<double> degrees;
+  for ( double d = -720.0; d <= 720.0; d += 0.37 )
+    degrees.push_back ( d );
+
+  const unsigned int n ( degrees.size() );
+  std::vector<double> s ( n ), c ( n );
+  Minerva::Core::Algorithms::sinCosDegrees ( &degrees[0], &s[0], &c[0], n );
+
+  for ( unsigned int i = 0; i < n; ++i )
+    Helper::expectSinCos ( degrees[i], s[i], c[i] );
+}
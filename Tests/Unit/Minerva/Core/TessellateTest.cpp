@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/Algorithms/Tessellate.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+typedef Minerva::Core::Algorithms::TessellatePoints Points;
+typedef Minerva::Core::Algorithms::TessellateIndices Indices;
+typedef Usul::Math::Vec3d Point;
+
+namespace Helper
+{
+  double area ( const Point& a, const Point& b, const Point& c )
+  {
+    return std::fabs ( ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( c[0] - a[0] ) * ( b[1] - a[1] ) ) / 2.0;
+  }
+
+  double area ( const Points& points, const Indices& triangles )
+  {
+    double answer ( 0.0 );
+    for ( unsigned int i = 0; i + 2 < triangles.size(); i += 3 )
+      answer += Helper::area ( points.at ( triangles[i] ), points.at ( triangles[i + 1] ), points.at ( triangles[i + 2] ) );
+    return answer;
+  }
+
+  void ring ( Points& points, Indices& sizes, double x, double y, double size, bool close )
+  {
+    points.push_back ( Point ( x, y, 0.0 ) );
+    points.push_back ( Point ( x + size, y, 0.0 ) );
+    points.push_back ( Point ( x + size, y + size, 0.0 ) );
+    points.push_back ( Point ( x, y + size, 0.0 ) );
+    if ( close )
+      points.push_back ( Point ( x, y, 0.0 ) );
+    sizes.push_back ( close ? 5 : 4 );
+  }
+}
+
+
+TEST(TessellateTest,Square)
+{
+  Points points;
+  Indices sizes, triangles;
+  Helper::ring ( points, sizes, -110.0, 40.0, 2.0, true );
+
+  EXPECT_TRUE ( Minerva::Core::Algorithms::tessellate ( points, sizes, triangles ) );
+  EXPECT_EQ ( 6u, triangles.size() );
+  EXPECT_NEAR ( 4.0, Helper::area ( points, triangles ), 1e-10 );
+}
+
+
+TEST(TessellateTest,Holes)
+{
+  Points points;
+  Indices sizes, triangles;
+  Helper::ring ( points, sizes, 0.0, 0.0, 10.0, true );
+  Helper::ring ( points, sizes, 1.0, 1.0, 2.0, false );
+  Helper::ring ( points, sizes, 5.0, 5.0, 3.0, true );
+
+  EXPECT_TRUE ( Minerva::Core::Algorithms::tessellate ( points, sizes, triangles ) );
+  EXPECT_NEAR ( 100.0 - 4.0 - 9.0, Helper::area ( points, triangles ), 1e-10 );
+}
+
+
+TEST(TessellateTest,LargeConcave)
+{
+  // A star with enough points to use the z-order.
+  Points points;
+  Indices sizes, triangles;
+  const unsigned int num ( 1000 );
+  for ( unsigned int i = 0; i < num; ++i )
+  {
+    const double angle ( 2.0 * M_PI * i / num );
+    const double radius ( ( 0 == i % 2 ) ? 10.0 : 5.0 );
+    points.push_back ( Point ( radius * std::cos ( angle ), radius * std::sin ( angle ), 0.0 ) );
+  }
+  sizes.push_back ( num );
+
+  double expected ( 0.0 );
+  for ( unsigned int i = 0; i < num; ++i )
+    expected += Helper::area ( Point ( 0.0, 0.0, 0.0 ), points[i], points[( i + 1 ) % num] );
+
+  EXPECT_TRUE ( Minerva::Core::Algorithms::tessellate ( points, sizes, triangles ) );
+  EXPECT_EQ ( ( num - 2 ) * 3, triangles.size() );
+  EXPECT_NEAR ( expected, Helper::area ( points, triangles ), 1e-8 );
+}
+
+
+TEST(TessellateTest,Degenerate)
+{
+  Points points;
+  Indices sizes, triangles;
+  points.push_back ( Point ( 0.0, 0.0, 0.0 ) );
+  points.push_back ( Point ( 1.0, 1.0, 0.0 ) );
+  points.push_back ( Point ( 2.0, 2.0, 0.0 ) );
+  sizes.push_back ( 3 );
+
+  EXPECT_FALSE ( Minerva::Core::Algorithms::tessellate ( points, sizes, triangles ) );
+  EXPECT_TRUE ( triangles.empty() );
+}
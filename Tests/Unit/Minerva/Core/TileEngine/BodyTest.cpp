@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/ElevationData.h"
+#include "Minerva/Core/TileEngine/Body.h"
+#include "Minerva/Core/TileEngine/Tile.h"
+#include "Minerva/Core/Functions/MakeBody.h"
+
+#include "gtest/gtest.h"
+
+typedef Minerva::Core::TileEngine::Body Body;
+typedef Minerva::Core::TileEngine::Tile Tile;
+typedef Minerva::Core::TileEngine::Extents Extents;
+typedef Minerva::Common::TileKey TileKey;
+
+namespace Helper
+{
+  // Make a tile with the same height everywhere.
+  Tile::RefPtr makeTile ( Body *body, TileKey::RefPtr key, double height )
+  {
+    const Minerva::Core::TileEngine::MeshSize meshSize ( key->meshSize() );
+    std::vector<float> data ( meshSize[0] * meshSize[1], static_cast<float> ( height ) );
+    Minerva::Core::ElevationData::RefPtr elevation ( new Minerva::Core::ElevationData ( meshSize[1], meshSize[0], data ) );
+
+    Tile::RefPtr tile ( new Tile ( key, 1.0, body, 0x0, elevation.get() ) );
+    tile->updateMesh();
+    return tile;
+  }
+
+  // Split the tile. The children are ten times their index higher than the parent.
+  Tile::Tiles split ( Body *body, Tile& tile, double height )
+  {
+    TileKey::ChildrenKeys keys;
+    tile.key()->split ( keys );
+
+    Tile::Tiles children ( keys.size() );
+    for ( unsigned int i = 0; i < keys.size(); ++i )
+    {
+      children[i] = Helper::makeTile ( body, keys[i], height + 10.0 * ( i + 1 ) );
+    }
+
+    tile.attachChildren ( children );
+    return children;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a test fixture with a top tile that is split once, and split again 
+//  in the lower left.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class BodyTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    body = Minerva::Core::Functions::makeEarth ( 0x0 );
+
+    TileKey::RefPtr key ( new TileKey );
+    key->level ( 0 );
+    key->extents ( Extents ( -45.0, -22.5, 45.0, 22.5 ) );
+    key->imageSize ( Minerva::Core::TileEngine::ImageSize ( 256, 256 ) );
+    key->meshSize ( Minerva::Core::TileEngine::MeshSize ( 17, 17 ) );
+
+    top = Helper::makeTile ( body.get(), key, 0.0 );
+    children = Helper::split ( body.get(), *top, 0.0 );
+    grandChildren = Helper::split ( body.get(), *children[TileKey::LOWER_LEFT], 100.0 );
+
+    tiles.push_back ( top );
+  }
+
+  Body::RefPtr body;
+  Tile::RefPtr top;
+  Tile::Tiles children;
+  Tile::Tiles grandChildren;
+  Body::Tiles tiles;
+};
+
+
+TEST_F(BodyTest,LeafTile)
+{
+  // One point in each quadrant of the top tile.
+  EXPECT_EQ ( children[TileKey::LOWER_RIGHT].get(), Body::leafTile ( tiles, Extents::Vertex (  20.0, -10.0 ) ).get() );
+  EXPECT_EQ ( children[TileKey::UPPER_LEFT].get(),  Body::leafTile ( tiles, Extents::Vertex ( -20.0,  10.0 ) ).get() );
+  EXPECT_EQ ( children[TileKey::UPPER_RIGHT].get(), Body::leafTile ( tiles, Extents::Vertex (  20.0,  10.0 ) ).get() );
+
+  // The lower left is split again.
+  EXPECT_EQ ( grandChildren[TileKey::LOWER_LEFT].get(),  Body::leafTile ( tiles, Extents::Vertex ( -40.0, -20.0 ) ).get() );
+  EXPECT_EQ ( grandChildren[TileKey::LOWER_RIGHT].get(), Body::leafTile ( tiles, Extents::Vertex ( -10.0, -20.0 ) ).get() );
+  EXPECT_EQ ( grandChildren[TileKey::UPPER_LEFT].get(),  Body::leafTile ( tiles, Extents::Vertex ( -40.0,  -5.0 ) ).get() );
+  EXPECT_EQ ( grandChildren[TileKey::UPPER_RIGHT].get(), Body::leafTile ( tiles, Extents::Vertex ( -10.0,  -5.0 ) ).get() );
+
+  // The leaf found is the one that holds the point.
+  for ( double lon = -44.0; lon < 45.0; lon += 7.0 )
+  {
+    for ( double lat = -22.0; lat < 22.5; lat += 3.0 )
+    {
+      const Extents::Vertex p ( lon, lat );
+      Tile::RefPtr leaf ( Body::leafTile ( tiles, p ) );
+      ASSERT_TRUE ( leaf.valid() );
+      EXPECT_TRUE ( leaf->isLeaf() );
+      EXPECT_TRUE ( leaf->extents().contains ( p ) );
+    }
+  }
+
+  // Nothing outside the top tiles.
+  EXPECT_FALSE ( Body::leafTile ( tiles, Extents::Vertex ( 100.0, 0.0 ) ).valid() );
+  EXPECT_FALSE ( Body::leafTile ( Body::Tiles(), Extents::Vertex ( 0.0, 0.0 ) ).valid() );
+}
+
+
+TEST_F(BodyTest,Elevations)
+{
+  // Neighbors on the same tile, jumps between tiles, and a point outside.
+  const double lon[] = { -40.0, -39.0, 20.0, -10.0, -20.0, 21.0, 100.0, -40.0 };
+  const double lat[] = { -20.0, -19.0, 10.0, -20.0,  10.0, 11.0,   0.0, -20.0 };
+  const unsigned int n ( sizeof ( lon ) / sizeof ( lon[0] ) );
+
+  std::vector<double> out ( n, -1.0 );
+  Body::tileElevations ( tiles, lat, lon, &out[0], n );
+
+  for ( unsigned int i = 0; i < n; ++i )
+  {
+    Tile::RefPtr leaf ( Body::leafTile ( tiles, Extents::Vertex ( lon[i], lat[i] ) ) );
+    const double expected ( leaf.valid() ? leaf->elevation ( lat[i], lon[i] ) : 0.0 );
+    EXPECT_NEAR ( expected, out[i], 0.001 );
+  }
+
+  EXPECT_NEAR ( 110.0 + 10.0 * TileKey::LOWER_LEFT, out[0], 0.001 );
+  EXPECT_NEAR ( 10.0 + 10.0 * TileKey::UPPER_RIGHT, out[2], 0.001 );
+  EXPECT_NEAR ( 110.0 + 10.0 * TileKey::LOWER_RIGHT, out[3], 0.001 );
+  EXPECT_NEAR ( 10.0 + 10.0 * TileKey::UPPER_LEFT, out[4], 0.001 );
+  EXPECT_EQ ( 0.0, out[6] );
+}
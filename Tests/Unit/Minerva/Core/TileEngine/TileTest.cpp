@@ -128,3 +128,57 @@ TEST_F(TileTest,Elevation)
     }
   }
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Test elevation on a sloped mesh. The heights are a plane, so they should
+//  be exact everywhere, not just at the grid points.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_F(TileTest,ElevationSlope)
+{
+  const Minerva::Core::TileEngine::MeshSize meshSize ( _tile->meshSize() );
+  const unsigned int rows ( meshSize[0] );
+  const unsigned int columns ( meshSize[1] );
+
+  // The rows go with longitude and the columns with latitude.
+  Minerva::Core::ElevationData::RefPtr data ( new Minerva::Core::ElevationData ( columns, rows ) );
+  for ( unsigned int r = 0; r < rows; ++r )
+  {
+    for ( unsigned int c = 0; c < columns; ++c )
+    {
+      data->value ( r, c, static_cast<float> ( 10 * r + 3 * c ) );
+    }
+  }
+
+  _tile->elevationData ( data.get() );
+  _tile->updateMesh();
+
+  Extents::Vertex mn ( _extents.minimum() );
+  Extents::Vertex mx ( _extents.maximum() );
+
+  // Number of steps to test. Not a multiple of the mesh size, so most points are inside a cell.
+  const unsigned int steps ( 11 );
+
+  for ( unsigned int i = 0; i < steps; ++i )
+  {
+    const double u ( static_cast<double> ( i ) / ( steps - 1 ) );
+
+    for ( unsigned int j = 0; j < steps; ++j )
+    {
+      const double v ( static_cast<double> ( j ) / ( steps - 1 ) );
+
+      const double lon ( mn[0] + u * ( mx[0] - mn[0] ) );
+      const double lat ( mn[1] + v * ( mx[1] - mn[1] ) );
+
+      const double expected ( 10.0 * u * ( rows - 1 ) + 3.0 * v * ( columns - 1 ) );
+
+      ASSERT_PRED2 ( TestCloseDouble(), _tile->elevation ( lat, lon ), expected );
+    }
+  }
+
+  // Outside the tile.
+  EXPECT_EQ ( 0.0, _tile->elevation ( 0.0, 90.0 ) );
+}
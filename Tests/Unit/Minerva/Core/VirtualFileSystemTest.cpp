@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Core/VirtualFileSystem.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+
+typedef Minerva::Core::Archive Archive;
+typedef Minerva::Core::VirtualFileSystem VirtualFileSystem;
+
+namespace Helper
+{
+  class MemoryArchive : public Archive
+  {
+  public:
+
+    void add ( const std::string& entry, const std::string& contents )
+    {
+      _files[entry] = Buffer ( contents.begin(), contents.end() );
+    }
+
+    virtual bool contains ( const std::string& entry ) const
+    {
+      return _files.end() != _files.find ( entry );
+    }
+
+    virtual void entries ( Entries& names ) const
+    {
+      for ( Files::const_iterator iter = _files.begin(); iter != _files.end(); ++iter )
+        names.push_back ( iter->first );
+    }
+
+    virtual bool read ( const std::string& entry, Buffer& buffer ) const
+    {
+      Files::const_iterator iter ( _files.find ( entry ) );
+      if ( _files.end() == iter )
+        return false;
+
+      buffer = iter->second;
+      return true;
+    }
+
+  private:
+
+    typedef std::map<std::string,Buffer> Files;
+    Files _files;
+  };
+}
+
+
+TEST(VirtualFileSystemTest,MountAndRead)
+{
+  VirtualFileSystem &vfs ( VirtualFileSystem::instance() );
+
+  Helper::MemoryArchive *memory ( new Helper::MemoryArchive );
+  Archive::RefPtr archive ( memory );
+  memory->add ( "doc.kml", "<kml/>" );
+  memory->add ( "models/house.dae", "house" );
+
+  EXPECT_FALSE ( vfs.contains ( "/virtual/test/doc.kml" ) );
+  EXPECT_EQ ( archive.get(), vfs.mount ( "/virtual/test", archive ).get() );
+
+  EXPECT_TRUE ( vfs.contains ( "/virtual/test/doc.kml" ) );
+  EXPECT_TRUE ( vfs.contains ( "/virtual/test/./models/house.dae" ) );
+  EXPECT_TRUE ( vfs.contains ( "\\virtual\\test\\models\\house.dae" ) );
+  EXPECT_FALSE ( vfs.contains ( "/virtual/test/models/barn.dae" ) );
+  EXPECT_FALSE ( vfs.contains ( "/virtual/other/doc.kml" ) );
+
+  VirtualFileSystem::Buffer buffer;
+  ASSERT_TRUE ( vfs.read ( "/virtual/test/models/house.dae", buffer ) );
+  EXPECT_EQ ( "house", std::string ( buffer.begin(), buffer.end() ) );
+
+  vfs.unmount ( "/virtual/test" );
+  EXPECT_FALSE ( vfs.contains ( "/virtual/test/doc.kml" ) );
+}
+
+
+TEST(VirtualFileSystemTest,Sharing)
+{
+  VirtualFileSystem &vfs ( VirtualFileSystem::instance() );
+
+  Archive::RefPtr first ( new Helper::MemoryArchive );
+  Archive::RefPtr second ( new Helper::MemoryArchive );
+
+  // The second mount at the same place gets the first archive.
+  EXPECT_EQ ( first.get(), vfs.mount ( "/virtual/shared/", first ).get() );
+  EXPECT_EQ ( first.get(), vfs.mount ( "/virtual/shared", second ).get() );
+  EXPECT_EQ ( first.get(), vfs.archive ( "/virtual/shared" ).get() );
+
+  // It stays until both are unmounted.
+  vfs.unmount ( "/virtual/shared" );
+  EXPECT_EQ ( first.get(), vfs.archive ( "/virtual/shared" ).get() );
+
+  vfs.unmount ( "/virtual/shared" );
+  EXPECT_FALSE ( vfs.archive ( "/virtual/shared" ).valid() );
+}
@@ -25,7 +25,9 @@
 
 #include "gtest/gtest.h"
 
+#include <cmath>
 #include <iomanip>
+#include <vector>
 
 
 struct TestVec3d
@@ -186,3 +188,49 @@ TEST_F(EllipsoidTest,ToMatrix)
   ASSERT_DOUBLE_EQ ( 0.0000000000, m[11] );
   ASSERT_DOUBLE_EQ ( 1.0000000000, m[15] );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Test that converting many points at once gives the same answer as one
+//  at a time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_F(EllipsoidTest,ToXYZMany)
+{
+  std::vector<double> lat, lon, elevation;
+  for ( double i = -90.0; i <= 90.0; i += 7.5 )
+  {
+    for ( double j = -180.0; j <= 180.0; j += 7.5 )
+    {
+      lat.push_back ( i );
+      lon.push_back ( j );
+      elevation.push_back ( i * j );
+    }
+  }
+
+  const unsigned int size ( lat.size() );
+  std::vector<double> x ( size ), y ( size ), z ( size );
+  _land->latLonHeightToXYZ ( &lat[0], &lon[0], &elevation[0], &x[0], &y[0], &z[0], size );
+
+  for ( unsigned int i = 0; i < size; ++i )
+  {
+    osg::Vec3d point;
+    _land->latLonHeightToXYZ ( lat[i], lon[i], elevation[i], point[0], point[1], point[2] );
+    ASSERT_PRED2 ( TestVec3d(), point, osg::Vec3d ( x[i], y[i], z[i] ) );
+  }
+
+  std::vector<double> lat1 ( size ), lon1 ( size ), elevation1 ( size );
+  _land->xyzToLatLonHeight ( &x[0], &y[0], &z[0], &lat1[0], &lon1[0], &elevation1[0], size );
+
+  for ( unsigned int i = 0; i < size; ++i )
+  {
+    // Skip the poles, where the height can't be found from x and y.
+    if ( std::fabs ( lat[i] ) < 90.0 )
+    {
+      ASSERT_NEAR ( lat[i], lat1[i], 1e-9 );
+      ASSERT_NEAR ( elevation[i], elevation1[i], 1e-6 );
+    }
+  }
+}
@@ -9,11 +9,22 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Minerva/Plugins/Kml/Factory.h"
+#include "Minerva/Plugins/Kml/KmlLayer.h"
 
+#include "Minerva/Core/Data/DataObject.h"
+
+#include "XmlTree/Document.h"
 #include "XmlTree/Node.h"
 
+#include "Usul/File/Temp.h"
+#include "Usul/Scope/RemoveFile.h"
+#include "Usul/Strings/Format.h"
+
 #include "gtest/gtest.h"
 
+#include <fstream>
+#include <typeinfo>
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -53,3 +64,229 @@ TEST(KmlParseTest,Coordinates)
   TEST_COORDINATES ( value2 );
   TEST_COORDINATES ( value3 );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helpers to compare the sax parser with the document tree.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  typedef Minerva::Layers::Kml::KmlLayer KmlLayer;
+  typedef Minerva::Core::Data::Container Container;
+  typedef Minerva::Core::Data::DataObject DataObject;
+  typedef Minerva::Core::Data::Feature Feature;
+
+  // Read the kml with the sax parser, the same way a file is opened.
+  KmlLayer::RefPtr readSax ( const std::string& kml )
+  {
+    const std::string filename ( Usul::File::Temp::file() + ".kml" );
+    Usul::Scope::RemoveFile remove ( filename );
+    {
+      std::ofstream out ( filename.c_str() );
+      out << kml;
+    }
+
+    KmlLayer::RefPtr layer ( new KmlLayer );
+    layer->read ( filename );
+    return layer;
+  }
+
+  // Read the kml from a document tree. Folders and documents at the top 
+  // go in the layer.
+  KmlLayer::RefPtr readTree ( const std::string& kml )
+  {
+    XmlTree::Document::RefPtr document ( new XmlTree::Document );
+    document->loadFromMemory ( kml );
+
+    KmlLayer::RefPtr layer ( new KmlLayer );
+
+    const XmlTree::Node::Children& children ( document->children() );
+    for ( XmlTree::Node::Children::const_iterator iter = children.begin(); iter != children.end(); ++iter )
+    {
+      if ( "Folder" == (*iter)->name() || "Document" == (*iter)->name() )
+        layer->parseFolder ( **iter );
+    }
+
+    return layer;
+  }
+
+  void compareExtents ( const Feature::Extents& a, const Feature::Extents& b )
+  {
+    EXPECT_DOUBLE_EQ ( b.minimum()[0], a.minimum()[0] );
+    EXPECT_DOUBLE_EQ ( b.minimum()[1], a.minimum()[1] );
+    EXPECT_DOUBLE_EQ ( b.maximum()[0], a.maximum()[0] );
+    EXPECT_DOUBLE_EQ ( b.maximum()[1], a.maximum()[1] );
+  }
+
+  void compareFeature ( Feature& sax, Feature& tree );
+
+  // The children have to be the same and in the same order.
+  void compareChildren ( Container& sax, Container& tree )
+  {
+    ASSERT_EQ ( tree.size(), sax.size() );
+    for ( unsigned int i = 0; i < tree.size(); ++i )
+    {
+      compareFeature ( *sax.feature ( i ), *tree.feature ( i ) );
+    }
+  }
+
+  void compareFeature ( Feature& sax, Feature& tree )
+  {
+    EXPECT_EQ ( tree.name(), sax.name() );
+    EXPECT_EQ ( tree.description(), sax.description() );
+    EXPECT_EQ ( tree.styleUrl(), sax.styleUrl() );
+    EXPECT_EQ ( tree.visibility(), sax.visibility() );
+
+    Container *saxContainer ( sax.asContainer() );
+    Container *treeContainer ( tree.asContainer() );
+    ASSERT_EQ ( 0x0 == treeContainer, 0x0 == saxContainer );
+    if ( 0x0 != treeContainer )
+    {
+      compareChildren ( *saxContainer, *treeContainer );
+    }
+
+    DataObject *saxObject ( sax.asDataObject() );
+    DataObject *treeObject ( tree.asDataObject() );
+    ASSERT_EQ ( 0x0 == treeObject, 0x0 == saxObject );
+    if ( 0x0 != treeObject )
+    {
+      EXPECT_EQ ( treeObject->style().valid(), saxObject->style().valid() );
+
+      DataObject::Geometry::RefPtr saxGeometry ( saxObject->geometry() );
+      DataObject::Geometry::RefPtr treeGeometry ( treeObject->geometry() );
+      ASSERT_EQ ( treeGeometry.valid(), saxGeometry.valid() );
+      if ( treeGeometry.valid() )
+      {
+        EXPECT_EQ ( std::string ( typeid ( *treeGeometry ).name() ), std::string ( typeid ( *saxGeometry ).name() ) );
+        compareExtents ( saxGeometry->extents(), treeGeometry->extents() );
+      }
+
+      compareExtents ( sax.extents(), tree.extents() );
+    }
+  }
+
+  void compare ( const std::string& kml )
+  {
+    KmlLayer::RefPtr sax ( readSax ( kml ) );
+    KmlLayer::RefPtr tree ( readTree ( kml ) );
+    compareChildren ( *sax, *tree );
+  }
+
+  std::string placemark ( unsigned int i )
+  {
+    return Usul::Strings::format ( 
+      "<Placemark>"
+        "<name>Placemark ", i, "</name>"
+        "<Point><coordinates>", i % 360 - 180, ",", i % 180 - 90, ",0</coordinates></Point>"
+      "</Placemark>" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A document with styles, folders and each kind of geometry.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static const char* saxDocument01 = 
+{
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  "<kml xmlns=\"http://earth.google.com/kml/2.2\">"
+  "<Document>"
+    "<name>Test document</name>"
+    "<Style id=\"red\">"
+      "<LineStyle><color>ff0000ff</color><width>2</width></LineStyle>"
+      "<PolyStyle><color>7f0000ff</color></PolyStyle>"
+    "</Style>"
+    "<Placemark>"
+      "<name>Point</name>"
+      "<description>A point &amp; some text</description>"
+      "<Point><coordinates>-111.89,33.61,10</coordinates></Point>"
+    "</Placemark>"
+    "<Folder>"
+      "<name>Lines</name>"
+      "<visibility>0</visibility>"
+      "<Placemark>"
+        "<name>Line</name>"
+        "<styleUrl>#red</styleUrl>"
+        "<LineString>"
+          "<coordinates>"
+            "-111.89,33.61,0 -111.90,33.62,0 -111.91,33.60,0"
+          "</coordinates>"
+        "</LineString>"
+      "</Placemark>"
+      "<Folder>"
+        "<name>Nested</name>"
+        "<Placemark>"
+          "<name>Polygon</name>"
+          "<styleUrl>#red</styleUrl>"
+          "<Polygon>"
+            "<outerBoundaryIs><LinearRing><coordinates>"
+              "0,0,0 1,0,0 1,1,0 0,1,0 0,0,0"
+            "</coordinates></LinearRing></outerBoundaryIs>"
+          "</Polygon>"
+        "</Placemark>"
+      "</Folder>"
+    "</Folder>"
+    "<Placemark>"
+      "<name>Multi</name>"
+      "<MultiGeometry>"
+        "<Point><coordinates>5,6,0</coordinates></Point>"
+        "<LineString><coordinates>5,6,0 7,8,0</coordinates></LineString>"
+      "</MultiGeometry>"
+    "</Placemark>"
+  "</Document>"
+  "</kml>"
+};
+
+
+TEST(KmlParseTest,SaxMatchesTree)
+{
+  Helper::compare ( saxDocument01 );
+
+  // Check a few things directly, so both parsers can't be wrong together.
+  Helper::KmlLayer::RefPtr layer ( Helper::readSax ( saxDocument01 ) );
+  EXPECT_EQ ( "Test document", layer->name() );
+  ASSERT_EQ ( 3u, layer->size() );
+  EXPECT_EQ ( "Point", layer->feature ( 0 )->name() );
+  EXPECT_EQ ( "Lines", layer->feature ( 1 )->name() );
+  EXPECT_FALSE ( layer->feature ( 1 )->visibility() );
+  EXPECT_EQ ( "Multi", layer->feature ( 2 )->name() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  More placemarks than fit in one batch, with folders between them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(KmlParseTest,SaxMatchesTreeBatches)
+{
+  std::string kml ( "<?xml version=\"1.0\" encoding=\"UTF-8\"?><kml xmlns=\"http://earth.google.com/kml/2.2\"><Document>" );
+
+  for ( unsigned int i = 0; i < 300; ++i )
+    kml += Helper::placemark ( i );
+
+  kml += "<Folder><name>Middle</name>";
+  for ( unsigned int i = 300; i < 700; ++i )
+    kml += Helper::placemark ( i );
+  kml += "</Folder>";
+
+  for ( unsigned int i = 700; i < 800; ++i )
+    kml += Helper::placemark ( i );
+
+  kml += "</Document></kml>";
+
+  Helper::compare ( kml );
+
+  Helper::KmlLayer::RefPtr layer ( Helper::readSax ( kml ) );
+  ASSERT_EQ ( 401u, layer->size() );
+  EXPECT_EQ ( "Placemark 299", layer->feature ( 299 )->name() );
+  EXPECT_EQ ( "Middle", layer->feature ( 300 )->name() );
+  EXPECT_EQ ( "Placemark 700", layer->feature ( 301 )->name() );
+}
@@ -165,3 +165,33 @@ TEST_F(OSMCacheTest,LineString)
 
   EXPECT_TRUE ( lines.size() == cachedLines.size() );
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Lines for a level are kept apart from the full lines, other levels and
+//  other tolerances.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_F(OSMCacheTest,LineStringLevel)
+{
+  LineString::RefPtr line ( LineString::create ( ways[0] ) );
+
+  std::vector<LineString::RefPtr> lines;
+  lines.push_back ( line->simplify ( 1.0 ) );
+
+  cache->addLineData ( key, 5, 1.0, extents, lines );
+
+  EXPECT_TRUE ( cache->hasLineData ( key, 5, 1.0, extents ) );
+  EXPECT_FALSE ( cache->hasLineData ( key, 6, 1.0, extents ) );
+  EXPECT_FALSE ( cache->hasLineData ( key, 5, 2.0, extents ) );
+  EXPECT_FALSE ( cache->hasLineData ( key, 5, 1.0 + 1e-12, extents ) );
+  EXPECT_FALSE ( cache->hasLineData ( key, extents ) );
+
+  std::vector<LineString::RefPtr> cachedLines;
+  cache->getLineData ( key, 5, 1.0, extents, cachedLines );
+
+  ASSERT_TRUE ( lines.size() == cachedLines.size() );
+  EXPECT_TRUE ( lines[0]->vertices().size() == cachedLines[0]->vertices().size() );
+}
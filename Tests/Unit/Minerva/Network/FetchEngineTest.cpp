@@ -0,0 +1,348 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2010, Adam Kubach
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Minerva/Network/FetchEngine.h"
+
+#include "Usul/Exceptions/Canceled.h"
+#include "Usul/Jobs/Job.h"
+
+#include "gtest/gtest.h"
+
+#include "boost/asio.hpp"
+#include "boost/bind.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef Minerva::Network::FetchEngine FetchEngine;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Small HTTP/1.1 server standing in for a tile server. Paths starting with
+//  "/slow" are answered after a delay, "/missing" returns 404 and everything
+//  else echoes the path back.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Helper
+{
+  class Server
+  {
+  public:
+
+    typedef boost::asio::ip::tcp tcp;
+
+    Server() :
+      _service(),
+      _acceptor ( _service, tcp::endpoint ( boost::asio::ip::address_v4::loopback(), 0 ) ),
+      _threads(),
+      _mutex(),
+      _sockets(),
+      _stopping ( false ),
+      _hits(),
+      _order(),
+      _connections ( 0 ),
+      _active ( 0 ),
+      _maxActive ( 0 )
+    {
+      _threads.create_thread ( boost::bind ( &Server::_accept, this ) );
+    }
+
+    ~Server()
+    {
+      boost::system::error_code ec;
+
+      // Wake up the accept loop.
+      {
+        boost::mutex::scoped_lock lock ( _mutex );
+        _stopping = true;
+      }
+      tcp::socket wake ( _service );
+      wake.connect ( _acceptor.local_endpoint(), ec );
+
+      // Hang up on the clients.
+      {
+        boost::mutex::scoped_lock lock ( _mutex );
+        for ( unsigned int i = 0; i < _sockets.size(); ++i )
+          _sockets[i]->shutdown ( tcp::socket::shutdown_both, ec );
+      }
+
+      _threads.join_all();
+    }
+
+    std::string url ( const std::string& path ) const
+    {
+      return "http://127.0.0.1:" + boost::lexical_cast<std::string> ( _acceptor.local_endpoint().port() ) + path;
+    }
+
+    unsigned int hits ( const std::string& path ) const
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+      std::map<std::string,unsigned int>::const_iterator i ( _hits.find ( path ) );
+      return ( ( _hits.end() == i ) ? 0 : i->second );
+    }
+
+    std::vector<std::string> order() const
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+      return _order;
+    }
+
+    unsigned int connections() const
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+      return _connections;
+    }
+
+    unsigned int maxActive() const
+    {
+      boost::mutex::scoped_lock lock ( _mutex );
+      return _maxActive;
+    }
+
+  private:
+
+    void _accept()
+    {
+      while ( true )
+      {
+        boost::shared_ptr<tcp::socket> socket ( new tcp::socket ( _service ) );
+        boost::system::error_code ec;
+        _acceptor.accept ( *socket, ec );
+        if ( ec )
+          return;
+
+        boost::mutex::scoped_lock lock ( _mutex );
+        if ( _stopping )
+          return;
+
+        ++_connections;
+        _sockets.push_back ( socket );
+        _threads.create_thread ( boost::bind ( &Server::_serve, this, socket ) );
+      }
+    }
+
+    void _serve ( boost::shared_ptr<tcp::socket> socket )
+    {
+      boost::asio::streambuf buffer;
+      boost::system::error_code ec;
+
+      // Keep the connection alive until the client closes it.
+      while ( true )
+      {
+        boost::asio::read_until ( *socket, buffer, "\r\n\r\n", ec );
+        if ( ec )
+          return;
+
+        std::istream in ( &buffer );
+        std::string method, path, line;
+        in >> method >> path;
+        while ( std::getline ( in, line ) && line != "\r" ) {}
+
+        {
+          boost::mutex::scoped_lock lock ( _mutex );
+          ++_hits[path];
+          _order.push_back ( path );
+          ++_active;
+          _maxActive = std::max ( _maxActive, _active );
+        }
+
+        if ( 0 == path.find ( "/slow" ) )
+          boost::this_thread::sleep ( boost::posix_time::milliseconds ( 300 ) );
+
+        const bool missing ( "/missing" == path );
+        const std::string body ( missing ? "" : path );
+        const std::string response ( ( missing ? "HTTP/1.1 404 Not Found\r\n" : "HTTP/1.1 200 OK\r\n" ) +
+          std::string ( "Content-Length: " ) + boost::lexical_cast<std::string> ( body.size() ) + "\r\n\r\n" + body );
+
+        {
+          boost::mutex::scoped_lock lock ( _mutex );
+          --_active;
+        }
+
+        boost::asio::write ( *socket, boost::asio::buffer ( response ), ec );
+        if ( ec )
+          return;
+      }
+    }
+
+    boost::asio::io_service _service;
+    tcp::acceptor _acceptor;
+    boost::thread_group _threads;
+    mutable boost::mutex _mutex;
+    std::vector< boost::shared_ptr<tcp::socket> > _sockets;
+    bool _stopping;
+    std::map<std::string,unsigned int> _hits;
+    std::vector<std::string> _order;
+    unsigned int _connections;
+    unsigned int _active;
+    unsigned int _maxActive;
+  };
+
+  std::string toString ( const FetchEngine::Buffer& data )
+  {
+    return std::string ( data.begin(), data.end() );
+  }
+
+  void nothing()
+  {
+  }
+}
+
+
+TEST(FetchEngineTest,Download)
+{
+  Helper::Server server;
+  FetchEngine &engine ( FetchEngine::instance() );
+
+  FetchEngine::Request::RefPtr request ( engine.fetch ( server.url ( "/tile?level=1" ), 0, 5000 ) );
+  ASSERT_TRUE ( request->wait ( 5000 ) );
+  EXPECT_EQ ( FetchEngine::SUCCEEDED, request->status() );
+  EXPECT_EQ ( 200, request->responseCode() );
+  EXPECT_EQ ( "/tile?level=1", Helper::toString ( request->data() ) );
+
+  FetchEngine::Request::RefPtr missing ( engine.fetch ( server.url ( "/missing" ), 0, 5000 ) );
+  ASSERT_TRUE ( missing->wait ( 5000 ) );
+  EXPECT_EQ ( FetchEngine::FAILED, missing->status() );
+  EXPECT_EQ ( 404, missing->responseCode() );
+
+  EXPECT_THROW ( FetchEngine::download ( server.url ( "/missing" ), "unused", 0, 5000 ), std::runtime_error );
+}
+
+
+TEST(FetchEngineTest,DownloadToFile)
+{
+  Helper::Server server;
+
+  const std::string directory ( "fetch_engine_test" );
+  const std::string file ( directory + "/tile.png" );
+  boost::filesystem::remove_all ( directory );
+  boost::filesystem::create_directories ( directory );
+
+  FetchEngine::download ( server.url ( "/tile?level=2" ), file, 0, 5000 );
+
+  {
+    std::ifstream in ( file.c_str(), std::ios::binary );
+    EXPECT_EQ ( "/tile?level=2", std::string ( std::istreambuf_iterator<char> ( in ), std::istreambuf_iterator<char>() ) );
+  }
+
+  // A second download replaces the file.
+  FetchEngine::download ( server.url ( "/tile?level=3" ), file, 0, 5000 );
+
+  {
+    std::ifstream in ( file.c_str(), std::ios::binary );
+    EXPECT_EQ ( "/tile?level=3", std::string ( std::istreambuf_iterator<char> ( in ), std::istreambuf_iterator<char>() ) );
+  }
+
+  // A failed download leaves nothing behind. The temporary files are gone too.
+  EXPECT_THROW ( FetchEngine::download ( server.url ( "/missing" ), directory + "/missing.png", 0, 5000 ), std::runtime_error );
+
+  const unsigned int numFiles ( std::distance ( boost::filesystem::directory_iterator ( directory ), boost::filesystem::directory_iterator() ) );
+  EXPECT_EQ ( 1u, numFiles );
+
+  boost::filesystem::remove_all ( directory );
+}
+
+
+TEST(FetchEngineTest,ReuseConnection)
+{
+  Helper::Server server;
+  FetchEngine &engine ( FetchEngine::instance() );
+
+  const unsigned int num ( 10 );
+  for ( unsigned int i = 0; i < num; ++i )
+  {
+    FetchEngine::Request::RefPtr request ( engine.fetch ( server.url ( "/tile?" + boost::lexical_cast<std::string> ( i ) ), 0, 5000 ) );
+    ASSERT_TRUE ( request->wait ( 5000 ) );
+    EXPECT_EQ ( FetchEngine::SUCCEEDED, request->status() );
+  }
+
+  EXPECT_EQ ( 1u, server.connections() );
+}
+
+
+TEST(FetchEngineTest,ShareInFlight)
+{
+  Helper::Server server;
+  FetchEngine &engine ( FetchEngine::instance() );
+
+  const std::string url ( server.url ( "/slow/shared" ) );
+  FetchEngine::Request::RefPtr a ( engine.fetch ( url, 0, 5000 ) );
+  FetchEngine::Request::RefPtr b ( engine.fetch ( url, 0, 5000 ) );
+  EXPECT_EQ ( a.get(), b.get() );
+
+  ASSERT_TRUE ( a->wait ( 5000 ) );
+  EXPECT_EQ ( 1u, server.hits ( "/slow/shared" ) );
+
+  // Once it's finished a new request goes back to the server.
+  FetchEngine::Request::RefPtr c ( engine.fetch ( url, 0, 5000 ) );
+  EXPECT_NE ( a.get(), c.get() );
+  ASSERT_TRUE ( c->wait ( 5000 ) );
+  EXPECT_EQ ( 2u, server.hits ( "/slow/shared" ) );
+}
+
+
+TEST(FetchEngineTest,LimitAndPriority)
+{
+  Helper::Server server;
+  FetchEngine &engine ( FetchEngine::instance() );
+
+  const unsigned int oldMax ( engine.maxTransfersPerHost() );
+  engine.maxTransfersPerHost ( 1 );
+
+  // Keep the host busy while the others queue up.
+  std::vector<FetchEngine::Request::RefPtr> requests;
+  requests.push_back ( engine.fetch ( server.url ( "/slow/first" ), 0, 5000 ) );
+  boost::this_thread::sleep ( boost::posix_time::milliseconds ( 50 ) );
+  requests.push_back ( engine.fetch ( server.url ( "/slow/low" ), 10, 5000 ) );
+  requests.push_back ( engine.fetch ( server.url ( "/slow/high" ), -10, 5000 ) );
+
+  for ( unsigned int i = 0; i < requests.size(); ++i )
+  {
+    ASSERT_TRUE ( requests[i]->wait ( 5000 ) );
+  }
+
+  const std::vector<std::string> order ( server.order() );
+  ASSERT_EQ ( 3u, order.size() );
+  EXPECT_EQ ( "/slow/first", order[0] );
+  EXPECT_EQ ( "/slow/high", order[1] );
+  EXPECT_EQ ( "/slow/low", order[2] );
+  EXPECT_EQ ( 1u, server.maxActive() );
+
+  engine.maxTransfersPerHost ( oldMax );
+}
+
+
+TEST(FetchEngineTest,Cancel)
+{
+  Helper::Server server;
+  FetchEngine &engine ( FetchEngine::instance() );
+
+  // Both waiters have to give up before the transfer stops.
+  const std::string url ( server.url ( "/slow/cancel" ) );
+  FetchEngine::Request::RefPtr a ( engine.fetch ( url, 0, 5000 ) );
+  FetchEngine::Request::RefPtr b ( engine.fetch ( url, 0, 5000 ) );
+  engine.cancel ( a );
+  EXPECT_FALSE ( a->wait ( 50 ) );
+  engine.cancel ( b );
+  ASSERT_TRUE ( b->wait ( 1000 ) );
+  EXPECT_EQ ( FetchEngine::CANCELED, b->status() );
+
+  // A canceled job stops the blocking download.
+  Usul::Jobs::Job::RefPtr job ( Usul::Jobs::create ( &Helper::nothing ) );
+  job->cancel();
+  EXPECT_THROW ( FetchEngine::download ( server.url ( "/slow/job" ), "unused", 0, 5000, job->queryInterface ( Usul::Interfaces::IUnknown::IID ) ), Usul::Exceptions::Canceled );
+}
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2002, Perry L. Miller IV
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark for the thread pool. Measures how many tasks per second the 
+//  pool can dispatch, and how long a task waits between being added and 
+//  being started when the pool is idle. Each is run with the pool and with 
+//  a copy of the single queue pool it replaced, so they can be compared.
+//
+//  Usage: PoolBenchmark [num tasks] [pool size] [num latency samples]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OldPool.h"
+
+#include "Usul/Strings/Format.h"
+#include "Usul/Threads/Pool.h"
+#include "Usul/Threads/Task.h"
+
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Detail
+{
+  typedef boost::posix_time::ptime Time;
+  typedef std::vector<double> Samples;
+
+  Time now()
+  {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  double microseconds ( const Time &start, const Time &stop )
+  {
+    return static_cast<double> ( ( stop - start ).total_microseconds() );
+  }
+
+  unsigned int argument ( int argc, char **argv, int which, unsigned int defaultValue )
+  {
+    return ( argc > which ) ? static_cast<unsigned int> ( std::abs ( ::atoi ( argv[which] ) ) ) : defaultValue;
+  }
+
+  void nothing()
+  {
+  }
+
+  // Record when the task started.
+  void started ( Time *time )
+  {
+    *time = Detail::now();
+  }
+
+  // Only the new pool counts the tasks it steals.
+  std::string stolen ( const Usul::Threads::Pool &pool )
+  {
+    return Usul::Strings::format ( ", ", pool.numTasksStolen(), " stolen" );
+  }
+  std::string stolen ( const OldPool & )
+  {
+    return std::string();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add many small tasks and wait for all of them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class PoolType > void _throughput ( const std::string &label, unsigned int numTasks, unsigned int poolSize )
+{
+  PoolType pool ( "Throughput benchmark", poolSize );
+
+  const Detail::Time start ( Detail::now() );
+
+  for ( unsigned int i = 0; i < numTasks; ++i )
+  {
+    pool.addTask ( static_cast<int> ( i % 4 ), pool.nextTaskId(), "task", 
+                   Detail::nothing, Detail::nothing, Detail::nothing, Detail::nothing );
+  }
+
+  pool.waitForTasks();
+
+  const double elapsed ( Detail::microseconds ( start, Detail::now() ) );
+
+  std::cout << label << " throughput: " << numTasks << " tasks in " << elapsed / 1000.0 << " ms, "
+            << ( numTasks / ( elapsed / 1000000.0 ) ) << " tasks/second"
+            << Detail::stolen ( pool ) << std::endl;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add one task at a time to an idle pool and measure the hand-off.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class PoolType > void _latency ( const std::string &label, unsigned int numSamples, unsigned int poolSize )
+{
+  PoolType pool ( "Latency benchmark", poolSize );
+
+  Detail::Samples samples;
+  samples.reserve ( numSamples );
+
+  for ( unsigned int i = 0; i < numSamples; ++i )
+  {
+    // Give the workers time to go idle.
+    boost::this_thread::sleep ( boost::posix_time::milliseconds ( 2 ) );
+
+    Detail::Time started;
+    const Detail::Time added ( Detail::now() );
+    pool.addTask ( 0, pool.nextTaskId(), "task", 
+                   boost::bind ( Detail::started, &started ), Detail::nothing, Detail::nothing, Detail::nothing );
+    pool.waitForTasks();
+
+    samples.push_back ( Detail::microseconds ( added, started ) );
+  }
+
+  if ( true == samples.empty() )
+    return;
+
+  std::sort ( samples.begin(), samples.end() );
+  double total ( 0.0 );
+  for ( Detail::Samples::const_iterator i = samples.begin(); i != samples.end(); ++i )
+  {
+    total += *i;
+  }
+
+  std::cout << label << " latency: mean " << total / samples.size() << " us, median " 
+            << samples.at ( samples.size() / 2 ) << " us, max " 
+            << samples.back() << " us over " << samples.size() << " samples" << std::endl;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  const unsigned int numTasks   ( Detail::argument ( argc, argv, 1, 100000 ) );
+  const unsigned int poolSize   ( Detail::argument ( argc, argv, 2, boost::thread::hardware_concurrency() ) );
+  const unsigned int numSamples ( Detail::argument ( argc, argv, 3, 200 ) );
+
+  std::cout << "Pool size: " << poolSize << std::endl;
+
+  _throughput<OldPool> ( "Old pool", numTasks, poolSize );
+  _throughput<Usul::Threads::Pool> ( "Pool", numTasks, poolSize );
+
+  _latency<OldPool> ( "Old pool", numSamples, poolSize );
+  _latency<Usul::Threads::Pool> ( "Pool", numSamples, poolSize );
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2002, Perry L. Miller IV
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The thread pool as it was before the per-worker queues.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OldPool.h"
+
+#include "Usul/Threads/Safe.h"
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+OldPool::OldPool ( const std::string &, unsigned int numThreads ) :
+  _mutex(),
+  _pool       (),
+  _queue      (),
+  _executing  (),
+  _nextTaskId ( 0 ),
+  _sleep      ( 10 ),
+  _numThreads ( numThreads ),
+  _runThreads ( true ),
+  _started    ( false )
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+OldPool::~OldPool()
+{
+  // Turn off the switch and wait for the threads.
+  Usul::Threads::Safe::set ( this->mutex(), false, _runThreads );
+
+  for ( ThreadPool::iterator iter = _pool.begin(); iter != _pool.end(); ++iter )
+  {
+    (*iter)->join();
+    delete *iter;
+    *iter = 0x0;
+  }
+  _pool.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a task.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+OldPool::TaskHandle OldPool::addTask ( int priority, int id, const std::string& name, Callback started, Callback finished, Callback cancelled, Callback error )
+{
+  Task::RefPtr task ( new Task ( id, name, started, finished, cancelled, error ) );
+  TaskHandle key ( priority, task->id() );
+
+  {
+    Guard guard ( this );
+    _queue[key] = task;
+  }
+
+  this->_startThreads();
+
+  return key;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the mutex.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+OldPool::Mutex& OldPool::mutex() const
+{
+  return _mutex;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the next task id. This will also increment the internal counter.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned long OldPool::nextTaskId()
+{
+  Guard guard ( this );
+  return _nextTaskId++;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of tasks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t OldPool::numTasks() const
+{
+  Guard guard ( this );
+  return ( _queue.size() + _executing.size() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for all tasks to complete.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OldPool::waitForTasks()
+{
+  while ( this->numTasks() > 0 )
+  {
+    boost::this_thread::sleep ( boost::posix_time::milliseconds ( _sleep ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the next task from the one queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+OldPool::Task::RefPtr OldPool::_nextTask()
+{
+  Guard guard ( this );
+  if ( true == _queue.empty() )
+    return Task::RefPtr ( 0x0 );
+
+  Task::RefPtr task ( _queue.begin()->second );
+  _queue.erase ( _queue.begin() );
+  _executing.insert ( task );
+  return task;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start the threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OldPool::_startThreads()
+{
+  Guard guard ( this );
+
+  if ( false == _started )
+  {
+    _pool.reserve ( _numThreads );
+    for ( unsigned int i = 0; i < _numThreads; ++i )
+    {
+      _pool.push_back ( new Thread ( boost::bind ( &OldPool::_threadStarted, this ) ) );
+    }
+    _started = true;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Worker loop. Sleeps when there is nothing to do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void OldPool::_threadStarted()
+{
+  while ( true == Usul::Threads::Safe::get ( this->mutex(), _runThreads ) )
+  {
+    Task::RefPtr task ( this->_nextTask() );
+    if ( true == task.valid() )
+    {
+      task->started();
+      task->finished();
+
+      Guard guard ( this );
+      _executing.erase ( task );
+    }
+    else
+    {
+      boost::this_thread::sleep ( boost::posix_time::milliseconds ( _sleep ) );
+    }
+  }
+}
@@ -0,0 +1,92 @@
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2002, Perry L. Miller IV
+//  All rights reserved.
+//  BSD License: http://www.opensource.org/licenses/bsd-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The thread pool as it was before the per-worker queues: one queue under
+//  one lock, and idle workers that sleep and look again. Only what the
+//  benchmark uses is kept, so both pools can be measured in one program.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_THREADS_POOL_BENCHMARK_OLD_POOL_H_
+#define _USUL_THREADS_POOL_BENCHMARK_OLD_POOL_H_
+
+#include "Usul/Threads/Task.h"
+#include "Usul/Threads/RecursiveMutex.h"
+#include "Usul/Threads/Guard.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace boost { class thread; }
+
+
+class OldPool
+{
+public:
+
+  // Useful typedefs.
+  typedef Usul::Threads::RecursiveMutex Mutex;
+  typedef Usul::Threads::Guard<Mutex> Guard;
+  typedef boost::thread Thread;
+  typedef std::vector < Thread* > ThreadPool;
+  typedef Usul::Threads::Task Task;
+  typedef std::pair < int, unsigned long > TaskHandle;
+  typedef std::map < TaskHandle, Task::RefPtr > TaskMap;
+  typedef std::set < Task::RefPtr > TaskSet;
+  typedef Task::Callback Callback;
+
+  // Constructor
+  OldPool ( const std::string &name, unsigned int numThreads );
+  ~OldPool();
+
+  // Add a task.
+  TaskHandle              addTask ( int priority, int id, const std::string& name, Callback started, Callback finished, Callback cancelled, Callback error );
+
+  // Get the mutex.
+  Mutex &                 mutex() const;
+
+  // Get the next task id. This will also increment the internal counter.
+  unsigned long           nextTaskId();
+
+  // Get the number of tasks.
+  std::size_t             numTasks() const;
+
+  // Wait for all tasks to complete.
+  void                    waitForTasks();
+
+private:
+
+  // No copying or assigning.
+  OldPool ( const OldPool & );
+  OldPool &operator = ( const OldPool & );
+
+  Task::RefPtr            _nextTask();
+
+  void                    _startThreads();
+
+  void                    _threadStarted();
+
+  // Data members.
+  mutable Mutex _mutex;
+  ThreadPool _pool;
+  TaskMap _queue;
+  TaskSet _executing;
+  unsigned long _nextTaskId;
+  unsigned long _sleep;
+  unsigned int _numThreads;
+  bool _runThreads;
+  bool _started;
+};
+
+
+#endif // _USUL_THREADS_POOL_BENCHMARK_OLD_POOL_H_
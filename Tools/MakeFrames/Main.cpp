@@ -1,19 +1,25 @@
 
 #include "Minerva/Core/Data/Camera.h"
 #include "Minerva/Core/DiskCache.h"
+#include "Minerva/Core/ImageCache.h"
 
 #include "Minerva/Document/AnimationController.h"
 #include "Minerva/Document/OffScreenView.h"
 #include "Minerva/Document/MinervaDocument.h"
+#include "Minerva/Network/FetchEngine.h"
 
 #include "XmlTree/Document.h"
 
 #include "Usul/Components/Loader.h"
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Registry/Database.h"
 
 #include "boost/filesystem.hpp"
 #include "boost/program_options.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 int main ( int argc, char** argv )
 {
@@ -39,6 +45,10 @@ int main ( int argc, char** argv )
     ( "latitude", boost::program_options::value<double>(), "Latitude of camera" )
     ( "altitude", boost::program_options::value<double>(), "Altitude of camera" )
     ( "cache-dir", boost::program_options::value<std::string>(), "Cache directory")
+    ( "packed-cache", "Pack cached tiles into large segment files instead of one file per tile" )
+    ( "write-threads", boost::program_options::value<unsigned int>(), "Number of threads that encode and write frames (0 writes them as they render)" )
+    ( "shard", boost::program_options::value<unsigned int>(), "Which part of the animation to render, from 0 to shards - 1" )
+    ( "shards", boost::program_options::value<unsigned int>(), "Number of parts to split the animation into, for running several processes on one cache" )
     ( "help", "This message" )
   ;
 
@@ -108,6 +118,48 @@ int main ( int argc, char** argv )
     Minerva::Core::DiskCache::instance().cacheDirectory ( vm["cache-dir"].as<std::string>() );
   }
 
+  if ( vm.count ( "packed-cache" ) )
+  {
+    // Same as the application setting. Only one process can write to the 
+    // packed segments, so stop if another one has them.
+    Usul::Registry::Database::instance()["disk_cache"]["packed_store"]["enabled"] = true;
+    if ( false == Minerva::Core::DiskCache::instance().tileStore().valid() )
+    {
+      return 1;
+    }
+  }
+
+  unsigned int writeThreads ( 2 );
+  if ( vm.count ( "write-threads" ) )
+  {
+    writeThreads = vm["write-threads"].as<unsigned int>();
+  }
+
+  unsigned int shards ( 1 );
+  if ( vm.count ( "shards" ) )
+  {
+    shards = std::max<unsigned int> ( 1, vm["shards"].as<unsigned int>() );
+  }
+
+  unsigned int shard ( 0 );
+  if ( vm.count ( "shard" ) )
+  {
+    shard = vm["shard"].as<unsigned int>();
+  }
+
+  if ( shard >= shards )
+  {
+    std::cout << "Shard must be less than the number of shards" << std::endl;
+    return 1;
+  }
+
+  // The packed segments are only safe to share between threads of one process.
+  if ( shards > 1 && vm.count ( "packed-cache" ) )
+  {
+    std::cout << "Shards can't share a packed cache. Use the default cache layout" << std::endl;
+    return 1;
+  }
+
   Minerva::Document::MinervaDocument::RefPtr document ( new Minerva::Document::MinervaDocument );
   document->read ( inputFile );
 
@@ -122,17 +174,14 @@ int main ( int argc, char** argv )
   const std::string base ( "" );
   const std::string ext ( ".jpg" );
   view->frameDumpProperties ( directory, base, ext );
+  view->writeThreads ( writeThreads );
 
   view->resize ( width, height );
   view->showLatLonText ( false );
   view->showEyeAltitude ( false );
 
-  // Loop to bring in needed detail.
-  const unsigned int times ( 4 );
-  for ( unsigned int i = 0; i < times; ++i )
-  {
-    view->waitForDetail ( camera );
-  }
+  // Bring in needed detail.
+  view->waitForDetail ( camera );
 
   Minerva::Core::Data::TimeSpan::RefPtr timeSpan ( document->timeSpanOfData() );
 
@@ -149,23 +198,50 @@ int main ( int argc, char** argv )
     animationController->setStepSize ( 1 );
     animationController->setCurrentTimeStep ( 0 );
 
+    // Count the frames, so each shard knows which ones are its own.
+    unsigned int numFrames ( 0 );
     while ( AnimationController::ANIMATION_RESULT_AT_END != animationController->stepForward() )
     {
-      // Bring in needed detail.
-      view->waitForDetail ( camera );
+      ++numFrames;
+    }
+
+    const unsigned int first ( static_cast<unsigned int> ( static_cast<unsigned long long> ( numFrames ) * shard / shards ) );
+    const unsigned int last  ( static_cast<unsigned int> ( static_cast<unsigned long long> ( numFrames ) * ( shard + 1 ) / shards ) );
+
+    // Number the files the same in every shard.
+    view->frameDumpProperties ( directory, base, ext, first );
+
+    animationController->setCurrentTimeStep ( 0 );
+
+    for ( unsigned int frame = 0; frame < last; ++frame )
+    {
+      animationController->stepForward();
+
+      if ( frame < first )
+        continue;
 
       document->visibleTimeSpan ( animationController->visibleTimeSpan() );
 
+      // Bring in needed detail. The last frame is still being written.
+      view->waitForDetail ( camera );
+
       view->render ( camera );
     }
   }
-  else
+  else if ( 0 == shard )
   {
     view->render ( camera );
   }
 
+  view->waitForWrites();
   view = 0x0;
   document = 0x0;
 
+  // Nothing can be downloading once the jobs are done.
+  Usul::Jobs::Manager::instance().cancel();
+  Usul::Jobs::Manager::instance().wait();
+  Minerva::Network::FetchEngine::destroy();
+  Minerva::Core::ImageCache::destroy();
+
   return 0;
 }